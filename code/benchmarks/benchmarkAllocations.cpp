@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+/**
+ * Replacement of the global operator new and delete, counting every
+ * heap allocation of the benchmark executable in allocationStats.
+ *
+ * Only compiled if the project was configured with
+ * ANPI_ENABLE_ALLOCATION_STATS.  Each block carries a small header with
+ * its size, so that the released bytes can be counted as well.
+ */
+
+#include "AllocationStats.hpp"
+
+#ifdef ANPI_ENABLE_ALLOCATION_STATS
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+  /// Header in front of each block, keeping the default alignment
+  const std::size_t HeaderSize = 16u;
+
+  inline void* countedNew(std::size_t n) {
+    for (;;) {
+      void* block = std::malloc(n + HeaderSize);
+      if (block != 0) {
+        *static_cast<std::size_t*>(block) = n;
+        anpi::allocationStats::instance().
+          allocated(anpi::allocationStats::Heap,n);
+        return static_cast<char*>(block) + HeaderSize;
+      }
+      std::new_handler handler = std::get_new_handler();
+      if (handler == 0) {
+        throw std::bad_alloc();
+      }
+      handler();
+    }
+  }
+
+  inline void countedDelete(void* ptr) noexcept {
+    if (ptr == 0) return;
+    char* block = static_cast<char*>(ptr) - HeaderSize;
+    anpi::allocationStats::instance().
+      freed(anpi::allocationStats::Heap,*reinterpret_cast<std::size_t*>(block));
+    std::free(block);
+  }
+} // namespace
+
+// The nothrow and sized variants of the standard library forward to these
+void* operator new(std::size_t n) { return countedNew(n); }
+void* operator new[](std::size_t n) { return countedNew(n); }
+void operator delete(void* ptr) noexcept { countedDelete(ptr); }
+void operator delete[](void* ptr) noexcept { countedDelete(ptr); }
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#ifndef ANPI_BENCHMARK_COUNTERS_HPP
+#define ANPI_BENCHMARK_COUNTERS_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+namespace anpi {
+  namespace benchmark {
+
+    /**
+     * Hardware performance counters of the calling thread, read through
+     * the Linux perf_event_open interface.
+     *
+     * Each counter is opened independently, so that the kernel may
+     * multiplex them if the CPU has not enough programmable counters;
+     * the values read are scaled accordingly.  Counters that cannot be
+     * opened (missing permissions, see /proc/sys/kernel/perf_event_paranoid,
+     * virtual machines, or other platforms) are reported as unavailable
+     * and read as zero.  Only user-space events are counted.
+     */
+    class perfCounters {
+    public:
+      /// Counted events
+      enum counterId {
+        Cycles = 0,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        BranchMisses,
+        DTLBMisses,
+        NumCounters
+      };
+
+      /// Name of each event, for reports
+      static const char* name(const counterId id) {
+        static const char* names[NumCounters] = {
+          "cycles","instructions","L1d-misses",
+          "LLC-misses","branch-misses","dTLB-misses"
+        };
+        return names[id];
+      }
+
+      perfCounters() {
+        for (int i=0;i<NumCounters;++i) {
+          _fd[i] = -1;
+        }
+#ifdef __linux__
+        const uint64_t cacheRead = (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) |
+          (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+
+        _fd[Cycles]       = open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES);
+        _fd[Instructions] = open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS);
+        _fd[L1DMisses]    = open(PERF_TYPE_HW_CACHE,
+                                 PERF_COUNT_HW_CACHE_L1D | cacheRead);
+        _fd[LLCMisses]    = open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES);
+        _fd[BranchMisses] = open(PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES);
+        _fd[DTLBMisses]   = open(PERF_TYPE_HW_CACHE,
+                                 PERF_COUNT_HW_CACHE_DTLB | cacheRead);
+#endif
+      }
+
+      ~perfCounters() {
+#ifdef __linux__
+        for (int i=0;i<NumCounters;++i) {
+          if (_fd[i] >= 0) {
+            ::close(_fd[i]);
+          }
+        }
+#endif
+      }
+
+      /// True if at least one counter could be opened
+      bool available() const {
+        for (int i=0;i<NumCounters;++i) {
+          if (_fd[i] >= 0) return true;
+        }
+        return false;
+      }
+
+      /// True if the given counter could be opened
+      bool available(const counterId id) const {
+        return _fd[id] >= 0;
+      }
+
+      /// Reset and start all counters
+      void start() {
+#ifdef __linux__
+        for (int i=0;i<NumCounters;++i) {
+          if (_fd[i] >= 0) {
+            ioctl(_fd[i],PERF_EVENT_IOC_RESET,0);
+            ioctl(_fd[i],PERF_EVENT_IOC_ENABLE,0);
+          }
+        }
+#endif
+      }
+
+      /// Stop all counters
+      void stop() {
+#ifdef __linux__
+        for (int i=0;i<NumCounters;++i) {
+          if (_fd[i] >= 0) {
+            ioctl(_fd[i],PERF_EVENT_IOC_DISABLE,0);
+          }
+        }
+#endif
+      }
+
+      /**
+       * Read the counts since the last start(), scaled to compensate
+       * for multiplexing.  Unavailable counters are set to zero.
+       */
+      void read(double values[NumCounters]) const {
+        for (int i=0;i<NumCounters;++i) {
+          values[i] = 0.;
+#ifdef __linux__
+          if (_fd[i] < 0) continue;
+
+          // value, time enabled, time running
+          uint64_t data[3] = {0u,0u,0u};
+          if (::read(_fd[i],data,sizeof(data)) != ssize_t(sizeof(data))) {
+            continue;
+          }
+          if (data[2] > 0u) {
+            values[i] = double(data[0])*double(data[1])/double(data[2]);
+          }
+#endif
+        }
+      }
+
+    private:
+      // not copyable: the descriptors are owned
+      perfCounters(const perfCounters&);
+      perfCounters& operator=(const perfCounters&);
+
+#ifdef __linux__
+      /// Open one disabled user-space counter of the calling thread
+      static int open(const uint32_t type,const uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr,0,sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = type;
+        attr.config         = config;
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                              PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return int(syscall(__NR_perf_event_open,&attr,0,-1,-1,0));
+      }
+#endif
+
+      int _fd[NumCounters];
+    };
+
+  } // namespace benchmark
+} // namespace anpi
+
+#endif
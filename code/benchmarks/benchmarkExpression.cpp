@@ -0,0 +1,135 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Cost of evaluating runtime expressions (see Expression.hpp): native
+ * code, the bytecode one value at a time through std::function as the
+ * solvers call it, and the bytecode over whole batches of values.
+ */
+#include "benchmarkFramework.hpp"
+
+#include "Expression.hpp"
+
+BOOST_AUTO_TEST_SUITE( Expression )
+
+/// Evaluate f at "size" points, one call per point
+template<typename T>
+class benchScalar {
+public:
+  benchScalar(const std::function<T(T)>& f) : _f(f),_sink(T(0)) {}
+
+  void prepare(const size_t size) {
+    _x.resize(size);
+    for (size_t i=0;i<size;++i) {
+      _x[i] = T(-3) + T(6)*T(i)/T(size);
+    }
+  }
+
+  inline void eval() {
+    T acc(0);
+    for (size_t i=0;i<_x.size();++i) {
+      acc += _f(_x[i]);
+    }
+    _sink = acc;
+  }
+
+private:
+  std::function<T(T)> _f;
+  std::vector<T> _x;
+  volatile T _sink;
+};
+
+/// Evaluate an expression at "size" points with one batch call
+template<typename T>
+class benchBatch {
+public:
+  benchBatch(const anpi::expression<T>& f) : _f(f) {}
+
+  void prepare(const size_t size) {
+    _x.resize(size);
+    for (size_t i=0;i<size;++i) {
+      _x[i] = T(-3) + T(6)*T(i)/T(size);
+    }
+  }
+
+  inline void eval() {
+    _f.evaluate(_x,_y);
+  }
+
+private:
+  anpi::expression<T> _f;
+  std::vector<T> _x;
+  std::vector<T> _y;
+};
+
+/// Time the three ways of evaluating one function, in ns per value
+template<typename T>
+void timeExpression(const std::string& name,
+                    const std::string& text,
+                    const std::function<T(T)>& native) {
+  ::anpi::benchmark::harness runner(0.05,10,50);
+  const std::vector<size_t> sizes = { 1024u, 65536u };
+  const anpi::expression<T> compiled(text);
+
+  benchScalar<T> bn(native);
+  benchScalar<T> bs((std::function<T(T)>(compiled)));
+  benchBatch<T>  bb(compiled);
+
+  std::vector<anpi::benchmark::measurement> tn,ts,tb;
+  runner.run(sizes,bn,tn);
+  runner.run(sizes,bs,ts);
+  runner.run(sizes,bb,tb);
+
+  const std::string type = (sizeof(T) == sizeof(float)) ? "float" : "double";
+  std::cout << text << " (" << type << ", "
+            << compiled.instructions().size() << " instructions)\n"
+            << "  size    native ns  scalar ns  batch ns" << std::endl;
+  for (size_t s=0;s<sizes.size();++s) {
+    const double n = double(sizes[s]);
+    std::cout << "  " << std::left << std::setw(8) << sizes[s] << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(9)  << 1.e9*tn[s].median/n
+              << std::setw(11) << 1.e9*ts[s].median/n
+              << std::setw(10) << 1.e9*tb[s].median/n
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+  }
+
+  ::anpi::benchmark::record("expr_native_" + name + "_" + type,tn);
+  ::anpi::benchmark::record("expr_scalar_" + name + "_" + type,ts);
+  ::anpi::benchmark::record("expr_batch_"  + name + "_" + type,tb);
+}
+
+template<typename T>
+void timeAllExpressions() {
+  timeExpression<T>("polynomial","x^5 - 3*x^3 + 2*x - 1",
+                    [](T x) { return x*x*x*x*x - T(3)*x*x*x + T(2)*x - T(1); });
+  timeExpression<T>("absexp","abs(x)-exp(-x)",
+                    [](T x) { return std::abs(x) - std::exp(-x); });
+  timeExpression<T>("mixed","sin(x)*sin(x) + x*exp(-x^2)/(1+x^2)",
+                    [](T x) {
+                      const T s = std::sin(x);
+                      return s*s + x*std::exp(-(x*x))/(T(1)+x*x); });
+}
+
+BOOST_AUTO_TEST_CASE( Float ) {
+  timeAllExpressions<float>();
+}
+
+BOOST_AUTO_TEST_CASE( Double ) {
+  timeAllExpressions<double>();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -11,68 +11,536 @@
 #ifndef ANPI_BENCHMARK_FRAMEWORK_HPP
 #define ANPI_BENCHMARK_FRAMEWORK_HPP
 
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <ostream>
 #include <fstream>
 #include <limits>
+#include <memory>
+#include <vector>
 #include "Matrix.hpp"
+#include "HasType.hpp"
+#include "AllocationStats.hpp"
+#include "Profiler.hpp"
+#include "benchmarkCounters.hpp"
+#include "benchmarkStream.hpp"
 
 //#include <Matrix.hpp>
-#include <PlotPy.hpp>
+#include <Plot.hpp>
 
 
 namespace anpi {
   namespace benchmark {
     /**
-     * Each measurement is composed by four attributes
+     * Each measurement holds the statistics of the time per evaluation,
+     * in seconds, for one size.
+     *
+     * The first attributes are the classic average, standard deviation,
+     * minimum and maximum.  The robust statistics follow: median,
+     * median absolute deviation, percentiles and a 95% confidence
+     * interval of the median.  All of them are computed after the
+     * rejection of outliers.
+     *
+     * If the harness collects hardware counters, their mean value per
+     * evaluation is stored in counters, indexed by
+     * perfCounters::counterId.  Negative values denote unavailable
+     * counters.
+     *
+     * The work declared by the bench (bytes moved, floating point
+     * operations and roots found per evaluation) is stored together
+     * with the throughput derived from the median time.  Undeclared
+     * work is zero.
+     *
+     * If the project was configured with ANPI_ENABLE_ALLOCATION_STATS,
+     * the heap allocations of one evaluation are stored as well (see
+     * allocationStats); otherwise they are negative.
      */
     struct measurement {
-      inline measurement() : size(0u),average(0.),stddev(0.),min(0.),max(0.) {};
+      inline measurement()
+        : size(0u),average(0.),stddev(0.),min(0.),max(0.),
+          median(0.),mad(0.),p05(0.),p25(0.),p75(0.),p95(0.),
+          ciLow(0.),ciHigh(0.),samples(0u),batch(0u),outliers(0u),
+          bytes(0.),flops(0.),roots(0.),
+          bandwidth(0.),gflops(0.),rootsPerSecond(0.),peakPercent(0.),
+          peakBytes(-1.) {
+        for (int i=0;i<perfCounters::NumCounters;++i) {
+          counters[i] = -1.;
+        }
+        for (int i=0;i<allocationStats::NumSources;++i) {
+          allocations[i] = allocatedBytes[i] = -1.;
+        }
+      }
       
       size_t size;
       double average;
       double stddev;
       double min;
       double max;
+
+      double median;
+      /// Median absolute deviation (unscaled)
+      double mad;
+      double p05;
+      double p25;
+      double p75;
+      double p95;
+      /// Confidence interval (95%) of the median
+      double ciLow;
+      double ciHigh;
+
+      /// Number of samples kept
+      size_t samples;
+      /// Evaluations timed together in each sample
+      size_t batch;
+      /// Number of samples rejected as outliers
+      size_t outliers;
+
+      /// Hardware events per evaluation
+      double counters[perfCounters::NumCounters];
+
+      /// Bytes moved per evaluation
+      double bytes;
+      /// Floating point operations per evaluation
+      double flops;
+      /// Roots found per evaluation
+      double roots;
+
+      /// Bandwidth in GB/s
+      double bandwidth;
+      /// Arithmetic throughput in GFLOP/s
+      double gflops;
+      /// Roots found per second
+      double rootsPerSecond;
+      /**
+       * Bandwidth as percentage of the machine memory peak (see
+       * peakBandwidth()).  It exceeds 100 when the working set fits in
+       * the caches.
+       */
+      double peakPercent;
+
+      /// Heap allocations per evaluation, indexed by allocationStats::source
+      double allocations[allocationStats::NumSources];
+      /// Bytes allocated per evaluation, indexed by allocationStats::source
+      double allocatedBytes[allocationStats::NumSources];
+      /// Largest growth of the live heap bytes during one evaluation
+      double peakBytes;
     };
 
+    /*
+     * Optional work declarations of a bench.  After prepare(size) the
+     * bench may provide any of
+     *   double bytes() const;  // bytes read and written per eval()
+     *   double flops() const;  // floating point operations per eval()
+     *   double roots() const;  // roots found per eval()
+     */
+    GENERATE_HAS_MEMBER(bytes);
+    GENERATE_HAS_MEMBER(flops);
+    GENERATE_HAS_MEMBER(roots);
+
+    template<class Bench>
+    inline double declaredBytes(const Bench& b,std::true_type) {
+      return double(b.bytes());
+    }
+    template<class Bench>
+    inline double declaredBytes(const Bench&,std::false_type) { return 0.; }
+
+    template<class Bench>
+    inline double declaredFlops(const Bench& b,std::true_type) {
+      return double(b.flops());
+    }
+    template<class Bench>
+    inline double declaredFlops(const Bench&,std::false_type) { return 0.; }
+
+    template<class Bench>
+    inline double declaredRoots(const Bench& b,std::true_type) {
+      return double(b.roots());
+    }
+    template<class Bench>
+    inline double declaredRoots(const Bench&,std::false_type) { return 0.; }
+
+    /**
+     * Store the work declared by the bench and derive the throughput
+     * from the median time.
+     */
+    template<class Bench>
+    inline void computeThroughput(const Bench& bench,measurement& m) {
+      m.bytes = declaredBytes(bench,has_member_bytes<Bench>());
+      m.flops = declaredFlops(bench,has_member_flops<Bench>());
+      m.roots = declaredRoots(bench,has_member_roots<Bench>());
+
+      if (m.median <= 0.) {
+        return;
+      }
+      m.bandwidth      = m.bytes/m.median/1.e9;
+      m.gflops         = m.flops/m.median/1.e9;
+      m.rootsPerSecond = m.roots/m.median;
+      if (m.bytes > 0.) {
+        m.peakPercent  = 100.*m.bandwidth/peakBandwidth();
+      }
+    }
+
     template<typename T>
     inline T sqr(const T val) { return val*val; }
+
+    /**
+     * Percentile p (in [0,1]) of sorted data, linearly interpolated
+     */
+    inline double percentile(const std::vector<double>& sorted,
+                             const double p) {
+      assert(!sorted.empty());
+      const double pos = p*double(sorted.size()-1);
+      const size_t lo  = size_t(pos);
+      if (lo+1 >= sorted.size()) {
+        return sorted.back();
+      }
+      const double w = pos - double(lo);
+      return sorted[lo]*(1.-w) + sorted[lo+1]*w;
+    }
+
+    /**
+     * Median absolute deviation of sorted data with the given median
+     */
+    inline double medianAbsoluteDeviation(const std::vector<double>& sorted,
+                                          const double median) {
+      std::vector<double> dev(sorted.size());
+      for (size_t i=0;i<sorted.size();++i) {
+        dev[i]=std::abs(sorted[i]-median);
+      }
+      std::sort(dev.begin(),dev.end());
+      return percentile(dev,0.5);
+    }
     
     /**
-     * Compute measurement statistics for each size
+     * Compute the statistics of the given samples (time per evaluation).
+     *
+     * Samples whose modified z-score 0.6745*|x-median|/MAD exceeds
+     * the threshold are rejected as outliers (Iglewicz and Hoaglin).
+     * The samples vector is sorted in place.
      */
-    void computeStats(const std::vector<size_t>& sizes,
-                      const anpi::Matrix<std::chrono::duration<double> >& mat,
-                      std::vector<measurement>& times) {
-
-      const size_t nums = sizes.size();
-      times.resize(nums);
-      for ( size_t s=0;s<nums;++s ) {
-        measurement& m = times[s];
-        m.size = sizes[s];        
-
-        double val = mat[s][0].count();
-        m.average = val;
-        m.stddev  = sqr(val);
-
-        m.min = val;
-        m.max = val;
-        
-        for ( size_t i=1;i<mat.cols();++i ) {
-          val = (mat[s][i]-mat[s][i-1]).count();
-          m.average += val;
-          m.stddev  += sqr(val);
-          m.min = std::min(m.min,val);
-          m.max = std::max(m.max,val);
-        }
-
-        m.average /= mat.cols();
-        m.stddev = std::sqrt(m.stddev/mat.cols() - sqr(m.average));
+    inline void computeStats(std::vector<double>& samples,
+                             measurement& m,
+                             const double threshold = 3.5) {
+
+      assert(!samples.empty());
+      std::sort(samples.begin(),samples.end());
+
+      // outlier rejection
+      const double rawMedian = percentile(samples,0.5);
+      const double rawMad    = medianAbsoluteDeviation(samples,rawMedian);
+      const size_t total     = samples.size();
+      if (rawMad > 0.) {
+        samples.erase(std::remove_if(samples.begin(),samples.end(),
+                                     [&](const double x) {
+                                       return 0.6745*std::abs(x-rawMedian)/
+                                         rawMad > threshold;
+                                     }),
+                      samples.end());
+      }
+      const size_t n = samples.size();
+      m.samples  = n;
+      m.outliers = total - n;
+
+      // classic statistics
+      m.min = samples.front();
+      m.max = samples.back();
+      m.average = 0.;
+      for (const double x : samples) {
+        m.average += x;
+      }
+      m.average /= double(n);
+      m.stddev = 0.;
+      for (const double x : samples) {
+        m.stddev += sqr(x-m.average);
       }
+      m.stddev = (n>1) ? std::sqrt(m.stddev/double(n-1)) : 0.;
+
+      // robust statistics
+      m.median = percentile(samples,0.5);
+      m.mad    = medianAbsoluteDeviation(samples,m.median);
+      m.p05    = percentile(samples,0.05);
+      m.p25    = percentile(samples,0.25);
+      m.p75    = percentile(samples,0.75);
+      m.p95    = percentile(samples,0.95);
+
+      // distribution-free confidence interval of the median, given by
+      // the order statistics around n/2 +/- 1.96*sqrt(n)/2
+      const double half = 1.96*std::sqrt(double(n))/2.;
+      const double lo = std::floor(double(n)/2. - half);
+      const double hi = std::ceil(double(n)/2. + half);
+      m.ciLow  = samples[size_t(std::max(1.,lo))-1];
+      m.ciHigh = samples[size_t(std::min(double(n),hi))-1];
     }
 
+    /**
+     * Benchmark harness.
+     *
+     * For each size the harness prepares the bench, warms it up, and
+     * calibrates how many evaluations must be timed together so that
+     * each sample is well above the clock resolution.  The number of
+     * samples is then chosen so that the whole measurement of one size
+     * takes about the target time, bounded by the minimum and maximum
+     * number of samples.
+     *
+     * Optionally, hardware performance counters are collected around the
+     * timed samples (see perfCounters), either by calling
+     * enableCounters() or by setting the environment variable
+     * ANPI_BENCHMARK_COUNTERS to 1.  If the counters cannot be opened
+     * only times are reported.
+     *
+     * If the project was configured with ANPI_ENABLE_ALLOCATION_STATS,
+     * one more batch is run after the timed samples to attribute the
+     * heap allocations and the peak of live bytes to each evaluation.
+     *
+     * The bench is an instance of a class that must provide at least
+     * the following:
+     * - an void prepare(const size_t size) method, that initializes the
+     *   state of the instance as required for the evaluation.  This
+     *   method is called outside the performance measurements.
+     * - an inline void eval() method that performs the evaluation.
+     */
+    class harness {
+    public:
+      typedef std::chrono::steady_clock clock;
+      typedef std::chrono::duration<double> durat;
+
+      /**
+       * Construct a harness
+       *
+       * @param targetTime time in seconds spent measuring each size
+       * @param minSamples minimum number of samples per size
+       * @param maxSamples maximum number of samples per size
+       */
+      harness(const double targetTime = 0.2,
+              const size_t minSamples = 10,
+              const size_t maxSamples = 100)
+        : _targetTime(targetTime),
+          _minSamples(minSamples),
+          _maxSamples(std::max(minSamples,maxSamples)),
+          _warmupTime(0.1*targetTime),
+          _minSampleTime(2.e-5),
+          _threshold(3.5),
+          _evaluations(0u) {
+        const char* env = std::getenv("ANPI_BENCHMARK_COUNTERS");
+        if ((env != 0) && (std::string(env) == "1")) {
+          enableCounters(true);
+        }
+      }
+
+      /**
+       * Collect hardware counters with the measurements.
+       *
+       * @return true if at least one counter is available
+       */
+      bool enableCounters(const bool enable) {
+        _perf.reset();
+        if (enable) {
+          _perf.reset(new perfCounters());
+          if (!_perf->available()) {
+            std::cerr << "Hardware performance counters unavailable "
+                      << "(see /proc/sys/kernel/perf_event_paranoid)"
+                      << std::endl;
+            _perf.reset();
+          }
+        }
+        return bool(_perf);
+      }
+
+      /// Time in seconds spent warming up each size
+      void setWarmupTime(const double t) { _warmupTime = t; }
+
+      /// Minimum duration of one timed sample, in seconds
+      void setMinSampleTime(const double t) { _minSampleTime = t; }
+
+      /// Threshold of the modified z-score to reject outliers
+      void setOutlierThreshold(const double t) { _threshold = t; }
+
+      /// Total number of calls to eval(), including warmup
+      size_t evaluations() const { return _evaluations; }
+
+      /**
+       * Measure the bench for all given sizes
+       */
+      template<class Bench>
+      void run(const std::vector<size_t>& sizes,
+               Bench& bench,
+               std::vector<measurement>& times) {
+        times.resize(sizes.size());
+        for (size_t s=0;s<sizes.size();++s) {
+          std::cout << "Testing size " << sizes[s] << std::endl;
+          run(sizes[s],bench,times[s]);
+        }
+      }
+
+      /**
+       * Measure the bench for one size
+       */
+      template<class Bench>
+      void run(const size_t size,
+               Bench& bench,
+               measurement& m) {
+        ANPI_PROFILE_SCOPE("benchmark","run");
+        {
+          ANPI_PROFILE_SCOPE("benchmark","prepare");
+          bench.prepare(size);
+        }
+
+        // warmup: at least one evaluation and the warmup time
+        double elapsed = 0.;
+        {
+          ANPI_PROFILE_SCOPE("benchmark","warmup");
+          do {
+            elapsed += time(bench,1u);
+          } while (elapsed < _warmupTime);
+        }
+
+        // calibrate the batch size doubling it until one sample is long
+        // enough to be reliably timed
+        size_t batch = 1u;
+        double t;
+        {
+          ANPI_PROFILE_SCOPE("benchmark","calibrate");
+          t = time(bench,batch);
+          while (t < _minSampleTime) {
+            batch *= 2u;
+            t = time(bench,batch);
+          }
+        }
+        const double perEval = t/double(batch);
+
+        // number of samples to fill the target time; if more than the
+        // maximum would be needed, longer samples are taken instead
+        const size_t wanted = size_t(_targetTime/t);
+        const size_t n = std::min(_maxSamples,std::max(_minSamples,wanted));
+        if (wanted > n) {
+          batch = std::max(batch,
+                           size_t(_targetTime/(double(n)*perEval)));
+        }
+
+        std::vector<double> samples(n);
+        double totals[perfCounters::NumCounters] = {};
+        for (size_t i=0;i<n;++i) {
+          ANPI_PROFILE_SCOPE("benchmark","sample");
+          if (_perf) {
+            _perf->start();
+          }
+          samples[i] = time(bench,batch)/double(batch);
+          if (_perf) {
+            _perf->stop();
+            double values[perfCounters::NumCounters];
+            _perf->read(values);
+            for (int c=0;c<perfCounters::NumCounters;++c) {
+              totals[c] += values[c];
+            }
+          }
+        }
+
+        m.size  = size;
+        m.batch = batch;
+        computeStats(samples,m,_threshold);
+        computeThroughput(bench,m);
+
+        if ((m.bytes > 0.) || (m.flops > 0.) || (m.roots > 0.)) {
+          std::cout << " ";
+          if (m.bytes > 0.) {
+            std::cout << " " << m.bandwidth << " GB/s ("
+                      << m.peakPercent << "% of peak)";
+          }
+          if (m.flops > 0.) {
+            std::cout << " " << m.gflops << " GFLOP/s";
+          }
+          if (m.roots > 0.) {
+            std::cout << " " << m.rootsPerSecond << " roots/s";
+          }
+          std::cout << std::endl;
+        }
+
+        if (_perf) {
+          std::cout << "  per evaluation:";
+          for (int c=0;c<perfCounters::NumCounters;++c) {
+            const perfCounters::counterId id = perfCounters::counterId(c);
+            m.counters[c] = _perf->available(id) ?
+              totals[c]/double(n*batch) : -1.;
+            if (m.counters[c] >= 0.) {
+              std::cout << " " << perfCounters::name(id)
+                        << "=" << m.counters[c];
+            }
+          }
+          std::cout << std::endl;
+        }
+
+        if (allocationStats::enabled()) {
+          countAllocations(bench,batch,m);
+          std::cout << "  allocations per evaluation:"
+                    << " heap=" << m.allocations[allocationStats::Heap]
+                    << " (" << m.allocatedBytes[allocationStats::Heap]
+                    << " bytes) anpi=" << m.allocations[allocationStats::Anpi]
+                    << " (" << m.allocatedBytes[allocationStats::Anpi]
+                    << " bytes), peak " << m.peakBytes << " bytes"
+                    << std::endl;
+        }
+
+        if (m.outliers > 0u) {
+          std::cout << "  " << m.outliers << " outliers rejected"
+                    << " (median " << m.median
+                    << " s, calibrated " << perEval << " s)" << std::endl;
+        }
+      }
+
+    private:
+      /**
+       * Count the allocations of one untimed batch of evaluations, and
+       * the largest growth of the live bytes within one evaluation
+       */
+      template<class Bench>
+      void countAllocations(Bench& bench,const size_t batch,measurement& m) {
+        allocationStats& stats = allocationStats::instance();
+        const allocationStats::snapshot before = stats.read();
+        size_t peak = 0u;
+        for (size_t i=0;i<batch;++i) {
+          stats.resetPeak();
+          const size_t base = stats.current();
+          bench.eval();
+          const size_t top = stats.peak();
+          peak = std::max(peak,(top > base) ? top - base : size_t(0u));
+        }
+        _evaluations += batch;
+        const allocationStats::snapshot after = stats.read();
+
+        for (int s=0;s<allocationStats::NumSources;++s) {
+          m.allocations[s] =
+            double(after.allocations[s] - before.allocations[s])/double(batch);
+          m.allocatedBytes[s] =
+            double(after.bytes[s] - before.bytes[s])/double(batch);
+        }
+        m.peakBytes = double(peak);
+      }
+
+      /// Time one batch of evaluations
+      template<class Bench>
+      double time(Bench& bench,const size_t batch) {
+        const auto start = clock::now();
+        for (size_t i=0;i<batch;++i) {
+          bench.eval();
+        }
+        const durat d = clock::now() - start;
+        _evaluations += batch;
+        return d.count();
+      }
+
+      double _targetTime;
+      size_t _minSamples;
+      size_t _maxSamples;
+      double _warmupTime;
+      double _minSampleTime;
+      double _threshold;
+      size_t _evaluations;
+      std::unique_ptr<perfCounters> _perf;
+    };
+
     /**
      * Save a file with each measurement in a row.
      *
@@ -81,27 +549,75 @@ namespace anpi {
      * # Average
      * # Standard deviation
      * # Minimum
-     * # Maximum  
+     * # Maximum
+     * # Median
+     * # Median absolute deviation
+     * # Percentiles 5, 25, 75 and 95
+     * # Confidence interval of the median (low and high)
+     * # Samples, batch and outliers
+     * # Hardware counters per evaluation (cycles, instructions, L1d
+     *   misses, LLC misses, branch misses, dTLB misses), -1 if unavailable
+     * # Declared bytes, flops and roots per evaluation
+     * # GB/s, GFLOP/s, roots/s and percentage of peak bandwidth
+     * # Heap allocations and bytes per evaluation (operator new, anpi
+     *   allocators) and peak bytes, -1 if not counted
      */
-    void write(std::ostream& stream,
+    inline void write(std::ostream& stream,
                const std::vector<measurement>& m) {
       for (auto i : m) {
         stream << i.size    << " \t";
         stream << i.average << " \t";
         stream << i.stddev  << " \t";
         stream << i.min     << " \t";
-        stream << i.max     << " \t" << std::endl;
+        stream << i.max     << " \t";
+        stream << i.median  << " \t";
+        stream << i.mad     << " \t";
+        stream << i.p05     << " \t";
+        stream << i.p25     << " \t";
+        stream << i.p75     << " \t";
+        stream << i.p95     << " \t";
+        stream << i.ciLow   << " \t";
+        stream << i.ciHigh  << " \t";
+        stream << i.samples << " \t";
+        stream << i.batch   << " \t";
+        stream << i.outliers<< " \t";
+        for (int c=0;c<perfCounters::NumCounters;++c) {
+          stream << i.counters[c] << " \t";
+        }
+        stream << i.bytes          << " \t";
+        stream << i.flops          << " \t";
+        stream << i.roots          << " \t";
+        stream << i.bandwidth      << " \t";
+        stream << i.gflops         << " \t";
+        stream << i.rootsPerSecond << " \t";
+        stream << i.peakPercent    << " \t";
+        for (int a=0;a<allocationStats::NumSources;++a) {
+          stream << i.allocations[a] << " \t" << i.allocatedBytes[a] << " \t";
+        }
+        stream << i.peakBytes << std::endl;
       }
     }
 
     /**
-     * Save a file with each measurement in a row
+     * Record a series in the machine-readable report (see
+     * benchmarkReport.hpp)
+     */
+    inline void record(const std::string& name,
+                       const std::vector<measurement>& m);
+
+    /**
+     * Save a file with each measurement in a row.
+     *
+     * The series is also recorded in the report under the file name
+     * without extension.
      */
-    void write(const std::string& filename,
+    inline void write(const std::string& filename,
                const std::vector<measurement>& m) {
       std::ofstream os(filename.c_str());
       write(os,m);
       os.close();
+
+      record(filename.substr(0,filename.rfind('.')),m);
     }
 
     /**
@@ -114,7 +630,7 @@ namespace anpi {
      * # Minimum
      * # Maximum  
      */
-    void plot(const std::vector<measurement>& m,
+    inline void plot(const std::vector<measurement>& m,
               const std::string& legend,
               const std::string& color = "r") {
       std::vector<double> x(m.size()),y(m.size());
@@ -130,16 +646,10 @@ namespace anpi {
     }
 
     /**
-     * Plot measurements (average only)
-     *
-     * The meaning of the columns is as follows:
-     * # Size
-     * # Average
-     * # Standard deviation
-     * # Minimum
-     * # Maximum  
+     * Plot the median of the measurements, with the range between the
+     * 5th and 95th percentiles
      */
-    void plotRange(const std::vector<measurement>& m,
+    inline void plotRange(const std::vector<measurement>& m,
                    const std::string& legend,
                    const std::string& color) {
       std::vector<double> x(m.size()),y(m.size()),miny(m.size()),maxy(m.size());
@@ -147,9 +657,9 @@ namespace anpi {
       for (size_t i=0;i<m.size();++i) {
         const measurement& mi = m[i];
         x[i]=mi.size;
-        y[i]=mi.average;
-        miny[i]=mi.min;
-        maxy[i]=mi.max;
+        y[i]=mi.median;
+        miny[i]=mi.p05;
+        maxy[i]=mi.p95;
       }
 
       static anpi::Plot2d<double> plotter;
@@ -157,66 +667,41 @@ namespace anpi {
       plotter.plot(x,y,miny,maxy,legend,color);
     }
     
-    void show() {
+    inline void show() {
        static anpi::Plot2d<double> plotter;
        plotter.show();
     }
+
+    /**
+     * Measure the fallback and SIMD versions of a float kernel, writing
+     * <name>_float_fb.txt and <name>_float_simd.txt and plotting both
+     */
+    template<class Fallback,class SIMD>
+    void compare(const std::vector<size_t>& sizes,
+                 harness& runner,
+                 const std::string& name,
+                 const std::string& color) {
+      std::vector<measurement> times;
+
+      {
+        Fallback bench;
+        runner.run(sizes,bench,times);
+
+        write(name + "_float_fb.txt",times);
+        plotRange(times,name + " (float) fallback",color);
+      }
+
+      {
+        SIMD bench;
+        runner.run(sizes,bench,times);
+
+        write(name + "_float_simd.txt",times);
+        plotRange(times,name + " (float) simd","k");
+      }
+    }
   } // namespace benchmark
 } // namespace anpi
-    
-/**
- * Meassure the time for all given sizes.
- * @param sizes  vector with all sizes to be tested
- * @param rep    number of repetitions to meassure the time
- * @param times  measurement taken for each time
- *               its time must be anpi::Matrix<anpi::benchmark::measurement>
- * @param bench  benchmark instance.  See below for requirements
- *
- * The @bench is an instance of a class that must provide at least
- * the following:
- * - an void prepare(const size_t size) method, that initializes the
- *   state of the instance as required for the evaluation.  This
- *   method is called outside the performance measurements.
- * - an inline void eval() method that performs the evaluation.
- *
- * The following variables are available in PREFIX and CODE:
- * - size holds the current evaluated size (type size_t)
- * - s    holds the index of the current evaluated size
- * - i    index of the current repetition
- */
-#define ANPI_BENCHMARK(sizes,rep,times,bench)                      \
-{                                                                  \
-  /* number of sizes to be tested */                               \
-  const size_t _nums = sizes.size();                               \
-                                                                   \
-  typedef std::chrono::duration<double> durat;                     \
-                                                                   \
-  /* each row holds a particular size */                           \
-  ::anpi::Matrix<durat> _mat(_nums,rep,::anpi::DoNotInitialize);   \
-                                                                   \
-  /* test each size */                                             \
-  for (size_t s=0;s<_nums;++s ) {                                  \
-    const size_t size = sizes[s];                                  \
-                                                                   \
-    std::cout << "Testing size " << size << std::endl;             \
-                                                                   \
-    durat* _row = _mat[s];                                         \
-                                                                   \
-    /* prefix code for initialization before measurement */        \
-    bench.prepare(size);                                           \
-                                                                   \
-    const auto _start = std::chrono::high_resolution_clock::now(); \
-                                                                   \
-    for ( size_t i=0;i<rep;++i ) {                                 \
-      /* the code to be benchmarked */                             \
-      bench.eval();                                                \
-                                                                   \
-      _row[i] = std::chrono::high_resolution_clock::now()-_start;  \
-    }                                                              \
-  }                                                                \
-                                                                   \
-  ::anpi::benchmark::computeStats(sizes,_mat,times);               \
-}
 
+#include "benchmarkReport.hpp"
 
 #endif
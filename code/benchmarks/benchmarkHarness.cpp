@@ -0,0 +1,156 @@
+/**
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+/**
+ * Sanity checks of the statistics computed by the benchmark harness
+ */
+#include "benchmarkFramework.hpp"
+
+BOOST_AUTO_TEST_SUITE( Harness )
+
+/// Trivial bench counting its evaluations
+class benchCount {
+public:
+  benchCount() : prepared(0u), evals(0u) {}
+  void prepare(const size_t) { ++prepared; }
+  inline void eval() { ++evals; }
+
+  size_t prepared;
+  volatile size_t evals;
+};
+
+BOOST_AUTO_TEST_CASE( Statistics ) {
+  // 1..19 plus one gross outlier
+  std::vector<double> samples;
+  for (int i=1;i<20;++i) {
+    samples.push_back(double(i));
+  }
+  samples.push_back(1000.);
+
+  anpi::benchmark::measurement m;
+  anpi::benchmark::computeStats(samples,m);
+
+  BOOST_CHECK_EQUAL( m.outliers, 1u );
+  BOOST_CHECK_EQUAL( m.samples, 19u );
+  BOOST_CHECK_CLOSE( m.median,  10., 1.e-9 );
+  BOOST_CHECK_CLOSE( m.average, 10., 1.e-9 );
+  BOOST_CHECK_CLOSE( m.mad,      5., 1.e-9 );
+  BOOST_CHECK_CLOSE( m.p25,     5.5, 1.e-9 );
+  BOOST_CHECK_CLOSE( m.p75,    14.5, 1.e-9 );
+  BOOST_CHECK_EQUAL( m.min, 1. );
+  BOOST_CHECK_EQUAL( m.max, 19. );
+  BOOST_CHECK( m.ciLow <= m.median && m.median <= m.ciHigh );
+  BOOST_CHECK( m.ciLow > m.min && m.ciHigh < m.max );
+}
+
+BOOST_AUTO_TEST_CASE( Calibration ) {
+  anpi::benchmark::harness runner(0.01,10,50);
+  benchCount bench;
+  anpi::benchmark::measurement m;
+  runner.run(8u,bench,m);
+
+  BOOST_CHECK_EQUAL( bench.prepared, 1u );
+  BOOST_CHECK_EQUAL( runner.evaluations(), size_t(bench.evals) );
+  BOOST_CHECK( m.batch > 1u );  // a counter increment is way below 20us
+  BOOST_CHECK( m.samples + m.outliers >= 10u );
+  BOOST_CHECK( m.samples + m.outliers <= 50u );
+}
+
+BOOST_AUTO_TEST_CASE( Counters ) {
+  anpi::benchmark::harness runner(0.01,10,50);
+  const bool available = runner.enableCounters(true);
+  benchCount bench;
+  anpi::benchmark::measurement m;
+  runner.run(8u,bench,m);
+
+  typedef anpi::benchmark::perfCounters pc;
+  if (available) {
+    // at least the increments themselves must have been counted
+    pc counters;
+    if (counters.available(pc::Instructions)) {
+      BOOST_CHECK( m.counters[pc::Instructions] > 0. );
+    }
+  } else {
+    // graceful fallback: times only
+    for (int c=0;c<pc::NumCounters;++c) {
+      BOOST_CHECK( m.counters[c] < 0. );
+    }
+  }
+  BOOST_CHECK( m.median > 0. );
+}
+
+/// Bench declaring its work
+class benchWork : public benchCount {
+public:
+  double bytes() const { return 8.e3; }
+  double flops() const { return 2.e3; }
+  double roots() const { return 1.; }
+};
+
+BOOST_AUTO_TEST_CASE( Throughput ) {
+  // avoid the bandwidth probe
+  anpi::benchmark::peakBandwidthCache() = 10.;
+
+  anpi::benchmark::measurement m;
+  m.median = 1.e-6;
+  benchWork work;
+  anpi::benchmark::computeThroughput(work,m);
+  BOOST_CHECK_CLOSE( m.bandwidth, 8., 1.e-9 );
+  BOOST_CHECK_CLOSE( m.gflops, 2., 1.e-9 );
+  BOOST_CHECK_CLOSE( m.rootsPerSecond, 1.e6, 1.e-9 );
+  BOOST_CHECK_CLOSE( m.peakPercent, 80., 1.e-9 );
+
+  // benches without declarations report no throughput
+  anpi::benchmark::measurement n;
+  n.median = 1.e-6;
+  benchCount count;
+  anpi::benchmark::computeThroughput(count,n);
+  BOOST_CHECK_EQUAL( n.bytes, 0. );
+  BOOST_CHECK_EQUAL( n.bandwidth, 0. );
+  BOOST_CHECK_EQUAL( n.rootsPerSecond, 0. );
+}
+
+/// Bench with one matrix temporary and one std::vector per evaluation
+class benchAllocating {
+public:
+  void prepare(const size_t size) { a.allocate(size,size); a.fill(1.); }
+  inline void eval() {
+    anpi::Matrix<double> c = a + a;
+    std::vector<int> v(256);
+    sink = c(0,0) + v[0];
+  }
+
+  anpi::Matrix<double> a;
+  volatile double sink;
+};
+
+BOOST_AUTO_TEST_CASE( Allocations ) {
+  anpi::benchmark::harness runner(0.01,5,5);
+  runner.setWarmupTime(0.);
+  benchAllocating bench;
+  anpi::benchmark::measurement m;
+  runner.run(64,bench,m);
+
+  typedef anpi::allocationStats as;
+  if (as::enabled()) {
+    BOOST_CHECK_CLOSE( m.allocations[as::Anpi], 1., 1.e-9 );
+    BOOST_CHECK( m.allocatedBytes[as::Anpi] >= 64.*64.*sizeof(double) );
+    BOOST_CHECK( m.allocations[as::Heap] >= 1. );
+    BOOST_CHECK( m.allocatedBytes[as::Heap] >= 256.*sizeof(int) );
+    BOOST_CHECK( m.peakBytes >= 64.*64.*sizeof(double) + 256.*sizeof(int) );
+  } else {
+    BOOST_CHECK_EQUAL( m.allocations[as::Heap], -1. );
+    BOOST_CHECK_EQUAL( m.peakBytes, -1. );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
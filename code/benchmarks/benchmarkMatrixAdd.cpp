@@ -24,22 +24,61 @@
 #include "Matrix.hpp"
 #include "Allocator.hpp"
 
+/**
+ * Row-aligned allocator that counts how many buffers it reserves
+ */
+template<class T,std::size_t Align=anpi::DefaultAlignment>
+class countingAllocator : public anpi::aligned_row_allocator<T,Align> {
+public:
+  /// Inherit all constructors
+  using anpi::aligned_row_allocator<T,Align>::aligned_row_allocator;
+
+  /// Change the stored type
+  template<class U>
+  struct rebind {
+    typedef countingAllocator<U, Align> other;
+  };
+
+  /// Counter shared by all instances
+  static size_t& allocations() {
+    static size_t counter = 0u;
+    return counter;
+  }
+
+  /// Count and reserve
+  T* allocate(std::size_t n) {
+    ++allocations();
+    return anpi::aligned_row_allocator<T,Align>::allocate(n);
+  }
+};
+
+namespace anpi {
+  // The counting allocator is as aligned as the row allocator
+  template<typename T, std::size_t A>
+  struct is_aligned_alloc< countingAllocator<T,A> > {
+    static const bool value = true;
+  };
+}
+
 BOOST_AUTO_TEST_SUITE( Matrix )
 
 /// Benchmark for addition operations
-template<typename T>
+template<typename T,class Alloc=anpi::aligned_row_allocator<T> >
 class benchAdd {
 protected:
+  /// Type of the matrices being added
+  typedef anpi::Matrix<T,Alloc> matrix_type;
+
   /// Maximum allowed size for the square matrices
   const size_t _maxSize;
 
   /// A large matrix holding 
-  anpi::Matrix<T> _data;
+  matrix_type _data;
 
   /// State of the benchmarked evaluation
-  anpi::Matrix<T> _a;
-  anpi::Matrix<T> _b;
-  anpi::Matrix<T> _c;
+  matrix_type _a;
+  matrix_type _b;
+  matrix_type _c;
 public:
   /// Construct
   benchAdd(const size_t maxSize)
@@ -56,17 +95,27 @@ public:
   /// Prepare the evaluation of given size
   void prepare(const size_t size) {
     assert (size<=this->_maxSize);
-    this->_a=std::move(anpi::Matrix<T>(size,size,_data.data()));
+    this->_a=std::move(matrix_type(size,size,_data.data()));
     this->_b=this->_a;
   }
+
+  /// Bytes moved per evaluation: two operands and the result
+  double bytes() const {
+    return 3.*sizeof(T)*this->_a.rows()*this->_a.dcols();
+  }
+
+  /// One addition per entry
+  double flops() const {
+    return double(this->_a.rows()*this->_a.cols());
+  }
 };
 
 /// Provide the evaluation method for in-place addition 
-template<typename T>
-class benchAddInPlaceFallback : public benchAdd<T> {
+template<typename T,class Alloc=anpi::aligned_row_allocator<T> >
+class benchAddInPlaceFallback : public benchAdd<T,Alloc> {
 public:
   /// Constructor
-  benchAddInPlaceFallback(const size_t n) : benchAdd<T>(n) { }
+  benchAddInPlaceFallback(const size_t n) : benchAdd<T,Alloc>(n) { }
   
   // Evaluate add in-place
   inline void eval() {
@@ -75,11 +124,11 @@ public:
 };
 
 /// Provide the evaluation method for on-copy addition 
-template<typename T>
-class benchAddOnCopyFallback : public benchAdd<T> {
+template<typename T,class Alloc=anpi::aligned_row_allocator<T> >
+class benchAddOnCopyFallback : public benchAdd<T,Alloc> {
 public:
   /// Constructor
-  benchAddOnCopyFallback(const size_t n) : benchAdd<T>(n) { }
+  benchAddOnCopyFallback(const size_t n) : benchAdd<T,Alloc>(n) { }
   
   // Evaluate add on-copy
   inline void eval() {
@@ -88,11 +137,11 @@ public:
 };
 
 /// Provide the evaluation method for in-place addition 
-template<typename T>
-class benchAddInPlaceSIMD : public benchAdd<T> {
+template<typename T,class Alloc=anpi::aligned_row_allocator<T> >
+class benchAddInPlaceSIMD : public benchAdd<T,Alloc> {
 public:
   /// Constructor
-  benchAddInPlaceSIMD(const size_t n) : benchAdd<T>(n) { }
+  benchAddInPlaceSIMD(const size_t n) : benchAdd<T,Alloc>(n) { }
   
   // Evaluate add in-place
   inline void eval() {
@@ -101,11 +150,11 @@ public:
 };
 
 /// Provide the evaluation method for on-copy addition 
-template<typename T>
-class benchAddOnCopySIMD : public benchAdd<T> {
+template<typename T,class Alloc=anpi::aligned_row_allocator<T> >
+class benchAddOnCopySIMD : public benchAdd<T,Alloc> {
 public:
   /// Constructor
-  benchAddOnCopySIMD(const size_t n) : benchAdd<T>(n) { }
+  benchAddOnCopySIMD(const size_t n) : benchAdd<T,Alloc>(n) { }
   
   // Evaluate add on-copy
   inline void eval() {
@@ -113,6 +162,69 @@ public:
   }
 };
 
+/// Benchmark for chained sums
+template<typename T>
+class benchChainedSum {
+protected:
+  /// Type of matrices used, counting their allocations
+  typedef anpi::Matrix<T,countingAllocator<T> > matrix_type;
+
+  /// The summands
+  matrix_type _a;
+  matrix_type _b;
+  matrix_type _c;
+  matrix_type _d;
+
+  /// The result
+  matrix_type _r;
+public:
+  /// Prepare the evaluation of given size
+  void prepare(const size_t size) {
+    this->_a.allocate(size,size);
+    this->_a.fill(T(1));
+    this->_b=this->_a;
+    this->_c=this->_a;
+    this->_d=this->_a;
+  }
+
+  /// Bytes moved per evaluation: three sums of two operands each
+  double bytes() const {
+    return 9.*sizeof(T)*this->_a.rows()*this->_a.dcols();
+  }
+
+  /// Three additions per entry
+  double flops() const {
+    return 3.*this->_a.rows()*this->_a.cols();
+  }
+
+  /// Number of allocations done so far by the matrices
+  static size_t allocations() {
+    return countingAllocator<T>::allocations();
+  }
+};
+
+/// Chained sum using temporaries, which lend their buffers to the result
+template<typename T>
+class benchChainedSumTemporaries : public benchChainedSum<T> {
+public:
+  // Evaluate the chained sum
+  inline void eval() {
+    this->_r = ((this->_a + this->_b) + this->_c) + this->_d;
+  }
+};
+
+/// Chained sum with named intermediate results
+template<typename T>
+class benchChainedSumNamed : public benchChainedSum<T> {
+public:
+  // Evaluate the chained sum
+  inline void eval() {
+    const typename benchChainedSum<T>::matrix_type ab  = this->_a + this->_b;
+    const typename benchChainedSum<T>::matrix_type abc = ab + this->_c;
+    this->_r = abc + this->_d;
+  }
+};
+
 /**
  * Instantiate and test the methods of the Matrix class
  */
@@ -124,14 +236,14 @@ BOOST_AUTO_TEST_CASE( Add ) {
                                1536,2048,3072,4096};
 
   const size_t n=sizes.back();
-  const size_t repetitions=100;
+  ::anpi::benchmark::harness runner;
   std::vector<anpi::benchmark::measurement> times;
 
   {
     benchAddOnCopyFallback<float>  baoc(n);
 
     // Measure on-copy add
-    ANPI_BENCHMARK(sizes,repetitions,times,baoc);
+    runner.run(sizes,baoc,times);
     
     ::anpi::benchmark::write("add_on_copy_float_fb.txt",times);
     ::anpi::benchmark::plotRange(times,"On-copy (float) fallback","r");
@@ -141,7 +253,7 @@ BOOST_AUTO_TEST_CASE( Add ) {
     benchAddOnCopySIMD<float>  baoc(n);
 
     // Measure on-copy add
-    ANPI_BENCHMARK(sizes,repetitions,times,baoc);
+    runner.run(sizes,baoc,times);
     
     ::anpi::benchmark::write("add_on_copy_float_simd.txt",times);
     ::anpi::benchmark::plotRange(times,"On-copy (float) simd","g");
@@ -151,7 +263,7 @@ BOOST_AUTO_TEST_CASE( Add ) {
     benchAddInPlaceFallback<float> baip(n);
 
     // Measure in place add
-    ANPI_BENCHMARK(sizes,repetitions,times,baip);
+    runner.run(sizes,baip,times);
 
     ::anpi::benchmark::write("add_in_place_float_fb.txt",times);
     ::anpi::benchmark::plotRange(times,"In-place (float) fallback","b");
@@ -161,7 +273,7 @@ BOOST_AUTO_TEST_CASE( Add ) {
     benchAddInPlaceSIMD<float> baip(n);
 
     // Measure in place add
-    ANPI_BENCHMARK(sizes,repetitions,times,baip);
+    runner.run(sizes,baip,times);
 
     ::anpi::benchmark::write("add_in_place_float_simd.txt",times);
     ::anpi::benchmark::plotRange(times,"In-place (float) simd","m");
@@ -173,7 +285,7 @@ BOOST_AUTO_TEST_CASE( Add ) {
     benchAddOnCopy<double>  baoc(n);
 
     // Measure on-copy add
-    ANPI_BENCHMARK(sizes,repetitions,times,baoc);
+    runner.run(sizes,baoc,times);
     
     ::anpi::benchmark::write("add_on_copy_double.txt",times);
     ::anpi::benchmark::plotRange(times,"On-copy (double)","g");
@@ -183,7 +295,7 @@ BOOST_AUTO_TEST_CASE( Add ) {
     benchAddInPlace<double> baip(n);
 
     // Measure in place add
-    ANPI_BENCHMARK(sizes,repetitions,times,baip);
+    runner.run(sizes,baip,times);
 
     ::anpi::benchmark::write("add_in_place_double.txt",times);
     ::anpi::benchmark::plotRange(times,"In-place (double)","m");
@@ -192,5 +304,109 @@ BOOST_AUTO_TEST_CASE( Add ) {
   
   ::anpi::benchmark::show();
 }
+
+/**
+ * Chained sums (a+b)+c+d: time and allocations per expression
+ */
+BOOST_AUTO_TEST_CASE( ChainedSum ) {
+
+  std::vector<size_t> sizes = {  24,  32,  48,  64,
+                                 96, 128, 192, 256,
+                                384, 512, 768,1024};
+
+  ::anpi::benchmark::harness runner;
+  std::vector<anpi::benchmark::measurement> times;
+
+  {
+    benchChainedSumNamed<float> bcs;
+
+    const size_t before = bcs.allocations();
+    const size_t evals  = runner.evaluations();
+    runner.run(sizes,bcs,times);
+    const size_t allocs = bcs.allocations() - before - 4*sizes.size();
+    std::cout << "Named intermediates: "
+              << double(allocs)/double(runner.evaluations()-evals)
+              << " allocations per expression" << std::endl;
+
+    ::anpi::benchmark::write("chained_sum_float_named.txt",times);
+    ::anpi::benchmark::plotRange(times,"Chained sum (float) named","r");
+  }
+
+  {
+    benchChainedSumTemporaries<float> bcs;
+
+    const size_t before = bcs.allocations();
+    const size_t evals  = runner.evaluations();
+    runner.run(sizes,bcs,times);
+    const size_t allocs = bcs.allocations() - before - 4*sizes.size();
+    std::cout << "Temporaries: "
+              << double(allocs)/double(runner.evaluations()-evals)
+              << " allocations per expression" << std::endl;
+
+    ::anpi::benchmark::write("chained_sum_float_temporaries.txt",times);
+    ::anpi::benchmark::plotRange(times,"Chained sum (float) temporaries","g");
+  }
+
+  ::anpi::benchmark::show();
+}
+
+/**
+ * Compare the default row-aligned allocator against the huge-page
+ * allocator with parallel first-touch initialization
+ */
+BOOST_AUTO_TEST_CASE( AddHugePages ) {
+
+  std::vector<size_t> sizes = { 256, 512, 768,1024,
+                               1536,2048,3072,4096,
+                               6144,8192};
+
+  const size_t n=sizes.back();
+  ::anpi::benchmark::harness runner(0.2,5,20);
+  std::vector<anpi::benchmark::measurement> times;
+
+  typedef anpi::huge_page_row_allocator<float> hpalloc;
+
+  {
+    benchAddOnCopySIMD<float>  baoc(n);
+
+    // Measure on-copy add
+    runner.run(sizes,baoc,times);
+    
+    ::anpi::benchmark::write("add_on_copy_float_default.txt",times);
+    ::anpi::benchmark::plotRange(times,"On-copy (float) default","r");
+  }
+
+  {
+    benchAddOnCopySIMD<float,hpalloc>  baoc(n);
+
+    // Measure on-copy add
+    runner.run(sizes,baoc,times);
+    
+    ::anpi::benchmark::write("add_on_copy_float_hugepage.txt",times);
+    ::anpi::benchmark::plotRange(times,"On-copy (float) huge pages","g");
+  }
+  
+  {
+    benchAddInPlaceSIMD<float> baip(n);
+
+    // Measure in place add
+    runner.run(sizes,baip,times);
+
+    ::anpi::benchmark::write("add_in_place_float_default.txt",times);
+    ::anpi::benchmark::plotRange(times,"In-place (float) default","b");
+  }
+
+  {
+    benchAddInPlaceSIMD<float,hpalloc> baip(n);
+
+    // Measure in place add
+    runner.run(sizes,baip,times);
+
+    ::anpi::benchmark::write("add_in_place_float_hugepage.txt",times);
+    ::anpi::benchmark::plotRange(times,"In-place (float) huge pages","m");
+  }
+
+  ::anpi::benchmark::show();
+}
   
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,178 @@
+/**
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ *
+ * @author Pablo Alvarado
+ * @date   29.12.2017
+ */
+
+
+#include <boost/test/unit_test.hpp>
+
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+
+/**
+ * Benchmarks for the fused element-wise kernels of the matrix class
+ */
+#include "benchmarkFramework.hpp"
+#include "Matrix.hpp"
+#include "Allocator.hpp"
+
+BOOST_AUTO_TEST_SUITE( MatrixFused )
+
+/// Benchmark state for the fused element-wise kernels
+template<typename T>
+class benchFused {
+protected:
+  /// State of the benchmarked evaluation
+  anpi::Matrix<T> _x;
+  anpi::Matrix<T> _y;
+  anpi::Matrix<T> _z;
+public:
+  /// Prepare the evaluation of given size
+  void prepare(const size_t size) {
+    this->_x.allocate(size,size);
+    for (size_t r=0;r<size;++r) {
+      for (size_t c=0;c<size;++c) {
+        this->_x(r,c)=T((r+c)%7)/T(7);
+      }
+    }
+    this->_y=this->_x;
+    this->_z=this->_x;
+  }
+
+  /// Bytes of one matrix
+  double matrixBytes() const {
+    return double(sizeof(T)*this->_x.rows()*this->_x.dcols());
+  }
+
+  /// Entries of one matrix
+  double entries() const {
+    return double(this->_x.rows()*this->_x.cols());
+  }
+};
+
+/// In-place y = alpha*x + y
+template<typename T>
+class benchAxpyFallback : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 3.*this->matrixBytes(); }
+  double flops() const { return 2.*this->entries(); }
+  inline void eval() {
+    anpi::fallback::axpy(T(0.5),this->_x,this->_y);
+  }
+};
+
+/// In-place y = alpha*x + y
+template<typename T>
+class benchAxpySIMD : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 3.*this->matrixBytes(); }
+  double flops() const { return 2.*this->entries(); }
+  inline void eval() {
+    anpi::simd::axpy(T(0.5),this->_x,this->_y);
+  }
+};
+
+/// On-copy z = alpha*x
+template<typename T>
+class benchScaleFallback : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 2.*this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    anpi::fallback::scale(T(0.5),this->_x,this->_z);
+  }
+};
+
+/// On-copy z = alpha*x
+template<typename T>
+class benchScaleSIMD : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 2.*this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    anpi::simd::scale(T(0.5),this->_x,this->_z);
+  }
+};
+
+/// On-copy z = x .* y
+template<typename T>
+class benchHadamardFallback : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 3.*this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    anpi::fallback::hadamard(this->_x,this->_y,this->_z);
+  }
+};
+
+/// On-copy z = x .* y
+template<typename T>
+class benchHadamardSIMD : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 3.*this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    anpi::simd::hadamard(this->_x,this->_y,this->_z);
+  }
+};
+
+/// On-copy z = alpha*x + beta*y
+template<typename T>
+class benchLincombFallback : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 3.*this->matrixBytes(); }
+  double flops() const { return 3.*this->entries(); }
+  inline void eval() {
+    anpi::fallback::lincomb(T(0.5),this->_x,T(-0.5),this->_y,this->_z);
+  }
+};
+
+/// On-copy z = alpha*x + beta*y
+template<typename T>
+class benchLincombSIMD : public benchFused<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 3.*this->matrixBytes(); }
+  double flops() const { return 3.*this->entries(); }
+  inline void eval() {
+    anpi::simd::lincomb(T(0.5),this->_x,T(-0.5),this->_y,this->_z);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( Fused ) {
+
+  std::vector<size_t> sizes = {  24,  32,  48,  64,
+                                 96, 128, 192, 256,
+                                384, 512, 768,1024,
+                               1536,2048,3072,4096};
+
+  ::anpi::benchmark::harness runner;
+  using ::anpi::benchmark::compare;
+
+  compare<benchAxpyFallback<float>,
+          benchAxpySIMD<float> >(sizes,runner,"axpy","r");
+  compare<benchScaleFallback<float>,
+          benchScaleSIMD<float> >(sizes,runner,"scale","g");
+  compare<benchHadamardFallback<float>,
+          benchHadamardSIMD<float> >(sizes,runner,"hadamard","b");
+  compare<benchLincombFallback<float>,
+          benchLincombSIMD<float> >(sizes,runner,"lincomb","m");
+
+  ::anpi::benchmark::show();
+}
+  
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ *
+ * @author Pablo Alvarado
+ * @date   29.12.2017
+ */
+
+
+#include <boost/test/unit_test.hpp>
+
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+
+/**
+ * Benchmarks for fill, comparison and reductions of the matrix class
+ */
+#include "benchmarkFramework.hpp"
+#include "Matrix.hpp"
+#include "Allocator.hpp"
+
+BOOST_AUTO_TEST_SUITE( MatrixReductions )
+
+/// Benchmark state for the fill, comparison and reduction kernels
+template<typename T>
+class benchReduction {
+protected:
+  /// State of the benchmarked evaluation
+  anpi::Matrix<T> _a;
+  anpi::Matrix<T> _b;
+
+  /// Result of the last evaluation, to avoid its removal by the optimizer
+  volatile T _result;
+public:
+  /// Prepare the evaluation of given size
+  void prepare(const size_t size) {
+    this->_a.allocate(size,size);
+    for (size_t r=0;r<size;++r) {
+      for (size_t c=0;c<size;++c) {
+        this->_a(r,c)=T((r+c)%7)/T(7);
+      }
+    }
+    this->_b=this->_a;
+  }
+
+  /// Bytes of one matrix
+  double matrixBytes() const {
+    return double(sizeof(T)*this->_a.rows()*this->_a.dcols());
+  }
+
+  /// Entries of one matrix
+  double entries() const {
+    return double(this->_a.rows()*this->_a.cols());
+  }
+};
+
+/// Fill with a constant
+template<typename T>
+class benchFillFallback : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return this->matrixBytes(); }
+  inline void eval() {
+    anpi::fallback::fill(this->_a,T(1));
+  }
+};
+
+/// Fill with a constant
+template<typename T>
+class benchFillSIMD : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return this->matrixBytes(); }
+  inline void eval() {
+    anpi::simd::fill(this->_a,T(1));
+  }
+};
+
+/// Compare equal matrices (worst case: no early exit)
+template<typename T>
+class benchEqualFallback : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 2.*this->matrixBytes(); }
+  inline void eval() {
+    this->_result = T(anpi::fallback::equal(this->_a,this->_b));
+  }
+};
+
+/// Compare equal matrices (worst case: no early exit)
+template<typename T>
+class benchEqualSIMD : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 2.*this->matrixBytes(); }
+  inline void eval() {
+    this->_result = T(anpi::simd::equal(this->_a,this->_b));
+  }
+};
+
+/// Sum all entries
+template<typename T>
+class benchSumFallback : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    this->_result = anpi::fallback::sum(this->_a);
+  }
+};
+
+/// Sum all entries
+template<typename T>
+class benchSumSIMD : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    this->_result = anpi::simd::sum(this->_a);
+  }
+};
+
+/// Dot product
+template<typename T>
+class benchDotFallback : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 2.*this->matrixBytes(); }
+  double flops() const { return 2.*this->entries(); }
+  inline void eval() {
+    this->_result = anpi::fallback::dot(this->_a,this->_b);
+  }
+};
+
+/// Dot product
+template<typename T>
+class benchDotSIMD : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return 2.*this->matrixBytes(); }
+  double flops() const { return 2.*this->entries(); }
+  inline void eval() {
+    this->_result = anpi::simd::dot(this->_a,this->_b);
+  }
+};
+
+/// Largest absolute value
+template<typename T>
+class benchNormInfFallback : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    this->_result = anpi::fallback::normInf(this->_a);
+  }
+};
+
+/// Largest absolute value
+template<typename T>
+class benchNormInfSIMD : public benchReduction<T> {
+public:
+  /// Work per evaluation
+  double bytes() const { return this->matrixBytes(); }
+  double flops() const { return this->entries(); }
+  inline void eval() {
+    this->_result = anpi::simd::normInf(this->_a);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( Reductions ) {
+
+  std::vector<size_t> sizes = {  24,  32,  48,  64,
+                                 96, 128, 192, 256,
+                                384, 512, 768,1024,
+                               1536,2048,3072,4096};
+
+  ::anpi::benchmark::harness runner;
+  using ::anpi::benchmark::compare;
+
+  compare<benchFillFallback<float>,
+          benchFillSIMD<float> >(sizes,runner,"fill","r");
+  compare<benchEqualFallback<float>,
+          benchEqualSIMD<float> >(sizes,runner,"equal","g");
+  compare<benchSumFallback<float>,
+          benchSumSIMD<float> >(sizes,runner,"sum","b");
+  compare<benchDotFallback<float>,
+          benchDotSIMD<float> >(sizes,runner,"dot","m");
+  compare<benchNormInfFallback<float>,
+          benchNormInfSIMD<float> >(sizes,runner,"norm_inf","c");
+
+  ::anpi::benchmark::show();
+}
+  
+BOOST_AUTO_TEST_SUITE_END()
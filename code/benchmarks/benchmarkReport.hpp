@@ -0,0 +1,463 @@
+/**
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#ifndef ANPI_BENCHMARK_REPORT_HPP
+#define ANPI_BENCHMARK_REPORT_HPP
+
+#include "benchmarkFramework.hpp"
+#include "Exception.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+/**
+ * Machine-readable benchmark reports and baseline comparison.
+ *
+ * Every series saved with anpi::benchmark::write(filename,times) is also
+ * recorded here under the name of the file without extension.  The
+ * following environment variables control the report:
+ *
+ * - ANPI_BENCHMARK_JSON      file where all series are written as JSON
+ * - ANPI_BENCHMARK_CSV       file where all series are written as CSV
+ * - ANPI_BENCHMARK_BASELINE  JSON file of a previous run to compare with
+ * - ANPI_BENCHMARK_THRESHOLD relative slowdown of the median tolerated
+ *                            before failing (default 0.1, i.e. 10%)
+ *
+ * A size regresses if its median is slower than the baseline median by
+ * more than the threshold, and the 95% confidence intervals of both
+ * medians do not overlap.  Regressions are reported as test errors, so
+ * that the benchmark executable exits with a non-zero code.
+ */
+
+namespace anpi {
+  namespace benchmark {
+
+    /**
+     * Description of the machine and build that produced a report
+     */
+    struct environment {
+      std::string cpu;
+      std::string isa;
+      std::string arithmetic;
+      std::string compiler;
+      std::string flags;
+      std::string build;
+      unsigned int threads;
+      std::string timestamp;
+
+      /// Capture the current environment
+      environment() : threads(1u) {
+        cpu = "unknown";
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo,line)) {
+          if (line.compare(0,10,"model name") == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+              cpu = line.substr(line.find_first_not_of(' ',colon+1));
+            }
+            break;
+          }
+        }
+
+#if defined __AVX512F__
+        isa = "AVX512F";
+#elif defined __AVX2__
+        isa = "AVX2";
+#elif defined __AVX__
+        isa = "AVX";
+#elif defined __SSE2__
+        isa = "SSE2";
+#else
+        isa = "scalar";
+#endif
+#ifdef __FMA__
+        isa += "+FMA";
+#endif
+
+#ifdef ANPI_ENABLE_SIMD
+        arithmetic = "simd";
+#else
+        arithmetic = "fallback";
+#endif
+
+#if defined __clang__
+        compiler = std::string("clang ") + __clang_version__;
+#elif defined __GNUC__
+        compiler = std::string("gcc ") + __VERSION__;
+#else
+        compiler = "unknown";
+#endif
+
+#ifdef ANPI_CXX_FLAGS
+        flags = ANPI_CXX_FLAGS;
+#else
+        flags = "unknown";
+#endif
+#ifdef ANPI_BUILD_TYPE
+        build = ANPI_BUILD_TYPE;
+#else
+        build = "unknown";
+#endif
+
+#ifdef _OPENMP
+        threads = unsigned(omp_get_max_threads());
+#else
+        threads = std::max(1u,std::thread::hardware_concurrency());
+#endif
+
+        char buffer[32];
+        const std::time_t now = std::time(0);
+        std::strftime(buffer,sizeof(buffer),"%Y-%m-%dT%H:%M:%SZ",
+                      std::gmtime(&now));
+        timestamp = buffer;
+      }
+    };
+
+    /**
+     * Collects all measured series and writes them as JSON and CSV.
+     */
+    class report {
+    public:
+      typedef std::vector<measurement> series_type;
+
+      /// The report of this process
+      static report& instance() {
+        static report theReport;
+        return theReport;
+      }
+
+      /// The captured environment
+      const environment& env() const { return _env; }
+
+      /**
+       * Record a series.  A series with an already recorded name
+       * replaces the previous one.
+       */
+      void add(const std::string& name,const series_type& times) {
+        bool found = false;
+        for (auto& s : _series) {
+          if (s.first == name) {
+            s.second = times;
+            found = true;
+          }
+        }
+        if (!found) {
+          _series.push_back(std::make_pair(name,times));
+        }
+
+        if (!_json.empty()) {
+          writeJSON(_json);
+        }
+        if (!_csv.empty()) {
+          writeCSV(_csv);
+        }
+        if (!_baselineFile.empty()) {
+          compare(name,times);
+        }
+      }
+
+      /// Write all series as JSON
+      void writeJSON(std::ostream& os) const {
+        os.precision(9);
+        os << "{\n  \"environment\": {\n";
+        os << "    \"cpu\": "        << quote(_env.cpu)        << ",\n";
+        os << "    \"isa\": "        << quote(_env.isa)        << ",\n";
+        os << "    \"arithmetic\": " << quote(_env.arithmetic) << ",\n";
+        os << "    \"compiler\": "   << quote(_env.compiler)   << ",\n";
+        os << "    \"flags\": "      << quote(_env.flags)      << ",\n";
+        os << "    \"build\": "      << quote(_env.build)      << ",\n";
+        os << "    \"threads\": "    << _env.threads           << ",\n";
+        os << "    \"peak_bandwidth_gbs\": ";
+        if (peakBandwidthCache() > 0.) {
+          os << peakBandwidthCache() << ",\n";
+        } else {
+          os << "null,\n";
+        }
+        os << "    \"timestamp\": "  << quote(_env.timestamp)  << "\n";
+        os << "  },\n  \"series\": [";
+        for (size_t s=0;s<_series.size();++s) {
+          os << (s ? ",\n" : "\n");
+          os << "    {\n      \"name\": " << quote(_series[s].first)
+             << ",\n      \"measurements\": [";
+          const series_type& m = _series[s].second;
+          for (size_t i=0;i<m.size();++i) {
+            os << (i ? ",\n" : "\n") << "        {";
+            const std::vector<std::pair<std::string,double> > f = fields(m[i]);
+            for (size_t k=0;k<f.size();++k) {
+              os << (k ? ", " : " ") << quote(f[k].first) << ": ";
+              // JSON has no nan nor inf
+              if (std::isfinite(f[k].second)) {
+                os << f[k].second;
+              } else {
+                os << "null";
+              }
+            }
+            os << " }";
+          }
+          os << "\n      ]\n    }";
+        }
+        os << "\n  ]\n}\n";
+      }
+
+      /// Write all series as JSON into the given file
+      void writeJSON(const std::string& filename) const {
+        std::ofstream os(filename.c_str());
+        writeJSON(os);
+      }
+
+      /// Write all series as CSV, with the environment as comments
+      void writeCSV(std::ostream& os) const {
+        os.precision(9);
+        os << "# cpu: "        << _env.cpu        << "\n"
+           << "# isa: "        << _env.isa        << "\n"
+           << "# arithmetic: " << _env.arithmetic << "\n"
+           << "# compiler: "   << _env.compiler   << "\n"
+           << "# flags: "      << _env.flags      << "\n"
+           << "# build: "      << _env.build      << "\n"
+           << "# threads: "    << _env.threads    << "\n"
+           << "# peak bandwidth (GB/s): " << peakBandwidthCache() << "\n"
+           << "# timestamp: "  << _env.timestamp  << "\n";
+
+        os << "series";
+        const std::vector<std::pair<std::string,double> > h =
+          fields(measurement());
+        for (const auto& f : h) {
+          os << "," << f.first;
+        }
+        os << "\n";
+
+        for (const auto& s : _series) {
+          for (const auto& m : s.second) {
+            os << s.first;
+            for (const auto& f : fields(m)) {
+              os << "," << f.second;
+            }
+            os << "\n";
+          }
+        }
+      }
+
+      /// Write all series as CSV into the given file
+      void writeCSV(const std::string& filename) const {
+        std::ofstream os(filename.c_str());
+        writeCSV(os);
+      }
+
+      /**
+       * Load a baseline written by writeJSON().
+       *
+       * @throw anpi::Exception if the file cannot be parsed
+       */
+      void loadBaseline(const std::string& filename) {
+        namespace pt = boost::property_tree;
+        _baselineFile = filename;
+        _baseline.clear();
+
+        pt::ptree tree;
+        try {
+          pt::read_json(filename,tree);
+        } catch (pt::json_parser_error& e) {
+          throw anpi::Exception("Cannot read benchmark baseline " + filename +
+                                ": " + e.what());
+        }
+
+        for (const auto& s : tree.get_child("series")) {
+          const std::string name = s.second.get<std::string>("name");
+          std::map<size_t,measurement>& sizes = _baseline[name];
+          for (const auto& mi : s.second.get_child("measurements")) {
+            measurement m;
+            m.size    = mi.second.get<size_t>("size");
+            // null values read as NaN, which never count as regressions
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            m.median  = mi.second.get<double>("median",nan);
+            m.ciLow   = mi.second.get<double>("ci_low",nan);
+            m.ciHigh  = mi.second.get<double>("ci_high",nan);
+            m.average = mi.second.get<double>("average",m.median);
+            sizes[m.size] = m;
+          }
+        }
+      }
+
+      /// Set the relative slowdown of the median tolerated
+      void setThreshold(const double threshold) { _threshold = threshold; }
+
+      /**
+       * Compare a series against the baseline, if the baseline has it.
+       *
+       * @return the number of sizes that regressed
+       */
+      size_t compare(const std::string& name,const series_type& times) {
+        if (!_error.empty()) {
+          BOOST_ERROR(_error);
+          _error.clear();
+        }
+
+        const auto it = _baseline.find(name);
+        if (it == _baseline.end()) {
+          std::cout << "Baseline has no series " << name << std::endl;
+          return 0u;
+        }
+
+        size_t regressions = 0u;
+        double worst = 0.;
+        for (const auto& m : times) {
+          const auto b = it->second.find(m.size);
+          if (b == it->second.end()) {
+            continue;
+          }
+          const double slowdown = m.median/b->second.median - 1.;
+          worst = std::max(worst,slowdown);
+          if ( (slowdown > _threshold) && (m.ciLow > b->second.ciHigh) ) {
+            ++regressions;
+            std::ostringstream msg;
+            msg << "Performance regression in " << name
+                << " for size " << m.size << ": median "
+                << m.median << " s vs baseline " << b->second.median
+                << " s (+" << 100.*slowdown << "%)";
+            BOOST_ERROR(msg.str());
+          }
+        }
+        std::cout << "Compared " << name << " with baseline: worst slowdown "
+                  << 100.*worst << "%, " << regressions << " regressions"
+                  << std::endl;
+        return regressions;
+      }
+
+    private:
+      /// Read the configuration from the environment
+      report() : _threshold(0.1) {
+        const char* env = std::getenv("ANPI_BENCHMARK_JSON");
+        if (env != 0) {
+          _json = env;
+        }
+        env = std::getenv("ANPI_BENCHMARK_CSV");
+        if (env != 0) {
+          _csv = env;
+        }
+        env = std::getenv("ANPI_BENCHMARK_THRESHOLD");
+        if (env != 0) {
+          _threshold = std::atof(env);
+        }
+        env = std::getenv("ANPI_BENCHMARK_BASELINE");
+        if ((env != 0) && (*env != 0)) {
+          try {
+            loadBaseline(env);
+          } catch (std::exception& e) {
+            // reported as test error with the first comparison
+            _error = e.what();
+          }
+        }
+      }
+
+      report(const report&);
+      report& operator=(const report&);
+
+      /// Names and values of the fields of a measurement, in output order
+      static std::vector<std::pair<std::string,double> >
+      fields(const measurement& m) {
+        std::vector<std::pair<std::string,double> > f;
+        f.push_back(std::make_pair("size",double(m.size)));
+        f.push_back(std::make_pair("average",m.average));
+        f.push_back(std::make_pair("stddev",m.stddev));
+        f.push_back(std::make_pair("min",m.min));
+        f.push_back(std::make_pair("max",m.max));
+        f.push_back(std::make_pair("median",m.median));
+        f.push_back(std::make_pair("mad",m.mad));
+        f.push_back(std::make_pair("p05",m.p05));
+        f.push_back(std::make_pair("p25",m.p25));
+        f.push_back(std::make_pair("p75",m.p75));
+        f.push_back(std::make_pair("p95",m.p95));
+        f.push_back(std::make_pair("ci_low",m.ciLow));
+        f.push_back(std::make_pair("ci_high",m.ciHigh));
+        f.push_back(std::make_pair("samples",double(m.samples)));
+        f.push_back(std::make_pair("batch",double(m.batch)));
+        f.push_back(std::make_pair("outliers",double(m.outliers)));
+        for (int c=0;c<perfCounters::NumCounters;++c) {
+          f.push_back(std::make_pair(perfCounters::name(perfCounters::counterId(c)),
+                                     m.counters[c]));
+        }
+        f.push_back(std::make_pair("bytes",m.bytes));
+        f.push_back(std::make_pair("flops",m.flops));
+        f.push_back(std::make_pair("roots",m.roots));
+        f.push_back(std::make_pair("gb_per_s",m.bandwidth));
+        f.push_back(std::make_pair("gflop_per_s",m.gflops));
+        f.push_back(std::make_pair("roots_per_s",m.rootsPerSecond));
+        f.push_back(std::make_pair("peak_percent",m.peakPercent));
+        f.push_back(std::make_pair("heap_allocs",
+                                   m.allocations[allocationStats::Heap]));
+        f.push_back(std::make_pair("heap_bytes",
+                                   m.allocatedBytes[allocationStats::Heap]));
+        f.push_back(std::make_pair("anpi_allocs",
+                                   m.allocations[allocationStats::Anpi]));
+        f.push_back(std::make_pair("anpi_bytes",
+                                   m.allocatedBytes[allocationStats::Anpi]));
+        f.push_back(std::make_pair("peak_bytes",m.peakBytes));
+        return f;
+      }
+
+      /// JSON string literal
+      static std::string quote(const std::string& str) {
+        std::string q("\"");
+        for (const char ch : str) {
+          switch (ch) {
+          case '"':  q += "\\\""; break;
+          case '\\': q += "\\\\"; break;
+          case '\n': q += "\\n";  break;
+          case '\t': q += "\\t";  break;
+          default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+              char buf[8];
+              std::snprintf(buf,sizeof(buf),"\\u%04x",int(ch));
+              q += buf;
+            } else {
+              q += ch;
+            }
+          }
+        }
+        return q + "\"";
+      }
+
+      environment _env;
+      std::vector<std::pair<std::string,series_type> > _series;
+
+      std::string _json;
+      std::string _csv;
+
+      std::string _baselineFile;
+      std::map<std::string,std::map<size_t,measurement> > _baseline;
+      double _threshold;
+      std::string _error;
+    };
+
+    inline void record(const std::string& name,
+                       const std::vector<measurement>& m) {
+      report::instance().add(name,m);
+    }
+
+  } // namespace benchmark
+} // namespace anpi
+
+#endif
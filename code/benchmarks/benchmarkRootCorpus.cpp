@@ -0,0 +1,291 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Throughput and robustness of the root finders over a large seeded
+ * corpus of generated equations (see EquationCorpus.hpp).
+ *
+ * The number of equations defaults to 10^5 and can be changed with the
+ * environment variable ANPI_CORPUS_SIZE.
+ *
+ * The "auto" row solves each equation with rootAuto(), using the method
+ * the autotuner chose for its family on another corpus.  The decisions
+ * are kept in the profile named by ANPI_AUTOTUNE_PROFILE, if set.
+ */
+#include "benchmarkFramework.hpp"
+
+#include "EquationCorpus.hpp"
+#include "Exception.hpp"
+
+#include "RootAuto.hpp"
+#include "RootBisection.hpp"
+#include "RootInterpolation.hpp"
+#include "RootSecant.hpp"
+#include "RootBrent.hpp"
+#include "RootNewtonRaphson.hpp"
+#include "RootRidder.hpp"
+
+BOOST_AUTO_TEST_SUITE( RootCorpus )
+
+/**
+ * Wraps a generated equation counting its evaluations, and throwing
+ * once the evaluation budget of one solve is exhausted, since the open
+ * methods have no iteration limit.
+ */
+template<typename T>
+class corpusCounter {
+public:
+  corpusCounter(const anpi::equation<T>& e,size_t* counter,
+                const size_t budget)
+    : _e(e),_counter(counter),_budget(budget) {}
+
+  T operator()(const T x) const {
+    if (++(*_counter) > _budget) {
+      throw anpi::Exception("Evaluation budget exhausted");
+    }
+    return _e(x);
+  }
+private:
+  anpi::equation<T> _e;
+  size_t* _counter;
+  size_t _budget;
+};
+
+/// Outcome of one solver over the corpus
+struct corpusResult {
+  /// Evaluations of each solve
+  std::vector<double> evaluations;
+  /// Failures and solves per family
+  size_t failures[anpi::NumEquationFamilies];
+  size_t solves[anpi::NumEquationFamilies];
+  /// Wall time of the whole corpus
+  double seconds;
+};
+
+/**
+ * Solve the equations with the given solver, in parallel if OpenMP is
+ * available.  They are generated beforehand, so that only the solves
+ * are timed.  The solver receives the equation,
+ * to pick its bracket or starting point, and the counted function.
+ *
+ * A solve fails if it throws (also when the evaluation budget is
+ * exhausted), returns a non-finite value, or lands farther than
+ * 100*eps*max(1,|x|) from every known root.
+ */
+template<typename T>
+corpusResult solveCorpus(const std::function<T(const anpi::equation<T>&,
+                                               const std::function<T(T)>&,
+                                               const T)>& solver,
+                         const std::vector<anpi::equation<T> >& equations,
+                         const T eps,
+                         const size_t budget) {
+  const long n = long(equations.size());
+  corpusResult res;
+  res.evaluations.resize(size_t(n));
+  std::vector<char> failed(static_cast<size_t>(n));
+
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point start = clock::now();
+
+#pragma omp parallel for schedule(dynamic,256)
+  for (long i=0;i<n;++i) {
+    const anpi::equation<T>& e = equations[size_t(i)];
+    size_t counter = 0u;
+    const std::function<T(T)> f(corpusCounter<T>(e,&counter,budget));
+
+    const T x = anpi::detail::solveOrNaN<T>([&]() {
+        return solver(e,f,eps);
+      });
+    const bool ok = std::isfinite(x) &&
+      (e.distance(x) <= T(100)*eps*std::max(T(1),std::abs(x)));
+
+    res.evaluations[size_t(i)] = double(counter);
+    failed[size_t(i)] = ok ? 0 : 1;
+  }
+
+  const std::chrono::duration<double> d = clock::now() - start;
+  res.seconds = d.count();
+
+  for (int f=0;f<anpi::NumEquationFamilies;++f) {
+    res.failures[f] = res.solves[f] = 0u;
+  }
+  for (long i=0;i<n;++i) {
+    const int f = int(uint64_t(i) % uint64_t(anpi::NumEquationFamilies));
+    ++res.solves[f];
+    res.failures[f] += size_t(failed[size_t(i)]);
+  }
+
+  return res;
+}
+
+/**
+ * Print the evaluation count distribution, failure rates and roots per
+ * second of one solver, and record it in the report.
+ */
+inline void printResult(const std::string& name,
+                        const std::string& type,
+                        corpusResult& res) {
+  std::vector<double>& ev = res.evaluations;
+  std::sort(ev.begin(),ev.end());
+
+  size_t failures = 0u;
+  for (int f=0;f<anpi::NumEquationFamilies;++f) {
+    failures += res.failures[f];
+  }
+  const size_t n = ev.size();
+  double sum = 0.;
+  for (const double e : ev) sum += e;
+
+  using anpi::benchmark::percentile;
+
+  std::cout << std::left << std::setw(14) << name << std::right
+            << std::fixed << std::setprecision(1)
+            << std::setw(6)  << ev.front()
+            << std::setw(7)  << percentile(ev,0.5)
+            << std::setw(7)  << percentile(ev,0.9)
+            << std::setw(7)  << percentile(ev,0.99)
+            << std::setw(8)  << ev.back()
+            << std::setw(8)  << sum/double(n)
+            << std::setprecision(2)
+            << std::setw(9)  << 100.*double(failures)/double(n)
+            << std::setprecision(0)
+            << std::setw(12) << double(n-failures)/res.seconds;
+  for (int f=0;f<anpi::NumEquationFamilies;++f) {
+    std::cout << std::setprecision(1) << std::setw(8)
+              << 100.*double(res.failures[f])/double(res.solves[f]);
+  }
+  std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+
+  anpi::benchmark::measurement m;
+  m.size    = n;
+  m.samples = 1u;
+  m.batch   = 1u;
+  m.average = m.median = m.min = m.max = res.seconds;
+  m.p05 = m.p25 = m.p75 = m.p95 = m.ciLow = m.ciHigh = res.seconds;
+  m.roots   = double(n-failures);
+  m.rootsPerSecond = m.roots/res.seconds;
+
+  ::anpi::benchmark::record("root_corpus_" + name + "_" + type,
+                            std::vector<anpi::benchmark::measurement>(1,m));
+}
+
+/// Run all solvers over the corpus
+template<typename T>
+void solveAll(const T eps) {
+  long n = 100000;
+  const char* env = std::getenv("ANPI_CORPUS_SIZE");
+  if ((env != 0) && (std::atol(env) > 0)) {
+    n = std::atol(env);
+  }
+
+  const anpi::equationCorpus<T> corpus(2018u);
+  std::vector<anpi::equation<T> > equations(static_cast<size_t>(n));
+  for (long i=0;i<n;++i) {
+    equations[size_t(i)] = corpus[uint64_t(i)];
+  }
+  const size_t budget = 1000u;
+  const std::string type = (sizeof(T) == sizeof(float)) ? "float" : "double";
+
+  typedef std::function<T(T)> f_type;
+  typedef std::function<T(const f_type&,T,T,const T)> closed_type;
+  typedef std::function<T(const f_type&,T,const T)> open_type;
+
+  std::cout << n << " equations (" << type << ", eps=" << eps
+            << ", budget " << budget << " evaluations)" << std::endl;
+  std::cout << "              ----------- evaluations -----------"
+            << "  fail%     roots/s  failure% per family" << std::endl;
+  std::cout << "method         min    p50    p90    p99     max    mean"
+            << "                  ";
+  for (int f=0;f<anpi::NumEquationFamilies;++f) {
+    std::cout << std::setw(8)
+              << std::string(anpi::equationFamilyName(anpi::EquationFamily(f)))
+                   .substr(0,7);
+  }
+  std::cout << std::endl;
+
+  const closed_type closedSolvers[] = {
+    anpi::rootBisection<T>, anpi::rootInterpolation<T>,
+    anpi::rootSecant<T>,    anpi::rootBrent<T>, anpi::rootRidder<T>
+  };
+  const char* closedNames[] = {
+    "bisection","interpolation","secant","brent","ridder"
+  };
+
+  for (int s=0;s<5;++s) {
+    const closed_type closed = closedSolvers[s];
+    corpusResult res =
+      solveCorpus<T>([closed](const anpi::equation<T>& e,const f_type& f,
+                              const T eps) {
+                       return closed(f,e.a,e.b,eps);
+                     },equations,eps,budget);
+    printResult(closedNames[s],type,res);
+  }
+
+  const open_type open = anpi::rootNewtonRaphson<T>;
+  corpusResult res =
+    solveCorpus<T>([open](const anpi::equation<T>& e,const f_type& f,
+                          const T eps) {
+                     return open(f,e.x0,eps);
+                   },equations,eps,budget);
+  printResult("newton",type,res);
+
+  // calibrate each family on 64 equations of another corpus
+  const char* path = std::getenv("ANPI_AUTOTUNE_PROFILE");
+  anpi::autotuneProfile profile = path ? anpi::autotuneProfile(path) :
+                                         anpi::autotuneProfile();
+  const anpi::equationCorpus<T> calibration(1u);
+  std::vector<anpi::tuningDecision> decisions;
+  for (int fam=0;fam<anpi::NumEquationFamilies;++fam) {
+    std::vector<anpi::tuningSample<T> > samples;
+    for (uint64_t i=uint64_t(fam);samples.size()<64u;
+         i+=anpi::NumEquationFamilies) {
+      const anpi::equation<T> e = calibration[i];
+      anpi::tuningSample<T> p;
+      p.f = e;
+      p.a = e.a;
+      p.b = e.b;
+      samples.push_back(p);
+    }
+    decisions.push_back(profile.decide<T>(
+      "corpus-" + type + "-" +
+      anpi::equationFamilyName(anpi::EquationFamily(fam)),samples,eps));
+  }
+  res = solveCorpus<T>([&decisions](const anpi::equation<T>& e,
+                                    const f_type& f,const T eps) {
+                         return anpi::rootAuto<T>(f,e.a,e.b,eps,
+                                                  decisions[e.family]);
+                       },equations,eps,budget);
+  printResult("auto",type,res);
+  std::cout << "auto methods:";
+  for (int fam=0;fam<anpi::NumEquationFamilies;++fam) {
+    std::cout << ' ' << anpi::equationFamilyName(anpi::EquationFamily(fam))
+              << '=' << anpi::rootMethodName(decisions[size_t(fam)].method);
+  }
+  std::cout << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( Float ) {
+  solveAll<float>(1.e-5f);
+}
+
+BOOST_AUTO_TEST_CASE( Double ) {
+  solveAll<double>(1.e-10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -13,7 +13,7 @@
 #include <exception>
 #include <vector>
 #include <complex>
-#include <PlotPy.hpp>
+#include <Plot.hpp>
 
 #include "Exception.hpp"
 
@@ -28,6 +28,7 @@
 #include "RootRidder.hpp"
 
 #include "Allocator.hpp"
+#include "Instrumentation.hpp"
 
 namespace anpi
 {
@@ -71,48 +72,6 @@ T t4(const T x)
   return cube(x0) + T(0.01) * x0;
 }
 
-/**
-     * Wrapper class to count function calls
-     *
-     * This wrapper fulfills the requirements to act as a
-     * std::function<T(T)>, and it simply counts the number
-     * of calls made to the operator(), before calling
-     * the functor provided at construction time.
-     */
-template <typename T>
-class CallCounter
-{
-protected:
-  /// Maximum allowed size for the square matrices
-  mutable size_t _counter;
-
-  std::function<T(T)> _f;
-
-public:
-  /// Construct
-  CallCounter(std::function<T(T)> f) : _counter(0u), _f(f) {}
-
-  /// Access the counter
-  inline size_t counter() const { return _counter; }
-
-  /// Reset the counter
-  inline void reset() { _counter = 0u; }
-
-  /// Call the function
-  T operator()(const T x)
-  {
-    ++_counter;
-    return _f(x);
-  }
-
-  /// Call the function
-  T operator()(const T x) const
-  {
-    ++_counter;
-    return _f(x);
-  }
-};
-
 /**
      * Test the given _closed_ root finder
      *
@@ -141,34 +100,30 @@ void rootBench(const std::function<T(const std::function<T(T)> &,
     throw anpi::Exception("Invalid factor.  It must be between 0 and 1");
   }
 
-  // Alias of the function type, for which the roots are being looked for.
-  typedef std::function<T(T)> f_type;
-
   // Try a series of tolerances
   for (T eps = start; eps > end; eps *= factor)
   {
     std::cout << "eps=" << eps << "; ";
 
-    // Create an std::function instance, which wraps the function
-    // t1 with the function counter
-    f_type c1(CallCounter<T>(t1<T>));
+    // Wrap the function t1 counting its evaluations
+    anpi::instrumented<T> c1(t1<T>);
     solver(c1, T(0), T(2), eps);
-    std::cout << c1.template target<CallCounter<T>>()->counter() << "; ";
+    std::cout << c1.evaluations() << "; ";
 
     // now the same with function t2
-    f_type c2(CallCounter<T>(t2<T>));
+    anpi::instrumented<T> c2(t2<T>);
     solver(c2, T(0), T(2), eps);
-    std::cout << c2.template target<CallCounter<T>>()->counter() << "; ";
+    std::cout << c2.evaluations() << "; ";
 
     // now the same with function t3
-    f_type c3(CallCounter<T>(t3<T>));
+    anpi::instrumented<T> c3(t3<T>);
     solver(c3, T(0), T(0.5), eps);
-    std::cout << c3.template target<CallCounter<T>>()->counter() << "; ";
+    std::cout << c3.evaluations() << "; ";
 
     // now the same with function t4
-    f_type c4(CallCounter<T>(t4<T>));
+    anpi::instrumented<T> c4(t4<T>);
     solver(c4, T(1), T(3), eps);
-    std::cout << c4.template target<CallCounter<T>>()->counter() << std::endl;
+    std::cout << c4.evaluations() << std::endl;
   }
 }
 
@@ -194,34 +149,30 @@ void rootBench(const std::function<T(const std::function<T(T)> &,
     throw anpi::Exception("Invalid factor.  It must be between 0 and 1");
   }
 
-  // Alias of the function type, for which the roots are being looked for.
-  typedef std::function<T(T)> f_type;
-
   // Try a series of tolerances
   for (T eps = start; eps > end; eps *= factor)
   {
     std::cout << "eps=" << eps << "; ";
 
-    // Create an std::function instance, which wraps the function
-    // t1 with the function counter
-    f_type c1(CallCounter<T>(t1<T>));
+    // Wrap the function t1 counting its evaluations
+    anpi::instrumented<T> c1(t1<T>);
     solver(c1, T(0), eps);
-    std::cout << c1.template target<CallCounter<T>>()->counter() << "; ";
+    std::cout << c1.evaluations() << "; ";
 
     // now the same with function t2
-    f_type c2(CallCounter<T>(t2<T>));
+    anpi::instrumented<T> c2(t2<T>);
     solver(c2, T(2), eps);
-    std::cout << c2.template target<CallCounter<T>>()->counter() << "; ";
+    std::cout << c2.evaluations() << "; ";
 
     // now the same with function t3
-    f_type c3(CallCounter<T>(t3<T>));
+    anpi::instrumented<T> c3(t3<T>);
     solver(c3, T(0), eps);
-    std::cout << c3.template target<CallCounter<T>>()->counter() << "; ";
+    std::cout << c3.evaluations() << "; ";
 
     // now the same with function t4
-    f_type c4(CallCounter<T>(t4<T>));
+    anpi::instrumented<T> c4(t4<T>);
     solver(c4, T(1), eps);
-    std::cout << c4.template target<CallCounter<T>>()->counter() << std::endl;
+    std::cout << c4.evaluations() << std::endl;
   }
 }
 
@@ -291,8 +242,6 @@ void rootBench(const std::function<T(const std::function<T(T)> &,
     throw anpi::Exception("Invalid factor.  It must be between 0 and 1");
   }
 
-  // Alias of the function type, for which the roots are being looked for.
-  typedef std::function<T(T)> f_type;
 
   //plot points for each test function
   plotPoints plot_t1, plot_t2, plot_t3, plot_t4;
@@ -306,35 +255,34 @@ void rootBench(const std::function<T(const std::function<T(T)> &,
   {
     //std::cout << "eps=" << eps << "; ";
 
-    // Create an std::function instance, which wraps the function
-    // t1 with the function counter
-    f_type c1(CallCounter<T>(t1<T>));
+    // Wrap the function t1 counting its evaluations
+    anpi::instrumented<T> c1(t1<T>);
     solver(c1, T(0), T(2), eps);
-    functCallCount = c1.template target<CallCounter<T>>()->counter();
+    functCallCount = c1.evaluations();
     //add points to plot
     plot_t1.epsilons.push_back(eps);
     plot_t1.functionCalls.push_back(functCallCount);
 
     //now the same with function t2
-    f_type c2(CallCounter<T>(t2<T>));
+    anpi::instrumented<T> c2(t2<T>);
     solver(c2, T(0), T(2), eps);
-    functCallCount = c2.template target<CallCounter<T>>()->counter();
+    functCallCount = c2.evaluations();
     //add points to plot
     plot_t2.epsilons.push_back(eps);
     plot_t2.functionCalls.push_back(functCallCount);
 
     //now the same with function t3
-    f_type c3(CallCounter<T>(t3<T>));
+    anpi::instrumented<T> c3(t3<T>);
     solver(c3, T(0), T(0.5), eps);
-    functCallCount = c3.template target<CallCounter<T>>()->counter();
+    functCallCount = c3.evaluations();
     //add points to plot
     plot_t3.epsilons.push_back(eps);
     plot_t3.functionCalls.push_back(functCallCount);
 
     //now the same with function t4
-    f_type c4(CallCounter<T>(t4<T>));
+    anpi::instrumented<T> c4(t4<T>);
     solver(c4, T(1), T(3), eps);
-    functCallCount = c4.template target<CallCounter<T>>()->counter();
+    functCallCount = c4.evaluations();
     //add points to plot
     plot_t4.epsilons.push_back(eps);
     plot_t4.functionCalls.push_back(functCallCount);
@@ -375,8 +323,6 @@ void rootBench(const std::function<T(const std::function<T(T)> &,
     throw anpi::Exception("Invalid factor.  It must be between 0 and 1");
   }
 
-  // Alias of the function type, for which the roots are being looked for.
-  typedef std::function<T(T)> f_type;
 
   //plot points for each test function
   plotPoints plot_t1, plot_t2, plot_t3, plot_t4;
@@ -388,35 +334,34 @@ void rootBench(const std::function<T(const std::function<T(T)> &,
   for (T eps = start; eps > end; eps *= factor)
   {
 
-    // Create an std::function instance, which wraps the function
-    // t1 with the function counter
-    f_type c1(CallCounter<T>(t1<T>));
+    // Wrap the function t1 counting its evaluations
+    anpi::instrumented<T> c1(t1<T>);
     solver(c1, T(0), eps);
-    functCallCount = c1.template target<CallCounter<T>>()->counter();
+    functCallCount = c1.evaluations();
     //add points to plot
     plot_t1.epsilons.push_back(eps);
     plot_t1.functionCalls.push_back(functCallCount);
 
     // now the same with function t2
-    f_type c2(CallCounter<T>(t2<T>));
+    anpi::instrumented<T> c2(t2<T>);
     solver(c2, T(2), eps);
-    functCallCount = c2.template target<CallCounter<T>>()->counter();
+    functCallCount = c2.evaluations();
     //add points to plot
     plot_t2.epsilons.push_back(eps);
     plot_t2.functionCalls.push_back(functCallCount);
 
     // now the same with function t3
-    f_type c3(CallCounter<T>(t3<T>));
+    anpi::instrumented<T> c3(t3<T>);
     solver(c3, T(0), eps);
-    functCallCount = c3.template target<CallCounter<T>>()->counter();
+    functCallCount = c3.evaluations();
     //add points to plot
     plot_t3.epsilons.push_back(eps);
     plot_t3.functionCalls.push_back(functCallCount);
 
     // now the same with function t4
-    f_type c4(CallCounter<T>(t4<T>));
+    anpi::instrumented<T> c4(t4<T>);
     solver(c4, T(1), eps);
-    functCallCount = c4.template target<CallCounter<T>>()->counter();
+    functCallCount = c4.evaluations();
     //add points to plot
     plot_t4.epsilons.push_back(eps);
     plot_t4.functionCalls.push_back(functCallCount);
@@ -0,0 +1,366 @@
+/**
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Wall-clock timing of the root finders
+ */
+#include "benchmarkFramework.hpp"
+
+#include "Exception.hpp"
+
+#include "RootBisection.hpp"
+#include "RootInterpolation.hpp"
+#include "RootSecant.hpp"
+#include "RootBrent.hpp"
+#include "RootNewtonRaphson.hpp"
+#include "RootRidder.hpp"
+
+BOOST_AUTO_TEST_SUITE( RootFinderTiming )
+
+// local to this file: benchmarkRootFinders.cpp has its own t1 to t4
+namespace {
+
+/// One root finding problem: the function, a bracket and a start point
+template<typename T>
+struct problem {
+  const char* name;
+  T (*f)(const T);
+  T a;
+  T b;
+  T x0;
+};
+
+/*
+ * The test functions of the homework
+ */
+template<typename T>
+T t1(const T x) { return std::abs(x) - std::exp(-x); }
+
+template<typename T>
+T t2(const T x) {
+  return std::exp(-x*x) - std::exp(-(x-T(3))*(x-T(3))/T(3));
+}
+
+template<typename T>
+T t3(const T x) { return x*x - std::atan(x); }
+
+template<typename T>
+T t4(const T x) {
+  const T x0 = x - T(2);
+  return x0*x0*x0 + T(0.01)*x0;
+}
+
+/*
+ * A larger corpus of smooth functions with a single root in the bracket
+ */
+template<typename T>
+T c1(const T x) { return x*x*x - T(2)*x - T(5); }
+template<typename T>
+T c2(const T x) { return std::cos(x) - x; }
+template<typename T>
+T c3(const T x) { return std::exp(x) - T(3); }
+template<typename T>
+T c4(const T x) { return std::log(x) + x; }
+template<typename T>
+T c5(const T x) { return x*x*x*x*x - x - T(1); }
+template<typename T>
+T c6(const T x) { return std::sin(x) - x/T(2); }
+template<typename T>
+T c7(const T x) { return std::tanh(x - T(1)); }
+template<typename T>
+T c8(const T x) { return x*std::exp(x) - T(1); }
+template<typename T>
+T c9(const T x) { return std::atan(x) - T(0.5); }
+template<typename T>
+T c10(const T x) { return x*x - T(2); }
+template<typename T>
+T c11(const T x) { return std::exp(-x) - x; }
+template<typename T>
+T c12(const T x) { return T(1)/x - T(2); }
+
+/// The homework problems, with the brackets and starts of benchmarkRootFinders
+template<typename T>
+std::vector< problem<T> > homework() {
+  return std::vector< problem<T> >{
+    { "t1", t1<T>, T(0), T(2),   T(0) },
+    { "t2", t2<T>, T(0), T(2),   T(2) },
+    { "t3", t3<T>, T(0), T(0.5), T(0) },
+    { "t4", t4<T>, T(1), T(3),   T(1) }
+  };
+}
+
+/// The larger corpus
+template<typename T>
+std::vector< problem<T> > corpus() {
+  std::vector< problem<T> > p = homework<T>();
+  const std::vector< problem<T> > c = {
+    { "c1",  c1<T>,  T(2),   T(3),   T(2)   },
+    { "c2",  c2<T>,  T(0),   T(1),   T(0.5) },
+    { "c3",  c3<T>,  T(0),   T(2),   T(1)   },
+    { "c4",  c4<T>,  T(0.1), T(1),   T(0.5) },
+    { "c5",  c5<T>,  T(1),   T(2),   T(1.2) },
+    { "c6",  c6<T>,  T(1.5), T(2.5), T(2)   },
+    { "c7",  c7<T>,  T(0),   T(3),   T(0.8) },
+    { "c8",  c8<T>,  T(0),   T(1),   T(0.5) },
+    { "c9",  c9<T>,  T(0),   T(1),   T(0.5) },
+    { "c10", c10<T>, T(1),   T(2),   T(1.5) },
+    { "c11", c11<T>, T(0),   T(1),   T(0.5) },
+    { "c12", c12<T>, T(0.1), T(1),   T(0.4) }
+  };
+  p.insert(p.end(),c.begin(),c.end());
+  return p;
+}
+
+/**
+ * Wraps a test function counting its evaluations.
+ *
+ * The open methods have no iteration limit, so that the wrapper throws
+ * once the evaluation budget of one solve is exhausted.  If requested,
+ * the evaluated positions are recorded.
+ */
+template<typename T>
+class budgetCounter {
+public:
+  budgetCounter(T (*f)(const T),size_t* counter,const size_t budget,
+                std::vector<T>* record = 0)
+    : _f(f),_counter(counter),_budget(budget),_record(record) {}
+
+  T operator()(const T x) const {
+    if (++(*_counter) > _budget) {
+      throw anpi::Exception("Evaluation budget exhausted");
+    }
+    if (_record) {
+      _record->push_back(x);
+    }
+    return _f(x);
+  }
+private:
+  T (*_f)(const T);
+  size_t* _counter;
+  size_t _budget;
+  std::vector<T>* _record;
+};
+
+/**
+ * Solve all problems of a set with one solver and tolerance.  The
+ * "size" of the harness is the number of decimal digits of the
+ * tolerance, i.e. eps = 10^-size.
+ */
+template<typename T>
+class benchSolve {
+public:
+  typedef std::function<T(T)> f_type;
+  typedef std::function<T(const f_type&,T,T,const T)> closed_type;
+  typedef std::function<T(const f_type&,T,const T)> open_type;
+
+  /// Maximum number of evaluations per solve
+  static const size_t Budget = 10000u;
+
+  benchSolve(const closed_type& solver,const std::vector< problem<T> >& p)
+    : _closed(solver),_problems(p),_eps(T(0)),_counter(0u),
+      _evaluations(0u),_failures(0u),_sink(T(0)) {}
+
+  benchSolve(const open_type& solver,const std::vector< problem<T> >& p)
+    : _open(solver),_problems(p),_eps(T(0)),_counter(0u),
+      _evaluations(0u),_failures(0u),_sink(T(0)) {}
+
+  /// Set the tolerance, and record one solve of each problem
+  void prepare(const size_t digits) {
+    _eps = T(std::pow(10.,-double(digits)));
+
+    _points.assign(_problems.size(),std::vector<T>());
+    _evaluations = 0u;
+    _failures    = 0u;
+    for (size_t i=0;i<_problems.size();++i) {
+      f_type rec(budgetCounter<T>(_problems[i].f,&_counter,Budget,
+                                  &_points[i]));
+      solve(i,rec);
+    }
+
+    _functions.clear();
+    for (const auto& p : _problems) {
+      _functions.push_back(f_type(budgetCounter<T>(p.f,&_counter,Budget)));
+    }
+  }
+
+  /// Solve all problems
+  inline void eval() {
+    for (size_t i=0;i<_problems.size();++i) {
+      solve(i,_functions[i]);
+    }
+  }
+
+  /// One root per problem
+  double roots() const { return double(_problems.size()); }
+
+  /// Function evaluations of one eval(), as recorded in prepare()
+  size_t evaluations() const { return _evaluations; }
+
+  /// Solves that failed (exception, exhausted budget or NaN) in prepare()
+  size_t failures() const { return _failures; }
+
+  /// Problems solved
+  const std::vector< problem<T> >& problems() const { return _problems; }
+
+  /// Positions evaluated for each problem in prepare()
+  const std::vector< std::vector<T> >& points() const { return _points; }
+
+private:
+  /// Solve one problem, counting evaluations and failures
+  inline void solve(const size_t i,const f_type& f) {
+    const problem<T>& p = _problems[i];
+    _counter = 0u;
+    const T x = anpi::detail::solveOrNaN<T>([&]() {
+        return _closed ? _closed(f,p.a,p.b,_eps) : _open(f,p.x0,_eps);
+      });
+    if (std::isnan(x)) {
+      ++_failures;
+    } else {
+      _sink += x;
+    }
+    _evaluations += _counter;
+  }
+
+  closed_type _closed;
+  open_type _open;
+  std::vector< problem<T> > _problems;
+  std::vector<f_type> _functions;
+  std::vector< std::vector<T> > _points;
+  T _eps;
+
+  size_t _counter;
+  size_t _evaluations;
+  size_t _failures;
+  volatile T _sink;
+};
+
+/**
+ * Evaluate the test functions directly, at the positions recorded by a
+ * solve bench, to time the pure evaluation cost of the same solves.
+ */
+template<typename T>
+class benchEvaluate {
+public:
+  benchEvaluate(const benchSolve<T>& solve) : _solve(solve),_sink(T(0)) {}
+
+  void prepare(const size_t) {
+    _f.clear();
+    _x.clear();
+    for (size_t i=0;i<_solve.problems().size();++i) {
+      for (const T x : _solve.points()[i]) {
+        _f.push_back(_solve.problems()[i].f);
+        _x.push_back(x);
+      }
+    }
+  }
+
+  inline void eval() {
+    T acc(0);
+    for (size_t i=0;i<_x.size();++i) {
+      acc += _f[i](_x[i]);
+    }
+    _sink = acc;
+  }
+
+private:
+  const benchSolve<T>& _solve;
+  std::vector<T (*)(const T)> _f;
+  std::vector<T> _x;
+  volatile T _sink;
+};
+
+/**
+ * Time one solver on one problem set for all tolerances, and print
+ * ns per solve, ns per evaluation and the solver overhead per solve.
+ */
+template<typename T,class Solver>
+void timeSolver(const std::string& name,
+                const Solver& solver,
+                const std::string& set,
+                const std::vector< problem<T> >& problems,
+                const std::vector<size_t>& digits,
+                ::anpi::benchmark::harness& runner) {
+  benchSolve<T> solve(solver,problems);
+  benchEvaluate<T> evaluate(solve);
+
+  const std::string type = (sizeof(T) == sizeof(float)) ? "float" : "double";
+  std::vector<anpi::benchmark::measurement> ts(digits.size());
+  std::vector<anpi::benchmark::measurement> te(digits.size());
+
+  std::cout << name << " (" << set << ", " << type << ")" << std::endl;
+  for (size_t d=0;d<digits.size();++d) {
+    runner.run(digits[d],solve,ts[d]);
+    runner.run(digits[d],evaluate,te[d]);
+  }
+
+  std::cout << "  eps     ns/solve  ns/eval  eval ns/solve  "
+            << "overhead ns/solve  failures" << std::endl;
+  const double solves = double(problems.size());
+  for (size_t d=0;d<digits.size();++d) {
+    // harness runs are interleaved: redo prepare to get the counts
+    solve.prepare(digits[d]);
+    const double evals = double(std::max(size_t(1),solve.evaluations()));
+    std::cout << "  1e-" << std::left << std::setw(4) << digits[d]
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9)  << 1.e9*ts[d].median/solves
+              << std::setw(9)  << 1.e9*ts[d].median/evals
+              << std::setw(15) << 1.e9*te[d].median/solves
+              << std::setw(19) << 1.e9*(ts[d].median-te[d].median)/solves
+              << std::setw(10) << solve.failures()
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+  }
+
+  ::anpi::benchmark::record("root_solve_" + name + "_" + set + "_" + type,ts);
+  ::anpi::benchmark::record("root_eval_"  + name + "_" + set + "_" + type,te);
+}
+
+/// Time all solvers on both problem sets
+template<typename T>
+void timeAllSolvers(const std::vector<size_t>& digits) {
+  ::anpi::benchmark::harness runner(0.05,10,50);
+
+  const std::vector< problem<T> > sets[2] = { homework<T>(), corpus<T>() };
+  const char* names[2] = { "t1-t4", "corpus" };
+
+  for (int s=0;s<2;++s) {
+    typedef typename benchSolve<T>::closed_type closed_type;
+    typedef typename benchSolve<T>::open_type open_type;
+    timeSolver<T>("bisection",closed_type(anpi::rootBisection<T>),
+                  names[s],sets[s],digits,runner);
+    timeSolver<T>("interpolation",closed_type(anpi::rootInterpolation<T>),
+                  names[s],sets[s],digits,runner);
+    timeSolver<T>("secant",closed_type(anpi::rootSecant<T>),
+                  names[s],sets[s],digits,runner);
+    timeSolver<T>("newton",open_type(anpi::rootNewtonRaphson<T>),
+                  names[s],sets[s],digits,runner);
+    timeSolver<T>("brent",closed_type(anpi::rootBrent<T>),
+                  names[s],sets[s],digits,runner);
+    timeSolver<T>("ridder",closed_type(anpi::rootRidder<T>),
+                  names[s],sets[s],digits,runner);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( Float ) {
+  timeAllSolvers<float>({1,2,3,4,5,6});
+}
+
+BOOST_AUTO_TEST_CASE( Double ) {
+  timeAllSolvers<double>({1,2,3,4,5,6,7,8,9,10,11,12,13,14});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
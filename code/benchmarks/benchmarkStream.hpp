@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#ifndef ANPI_BENCHMARK_STREAM_HPP
+#define ANPI_BENCHMARK_STREAM_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#ifdef __linux__
+#  include <unistd.h>
+#endif
+
+namespace anpi {
+  namespace benchmark {
+
+    /**
+     * STREAM-like probe of the memory bandwidth ceiling.
+     *
+     * Runs the triad a[i] = b[i] + s*c[i] over three arrays, each at
+     * least four times larger than the last level cache, and returns
+     * the best bandwidth in GB/s (1e9 bytes per second) out of the
+     * given number of trials.  As in STREAM, only the three explicit
+     * accesses per element are counted.  With OpenMP the probe uses all
+     * threads, initializing the arrays in parallel so that the pages are
+     * distributed as the computation uses them.
+     */
+    inline double streamTriad(const int trials = 10) {
+      size_t bytes = size_t(32) << 20;
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+      const long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+      if (llc > 0) {
+        bytes = std::max(bytes,size_t(4*llc));
+      }
+#endif
+      const long n = long(bytes/sizeof(double));
+
+      double* a = new double[n];
+      double* b = new double[n];
+      double* c = new double[n];
+
+#pragma omp parallel for schedule(static)
+      for (long i=0;i<n;++i) {
+        a[i]=0.;
+        b[i]=1.;
+        c[i]=2.;
+      }
+
+      const double s = 3.;
+      double best = 0.;
+      for (int t=0;t<trials;++t) {
+        const auto start = std::chrono::steady_clock::now();
+#pragma omp parallel for schedule(static)
+        for (long i=0;i<n;++i) {
+          a[i] = b[i] + s*c[i];
+        }
+        const std::chrono::duration<double> d =
+          std::chrono::steady_clock::now() - start;
+        const double gbs = 3.*double(n)*sizeof(double)/d.count()/1.e9;
+        best = std::max(best,gbs);
+      }
+
+      // keep the results alive
+      volatile double sink = a[n/2];
+      (void)sink;
+
+      delete[] a;
+      delete[] b;
+      delete[] c;
+
+      return best;
+    }
+
+    /// Cached peak bandwidth in GB/s, or a negative value if unknown
+    inline double& peakBandwidthCache() {
+      static double peak = -1.;
+      return peak;
+    }
+
+    /**
+     * Peak memory bandwidth of this machine, in GB/s.
+     *
+     * It is probed with streamTriad() on the first call, unless the
+     * environment variable ANPI_BENCHMARK_PEAK_BW provides it.
+     */
+    inline double peakBandwidth() {
+      double& peak = peakBandwidthCache();
+      if (peak < 0.) {
+        const char* env = std::getenv("ANPI_BENCHMARK_PEAK_BW");
+        if ((env != 0) && (std::atof(env) > 0.)) {
+          peak = std::atof(env);
+        } else {
+          std::cout << "Probing memory bandwidth (STREAM triad)... "
+                    << std::flush;
+          peak = streamTriad();
+          std::cout << peak << " GB/s" << std::endl;
+        }
+      }
+      return peak;
+    }
+
+  } // namespace benchmark
+} // namespace anpi
+
+#endif
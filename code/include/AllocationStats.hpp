@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_ALLOCATION_STATS_HPP
+#define ANPI_ALLOCATION_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+
+#include <AnpiConfig.hpp>
+
+namespace anpi {
+
+  /**
+   * Process-wide counters of heap allocations.
+   *
+   * Two sources are distinguished: the anpi allocators used by Matrix
+   * (see Allocator.hpp) and the global operator new, which also covers
+   * std::allocator and the state of std::function objects.  The number
+   * of bytes currently alive and its peak are shared by both sources.
+   *
+   * The allocators report to these counters only if the project was
+   * configured with ANPI_ENABLE_ALLOCATION_STATS.  The operator new hook
+   * is part of the benchmark executable, see benchmarkAllocations.cpp.
+   */
+  class allocationStats {
+  public:
+    /// Sources of allocations
+    enum source {
+      Heap = 0,
+      Anpi,
+      NumSources
+    };
+
+    /// Copy of the counters at one point in time
+    struct snapshot {
+      size_t allocations[NumSources];
+      size_t deallocations[NumSources];
+      size_t bytes[NumSources];
+      /// Bytes allocated and not yet released
+      size_t current;
+      /// Maximum of current since the last resetPeak()
+      size_t peak;
+    };
+
+    /// True if the anpi allocators were built with the counters
+    static constexpr bool enabled() {
+#ifdef ANPI_ENABLE_ALLOCATION_STATS
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    /// Counters of this process
+    static allocationStats& instance() {
+      static allocationStats stats;
+      return stats;
+    }
+
+    /// Count an allocation of the given number of bytes
+    void allocated(const source src,const size_t bytes) {
+      _allocations[src].fetch_add(1u,std::memory_order_relaxed);
+      _bytes[src].fetch_add(bytes,std::memory_order_relaxed);
+      const size_t now =
+        _current.fetch_add(bytes,std::memory_order_relaxed) + bytes;
+      size_t peak = _peak.load(std::memory_order_relaxed);
+      while ((now > peak) &&
+             !_peak.compare_exchange_weak(peak,now,
+                                          std::memory_order_relaxed)) {}
+    }
+
+    /// Count the release of the given number of bytes
+    void freed(const source src,const size_t bytes) {
+      _deallocations[src].fetch_add(1u,std::memory_order_relaxed);
+      _current.fetch_sub(bytes,std::memory_order_relaxed);
+    }
+
+    /// Restart the peak at the bytes currently alive
+    void resetPeak() {
+      _peak.store(_current.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+    }
+
+    /// Bytes currently alive
+    size_t current() const {
+      return _current.load(std::memory_order_relaxed);
+    }
+
+    /// Peak of the bytes alive since the last resetPeak()
+    size_t peak() const {
+      return _peak.load(std::memory_order_relaxed);
+    }
+
+    /// Read all counters
+    snapshot read() const {
+      snapshot s;
+      for (int i=0;i<NumSources;++i) {
+        s.allocations[i]   = _allocations[i].load(std::memory_order_relaxed);
+        s.deallocations[i] = _deallocations[i].load(std::memory_order_relaxed);
+        s.bytes[i]         = _bytes[i].load(std::memory_order_relaxed);
+      }
+      s.current = _current.load(std::memory_order_relaxed);
+      s.peak    = _peak.load(std::memory_order_relaxed);
+      return s;
+    }
+
+  private:
+    allocationStats() : _current(0u),_peak(0u) {
+      for (int i=0;i<NumSources;++i) {
+        _allocations[i]   = 0u;
+        _deallocations[i] = 0u;
+        _bytes[i]         = 0u;
+      }
+    }
+    allocationStats(const allocationStats&);
+    allocationStats& operator=(const allocationStats&);
+
+    std::atomic<size_t> _allocations[NumSources];
+    std::atomic<size_t> _deallocations[NumSources];
+    std::atomic<size_t> _bytes[NumSources];
+    std::atomic<size_t> _current;
+    std::atomic<size_t> _peak;
+  };
+
+} // namespace anpi
+
+#endif
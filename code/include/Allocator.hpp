@@ -12,7 +12,14 @@
 #define ANPI_ALLOCATOR_HPP
 
 #include <boost/align/aligned_allocator.hpp>
+#include <new>
 #include "HasType.hpp"
+#include "AllocationStats.hpp"
+#include "Profiler.hpp"
+
+#if defined(__linux__)
+#  include <sys/mman.h>
+#endif
 
 namespace anpi {
 
@@ -38,19 +45,49 @@ namespace anpi {
   
   /**
    * Use the boost version of aligned_allocator
+   *
+   * If configured with ANPI_ENABLE_ALLOCATION_STATS, the allocations are
+   * counted in allocationStats; with ANPI_ENABLE_PROFILER they appear
+   * in the trace.
    */
   template<class T, std::size_t Align=DefaultAlignment>
   class aligned_allocator : public boost::alignment::aligned_allocator<T,Align>
   {
+    typedef boost::alignment::aligned_allocator<T,Align> base_type;
   public:
     /// Inherit all constructors
-    using boost::alignment::aligned_allocator<T,Align>::aligned_allocator;
+    using base_type::aligned_allocator;
 
     /// Change the stored type
     template<class U>
     struct rebind {
       typedef aligned_allocator<U, Align> other;
     };
+
+#if defined(ANPI_ENABLE_ALLOCATION_STATS) || defined(ANPI_ENABLE_PROFILER)
+    /// Type of the pointers returned by allocate()
+    typedef typename base_type::pointer pointer;
+
+    /// Reserve memory for n elements of type T
+    pointer allocate(std::size_t n) {
+      ANPI_PROFILE_SCOPE("alloc","allocate");
+      pointer ptr = base_type::allocate(n);
+#  ifdef ANPI_ENABLE_ALLOCATION_STATS
+      allocationStats::instance().allocated(allocationStats::Anpi,
+                                            n*sizeof(T));
+#  endif
+      return ptr;
+    }
+
+    /// Release the memory of n elements at the given position
+    void deallocate(pointer ptr,std::size_t n) {
+      ANPI_PROFILE_SCOPE("alloc","deallocate");
+#  ifdef ANPI_ENABLE_ALLOCATION_STATS
+      allocationStats::instance().freed(allocationStats::Anpi,n*sizeof(T));
+#  endif
+      base_type::deallocate(ptr,n);
+    }
+#endif
   };
 
   /**
@@ -74,6 +111,118 @@ namespace anpi {
   };
 
 
+  /**
+   * Size of the huge pages requested by the huge_page_allocator (2 MB)
+   */
+  static const size_t HugePageSize = size_t(2u) << 20;
+
+  /**
+   * Aligned allocator requesting transparent huge pages for large blocks.
+   *
+   * Blocks of at least HugePageSize bytes are mapped directly with
+   * mmap, first trying explicit huge pages (MAP_HUGETLB) and, if the
+   * system has none reserved, falling back to a normal mapping
+   * advised with MADV_HUGEPAGE.  Smaller blocks, or systems without
+   * mmap, use the plain aligned_allocator.
+   *
+   * The mapped memory is zero-filled by the kernel, but its physical
+   * pages are only assigned at the first write ("first touch").
+   */
+  template<class T, std::size_t Align=DefaultAlignment>
+  class huge_page_allocator : public aligned_allocator<T,Align> {
+  public:
+    /// Inherit all constructors
+    using aligned_allocator<T,Align>::aligned_allocator;
+
+    /// Change the stored type
+    template<class U>
+    struct rebind {
+      typedef huge_page_allocator<U, Align> other;
+    };
+
+    /// Type of the pointers returned by allocate()
+    typedef typename aligned_allocator<T,Align>::pointer pointer;
+
+    /// Reserve memory for n elements of type T
+    pointer allocate(std::size_t n) {
+#if defined(__linux__)
+      const std::size_t bytes = n*sizeof(T);
+      if (bytes >= HugePageSize) {
+        ANPI_PROFILE_SCOPE("alloc","mmap");
+        const std::size_t len = mappedSize(bytes);
+        void* ptr = MAP_FAILED;
+#  if defined(MAP_HUGETLB)
+        ptr = mmap(0,len,PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,-1,0);
+#  endif
+        if (ptr == MAP_FAILED) { // no reserved huge pages: ask for THP
+          ptr = mmap(0,len,PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+          if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+          }
+#  if defined(MADV_HUGEPAGE)
+          madvise(ptr,len,MADV_HUGEPAGE);
+#  endif
+        }
+#  ifdef ANPI_ENABLE_ALLOCATION_STATS
+        allocationStats::instance().allocated(allocationStats::Anpi,bytes);
+#  endif
+        return static_cast<pointer>(ptr);
+      }
+#endif
+      return aligned_allocator<T,Align>::allocate(n);
+    }
+
+    /// Release the memory of n elements at the given position
+    void deallocate(pointer ptr,std::size_t n) {
+#if defined(__linux__)
+      const std::size_t bytes = n*sizeof(T);
+      if (bytes >= HugePageSize) {
+        ANPI_PROFILE_SCOPE("alloc","munmap");
+#  ifdef ANPI_ENABLE_ALLOCATION_STATS
+        allocationStats::instance().freed(allocationStats::Anpi,bytes);
+#  endif
+        munmap(ptr,mappedSize(bytes));
+        return;
+      }
+#endif
+      aligned_allocator<T,Align>::deallocate(ptr,n);
+    }
+
+  private:
+    /// Round up the given number of bytes to an integer number of huge pages
+    static inline std::size_t mappedSize(const std::size_t bytes) {
+      return (bytes + (HugePageSize-1)) & ~(HugePageSize-1);
+    }
+  };
+
+  /**
+   * Row-aligned version of the huge_page_allocator.
+   *
+   * Matrices using this allocator are also initialized in parallel
+   * ("first touch"), so that with a NUMA-aware kernel each memory page
+   * is placed on the node of the thread that later processes its rows.
+   */
+  template<class T, std::size_t Align=DefaultAlignment>
+  class huge_page_row_allocator : public huge_page_allocator<T,Align> {
+  public:
+    /// Inherit all constructors
+    using huge_page_allocator<T,Align>::huge_page_allocator;
+
+    /// Change the stored type
+    template<class U>
+    struct rebind {
+      typedef huge_page_row_allocator<U, Align> other;
+    };
+
+    /// Type to identify this as a row-aligned allocator
+    typedef std::true_type row_aligned;
+
+    /// Type to request parallel first-touch initialization
+    typedef std::true_type first_touch;
+  };
+
   /**
    * Check if a class is an aligned_allocator or an aligned_row_allocator
    */
@@ -94,10 +243,27 @@ namespace anpi {
     static const bool value = true;
   };
 
+  // Specialization for the huge_page_allocator
+  template<typename T, std::size_t A>
+  struct is_aligned_alloc< anpi::huge_page_allocator<T,A> > {
+    static const bool value = true;
+  };
+
+  // Specialization for the huge_page_row_allocator
+  template<typename T, std::size_t A>
+  struct is_aligned_alloc< anpi::huge_page_row_allocator<T,A> > {
+    static const bool value = true;
+  };
+
   /**
    * Create metafunction has_type_row_aligned<T>
    */
   GENERATE_HAS_TYPE(row_aligned);
+
+  /**
+   * Create metafunction has_type_first_touch<T>
+   */
+  GENERATE_HAS_TYPE(first_touch);
   
   /**
    * Extract alignment of an allocator
@@ -113,6 +279,7 @@ namespace anpi {
     static constexpr size_t value       = sizeof(typename Alloc::value_type);
     static constexpr bool   aligned     = false;
     static constexpr bool   row_aligned = false;
+    static constexpr bool   first_touch = false;
   };
 
   /**
@@ -127,6 +294,8 @@ namespace anpi {
     static constexpr bool   aligned     = true;
     static constexpr bool   row_aligned =
       has_type_row_aligned<Alloc<T,Align> >::value;
+    static constexpr bool   first_touch =
+      has_type_first_touch<Alloc<T,Align> >::value;
   };
   
 }
@@ -1 +1,4 @@
 #define ANPI_ENABLE_SIMD
+/* #undef ANPI_ENABLE_PYTHON */
+/* #undef ANPI_ENABLE_ALLOCATION_STATS */
+/* #undef ANPI_ENABLE_PROFILER */
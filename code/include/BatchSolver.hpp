@@ -0,0 +1,981 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_BATCH_SOLVER_HPP
+#define ANPI_BATCH_SOLVER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Checkpoint.hpp"
+#include "ColumnFile.hpp"
+#include "Exception.hpp"
+#include "EquationCorpus.hpp"
+#include "Expression.hpp"
+#include "Profiler.hpp"
+#include "ReorderBuffer.hpp"
+#include "ThreadPool.hpp"
+
+#include "RootBisection.hpp"
+#include "RootInterpolation.hpp"
+#include "RootSecant.hpp"
+#include "RootNewtonRaphson.hpp"
+#include "RootBrent.hpp"
+#include "RootRidder.hpp"
+
+namespace anpi {
+  namespace batch {
+
+    /**
+     * Input format, one problem per line:
+     *
+     *   poly <a> <b> <c0> [<c1> ...]   root of c0 + c1 x + c2 x^2 + ...
+     *                                  in the bracket [a,b]
+     *   corpus <seed> <index>          equation index of the seeded
+     *                                  corpus, see EquationCorpus.hpp
+     *   expr <a> <b> <expression>      root of an expression of x in
+     *                                  [a,b], see Expression.hpp
+     *
+     * Bracketing methods search in [a,b], the secant method starts at a
+     * and b, and Newton-Raphson at the middle of the bracket (or at the
+     * guess x0 of corpus equations).
+     *
+     * Output, one line per input line and in the same order:
+     *
+     *   <root> <evaluations> <status>
+     *
+     * where status is ok, failed (no finite root), budget (the
+     * evaluation budget was exhausted), error (the solver threw) or
+     * invalid (the line could not be parsed).  Empty lines and lines
+     * starting with # are copied unchanged.
+     */
+
+    /// Polynomial with ascending coefficients, evaluated with Horner
+    class polynomial {
+    public:
+      polynomial() {}
+      explicit polynomial(const std::vector<double>& c) : _c(c) {}
+
+      double operator()(const double x) const {
+        double y = 0.;
+        for (size_t i=_c.size();i>0u;--i) {
+          y = y*x + _c[i-1u];
+        }
+        return y;
+      }
+    private:
+      std::vector<double> _c;
+    };
+
+    /// One problem to solve
+    struct problem {
+      std::function<double(double)> f;
+      double a;
+      double b;
+      double x0;
+    };
+
+    /**
+     * Parse one input line.
+     *
+     * @return false if the line is malformed
+     */
+    inline bool parseProblem(const std::string& line,problem& p) {
+      const char* s = line.c_str();
+      while (*s == ' ' || *s == '\t') ++s;
+      char* end = 0;
+
+      if (std::strncmp(s,"poly",4) == 0) {
+        s += 4;
+        std::vector<double> v;
+        for (;;) {
+          const double d = std::strtod(s,&end);
+          if (end == s) break;
+          v.push_back(d);
+          s = end;
+        }
+        while (*s == ' ' || *s == '\t' || *s == '\r') ++s;
+        if (*s != 0 || v.size() < 3u || !(v[0] < v[1])) {
+          return false;
+        }
+        p.a = v[0];
+        p.b = v[1];
+        p.x0 = 0.5*(p.a + p.b);
+        p.f = polynomial(std::vector<double>(v.begin()+2,v.end()));
+        return true;
+      }
+
+      if (std::strncmp(s,"expr",4) == 0) {
+        s += 4;
+        const double a = std::strtod(s,&end);
+        if (end == s) return false;
+        s = end;
+        const double b = std::strtod(s,&end);
+        if (end == s || !(a < b)) return false;
+        s = end;
+
+        // consecutive lines often share the expression: compile it once
+        // per thread
+        struct cache {
+          std::string text;
+          anpi::expression<double> f;
+        };
+        static thread_local cache last;
+        std::string text(s);
+        if (!text.empty() && text[text.size()-1u] == '\r') {
+          text.erase(text.size()-1u);
+        }
+        if (last.text.empty() || text != last.text) {
+          try {
+            last.f = anpi::expression<double>(text);
+          } catch (anpi::Exception&) {
+            return false;
+          }
+          last.text = text;
+        }
+        p.a = a;
+        p.b = b;
+        p.x0 = 0.5*(a + b);
+        p.f = last.f;
+        return true;
+      }
+
+      if (std::strncmp(s,"corpus",6) == 0) {
+        s += 6;
+        const unsigned long long seed = std::strtoull(s,&end,10);
+        if (end == s) return false;
+        s = end;
+        const unsigned long long index = std::strtoull(s,&end,10);
+        if (end == s) return false;
+        s = end;
+        while (*s == ' ' || *s == '\t' || *s == '\r') ++s;
+        if (*s != 0) return false;
+        const anpi::equation<double> e =
+          anpi::equationCorpus<double>(seed)[index];
+        p.a = e.a;
+        p.b = e.b;
+        p.x0 = e.x0;
+        p.f = e;
+        return true;
+      }
+
+      return false;
+    }
+
+    /// Thrown by budgeted when a solve runs out of evaluations
+    class budgetExhausted : public anpi::Exception {
+    public:
+      budgetExhausted() : anpi::Exception("Evaluation budget exhausted") {}
+    };
+
+    /**
+     * Counts the evaluations of a function, throwing once the budget is
+     * exhausted, since the open methods have no iteration limit.
+     */
+    class budgeted {
+    public:
+      budgeted(const std::function<double(double)>& f,size_t* counter,
+               const size_t budget)
+        : _f(&f),_counter(counter),_budget(budget) {}
+
+      double operator()(const double x) const {
+        ANPI_PROFILE_SCOPE("eval","evaluate");
+        if (++(*_counter) > _budget) {
+          throw budgetExhausted();
+        }
+        return (*_f)(x);
+      }
+    private:
+      const std::function<double(double)>* _f;
+      size_t* _counter;
+      size_t _budget;
+    };
+
+    /// Root finder of the form "x = solve(f,a,b,x0,eps)"
+    typedef std::function<double(const std::function<double(double)>&,
+                                 double,double,double,double)> solverType;
+
+    /**
+     * Solver with the given name: bisection, interpolation, secant,
+     * newton, brent or ridder.
+     *
+     * @throws anpi::Exception if there is no such solver
+     */
+    inline solverType findSolver(const std::string& name) {
+      typedef const std::function<double(double)>& fType;
+      if (name == "bisection") {
+        return [](fType f,double a,double b,double,double eps) {
+          return anpi::rootBisection<double>(f,a,b,eps);
+        };
+      } else if (name == "interpolation") {
+        return [](fType f,double a,double b,double,double eps) {
+          return anpi::rootInterpolation<double>(f,a,b,eps);
+        };
+      } else if (name == "secant") {
+        return [](fType f,double a,double b,double,double eps) {
+          return anpi::rootSecant<double>(f,a,b,eps);
+        };
+      } else if (name == "newton") {
+        return [](fType f,double,double,double x0,double eps) {
+          return anpi::rootNewtonRaphson<double>(f,x0,eps);
+        };
+      } else if (name == "brent") {
+        return [](fType f,double a,double b,double,double eps) {
+          return anpi::rootBrent<double>(f,a,b,eps);
+        };
+      } else if (name == "ridder") {
+        return [](fType f,double a,double b,double,double eps) {
+          return anpi::rootRidder<double>(f,a,b,eps);
+        };
+      }
+      throw anpi::Exception("Unknown solver " + name);
+    }
+
+    /// Settings of a batch run
+    struct options {
+      options()
+        : method("brent"),eps(1.e-10),budget(1000u),threads(0u),
+          chunk(1024u),window(0u),pin(false),interval(10.) {}
+
+      /// Solver name, see findSolver()
+      std::string method;
+      /// Tolerance passed to the solver
+      double eps;
+      /// Maximum number of evaluations of one solve
+      size_t budget;
+      /// Worker threads, 0 for one per CPU the process may run on
+      unsigned int threads;
+      /// Lines per unit of work
+      size_t chunk;
+      /// Chunks in flight, 0 for four per worker
+      size_t window;
+      /// Bind each worker thread to one CPU
+      bool pin;
+      /// Checkpoint file to resume from and update, empty for none
+      std::string checkpoint;
+      /// Seconds between checkpoints
+      double interval;
+    };
+
+    /// Totals of a batch run
+    struct summary {
+      /// Input lines read
+      uint64_t lines;
+      /// Problems solved with status ok
+      uint64_t solved;
+      /// Problems with any other status
+      uint64_t failed;
+      /// Wall time
+      double seconds;
+    };
+
+    /// Result of one problem
+    enum solveStatus {
+      /// Finite root found
+      Solved = 0,
+      /// The solver returned no finite root
+      Failed,
+      /// The evaluation budget was exhausted
+      Budget,
+      /// The solver threw
+      Error,
+      /// The line could not be parsed
+      Invalid
+    };
+
+    /// Name of a status in the output lines
+    inline const char* statusName(const solveStatus s) {
+      static const char* const names[] = {
+        "ok", "failed", "budget", "error", "invalid"
+      };
+      return names[s];
+    }
+
+    /// Root, evaluations and status of one problem
+    struct outcome {
+      double root;
+      size_t evaluations;
+      solveStatus status;
+    };
+
+    /// Solve f in [a,b], or from x0 for the open methods
+    inline outcome solveFunction(const std::function<double(double)>& f,
+                                 const double a,const double b,
+                                 const double x0,
+                                 const solverType& solver,
+                                 const options& opts) {
+      outcome o;
+      o.root = std::numeric_limits<double>::quiet_NaN();
+      o.evaluations = 0u;
+
+      // wrapped by reference, which std::function stores without
+      // allocating
+      const budgeted counted(f,&o.evaluations,opts.budget);
+      const std::function<double(double)> g(std::cref(counted));
+      try {
+        o.root = solver(g,a,b,x0,opts.eps);
+        o.status = std::isfinite(o.root) ? Solved : Failed;
+      } catch (budgetExhausted&) {
+        o.status = Budget;
+      } catch (anpi::Exception&) {
+        o.status = Error;
+      }
+      return o;
+    }
+
+    /// Solve the problem of one line, which must not be empty or a comment
+    inline outcome solveProblem(const std::string& line,
+                                const solverType& solver,
+                                const options& opts) {
+      problem p;
+      if (!parseProblem(line,p)) {
+        outcome o;
+        o.root = std::numeric_limits<double>::quiet_NaN();
+        o.evaluations = 0u;
+        o.status = Invalid;
+        return o;
+      }
+      return solveFunction(p.f,p.a,p.b,p.x0,solver,opts);
+    }
+
+    /**
+     * Solve the problem of one input line, appending the output line to
+     * out.
+     *
+     * @return 0 for copied lines, 1 for solved problems, -1 for failures
+     */
+    inline int solveLine(const std::string& line,
+                         const solverType& solver,
+                         const options& opts,
+                         std::string& out) {
+      const size_t first = line.find_first_not_of(" \t\r");
+      if (first == std::string::npos || line[first] == '#') {
+        out += line;
+        out += '\n';
+        return 0;
+      }
+
+      const outcome o = solveProblem(line,solver,opts);
+      if (o.status == Invalid) {
+        out += "nan 0 invalid\n";
+        return -1;
+      }
+
+      char buf[64];
+      const int n = std::snprintf(buf,sizeof(buf),"%.17g %lu ",o.root,
+                                  static_cast<unsigned long>(o.evaluations));
+      out.append(buf,size_t(n));
+      out += statusName(o.status);
+      out += '\n';
+      return (o.status == Solved) ? 1 : -1;
+    }
+
+    /**
+     * Solve all lines of in, writing the results to out in input order.
+     *
+     * The calling thread reads chunks of lines, a work-stealing
+     * threadPool solves them, and a writer thread emits the results through a
+     * reorderBuffer, so that at most opts.window chunks are held in
+     * memory.  If progress is not null, the lines done and the roots
+     * per second are reported there about once a second.
+     *
+     * A resumed run continues the counts of resume, whose input offset
+     * in must already be positioned at.  If publish is set, the writer
+     * flushes out after each chunk and passes it the progress so far.
+     *
+     * @throws anpi::Exception if the method is unknown
+     */
+    typedef std::function<void(const checkpointState&)> publishType;
+
+    inline summary run(std::istream& in,
+                       std::ostream& out,
+                       const options& opts,
+                       std::ostream* progress = 0,
+                       const checkpointState& resume = checkpointState(),
+                       const publishType& publish = publishType()) {
+      typedef std::chrono::steady_clock clock;
+      const clock::time_point start = clock::now();
+
+      const solverType solver = findSolver(opts.method);
+      threadPool pool(opts.threads,opts.pin);
+      const size_t chunkSize = std::max(size_t(1u),opts.chunk);
+      const size_t window = opts.window ? opts.window : 4u*pool.size();
+
+      struct chunk {
+        uint64_t seq;
+        std::vector<std::string> lines;
+        /// Input offset after the last line
+        uint64_t inputEnd;
+      };
+      struct result {
+        result() : lines(0u),solved(0u),failed(0u),inputEnd(0u) {}
+        std::string text;
+        size_t lines;
+        size_t solved;
+        size_t failed;
+        uint64_t inputEnd;
+      };
+
+      reorderBuffer<result> reorder(window);
+
+      // writer
+      summary sum;
+      sum.lines  = resume.lines;
+      sum.solved = resume.solved;
+      sum.failed = resume.failed;
+      const uint64_t resumed = resume.solved + resume.failed;
+      std::thread writer([&]() {
+        ANPI_PROFILE_THREAD("batch writer");
+        clock::time_point report = clock::now();
+        checkpointState state = resume;
+        result r;
+        while (reorder.take(r)) {
+          out << r.text;
+          sum.lines  += r.lines;
+          sum.solved += r.solved;
+          sum.failed += r.failed;
+
+          if (publish) {
+            out.flush();
+            state.lines = sum.lines;
+            state.inputOffset = r.inputEnd;
+            state.outputOffset += r.text.size();
+            state.solved = sum.solved;
+            state.failed = sum.failed;
+            publish(state);
+          }
+
+          const clock::time_point now = clock::now();
+          if (progress && now - report >= std::chrono::seconds(1)) {
+            const std::chrono::duration<double> d = now - start;
+            *progress << "\r" << sum.lines << " lines, "
+                      << uint64_t(double(sum.solved + sum.failed - resumed)/
+                                  d.count())
+                      << " roots/s" << std::flush;
+            report = now;
+          }
+        }
+        out.flush();
+      });
+
+      // reader
+      taskGroup group(pool);
+      uint64_t offset = resume.inputOffset;
+      while (in) {
+        chunk c;
+        c.lines.reserve(chunkSize);
+        std::string line;
+        while (c.lines.size() < chunkSize && std::getline(in,line)) {
+          offset += line.size() + (in.eof() ? 0u : 1u);
+          c.lines.push_back(line);
+        }
+        if (c.lines.empty()) break;
+        c.inputEnd = offset;
+        c.seq = reorder.reserve();
+
+        // solved by any worker, put back in order by the reorder buffer
+        const std::shared_ptr<chunk> p(new chunk(std::move(c)));
+        group.run([p,&solver,&opts,&reorder]() {
+            ANPI_PROFILE_SCOPE("batch","chunk");
+            result r;
+            r.lines = p->lines.size();
+            r.inputEnd = p->inputEnd;
+            for (size_t i=0;i<p->lines.size();++i) {
+              const int s = solveLine(p->lines[i],solver,opts,r.text);
+              if (s > 0) ++r.solved;
+              else if (s < 0) ++r.failed;
+            }
+            reorder.put(p->seq,std::move(r));
+          });
+      }
+      group.wait();
+      reorder.close();
+      writer.join();
+
+      const std::chrono::duration<double> d = clock::now() - start;
+      sum.seconds = d.count();
+      if (progress) {
+        *progress << "\r" << sum.lines << " lines in " << sum.seconds
+                  << " s, "
+                  << uint64_t(double(sum.solved + sum.failed - resumed)/
+                              sum.seconds)
+                  << " roots/s, " << sum.failed << " failed" << std::endl;
+      }
+      return sum;
+    }
+
+    /// Fingerprint of a job: checkpoints of other jobs must not be used
+    inline uint64_t jobFingerprint(const std::string& kind,
+                                   const options& opts,
+                                   const uint64_t size) {
+      char buf[128];
+      std::snprintf(buf,sizeof(buf)," %.17g %lu %lu %llu",opts.eps,
+                    static_cast<unsigned long>(opts.budget),
+                    static_cast<unsigned long>(opts.chunk),
+                    static_cast<unsigned long long>(size));
+      return fingerprint(kind + " " + opts.method + buf);
+    }
+
+    /// Whether both paths name the same existing file
+    inline bool sameFile(const std::string& a,const std::string& b) {
+      struct stat sa;
+      struct stat sb;
+      return ::stat(a.c_str(),&sa) == 0 && ::stat(b.c_str(),&sb) == 0 &&
+        sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+    }
+
+    /**
+     * Refuse to write the output over the input, which opening the
+     * output would truncate while it is still being read.
+     *
+     * @throws anpi::Exception if both are the same file
+     */
+    inline void checkDistinctFiles(const std::string& input,
+                                   const std::string& output) {
+      if (sameFile(input,output)) {
+        throw anpi::Exception("Output " + output +
+                              " is the input file");
+      }
+    }
+
+    /**
+     * Fail a finished job whose background checkpoints failed: it ran
+     * to the end, but could not have been resumed.
+     *
+     * @throws anpi::Exception with the error of the checkpointer
+     */
+    inline void checkSaved(const checkpointer& saver) {
+      const std::string error = saver.error();
+      if (!error.empty()) {
+        throw anpi::Exception(error + " (the output is complete)");
+      }
+    }
+
+    /**
+     * Solve the lines of the file input into the file output, as run().
+     *
+     * If opts.checkpoint is set, a checkpoint with the lines done and
+     * the input and output offsets after them is written every
+     * opts.interval seconds, after syncing the output up to that
+     * offset.  If the checkpoint exists, the job resumes after the
+     * lines it records: the output is cut back to its offset and the
+     * input continues from there.  The checkpoint is removed once the
+     * job is complete.
+     *
+     * @throws anpi::Exception if a file cannot be opened, output is
+     *         the input file, the checkpoint belongs to another job or
+     *         cannot be written
+     */
+    inline summary runText(const std::string& input,
+                           const std::string& output,
+                           const options& opts,
+                           std::ostream* progress = 0) {
+      checkDistinctFiles(input,output);
+      struct stat st;
+      if (::stat(input.c_str(),&st) != 0) {
+        throw anpi::Exception("Cannot read " + input);
+      }
+      const uint64_t job = jobFingerprint("text",opts,uint64_t(st.st_size));
+
+      checkpointState resume;
+      const bool resuming = !opts.checkpoint.empty() &&
+        readCheckpoint(opts.checkpoint,resume);
+      if (resuming) {
+        struct stat ost;
+        if (resume.fingerprint != job) {
+          throw anpi::Exception("Checkpoint " + opts.checkpoint +
+                                " belongs to another job");
+        }
+        if (::stat(output.c_str(),&ost) != 0 ||
+            uint64_t(ost.st_size) < resume.outputOffset ||
+            ::truncate(output.c_str(),off_t(resume.outputOffset)) != 0) {
+          throw anpi::Exception("Output " + output +
+                                " does not match the checkpoint");
+        }
+        if (progress) {
+          *progress << "Resuming after line " << resume.lines << std::endl;
+        }
+      } else {
+        resume = checkpointState();
+        resume.fingerprint = job;
+      }
+
+      std::ifstream in(input.c_str(),std::ios::binary);
+      in.seekg(std::streamoff(resume.inputOffset));
+      std::ofstream out(output.c_str(),std::ios::binary |
+                        (resuming ? std::ios::app : std::ios::trunc));
+      if (!in || !out) {
+        throw anpi::Exception("Cannot open " + (in ? output : input));
+      }
+      if (opts.checkpoint.empty()) {
+        return run(in,out,opts,progress);
+      }
+
+      // the writer publishes, the checkpointer syncs and saves
+      std::mutex latestMutex;
+      checkpointState latest = resume;
+      const int fd = ::open(output.c_str(),O_RDONLY);
+      checkpointer saver(opts.checkpoint,opts.interval,
+                         [&](checkpointState& s) {
+                           {
+                             std::lock_guard<std::mutex> lock(latestMutex);
+                             s = latest;
+                           }
+                           if (fd < 0 || ::fsync(fd) != 0) {
+                             throw anpi::Exception("Cannot sync " + output);
+                           }
+                         },progress);
+      const summary sum =
+        run(in,out,opts,progress,resume,
+            [&](const checkpointState& s) {
+              std::lock_guard<std::mutex> lock(latestMutex);
+              latest = s;
+            });
+      saver.stop();
+      out.close();
+      if (fd >= 0) ::close(fd);
+      if (!out) {
+        throw anpi::Exception("Cannot write " + output);
+      }
+      ::unlink(opts.checkpoint.c_str());
+      checkSaved(saver);
+      return sum;
+    }
+
+    /**
+     * Polynomial whose coefficients are the elements of one row of the
+     * columns c0, c1, ..., read in place.  Small and trivially copyable,
+     * so that std::function holds it without allocating.
+     */
+    class columnPolynomial {
+    public:
+      columnPolynomial(const std::vector<const double*>& c,const uint64_t row)
+        : _c(&c),_row(row) {}
+
+      double operator()(const double x) const {
+        const std::vector<const double*>& c = *_c;
+        double y = 0.;
+        for (size_t i=c.size();i>0u;--i) {
+          y = y*x + c[i-1u][_row];
+        }
+        return y;
+      }
+    private:
+      const std::vector<const double*>* _c;
+      uint64_t _row;
+    };
+
+    /**
+     * The problems of the rows of a column file: either the UInt64
+     * columns seed and index (equations of the corpus), or the Float64
+     * columns a, b and c0, c1, ... (polynomials c0 + c1 x + ... in
+     * [a,b]) and optionally x0, the start of Newton-Raphson, which
+     * otherwise is the middle of [a,b].
+     */
+    class columnProblems {
+    public:
+      /// @throws anpi::Exception if in has none of the column sets above
+      explicit columnProblems(const columnFile& in)
+        : _seed(0),_index(0),_a(0),_b(0),_x0(0) {
+        if (in.has("seed")) {
+          _seed  = in.column<uint64_t>("seed");
+          _index = in.column<uint64_t>("index");
+          return;
+        }
+        _a = in.column<double>("a");
+        _b = in.column<double>("b");
+        if (in.has("x0")) _x0 = in.column<double>("x0");
+        while (in.has("c" + std::to_string(_c.size()))) {
+          _c.push_back(in.column<double>("c" + std::to_string(_c.size())));
+        }
+        if (_c.empty()) {
+          throw anpi::Exception("No coefficient columns in column file");
+        }
+      }
+
+      /// Solve the problem of row i
+      outcome solve(const uint64_t i,
+                    const solverType& solver,
+                    const options& opts) const {
+        if (_seed) {
+          const anpi::equation<double> e =
+            anpi::equationCorpus<double>(_seed[i])[_index[i]];
+          return solveFunction(e,e.a,e.b,e.x0,solver,opts);
+        }
+        if (_a[i] < _b[i]) {
+          return solveFunction(columnPolynomial(_c,i),_a[i],_b[i],
+                               _x0 ? _x0[i] : 0.5*(_a[i] + _b[i]),
+                               solver,opts);
+        }
+        outcome o;
+        o.root = std::numeric_limits<double>::quiet_NaN();
+        o.evaluations = 0u;
+        o.status = Invalid;
+        return o;
+      }
+
+    private:
+      const uint64_t* _seed;
+      const uint64_t* _index;
+      const double* _a;
+      const double* _b;
+      const double* _x0;
+      std::vector<const double*> _c;
+    };
+
+    /// The result columns of a column job, created or mapped in place
+    struct columnResults {
+      /**
+       * Create output with rows rows, or map the existing file writable
+       * if existing is set.
+       *
+       * @throws anpi::Exception if the file cannot be created or mapped,
+       *         or an existing one does not have rows rows
+       */
+      columnResults(const std::string& output,const uint64_t rows,
+                    const bool existing) {
+        if (existing) {
+          file.reset(new columnFile(output,true));
+          if (file->rows() != rows) {
+            throw anpi::Exception("Output " + output +
+                                  " does not match the checkpoint");
+          }
+        } else {
+          std::vector<columnFile::columnSpec> spec;
+          spec.push_back(columnFile::columnSpec("root",Float64));
+          spec.push_back(columnFile::columnSpec("evaluations",UInt32));
+          spec.push_back(columnFile::columnSpec("status",UInt8));
+          file.reset(new columnFile(output,rows,spec));
+        }
+        root = file->writableColumn<double>("root");
+        evaluations = file->writableColumn<uint32_t>("evaluations");
+        status = file->writableColumn<uint8_t>("status");
+      }
+
+      /// Store the outcome of row i
+      void store(const uint64_t i,const outcome& o) {
+        root[i] = o.root;
+        evaluations[i] = uint32_t(o.evaluations);
+        status[i] = uint8_t(o.status);
+      }
+
+      std::unique_ptr<columnFile> file;
+      double* root;
+      uint32_t* evaluations;
+      uint8_t* status;
+    };
+
+    /**
+     * Call mark(k) for each chunk k of chunk rows lying entirely inside
+     * the completed ranges of a column checkpoint.
+     *
+     * @return number of rows in those chunks
+     */
+    template<typename Mark>
+    uint64_t completedChunks(const checkpointState& s,const uint64_t rows,
+                             const uint64_t chunk,Mark mark) {
+      const uint64_t chunks = (rows + chunk - 1u)/chunk;
+      uint64_t covered = 0u;
+      for (size_t i=0;i<s.ranges.size();++i) {
+        const uint64_t last = std::min(rows,s.ranges[i].second);
+        for (uint64_t k=s.ranges[i].first/chunk;
+             k < chunks && k*chunk < last;++k) {
+          if (k*chunk >= s.ranges[i].first &&
+              std::min(rows,(k+1u)*chunk) <= last) {
+            mark(k);
+            covered += std::min(rows,(k+1u)*chunk) - k*chunk;
+          }
+        }
+      }
+      return covered;
+    }
+
+    /// Append the rows of chunk k to the sorted ranges of a checkpoint
+    inline void appendChunk(checkpointState& s,const uint64_t k,
+                            const uint64_t rows,const uint64_t chunk) {
+      const uint64_t first = k*chunk;
+      const uint64_t last = std::min(rows,first + chunk);
+      if (!s.ranges.empty() && s.ranges.back().second == first) {
+        s.ranges.back().second = last;
+      } else {
+        s.ranges.push_back(std::make_pair(first,last));
+      }
+    }
+
+    /**
+     * Solve all rows of a column file (see ColumnFile.hpp), writing the
+     * results to a new column file with the columns root (Float64),
+     * evaluations (UInt32) and status (UInt8, a solveStatus).
+     *
+     * The input holds the columns of one of the problem kinds of
+     * columnProblems.  Both files are memory mapped, and the workers of a threadPool
+     * solve disjoint chunks of opts.chunk rows directly on the mapped
+     * columns: nothing is parsed and nothing is copied.
+     *
+     * If opts.checkpoint is set, the completed chunks are recorded as
+     * row ranges every opts.interval seconds, after syncing the output
+     * mapping.  The workers only raise a flag per chunk; the scan, sync
+     * and write happen on the checkpointer thread.  If the checkpoint
+     * exists, the existing output is reused and the recorded chunks are
+     * skipped.  The checkpoint is removed once the job is complete.
+     *
+     * @throws anpi::Exception if a file cannot be mapped, output is the
+     *         input file, the input has no known problem columns, the
+     *         method is unknown, or the checkpoint belongs to another job
+     *         or cannot be written
+     */
+    inline summary runColumns(const std::string& input,
+                              const std::string& output,
+                              const options& opts,
+                              std::ostream* progress = 0) {
+      typedef std::chrono::steady_clock clock;
+      const clock::time_point start = clock::now();
+
+      const solverType solver = findSolver(opts.method);
+      checkDistinctFiles(input,output);
+      const columnFile in(input);
+      const uint64_t rows = in.rows();
+      const columnProblems problems(in);
+
+      const uint64_t chunk = std::max(size_t(1u),opts.chunk);
+      const uint64_t chunks = (rows + chunk - 1u)/chunk;
+      const uint64_t job = jobFingerprint("columns",opts,rows);
+
+      // one flag per chunk, raised once its rows are written
+      std::unique_ptr<std::atomic<uint8_t>[]>
+        done(new std::atomic<uint8_t>[size_t(chunks)]);
+      for (uint64_t k=0;k<chunks;++k) {
+        done[k].store(0u,std::memory_order_relaxed);
+      }
+
+      checkpointState resume;
+      const bool resuming = !opts.checkpoint.empty() &&
+        readCheckpoint(opts.checkpoint,resume);
+      uint64_t skipped = 0u;
+      if (resuming) {
+        if (resume.fingerprint != job) {
+          throw anpi::Exception("Checkpoint " + opts.checkpoint +
+                                " belongs to another job");
+        }
+        skipped = completedChunks(resume,rows,chunk,[&](const uint64_t k) {
+            done[k].store(1u,std::memory_order_relaxed);
+          });
+        if (progress) {
+          *progress << "Resuming with " << skipped << " rows done"
+                    << std::endl;
+        }
+      }
+      columnResults out(output,rows,resuming);
+
+      std::unique_ptr<checkpointer> saver;
+      if (!opts.checkpoint.empty()) {
+        saver.reset(new checkpointer(
+          opts.checkpoint,opts.interval,
+          [&](checkpointState& s) {
+            s.fingerprint = job;
+            for (uint64_t k=0;k<chunks;++k) {
+              if (done[k].load(std::memory_order_acquire)) {
+                appendChunk(s,k,rows,chunk);
+              }
+            }
+            out.file->sync(); // the rows of the flags seen above are durable
+          },progress));
+      }
+
+      // progress reports from their own thread, since the calling
+      // thread takes part in the parallelFor below
+      std::atomic<uint64_t> processed(0u);
+      std::mutex finishedMutex;
+      std::condition_variable finished;
+      bool running = true;
+      std::thread reporter;
+      if (progress) {
+        reporter = std::thread([&]() {
+          std::unique_lock<std::mutex> lock(finishedMutex);
+          while (running) {
+            finished.wait_for(lock,std::chrono::seconds(1));
+            if (!running) break;
+            const std::chrono::duration<double> d = clock::now() - start;
+            *progress << "\r" << skipped + processed.load() << " rows, "
+                      << uint64_t(double(processed.load())/d.count())
+                      << " roots/s" << std::flush;
+          }
+        });
+      }
+
+      // one chunk per task: chunks of slow solves get spread by stealing
+      threadPool pool(opts.threads,opts.pin);
+      std::exception_ptr error;
+      try {
+        pool.parallelFor(0u,size_t(chunks),[&](const size_t k) {
+            if (done[k].load(std::memory_order_relaxed)) return;
+            ANPI_PROFILE_SCOPE("batch","chunk");
+            const uint64_t first = k*chunk;
+            const uint64_t last = std::min(rows,first + chunk);
+            for (uint64_t i=first;i<last;++i) {
+              out.store(i,problems.solve(i,solver,opts));
+            }
+            done[k].store(1u,std::memory_order_release);
+            processed.fetch_add(last - first,std::memory_order_relaxed);
+          },1u);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      {
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        running = false;
+      }
+      finished.notify_one();
+      if (reporter.joinable()) reporter.join();
+      if (error) std::rethrow_exception(error);
+      if (saver) {
+        saver->stop();
+        out.file->sync();
+        ::unlink(opts.checkpoint.c_str());
+        checkSaved(*saver);
+      }
+
+      summary sum;
+      sum.lines = rows;
+      sum.solved = uint64_t(std::count(out.status,out.status + rows,
+                                       uint8_t(Solved)));
+      sum.failed = rows - sum.solved;
+      const std::chrono::duration<double> d = clock::now() - start;
+      sum.seconds = d.count();
+      if (progress) {
+        *progress << "\r" << sum.lines << " rows in " << sum.seconds
+                  << " s, " << uint64_t(double(processed.load())/sum.seconds)
+                  << " roots/s, " << sum.failed << " failed" << std::endl;
+      }
+      return sum;
+    }
+
+  } // namespace batch
+} // namespace anpi
+
+#endif
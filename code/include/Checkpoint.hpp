@@ -0,0 +1,282 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_CHECKPOINT_HPP
+#define ANPI_CHECKPOINT_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Exception.hpp"
+#include "Profiler.hpp"
+#include "bits/FileUtil.hpp"
+
+namespace anpi {
+  namespace batch {
+
+    /**
+     * Progress of a batch job, enough to resume it after a crash.
+     *
+     * Text jobs finish their lines in order, so the first lines done,
+     * the input offset after them and the output offset after their
+     * results describe them.  Column jobs finish chunks of rows in any
+     * order and keep the list of completed row ranges instead.
+     */
+    struct checkpointState {
+      checkpointState()
+        : fingerprint(0u),lines(0u),inputOffset(0u),outputOffset(0u),
+          solved(0u),failed(0u) {}
+
+      /// Identifies the job, see fingerprint()
+      uint64_t fingerprint;
+      /// Text jobs: lines done
+      uint64_t lines;
+      /// Text jobs: bytes of input consumed by those lines
+      uint64_t inputOffset;
+      /// Text jobs: bytes of output written for those lines
+      uint64_t outputOffset;
+      /// Text jobs: problems solved and failed so far
+      uint64_t solved;
+      uint64_t failed;
+      /// Column jobs: sorted, disjoint completed row ranges [first,last)
+      std::vector<std::pair<uint64_t,uint64_t> > ranges;
+    };
+
+    /// FNV-1a hash of n bytes, continuing from h
+    inline uint64_t fnv1a(const void* data,const size_t n,
+                          uint64_t h = 14695981039346656037ull) {
+      const unsigned char* p = static_cast<const unsigned char*>(data);
+      for (size_t i=0;i<n;++i) {
+        h = (h ^ p[i])*1099511628211ull;
+      }
+      return h;
+    }
+
+    /// Hash of the parameters a checkpoint is only valid for
+    inline uint64_t fingerprint(const std::string& job) {
+      return fnv1a(job.data(),job.size());
+    }
+
+    /**
+     * Write the state to path atomically, see anpi::replaceFile().
+     *
+     * Layout: "ANPICKP1", the six counters, the number of ranges, the
+     * ranges, and the FNV-1a hash of everything before it, all uint64_t.
+     *
+     * @throws anpi::Exception if the file cannot be written
+     */
+    inline void writeCheckpoint(const std::string& path,
+                                const checkpointState& s) {
+      std::vector<uint64_t> words;
+      words.reserve(9u + 2u*s.ranges.size());
+      uint64_t magic;
+      std::memcpy(&magic,"ANPICKP1",8u);
+      words.push_back(magic);
+      words.push_back(s.fingerprint);
+      words.push_back(s.lines);
+      words.push_back(s.inputOffset);
+      words.push_back(s.outputOffset);
+      words.push_back(s.solved);
+      words.push_back(s.failed);
+      words.push_back(s.ranges.size());
+      for (size_t i=0;i<s.ranges.size();++i) {
+        words.push_back(s.ranges[i].first);
+        words.push_back(s.ranges[i].second);
+      }
+      words.push_back(fnv1a(words.data(),words.size()*sizeof(uint64_t)));
+      replaceFile(path,words.data(),words.size()*sizeof(uint64_t),
+                  "checkpoint");
+    }
+
+    /**
+     * Read the checkpoint at path.
+     *
+     * @return false if there is no checkpoint
+     * @throws anpi::Exception if the file is not a valid checkpoint
+     */
+    inline bool readCheckpoint(const std::string& path,checkpointState& s) {
+      const int fd = ::open(path.c_str(),O_RDONLY);
+      if (fd < 0) {
+        if (errno == ENOENT) return false;
+        throw anpi::Exception("Cannot read checkpoint " + path + ": " +
+                              std::strerror(errno));
+      }
+      std::string bytes;
+      char buf[4096];
+      ssize_t r;
+      while ((r = ::read(fd,buf,sizeof(buf))) != 0) {
+        if (r < 0) {
+          if (errno == EINTR) continue;
+          break;
+        }
+        bytes.append(buf,size_t(r));
+      }
+      ::close(fd);
+
+      std::vector<uint64_t> words(bytes.size()/sizeof(uint64_t));
+      if (!words.empty()) {
+        std::memcpy(words.data(),bytes.data(),words.size()*sizeof(uint64_t));
+      }
+      uint64_t magic;
+      std::memcpy(&magic,"ANPICKP1",8u);
+      if (r < 0 || bytes.size() % sizeof(uint64_t) != 0u ||
+          words.size() < 9u ||
+          words[0] != magic || words[7] != (words.size() - 9u)/2u ||
+          words.size() != 9u + 2u*words[7] ||
+          words.back() != fnv1a(words.data(),
+                                (words.size()-1u)*sizeof(uint64_t))) {
+        throw anpi::Exception("Corrupt checkpoint " + path);
+      }
+
+      s.fingerprint  = words[1];
+      s.lines        = words[2];
+      s.inputOffset  = words[3];
+      s.outputOffset = words[4];
+      s.solved       = words[5];
+      s.failed       = words[6];
+      s.ranges.resize(size_t(words[7]));
+      for (size_t i=0;i<s.ranges.size();++i) {
+        s.ranges[i].first  = words[8u + 2u*i];
+        s.ranges[i].second = words[9u + 2u*i];
+      }
+      return true;
+    }
+
+    /**
+     * Thread writing a checkpoint every interval seconds.
+     *
+     * The snapshot function fills the state and must make the output it
+     * describes durable first; it runs on this thread, so the workers
+     * only publish their progress and never wait for the disk.
+     *
+     * The first checkpoint is written by the constructor, so that a path
+     * that cannot be written stops the job before it starts.  Later
+     * failures are kept in error(), and the first one is reported on the
+     * progress stream, if any.
+     */
+    class checkpointer {
+    public:
+      typedef std::function<void(checkpointState&)> snapshotType;
+
+      /**
+       * @throws anpi::Exception if the first checkpoint cannot be written
+       */
+      checkpointer(const std::string& path,const double interval,
+                   const snapshotType& snapshot,std::ostream* progress = 0)
+        : _path(path),_snapshot(snapshot),_progress(progress),_stop(false),
+          _written(0u),_busy(0.) {
+        const std::chrono::duration<double> d(interval > 0. ? interval : 1.);
+        _interval = std::chrono::duration_cast<
+          std::chrono::steady_clock::duration>(d);
+        save();
+        _written = 1u;
+        _thread = std::thread(&checkpointer::loop,this);
+      }
+
+      ~checkpointer() { stop(); }
+
+      /// Stop the thread without writing a last checkpoint
+      void stop() {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (_stop) return;
+          _stop = true;
+        }
+        _wake.notify_one();
+        _thread.join();
+      }
+
+      /// Checkpoints written
+      uint64_t written() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _written;
+      }
+
+      /// Seconds spent taking snapshots and writing them
+      double busy() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _busy;
+      }
+
+      /// Message of the last failed checkpoint, if any
+      std::string error() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _error;
+      }
+
+    private:
+      void save() {
+        ANPI_PROFILE_SCOPE("io","checkpoint");
+        checkpointState s;
+        _snapshot(s);
+        writeCheckpoint(_path,s);
+      }
+
+      void loop() {
+        typedef std::chrono::steady_clock clock;
+        ANPI_PROFILE_THREAD("checkpointer");
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+          const clock::time_point deadline = clock::now() + _interval;
+          while (!_stop && _wake.wait_until(lock,deadline) !=
+                 std::cv_status::timeout) {}
+          if (_stop) return;
+
+          lock.unlock();
+          const clock::time_point start = clock::now();
+          std::string error;
+          try {
+            save();
+          } catch (std::exception& e) {
+            error = e.what();
+          }
+          const std::chrono::duration<double> d = clock::now() - start;
+          lock.lock();
+          _busy += d.count();
+          if (error.empty()) {
+            ++_written;
+          } else {
+            if (_error.empty() && _progress) {
+              *_progress << "\n" << error << std::endl;
+            }
+            _error = error;
+          }
+        }
+      }
+
+      std::string _path;
+      snapshotType _snapshot;
+      std::ostream* _progress;
+      std::chrono::steady_clock::duration _interval;
+
+      mutable std::mutex _mutex;
+      std::condition_variable _wake;
+      bool _stop;
+      uint64_t _written;
+      double _busy;
+      std::string _error;
+
+      std::thread _thread;
+    };
+
+  } // namespace batch
+} // namespace anpi
+
+#endif
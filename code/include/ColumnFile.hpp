@@ -0,0 +1,323 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_COLUMN_FILE_HPP
+#define ANPI_COLUMN_FILE_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Exception.hpp"
+
+namespace anpi {
+
+  /// Element types of the columns of a columnFile
+  enum columnType {
+    Float64 = 0,
+    UInt64,
+    UInt32,
+    UInt8,
+    NumColumnTypes
+  };
+
+  /// Size in bytes of one element of the given type
+  inline size_t columnTypeSize(const columnType t) {
+    static const size_t sizes[] = { 8u, 8u, 4u, 1u };
+    return sizes[t];
+  }
+
+  /// Column type of T
+  template<typename T> struct columnTypeOf;
+  template<> struct columnTypeOf<double>   {
+    static const columnType value = Float64;
+  };
+  template<> struct columnTypeOf<uint64_t> {
+    static const columnType value = UInt64;
+  };
+  template<> struct columnTypeOf<uint32_t> {
+    static const columnType value = UInt32;
+  };
+  template<> struct columnTypeOf<uint8_t>  {
+    static const columnType value = UInt8;
+  };
+
+  /**
+   * Table of named columns stored in a memory-mapped file.
+   *
+   * Layout, all integers in host byte order:
+   *
+   *   "ANPICOL1", uint64_t rows, uint32_t columns, uint32_t 0
+   *   one descriptor per column: char name[24] (zero padded),
+   *     uint32_t type, uint32_t 0, uint64_t offset
+   *   the columns, each a contiguous array of rows elements starting
+   *   at its offset, which is a multiple of Alignment
+   *
+   * Since every column is a plain aligned array, the rows are used in
+   * place: reading needs no parsing and no copies, and writing goes
+   * straight to the page cache.  The same files can be opened from
+   * NumPy with np.memmap(path, dtype, offset=..., shape=(rows,)).
+   */
+  class columnFile {
+  public:
+    /// Alignment of the start of each column, in bytes
+    static const size_t Alignment = 64u;
+    /// Longest column name
+    static const size_t MaxName = 23u;
+
+    /// Name and type of a column to create
+    typedef std::pair<std::string,columnType> columnSpec;
+
+    /**
+     * Map an existing file for reading, or also for writing.
+     *
+     * @throws anpi::Exception if the file cannot be mapped or is not a
+     *         valid column file
+     */
+    explicit columnFile(const std::string& path,const bool writable = false)
+      : _data(0),_size(0u),_writable(writable) {
+      const int fd = ::open(path.c_str(),writable ? O_RDWR : O_RDONLY);
+      if (fd < 0) fail("Cannot open",path);
+      struct stat st;
+      if (::fstat(fd,&st) < 0) {
+        ::close(fd);
+        fail("Cannot stat",path);
+      }
+      _size = size_t(st.st_size);
+      if (_size < sizeof(header)) {
+        ::close(fd);
+        throw anpi::Exception("Not a column file: " + path);
+      }
+      void* p = ::mmap(0,_size,writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                       MAP_SHARED,fd,0);
+      ::close(fd);
+      if (p == MAP_FAILED) fail("Cannot map",path);
+      _data = static_cast<char*>(p);
+#if defined(MADV_SEQUENTIAL)
+      if (!writable) ::madvise(p,_size,MADV_SEQUENTIAL);
+#endif
+      if (!validate()) {
+        ::munmap(_data,_size);
+        _data = 0;
+        throw anpi::Exception("Not a valid column file: " + path);
+      }
+    }
+
+    /**
+     * Create (or replace) a file with the given columns of rows zeroed
+     * elements each, mapped for writing.
+     *
+     * @throws anpi::Exception if the file cannot be created
+     */
+    columnFile(const std::string& path,const uint64_t rows,
+               const std::vector<columnSpec>& columns)
+      : _data(0),_size(0u),_writable(true) {
+      size_t offset = align(sizeof(header) + columns.size()*sizeof(entry));
+      std::vector<entry> cols(columns.size());
+      for (size_t i=0;i<columns.size();++i) {
+        if (columns[i].first.empty() || columns[i].first.size() > MaxName ||
+            columns[i].second >= NumColumnTypes) {
+          throw anpi::Exception("Invalid column " + columns[i].first);
+        }
+        std::memset(&cols[i],0,sizeof(entry));
+        std::memcpy(cols[i].name,columns[i].first.data(),
+                    columns[i].first.size());
+        cols[i].type = uint32_t(columns[i].second);
+        cols[i].offset = offset;
+        offset = align(offset +
+                       size_t(rows)*columnTypeSize(columns[i].second));
+      }
+      _size = offset;
+
+      const int fd = ::open(path.c_str(),O_RDWR | O_CREAT | O_TRUNC,0644);
+      if (fd < 0) fail("Cannot create",path);
+      if (::ftruncate(fd,off_t(_size)) < 0) {
+        ::close(fd);
+        fail("Cannot resize",path);
+      }
+      void* p = ::mmap(0,_size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+      ::close(fd);
+      if (p == MAP_FAILED) fail("Cannot map",path);
+      _data = static_cast<char*>(p);
+
+      header h;
+      std::memcpy(h.magic,"ANPICOL1",8u);
+      h.rows = rows;
+      h.columns = uint32_t(cols.size());
+      h.reserved = 0u;
+      std::memcpy(_data,&h,sizeof(h));
+      if (!cols.empty()) {
+        std::memcpy(_data + sizeof(h),&cols[0],cols.size()*sizeof(entry));
+      }
+    }
+
+    columnFile(const columnFile&) = delete;
+    columnFile& operator=(const columnFile&) = delete;
+
+    ~columnFile() {
+      if (_data) ::munmap(_data,_size);
+    }
+
+    /// Number of rows
+    uint64_t rows() const { return head().rows; }
+
+    /// Number of columns
+    size_t columns() const { return head().columns; }
+
+    /// Name of the i-th column
+    std::string name(const size_t i) const {
+      const entry& c = descriptor(i);
+      return std::string(c.name,strnlen(c.name,sizeof(c.name)));
+    }
+
+    /// Type of the i-th column
+    columnType type(const size_t i) const {
+      return columnType(descriptor(i).type);
+    }
+
+    /// Index of the column with the given name, or columns() if none
+    size_t find(const std::string& name) const {
+      for (size_t i=0;i<columns();++i) {
+        if (this->name(i) == name) return i;
+      }
+      return columns();
+    }
+
+    /// Whether there is a column with the given name
+    bool has(const std::string& name) const {
+      return find(name) < columns();
+    }
+
+    /**
+     * Elements of the named column.
+     *
+     * @throws anpi::Exception if there is no such column of type T
+     */
+    template<typename T>
+    const T* column(const std::string& name) const {
+      return reinterpret_cast<const T*>(columnData(name,
+                                                   columnTypeOf<T>::value));
+    }
+
+    /**
+     * Writable elements of the named column.
+     *
+     * @throws anpi::Exception if the file was opened for reading, or
+     *         there is no such column of type T
+     */
+    template<typename T>
+    T* writableColumn(const std::string& name) {
+      if (!_writable) {
+        throw anpi::Exception("Column file is read only");
+      }
+      return reinterpret_cast<T*>(columnData(name,columnTypeOf<T>::value));
+    }
+
+    /// Flush the written pages to the file
+    void sync() {
+      if (_writable && ::msync(_data,_size,MS_SYNC) < 0) {
+        throw anpi::Exception("Cannot sync column file: " +
+                              std::string(std::strerror(errno)));
+      }
+    }
+
+    /// Whether the file at path starts as a column file
+    static bool isColumnFile(const std::string& path) {
+      char magic[8];
+      const int fd = ::open(path.c_str(),O_RDONLY);
+      if (fd < 0) return false;
+      const bool ok = ::read(fd,magic,8) == 8 &&
+        std::memcmp(magic,"ANPICOL1",8u) == 0;
+      ::close(fd);
+      return ok;
+    }
+
+  private:
+    struct header {
+      char magic[8];
+      uint64_t rows;
+      uint32_t columns;
+      uint32_t reserved;
+    };
+
+    struct entry {
+      char name[MaxName+1u];
+      uint32_t type;
+      uint32_t reserved;
+      uint64_t offset;
+    };
+
+    static_assert(sizeof(header) == 24u && sizeof(entry) == 40u,
+                  "column file descriptors must have no padding");
+
+    static size_t align(const size_t n) {
+      return (n + (Alignment-1u)) & ~(Alignment-1u);
+    }
+
+    static void fail(const char* what,const std::string& path) {
+      throw anpi::Exception(std::string(what) + " " + path + ": " +
+                            std::strerror(errno));
+    }
+
+    const header& head() const {
+      return *reinterpret_cast<const header*>(_data);
+    }
+
+    const entry& descriptor(const size_t i) const {
+      return reinterpret_cast<const entry*>(_data + sizeof(header))[i];
+    }
+
+    const char* columnData(const std::string& name,const columnType t) const {
+      const size_t i = find(name);
+      if (i == columns() || type(i) != t) {
+        throw anpi::Exception("No column " + name + " of the requested type");
+      }
+      return _data + descriptor(i).offset;
+    }
+
+    char* columnData(const std::string& name,const columnType t) {
+      return const_cast<char*>(static_cast<const columnFile*>(this)->
+                               columnData(name,t));
+    }
+
+    /// Check that all descriptors and columns lie inside the mapping
+    bool validate() const {
+      const header& h = head();
+      if (std::memcmp(h.magic,"ANPICOL1",8u) != 0) return false;
+      const size_t table = sizeof(header) + size_t(h.columns)*sizeof(entry);
+      if (h.columns > (_size - sizeof(header))/sizeof(entry)) return false;
+      for (size_t i=0;i<h.columns;++i) {
+        const entry& c = descriptor(i);
+        if (c.type >= NumColumnTypes || c.offset % Alignment != 0u ||
+            c.offset < table || c.offset > _size) {
+          return false;
+        }
+        const uint64_t bytes = h.rows*columnTypeSize(columnType(c.type));
+        if (h.rows != bytes/columnTypeSize(columnType(c.type)) ||
+            bytes > _size - c.offset) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    char* _data;
+    size_t _size;
+    bool _writable;
+  };
+
+} // namespace anpi
+
+#endif
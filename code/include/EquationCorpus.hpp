@@ -0,0 +1,240 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_EQUATION_CORPUS_HPP
+#define ANPI_EQUATION_CORPUS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include "Exception.hpp"
+
+namespace anpi {
+
+  /**
+   * Families of generated equations
+   */
+  enum EquationFamily {
+    /// Odd number of simple roots packed in a narrow cluster
+    ClusteredPolynomial = 0,
+    /// Root of odd multiplicity 3 or 5
+    MultipleRootPolynomial,
+    /// Increasing mixture a*exp(b*x) + c*log(x) shifted to a root
+    ExpLogMixture,
+    /// eps*atan(x-r) with eps as small as 1e-10
+    NearlyFlat,
+    /// tanh(s*(x-r)) with a slope s up to 1e6
+    Steep,
+    /// Jump discontinuity where the sign changes, without a true root
+    Discontinuous,
+    /// Number of families
+    NumEquationFamilies
+  };
+
+  /// Name of a family, for reports
+  inline const char* equationFamilyName(const EquationFamily family) {
+    static const char* names[NumEquationFamilies] = {
+      "clustered","multiple","exp-log","flat","steep","discontinuous"
+    };
+    return names[family];
+  }
+
+  /**
+   * A generated equation f(x)=0 with its known roots, a bracket [a,b]
+   * with a sign change, and a starting point x0 inside the bracket for
+   * the open methods.
+   *
+   * All equations change sign from negative to positive across the
+   * bracket, i.e. f(a)<0<f(b).
+   *
+   * The equation is a functor, so that it can be wrapped directly into
+   * a std::function<T(T)>.
+   */
+  template<typename T>
+  struct equation {
+    /// Maximum number of known roots
+    static const int MaxRoots = 5;
+
+    EquationFamily family;
+
+    /// Bracket
+    T a;
+    T b;
+    /// Starting point of open methods
+    T x0;
+
+    /// Known roots inside the bracket
+    int nroots;
+    T roots[MaxRoots];
+
+    /// Family parameters
+    T p[4];
+
+    /// Evaluate the function
+    T operator()(const T x) const {
+      switch (family) {
+      case ClusteredPolynomial: {
+        T y = p[0];
+        for (int i=0;i<nroots;++i) {
+          y *= (x - roots[i]);
+        }
+        return y;
+      }
+      case MultipleRootPolynomial: {
+        const T d = x - roots[0];
+        T y = p[0]*(x*x + p[2]);
+        for (int i=0;i<int(p[1]);++i) {
+          y *= d;
+        }
+        return y;
+      }
+      case ExpLogMixture:
+        return p[0]*std::exp(p[1]*x) + p[2]*std::log(x) - p[3];
+      case NearlyFlat:
+        return p[0]*std::atan(x - roots[0]);
+      case Steep:
+        return std::tanh(p[0]*(x - roots[0]));
+      case Discontinuous:
+        return (x - roots[0]) + ((x < roots[0]) ? -p[0] : p[0]);
+      default:
+        throw anpi::Exception("Unknown equation family");
+      }
+    }
+
+    /// Distance from x to the nearest known root
+    T distance(const T x) const {
+      T d = std::abs(x - roots[0]);
+      for (int i=1;i<nroots;++i) {
+        d = std::min(d,T(std::abs(x - roots[i])));
+      }
+      return d;
+    }
+  };
+
+  /**
+   * Seeded generator of equations.
+   *
+   * Each instance depends only on the seed and its index, so that large
+   * corpora can be generated in parallel and reproduced exactly.  The
+   * families cycle with the index, so that any contiguous range of
+   * indices contains an even mix.
+   */
+  template<typename T>
+  class equationCorpus {
+  public:
+    /// Construct with the given seed
+    explicit equationCorpus(const uint64_t seed = 0u) : _seed(seed) {}
+
+    /// Seed of the corpus
+    uint64_t seed() const { return _seed; }
+
+    /// Generate the equation with the given index
+    equation<T> operator[](const uint64_t index) const {
+      std::mt19937_64 rng(mix(_seed + 0x9E3779B97F4A7C15ull*(index+1u)));
+      const EquationFamily family =
+        EquationFamily(index % uint64_t(NumEquationFamilies));
+      return generate(family,rng);
+    }
+
+    /// Generate an equation of the given family
+    equation<T> generate(const EquationFamily family,
+                         std::mt19937_64& rng) const {
+      equation<T> e;
+      e.family = family;
+      e.nroots = 1;
+      for (int i=0;i<4;++i) {
+        e.p[i] = T(0);
+      }
+
+      // center and distance of the bracket ends to the roots
+      const double center = uniform(rng,-5.,5.);
+      const double left   = uniform(rng,0.1,2.);
+      const double right  = uniform(rng,0.1,2.);
+      double lo = center, hi = center;
+
+      switch (family) {
+      case ClusteredPolynomial: {
+        e.nroots = (rng() & 1u) ? 5 : 3;
+        const double width = logUniform(rng,1.e-3,1.e-1);
+        for (int i=0;i<e.nroots;++i) {
+          e.roots[i] = T(center + width*(double(i)/double(e.nroots-1) - 0.5));
+        }
+        lo = double(e.roots[0]);
+        hi = double(e.roots[e.nroots-1]);
+        e.p[0] = T(uniform(rng,0.5,2.));
+      } break;
+      case MultipleRootPolynomial: {
+        e.roots[0] = T(center);
+        e.p[0] = T(uniform(rng,0.5,2.));
+        e.p[1] = T((rng() & 1u) ? 5 : 3);
+        e.p[2] = T(uniform(rng,0.5,4.));
+      } break;
+      case ExpLogMixture: {
+        // increasing on x>0, root in [0.5,5]
+        const double r = uniform(rng,0.5,5.);
+        e.roots[0] = T(r);
+        e.p[0] = T(uniform(rng,0.1,2.));
+        e.p[1] = T(uniform(rng,0.1,1.));
+        e.p[2] = T(uniform(rng,0.1,2.));
+        e.p[3] = T(double(e.p[0])*std::exp(double(e.p[1])*r) +
+                   double(e.p[2])*std::log(r));
+        // the exact root of the rounded function lies within a few ulps
+        lo = hi = r;
+        e.a  = T(r*uniform(rng,0.2,0.9));
+        e.b  = T(r + right);
+        e.x0 = T(r + uniform(rng,-0.5,0.5)*std::min(r - double(e.a),right));
+        return e;
+      }
+      case NearlyFlat: {
+        e.roots[0] = T(center);
+        e.p[0] = T(logUniform(rng,1.e-10,1.e-4));
+      } break;
+      case Steep: {
+        e.roots[0] = T(center);
+        e.p[0] = T(logUniform(rng,1.e2,1.e6));
+      } break;
+      case Discontinuous: {
+        e.roots[0] = T(center);
+        e.p[0] = T(uniform(rng,0.1,1.));
+      } break;
+      default:
+        throw anpi::Exception("Unknown equation family");
+      }
+
+      e.a = T(lo - left);
+      e.b = T(hi + right);
+      // start near the root(s), inside the bracket
+      e.x0 = T(0.5*(lo+hi) + uniform(rng,-0.25,0.25)*std::min(left,right));
+      return e;
+    }
+
+  private:
+    /// SplitMix64 finalizer, to decorrelate neighboring seeds
+    static uint64_t mix(uint64_t z) {
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+    }
+
+    static double uniform(std::mt19937_64& rng,const double lo,const double hi) {
+      return lo + (hi-lo)*(double(rng() >> 11)*(1./9007199254740992.));
+    }
+
+    static double logUniform(std::mt19937_64& rng,
+                             const double lo,const double hi) {
+      return std::exp(uniform(rng,std::log(lo),std::log(hi)));
+    }
+
+    uint64_t _seed;
+  };
+
+} // namespace anpi
+
+#endif
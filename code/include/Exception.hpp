@@ -9,6 +9,8 @@
  */
 
 #include <exception>
+#include <limits>
+#include <string>
 
 #ifndef ANPI_EXCEPTION_HPP
 #define ANPI_EXCEPTION_HPP
@@ -24,6 +26,23 @@ namespace anpi {
     inline Exception(const std::string& name="anpi exception") : _name(name) { }
     inline const char* what() const noexcept { return _name.c_str(); }
   };
+
+  namespace detail {
+
+    /**
+     * Root of solve(), or NaN if it throws anpi::Exception, as the root
+     * finders do for invalid brackets and exhausted evaluation budgets.
+     */
+    template<typename T,class Solve>
+    inline T solveOrNaN(const Solve& solve) {
+      try {
+        return solve();
+      } catch (anpi::Exception&) {
+        return std::numeric_limits<T>::quiet_NaN();
+      }
+    }
+
+  } // namespace detail
   
 }
 
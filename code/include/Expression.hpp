@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_EXPRESSION_HPP
+#define ANPI_EXPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Exception.hpp"
+
+namespace anpi {
+
+  /**
+   * Function of x given as text at runtime, for instance
+   * "abs(x)-exp(-x)", compiled to a register based bytecode.
+   *
+   * Syntax: numbers, the variable x, the constants pi and e, the
+   * operators + - * / ^ (right associative, binding tighter than the
+   * unary minus, so -x^2 = -(x^2)), parentheses, and the functions
+   *
+   *   abs exp log log10 sqrt cbrt sin cos tan asin acos atan
+   *   sinh cosh tanh floor ceil        (one argument)
+   *   pow min max atan2                (two arguments)
+   *
+   * The compiler folds constant subexpressions, shares common
+   * subexpressions (also up to the order of the operands of + * min
+   * max), rewrites a^2 as a*a and a^-1 as 1/a, and reuses registers
+   * whose values are no longer needed.
+   *
+   * An expression is a functor of the form "T f(T x)", so that it can
+   * be passed to all solvers through std::function.  evaluate() instead
+   * computes a whole array of values, running each instruction over a
+   * batch of Lanes values at once: the dispatch cost is then shared by
+   * all lanes, and the arithmetic of each instruction vectorizes.
+   *
+   * Copies share the compiled program.
+   */
+  template<typename T>
+  class expression {
+  public:
+    /// Values processed by each instruction in evaluate()
+    static const size_t Lanes = 128u/sizeof(T);
+    /// Maximum number of registers of a program
+    static const size_t MaxRegisters = 256u;
+
+    /// Operations of the bytecode
+    enum opcode {
+      // binary
+      Add = 0, Sub, Mul, Div, Pow, Min, Max, Atan2,
+      // unary
+      Neg, Abs, Exp, Log, Log10, Sqrt, Cbrt, Sin, Cos, Tan,
+      Asin, Acos, Atan, Sinh, Cosh, Tanh, Floor, Ceil,
+      NumOpcodes
+    };
+
+    /// One instruction: r[dst] = op(r[a],r[b])
+    struct instruction {
+      uint16_t op;
+      uint16_t dst;
+      uint16_t a;
+      uint16_t b;
+    };
+
+    /// Expression "x"
+    expression();
+
+    /**
+     * Compile the given text.
+     *
+     * @throws anpi::Exception with the column of the error if the text
+     *         is not a valid expression
+     */
+    explicit expression(const std::string& text);
+
+    /// Value at x
+    inline T operator()(const T x) const;
+
+    /// Compute y[i] = f(x[i]) for i in [0,n)
+    void evaluate(const T* x,T* y,const size_t n) const;
+
+    /// Compute y[i] = f(x[i]) for all elements of x
+    void evaluate(const std::vector<T>& x,std::vector<T>& y) const;
+
+    /// Source text
+    const std::string& text() const { return _p->text; }
+
+    /// Compiled instructions
+    const std::vector<instruction>& instructions() const {
+      return _p->code;
+    }
+
+    /// Registers used: x, the constants and the temporaries
+    size_t registers() const { return _p->registers; }
+
+    /// Readable listing of the program
+    std::string disassemble() const;
+
+    /// Name of an opcode
+    static const char* name(const int op);
+
+    /// Result of one operation, as evaluated by the bytecode
+    static inline T apply(const int op,const T a,const T b);
+
+  private:
+    struct program {
+      std::string text;
+      /// Values of registers 1..constants.size(); register 0 is x
+      std::vector<T> constants;
+      std::vector<instruction> code;
+      size_t registers;
+      /// Register holding the result
+      uint16_t result;
+    };
+
+    class compiler;
+
+    std::shared_ptr<const program> _p;
+  };
+
+} // namespace anpi
+
+#include "Expression.tpp"
+
+#endif
@@ -0,0 +1,522 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ *
+ * Parser, compiler and interpreter of runtime expressions.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+namespace anpi {
+
+  template<typename T>
+  const size_t expression<T>::Lanes;
+
+  template<typename T>
+  const size_t expression<T>::MaxRegisters;
+
+  /**
+   * Recursive descent parser building a DAG of nodes, hash-consed so
+   * that equal subexpressions become the same node, and emitting the
+   * bytecode of the nodes reachable from the root.
+   */
+  template<typename T>
+  class expression<T>::compiler {
+  public:
+    explicit compiler(const std::string& text) : _s(text),_pos(0u) {}
+
+    void compile(program& p) {
+      const int root = parseExpr();
+      skip();
+      if (_pos < _s.size()) {
+        fail("unexpected '" + _s.substr(_pos,1u) + "'");
+      }
+
+      // nodes reachable from the root; operands precede their users
+      const size_t n = _nodes.size();
+      std::vector<char> live(n,0);
+      live[size_t(root)] = 1;
+      for (size_t i=n;i-->0u;) {
+        if (live[i] && _nodes[i].op >= 0) {
+          live[size_t(_nodes[i].a)] = 1;
+          if (_nodes[i].b >= 0) live[size_t(_nodes[i].b)] = 1;
+        }
+      }
+
+      // register 0 is x, then the constants, then the temporaries
+      std::vector<uint16_t> reg(n,0u);
+      std::vector<size_t> lastUse(n,0u);
+      p.constants.clear();
+      for (size_t i=0;i<n;++i) {
+        if (!live[i]) continue;
+        if (_nodes[i].op == Constant) {
+          p.constants.push_back(_nodes[i].value);
+          reg[i] = uint16_t(p.constants.size());
+        } else if (_nodes[i].op >= 0) {
+          lastUse[size_t(_nodes[i].a)] = i;
+          if (_nodes[i].b >= 0) lastUse[size_t(_nodes[i].b)] = i;
+        }
+      }
+
+      size_t next = p.constants.size() + 1u;
+      std::vector<uint16_t> free;
+      p.code.clear();
+      for (size_t i=0;i<n;++i) {
+        const node& nd = _nodes[i];
+        if (!live[i] || nd.op < 0) continue;
+
+        // operands read for the last time can hold the result
+        const size_t a = size_t(nd.a);
+        const size_t b = (nd.b >= 0) ? size_t(nd.b) : a;
+        if (_nodes[a].op >= 0 && lastUse[a] == i) free.push_back(reg[a]);
+        if (b != a && _nodes[b].op >= 0 && lastUse[b] == i) {
+          free.push_back(reg[b]);
+        }
+
+        if (free.empty()) {
+          if (next >= MaxRegisters) {
+            throw anpi::Exception("Expression too complex: " + _s);
+          }
+          reg[i] = uint16_t(next++);
+        } else {
+          reg[i] = free.back();
+          free.pop_back();
+        }
+
+        instruction in;
+        in.op  = uint16_t(nd.op);
+        in.dst = reg[i];
+        in.a   = reg[a];
+        in.b   = reg[b];
+        p.code.push_back(in);
+      }
+
+      p.registers = next;
+      p.result = reg[size_t(root)];
+      p.text = _s;
+    }
+
+  private:
+    /// Leaves of the DAG, besides the opcodes
+    enum { Variable = -1, Constant = -2 };
+
+    struct node {
+      int op;
+      int a;
+      int b;
+      T value;
+    };
+
+    typedef std::tuple<int,int,int,uint64_t> key;
+
+    std::string _s;
+    size_t _pos;
+    std::vector<node> _nodes;
+    std::map<key,int> _index;
+
+    static bool unary(const int op) { return op >= Neg; }
+
+    bool isConstant(const int n) const {
+      return _nodes[size_t(n)].op == Constant;
+    }
+
+    bool isConstant(const int n,const double v) const {
+      return isConstant(n) && (double(_nodes[size_t(n)].value) == v);
+    }
+
+    /// Node of the given contents, shared if it already exists
+    int intern(const int op,const int a,const int b,const T value) {
+      uint64_t bits = 0u;
+      const double v = double(value);
+      std::memcpy(&bits,&v,sizeof(bits));
+      const key k(op,a,b,bits);
+      typename std::map<key,int>::const_iterator it = _index.find(k);
+      if (it != _index.end()) {
+        return it->second;
+      }
+      node nd;
+      nd.op = op;
+      nd.a = a;
+      nd.b = b;
+      nd.value = value;
+      _nodes.push_back(nd);
+      const int id = int(_nodes.size()) - 1;
+      _index[k] = id;
+      return id;
+    }
+
+    int constant(const T v) { return intern(Constant,-1,-1,v); }
+
+    int variable() { return intern(Variable,-1,-1,T(0)); }
+
+    /// Node of op(a,b), folded and simplified where possible
+    int make(const int op,int a,int b) {
+      if (unary(op)) {
+        b = -1;
+        if (isConstant(a)) {
+          return constant(apply(op,_nodes[size_t(a)].value,T(0)));
+        }
+        if (op == Neg && _nodes[size_t(a)].op == Neg) {
+          return _nodes[size_t(a)].a;
+        }
+        return intern(op,a,-1,T(0));
+      }
+
+      if (isConstant(a) && isConstant(b)) {
+        return constant(apply(op,_nodes[size_t(a)].value,
+                              _nodes[size_t(b)].value));
+      }
+
+      switch (op) {
+      case Add:
+        if (isConstant(a,0.)) return b;
+        if (isConstant(b,0.)) return a;
+        break;
+      case Sub:
+        if (isConstant(b,0.)) return a;
+        if (isConstant(a,0.)) return make(Neg,b,-1);
+        break;
+      case Mul:
+        if (isConstant(a,1.)) return b;
+        if (isConstant(b,1.)) return a;
+        break;
+      case Div:
+        if (isConstant(b,1.)) return a;
+        break;
+      case Pow:
+        if (isConstant(b,1.)) return a;
+        if (isConstant(b,2.)) return make(Mul,a,a);
+        if (isConstant(b,-1.)) return make(Div,constant(T(1)),a);
+        break;
+      default:
+        break;
+      }
+
+      // commutative operations are shared regardless of operand order
+      if ((op == Add || op == Mul || op == Min || op == Max) && (a > b)) {
+        std::swap(a,b);
+      }
+      return intern(op,a,b,T(0));
+    }
+
+    void fail(const std::string& msg) const {
+      std::ostringstream os;
+      os << "Expression error at column " << _pos+1u << ": " << msg;
+      throw anpi::Exception(os.str());
+    }
+
+    void skip() {
+      while (_pos < _s.size() && std::isspace((unsigned char)_s[_pos])) {
+        ++_pos;
+      }
+    }
+
+    bool accept(const char c) {
+      skip();
+      if (_pos < _s.size() && _s[_pos] == c) {
+        ++_pos;
+        return true;
+      }
+      return false;
+    }
+
+    void expect(const char c) {
+      if (!accept(c)) {
+        fail(std::string("expected '") + c + "'");
+      }
+    }
+
+    int parseExpr() {
+      int l = parseTerm();
+      for (;;) {
+        if (accept('+')) {
+          l = make(Add,l,parseTerm());
+        } else if (accept('-')) {
+          l = make(Sub,l,parseTerm());
+        } else {
+          return l;
+        }
+      }
+    }
+
+    int parseTerm() {
+      int l = parseUnary();
+      for (;;) {
+        if (accept('*')) {
+          l = make(Mul,l,parseUnary());
+        } else if (accept('/')) {
+          l = make(Div,l,parseUnary());
+        } else {
+          return l;
+        }
+      }
+    }
+
+    int parseUnary() {
+      if (accept('-')) return make(Neg,parseUnary(),-1);
+      if (accept('+')) return parseUnary();
+      return parsePower();
+    }
+
+    int parsePower() {
+      const int base = parsePrimary();
+      if (accept('^')) {
+        return make(Pow,base,parseUnary());
+      }
+      return base;
+    }
+
+    int parsePrimary() {
+      skip();
+      if (_pos >= _s.size()) {
+        fail("unexpected end");
+      }
+      const char c = _s[_pos];
+
+      if (std::isdigit((unsigned char)c) || c == '.') {
+        const char* begin = _s.c_str() + _pos;
+        char* end = 0;
+        const double v = std::strtod(begin,&end);
+        if (end == begin) {
+          fail("invalid number");
+        }
+        _pos += size_t(end - begin);
+        return constant(T(v));
+      }
+
+      if (accept('(')) {
+        const int e = parseExpr();
+        expect(')');
+        return e;
+      }
+
+      if (!std::isalpha((unsigned char)c)) {
+        fail(std::string("unexpected '") + c + "'");
+      }
+      const size_t start = _pos;
+      while (_pos < _s.size() &&
+             (std::isalnum((unsigned char)_s[_pos]) || _s[_pos] == '_')) {
+        ++_pos;
+      }
+      const std::string id = _s.substr(start,_pos - start);
+
+      if (id == "x")  return variable();
+      if (id == "pi") return constant(T(3.14159265358979323846));
+      if (id == "e")  return constant(T(2.71828182845904523536));
+
+      for (int op=Add;op<NumOpcodes;++op) {
+        if ((op == Add) || (op == Sub) || (op == Mul) || (op == Div) ||
+            (op == Neg) || (id != name(op))) {
+          continue;
+        }
+        expect('(');
+        const int a = parseExpr();
+        int b = -1;
+        if (!unary(op)) {
+          expect(',');
+          b = parseExpr();
+        }
+        expect(')');
+        return make(op,a,b);
+      }
+
+      _pos = start;
+      fail("unknown name '" + id + "'");
+      return -1;
+    }
+  };
+
+  template<typename T>
+  expression<T>::expression() {
+    program* p = new program();
+    std::shared_ptr<const program> sp(p);
+    compiler("x").compile(*p);
+    _p = sp;
+  }
+
+  template<typename T>
+  expression<T>::expression(const std::string& text) {
+    program* p = new program();
+    std::shared_ptr<const program> sp(p);
+    compiler(text).compile(*p);
+    _p = sp;
+  }
+
+  template<typename T>
+  const char* expression<T>::name(const int op) {
+    static const char* names[NumOpcodes] = {
+      "add","sub","mul","div","pow","min","max","atan2",
+      "neg","abs","exp","log","log10","sqrt","cbrt","sin","cos","tan",
+      "asin","acos","atan","sinh","cosh","tanh","floor","ceil"
+    };
+    return (op >= 0 && op < NumOpcodes) ? names[op] : "?";
+  }
+
+  template<typename T>
+  inline T expression<T>::apply(const int op,const T a,const T b) {
+    switch (op) {
+    case Add:   return a + b;
+    case Sub:   return a - b;
+    case Mul:   return a * b;
+    case Div:   return a / b;
+    case Pow:   return std::pow(a,b);
+    case Min:   return (b < a) ? b : a;
+    case Max:   return (a < b) ? b : a;
+    case Atan2: return std::atan2(a,b);
+    case Neg:   return -a;
+    case Abs:   return std::abs(a);
+    case Exp:   return std::exp(a);
+    case Log:   return std::log(a);
+    case Log10: return std::log10(a);
+    case Sqrt:  return std::sqrt(a);
+    case Cbrt:  return std::cbrt(a);
+    case Sin:   return std::sin(a);
+    case Cos:   return std::cos(a);
+    case Tan:   return std::tan(a);
+    case Asin:  return std::asin(a);
+    case Acos:  return std::acos(a);
+    case Atan:  return std::atan(a);
+    case Sinh:  return std::sinh(a);
+    case Cosh:  return std::cosh(a);
+    case Tanh:  return std::tanh(a);
+    case Floor: return std::floor(a);
+    case Ceil:  return std::ceil(a);
+    }
+    return std::numeric_limits<T>::quiet_NaN();
+  }
+
+  template<typename T>
+  inline T expression<T>::operator()(const T x) const {
+    const program& p = *_p;
+    T r[MaxRegisters];
+    r[0] = x;
+    for (size_t c=0;c<p.constants.size();++c) {
+      r[c+1u] = p.constants[c];
+    }
+    for (size_t i=0;i<p.code.size();++i) {
+      const instruction& in = p.code[i];
+      r[in.dst] = apply(in.op,r[in.a],r[in.b]);
+    }
+    return r[p.result];
+  }
+
+// One loop over the lanes per instruction, where u and v are the
+// operands of each lane
+#define ANPI_EXPR_BINARY(OP,EXPR)               \
+  case OP:                                      \
+    for (size_t l=0;l<Lanes;++l) {              \
+      const T u = a[l];                         \
+      const T v = b[l];                         \
+      d[l] = (EXPR);                            \
+    }                                           \
+    break;
+
+#define ANPI_EXPR_UNARY(OP,EXPR)                \
+  case OP:                                      \
+    for (size_t l=0;l<Lanes;++l) {              \
+      const T u = a[l];                         \
+      d[l] = (EXPR);                            \
+    }                                           \
+    break;
+
+  template<typename T>
+  void expression<T>::evaluate(const T* x,T* y,const size_t n) const {
+    if (n == 0u) return;
+    const program& p = *_p;
+
+    // register file of Lanes values per register, with the constants
+    // broadcast once
+    std::vector<T> regs(p.registers*Lanes);
+    for (size_t c=0;c<p.constants.size();++c) {
+      std::fill_n(regs.begin() + std::ptrdiff_t((c+1u)*Lanes),Lanes,
+                  p.constants[c]);
+    }
+    T* r = &regs.front();
+
+    for (size_t i=0;i<n;i+=Lanes) {
+      // the last batch is padded with valid values
+      const size_t m = std::min(Lanes,n - i);
+      std::copy(x + i,x + i + m,r);
+      std::fill(r + m,r + Lanes,x[i]);
+
+      for (size_t k=0;k<p.code.size();++k) {
+        const instruction& in = p.code[k];
+        T* d = r + size_t(in.dst)*Lanes;
+        const T* a = r + size_t(in.a)*Lanes;
+        const T* b = r + size_t(in.b)*Lanes;
+        switch (in.op) {
+          ANPI_EXPR_BINARY(Add,u + v)
+          ANPI_EXPR_BINARY(Sub,u - v)
+          ANPI_EXPR_BINARY(Mul,u * v)
+          ANPI_EXPR_BINARY(Div,u / v)
+          ANPI_EXPR_BINARY(Pow,std::pow(u,v))
+          ANPI_EXPR_BINARY(Min,(v < u) ? v : u)
+          ANPI_EXPR_BINARY(Max,(u < v) ? v : u)
+          ANPI_EXPR_BINARY(Atan2,std::atan2(u,v))
+          ANPI_EXPR_UNARY(Neg,-u)
+          ANPI_EXPR_UNARY(Abs,std::abs(u))
+          ANPI_EXPR_UNARY(Exp,std::exp(u))
+          ANPI_EXPR_UNARY(Log,std::log(u))
+          ANPI_EXPR_UNARY(Log10,std::log10(u))
+          ANPI_EXPR_UNARY(Sqrt,std::sqrt(u))
+          ANPI_EXPR_UNARY(Cbrt,std::cbrt(u))
+          ANPI_EXPR_UNARY(Sin,std::sin(u))
+          ANPI_EXPR_UNARY(Cos,std::cos(u))
+          ANPI_EXPR_UNARY(Tan,std::tan(u))
+          ANPI_EXPR_UNARY(Asin,std::asin(u))
+          ANPI_EXPR_UNARY(Acos,std::acos(u))
+          ANPI_EXPR_UNARY(Atan,std::atan(u))
+          ANPI_EXPR_UNARY(Sinh,std::sinh(u))
+          ANPI_EXPR_UNARY(Cosh,std::cosh(u))
+          ANPI_EXPR_UNARY(Tanh,std::tanh(u))
+          ANPI_EXPR_UNARY(Floor,std::floor(u))
+          ANPI_EXPR_UNARY(Ceil,std::ceil(u))
+        }
+      }
+
+      const T* res = r + size_t(p.result)*Lanes;
+      std::copy(res,res + m,y + i);
+    }
+  }
+
+#undef ANPI_EXPR_BINARY
+#undef ANPI_EXPR_UNARY
+
+  template<typename T>
+  void expression<T>::evaluate(const std::vector<T>& x,
+                               std::vector<T>& y) const {
+    y.resize(x.size());
+    if (!x.empty()) {
+      evaluate(&x.front(),&y.front(),x.size());
+    }
+  }
+
+  template<typename T>
+  std::string expression<T>::disassemble() const {
+    const program& p = *_p;
+    std::ostringstream os;
+    os.precision(17);
+    for (size_t c=0;c<p.constants.size();++c) {
+      os << "r" << c+1u << " = " << p.constants[c] << "\n";
+    }
+    for (size_t i=0;i<p.code.size();++i) {
+      const instruction& in = p.code[i];
+      os << "r" << in.dst << " = " << name(in.op) << " r" << in.a;
+      if (in.op < Neg) os << " r" << in.b;
+      os << "\n";
+    }
+    os << "return r" << p.result << "\n";
+    return os.str();
+  }
+
+} // namespace anpi
@@ -54,4 +54,39 @@
     : public std::integral_constant<bool,                               \
                                     detail::HasType_##Type<T>::value> { \
   }
+
+/**
+ * Generates a metafunction to check if a class has a member (method or
+ * attribute) with the given name.
+ *
+ * For example:
+ *
+ * \code
+ * GENERATE_HAS_MEMBER(foobar)
+ * \endcode
+ *
+ * generates a metafunction, such that \c has_member_foobar<T>::value
+ * is true iff &T::foobar is valid, or false otherwise.  Overloaded
+ * members are not detected.
+ */
+#define GENERATE_HAS_MEMBER(Member)                                     \
+  namespace detail {                                                    \
+    template < class T >                                                \
+    class HasMember_##Member {                                          \
+    private:                                                            \
+      template < class U >                                              \
+      static std::true_type test ( decltype(&U::Member) );              \
+      template < class U >                                              \
+      static std::false_type test ( ... );                              \
+    public:                                                             \
+      static constexpr bool value =                                     \
+        decltype(test<T>(nullptr))::value;                              \
+    };                                                                  \
+  } /* namespace detail */                                              \
+                                                                        \
+  template < class T >                                                  \
+  struct has_member_##Member                                            \
+    : public std::integral_constant<bool,                               \
+                                    detail::HasMember_##Member<T>::value> { \
+  }
 #endif
@@ -0,0 +1,445 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_INSTRUMENTATION_HPP
+#define ANPI_INSTRUMENTATION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Profiler.hpp"
+
+namespace anpi {
+
+  /**
+   * Histogram with logarithmic buckets, in the style of HdrHistogram.
+   *
+   * Values below 16 have a bucket each.  Above, every power of two is
+   * split in 16 linear sub-buckets, so that any value is represented
+   * with a relative error below 1/16, in 976 buckets covering the whole
+   * 64 bit range.
+   */
+  class logHistogram {
+  public:
+    /// Bits of the linear subdivision of each power of two
+    static const int SubBits = 4;
+    /// Sub-buckets per power of two
+    static const size_t SubBuckets = size_t(1u) << SubBits;
+    /// Total number of buckets
+    static const size_t NumBuckets = (64u - SubBits + 1u)*SubBuckets;
+
+    /// One bucket of a snapshot: all values in [lower,upper]
+    struct bucket {
+      uint64_t lower;
+      uint64_t upper;
+      uint64_t count;
+    };
+
+    logHistogram() { clear(); }
+
+    /// Bucket index of a value
+    static size_t index(const uint64_t v) {
+      if (v < SubBuckets) {
+        return size_t(v);
+      }
+      const int e = 63 - clz(v);
+      const size_t sub = size_t(v >> (e - SubBits)) & (SubBuckets-1u);
+      return size_t(e - SubBits + 1)*SubBuckets + sub;
+    }
+
+    /// Smallest value of a bucket
+    static uint64_t lowerBound(const size_t b) {
+      if (b < SubBuckets) {
+        return uint64_t(b);
+      }
+      const int e = int(b/SubBuckets) + SubBits - 1;
+      return uint64_t(SubBuckets + b%SubBuckets) << (e - SubBits);
+    }
+
+    /// Largest value of a bucket
+    static uint64_t upperBound(const size_t b) {
+      if (b < SubBuckets) {
+        return uint64_t(b);
+      }
+      const int e = int(b/SubBuckets) + SubBits - 1;
+      return lowerBound(b) + ((uint64_t(1u) << (e - SubBits)) - 1u);
+    }
+
+    /// Remove all values
+    void clear() {
+      for (size_t b=0;b<NumBuckets;++b) {
+        _counts[b] = 0u;
+      }
+      _total = 0u;
+      _sum = 0.;
+    }
+
+    /// Add n times the value v
+    void record(const uint64_t v,const uint64_t n = 1u) {
+      _counts[index(v)] += n;
+      _total += n;
+      _sum += double(v)*double(n);
+    }
+
+    /**
+     * Add n values known to fall into bucket b.  Their sum must be
+     * added with addSum() for mean() to be exact.
+     */
+    void addBucket(const size_t b,const uint64_t n) {
+      _counts[b] += n;
+      _total += n;
+    }
+
+    /// Add to the sum of the recorded values
+    void addSum(const double sum) { _sum += sum; }
+
+    /// Add all values of another histogram
+    void merge(const logHistogram& other) {
+      for (size_t b=0;b<NumBuckets;++b) {
+        _counts[b] += other._counts[b];
+      }
+      _total += other._total;
+      _sum += other._sum;
+    }
+
+    /// Number of values in one bucket
+    uint64_t count(const size_t b) const { return _counts[b]; }
+
+    /// Number of values recorded
+    uint64_t total() const { return _total; }
+
+    /// Exact mean of the recorded values
+    double mean() const { return (_total > 0u) ? _sum/double(_total) : 0.; }
+
+    /// Lower bound of the bucket of the smallest value
+    uint64_t min() const {
+      for (size_t b=0;b<NumBuckets;++b) {
+        if (_counts[b] > 0u) return lowerBound(b);
+      }
+      return 0u;
+    }
+
+    /// Upper bound of the bucket of the largest value
+    uint64_t max() const {
+      for (size_t b=NumBuckets;b-- > 0;) {
+        if (_counts[b] > 0u) return upperBound(b);
+      }
+      return 0u;
+    }
+
+    /**
+     * Upper bound of the bucket holding the p-quantile (p in [0,1]),
+     * i.e. a value not exceeded by at least a fraction p of the values
+     */
+    uint64_t percentile(const double p) const {
+      if (_total == 0u) {
+        return 0u;
+      }
+      const double rank = std::max(1.,std::ceil(p*double(_total)));
+      uint64_t seen = 0u;
+      for (size_t b=0;b<NumBuckets;++b) {
+        seen += _counts[b];
+        if (double(seen) >= rank) {
+          return upperBound(b);
+        }
+      }
+      return max();
+    }
+
+    /// The non-empty buckets, in increasing order
+    std::vector<bucket> buckets() const {
+      std::vector<bucket> result;
+      for (size_t b=0;b<NumBuckets;++b) {
+        if (_counts[b] > 0u) {
+          bucket bk = { lowerBound(b), upperBound(b), _counts[b] };
+          result.push_back(bk);
+        }
+      }
+      return result;
+    }
+
+  private:
+    /// Count of leading zeros of a non-zero value
+    static int clz(const uint64_t v) {
+#if defined(__GNUC__)
+      return __builtin_clzll(v);
+#else
+      int n = 0;
+      for (uint64_t m = uint64_t(1u) << 63; (v & m) == 0u; m >>= 1) ++n;
+      return n;
+#endif
+    }
+
+    uint64_t _counts[NumBuckets];
+    uint64_t _total;
+    double _sum;
+  };
+
+  /**
+   * Merged state of an instrumented function at one point in time
+   */
+  struct instrumentationSnapshot {
+    /// Calls to the function
+    uint64_t evaluations;
+    /// Solves finished with endSolve()
+    uint64_t solves;
+    /// Duration of each evaluation, in nanoseconds
+    logHistogram latency;
+    /// Evaluations of each solve
+    logHistogram iterations;
+  };
+
+  /**
+   * Counters of an instrumented function, sharded per thread.
+   *
+   * Each thread writes only into its own shard, so that the hot path
+   * has no contended atomic operations nor locks: the counters are
+   * atomic only to be read safely by other threads, and are updated
+   * with plain relaxed loads and stores.  The shards are merged when
+   * read.  A small per-thread cache finds the shard of the calling
+   * thread without locking; the registry mutex is only taken the
+   * first time a thread uses a function.
+   */
+  class instrumentationState {
+  public:
+    /// What to record besides the number of evaluations
+    enum option {
+      Counts     = 0,
+      /// Histogram of the duration of each evaluation
+      Latency    = 1,
+      /// Histogram of the evaluations per solve (see endSolve())
+      Iterations = 2
+    };
+
+    explicit instrumentationState(const unsigned opts)
+      : _id(nextId()),_options(opts) {}
+
+    unsigned options() const { return _options; }
+
+    /// Count one evaluation of the calling thread
+    void evaluation() {
+      shard& s = local();
+      bump(s.evaluations,1u);
+    }
+
+    /// Count one evaluation that took the given nanoseconds
+    void evaluation(const uint64_t ns) {
+      shard& s = local();
+      bump(s.evaluations,1u);
+      bump(s.latency[logHistogram::index(ns)],1u);
+      bump(s.latencySum,ns);
+    }
+
+    /// Start a solve in the calling thread
+    void beginSolve() {
+      shard& s = local();
+      s.solveStart = s.evaluations.load(std::memory_order_relaxed);
+    }
+
+    /// Finish the solve of the calling thread started with beginSolve()
+    void endSolve() {
+      shard& s = local();
+      const uint64_t n =
+        s.evaluations.load(std::memory_order_relaxed) - s.solveStart;
+      bump(s.solves,1u);
+      if (_options & Iterations) {
+        bump(s.iterations[logHistogram::index(n)],1u);
+        bump(s.iterationSum,n);
+      }
+    }
+
+    /// Merge all shards
+    instrumentationSnapshot read() const {
+      instrumentationSnapshot snap;
+      snap.evaluations = 0u;
+      snap.solves = 0u;
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (const auto& entry : _shards) {
+        const shard& s = *entry.second;
+        snap.evaluations += s.evaluations.load(std::memory_order_relaxed);
+        snap.solves      += s.solves.load(std::memory_order_relaxed);
+        snap.latency.addSum(double(s.latencySum.load(std::memory_order_relaxed)));
+        snap.iterations.addSum(double(s.iterationSum.
+                                      load(std::memory_order_relaxed)));
+        for (size_t b=0;b<logHistogram::NumBuckets;++b) {
+          const uint64_t l = s.latency[b].load(std::memory_order_relaxed);
+          const uint64_t i = s.iterations[b].load(std::memory_order_relaxed);
+          if (l > 0u) snap.latency.addBucket(b,l);
+          if (i > 0u) snap.iterations.addBucket(b,i);
+        }
+      }
+      return snap;
+    }
+
+    /// Set all counters to zero.  Not meant to race with evaluations.
+    void reset() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (auto& entry : _shards) {
+        shard& s = *entry.second;
+        s.evaluations.store(0u,std::memory_order_relaxed);
+        s.solves.store(0u,std::memory_order_relaxed);
+        s.latencySum.store(0u,std::memory_order_relaxed);
+        s.iterationSum.store(0u,std::memory_order_relaxed);
+        s.solveStart = 0u;
+        for (size_t b=0;b<logHistogram::NumBuckets;++b) {
+          s.latency[b].store(0u,std::memory_order_relaxed);
+          s.iterations[b].store(0u,std::memory_order_relaxed);
+        }
+      }
+    }
+
+  private:
+    instrumentationState(const instrumentationState&);
+    instrumentationState& operator=(const instrumentationState&);
+
+    /// Counters written by one thread only
+    struct shard {
+      shard() : evaluations(0u),solves(0u),latencySum(0u),iterationSum(0u),
+                solveStart(0u) {
+        for (size_t b=0;b<logHistogram::NumBuckets;++b) {
+          latency[b]    = 0u;
+          iterations[b] = 0u;
+        }
+      }
+
+      // padding keeps the hot counters of different threads on
+      // different cache lines
+      char padFront[64];
+      std::atomic<uint64_t> evaluations;
+      std::atomic<uint64_t> solves;
+      std::atomic<uint64_t> latencySum;
+      std::atomic<uint64_t> iterationSum;
+      uint64_t solveStart;
+      char padBack[64];
+      std::atomic<uint64_t> latency[logHistogram::NumBuckets];
+      std::atomic<uint64_t> iterations[logHistogram::NumBuckets];
+    };
+
+    /// Uncontended increment of a counter owned by the calling thread
+    static void bump(std::atomic<uint64_t>& c,const uint64_t n) {
+      c.store(c.load(std::memory_order_relaxed) + n,
+              std::memory_order_relaxed);
+    }
+
+    /// Unique id of each state, never reused
+    static uint64_t nextId() {
+      static std::atomic<uint64_t> id(1u);
+      return id.fetch_add(1u);
+    }
+
+    /// Shard of the calling thread
+    shard& local() {
+      struct cacheEntry {
+        uint64_t id;
+        shard* s;
+      };
+      static const size_t CacheSize = 8u;
+      static thread_local cacheEntry cache[CacheSize];
+
+      cacheEntry& entry = cache[_id % CacheSize];
+      if (entry.id == _id) {
+        return *entry.s;
+      }
+
+      const std::thread::id self = std::this_thread::get_id();
+      std::lock_guard<std::mutex> lock(_mutex);
+      shard* s = 0;
+      for (auto& sh : _shards) {
+        if (sh.first == self) {
+          s = sh.second.get();
+          break;
+        }
+      }
+      if (s == 0) {
+        _shards.push_back(std::make_pair(self,
+                                         std::unique_ptr<shard>(new shard())));
+        s = _shards.back().second.get();
+      }
+      entry.id = _id;
+      entry.s  = s;
+      return *s;
+    }
+
+    const uint64_t _id;
+    const unsigned _options;
+    mutable std::mutex _mutex;
+    std::vector<std::pair<std::thread::id,std::unique_ptr<shard> > > _shards;
+  };
+
+  /**
+   * Instrumented function, usable in parallel solves.
+   *
+   * It wraps a function and counts its evaluations per thread (see
+   * instrumentationState).  Copies share the same counters, so that
+   * the wrapper can be passed by value as a std::function<T(T)> and
+   * still be read afterwards, without std::function::target().
+   *
+   * Optionally, the duration of each evaluation and the number of
+   * evaluations of each solve (delimited with beginSolve() and
+   * endSolve() in the solving thread) are collected in histograms.
+   */
+  template<typename T>
+  class instrumented {
+  public:
+    /**
+     * Wrap the function f
+     *
+     * @param opts combination of instrumentationState::Latency and
+     *        instrumentationState::Iterations
+     */
+    explicit instrumented(const std::function<T(T)>& f,
+                          const unsigned opts = instrumentationState::Counts)
+      : _f(f),_state(std::make_shared<instrumentationState>(opts)) {}
+
+    /// Evaluate the function
+    T operator()(const T x) const {
+      ANPI_PROFILE_SCOPE("eval","evaluate");
+      if (_state->options() & instrumentationState::Latency) {
+        typedef std::chrono::steady_clock clock;
+        const clock::time_point start = clock::now();
+        const T y = _f(x);
+        const std::chrono::nanoseconds d = clock::now() - start;
+        _state->evaluation(uint64_t(d.count()));
+        return y;
+      }
+      _state->evaluation();
+      return _f(x);
+    }
+
+    /// Start a solve in the calling thread
+    void beginSolve() const { _state->beginSolve(); }
+
+    /// Finish the solve of the calling thread
+    void endSolve() const { _state->endSolve(); }
+
+    /// Total evaluations of all threads so far
+    uint64_t evaluations() const { return _state->read().evaluations; }
+
+    /// Merged counters and histograms of all threads
+    instrumentationSnapshot snapshot() const { return _state->read(); }
+
+    /// Restart all counters
+    void reset() const { _state->reset(); }
+
+  private:
+    std::function<T(T)> _f;
+    std::shared_ptr<instrumentationState> _state;
+  };
+
+} // namespace anpi
+
+#endif
@@ -46,6 +46,11 @@ namespace anpi
    * use anpi::aligned_allocator and for forcing the alignment of each
    * row you can use anpi::aligned_row_allocator, both defined in
    * <Allocator.hpp>.
+   *
+   * For very large matrices anpi::huge_page_row_allocator requests
+   * huge pages and initializes the rows in parallel (first touch), so
+   * that on NUMA systems each page lands on the node of the thread
+   * that processes it.
    */
   template<typename T,class Alloc=anpi::aligned_row_allocator<T> >
   class Matrix {
@@ -87,6 +92,9 @@ namespace anpi
       /// Dominant (real) number of columns
       size_t _dcols;
 
+      /// Number of entries reserved in the buffer (at least tentries())
+      size_t _capacity;
+
       /// Return the total number of entries (i.e. real buffer size)
       inline size_t tentries() const {return _rows*_dcols;}
 
@@ -97,6 +105,10 @@ namespace anpi
       /// Allocator indicates we must align each row
       static constexpr bool rowAlign =
         extract_alignment<allocator_type>::row_aligned;
+
+      /// Allocator requests parallel first-touch initialization
+      static constexpr bool firstTouch =
+        extract_alignment<allocator_type>::first_touch;
       
       /**
        * @name Default constructor
@@ -179,14 +191,16 @@ namespace anpi
     /**
      * Compare two matrices for equality
      *
-     * This is slow, as all componentes are elementwise compared
+     * The components are bitwise compared, ignoring the padding, and
+     * the comparison stops at the first block of entries that differs.
      */
     bool operator==(const Matrix<T,Alloc>& other) const;
 
     /**
-     * Compare two matrices for equality
+     * Compare two matrices for inequality
      *
-     * This is slow, as all componentes are elementwise compared
+     * The components are bitwise compared, ignoring the padding, and
+     * the comparison stops at the first block of entries that differs.
      */
     bool operator!=(const Matrix<T,Alloc>& other) const;
     
@@ -219,9 +233,28 @@ namespace anpi
     
     /**
      * Allocate memory for the given number of rows and cols
+     *
+     * If the new shape fits into the already reserved buffer, no
+     * memory is allocated and just the shape (and padding) is updated.
+     * In any case, the content of the matrix is undefined afterwards.
      */
     void allocate(const size_t row,const size_t col);
 
+    /**
+     * Ensure that the buffer can hold a matrix of the given size
+     * without further allocations.
+     *
+     * The shape and content of the matrix are kept.
+     */
+    void reserve(const size_t row,const size_t col);
+
+    /**
+     * Release the reserved memory not required by the current shape
+     *
+     * The shape and content of the matrix are kept.
+     */
+    void shrink_to_fit();
+
     /**
      * Reset this matrix to a default constructed empty state
      */
@@ -286,6 +319,14 @@ namespace anpi
       return this->_impl._rows * this->_impl._cols;
     }
 
+    /**
+     * Number of entries (including padding) that the reserved buffer
+     * can hold
+     */
+    inline size_t capacity() const {
+      return this->_impl._capacity;
+    }
+
     /**
      * Pointer to data block
      */
@@ -321,10 +362,21 @@ namespace anpi
     // Call the memory deallocation 
     void _deallocate();
 
+    /// Move the content into a new buffer with n entries
+    void _reallocate(const size_t n);
+
     
     /// Use the allocator to create the necessary storage
     void _create_storage(size_t _rows,size_t _cols);
 
+    /**
+     * Number of entries to be reserved for a matrix of the given size.
+     * The padded number of columns is returned in dcols.
+     */
+    static size_t _storage_size(const size_t _rows,
+                                const size_t _cols,
+                                size_t& dcols);
+
     /// Read-writable reference to the allocator in use
     allocator_type& _get_allocator() noexcept;
 
@@ -346,6 +398,87 @@ namespace anpi
   template<typename T,class Alloc>
   Matrix<T,Alloc> operator-(const Matrix<T,Alloc>& a,
                             const Matrix<T,Alloc>& b);
+
+  /**
+   * @name Operators on temporaries
+   *
+   * If one of the operands is about to expire, the result is computed
+   * in place into its buffer, which is then moved into the result.
+   * Chained expressions like (a+b)+c allocate only once.
+   */
+  //@{
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator+(Matrix<T,Alloc>&& a,
+                            const Matrix<T,Alloc>& b);
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator+(const Matrix<T,Alloc>& a,
+                            Matrix<T,Alloc>&& b);
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator+(Matrix<T,Alloc>&& a,
+                            Matrix<T,Alloc>&& b);
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator-(Matrix<T,Alloc>&& a,
+                            const Matrix<T,Alloc>& b);
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator-(const Matrix<T,Alloc>& a,
+                            Matrix<T,Alloc>&& b);
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator-(Matrix<T,Alloc>&& a,
+                            Matrix<T,Alloc>&& b);
+  //@}
+
+  /**
+   * Check if all components of both matrices differ at most by tol
+   */
+  template<typename T,class Alloc,typename U>
+  bool approxEqual(const Matrix<T,Alloc>& a,
+                   const Matrix<T,Alloc>& b,
+                   const U tol);
+
+  /**
+   * @name Reductions
+   *
+   * All entries of the matrix (without padding) are reduced to a
+   * single value.  For float and double the SIMD versions accumulate
+   * in a different order than a sequential loop, so that the results
+   * may differ in the last bits.
+   */
+  //@{
+
+  /// Sum of all components
+  template<typename T,class Alloc>
+  T sum(const Matrix<T,Alloc>& a);
+
+  /// Smallest component (the matrix must not be empty)
+  template<typename T,class Alloc>
+  T min(const Matrix<T,Alloc>& a);
+
+  /// Largest component (the matrix must not be empty)
+  template<typename T,class Alloc>
+  T max(const Matrix<T,Alloc>& a);
+
+  /// Sum of the component-wise products of a and b
+  template<typename T,class Alloc>
+  T dot(const Matrix<T,Alloc>& a,
+        const Matrix<T,Alloc>& b);
+
+  /// Sum of the absolute values of all components
+  template<typename T,class Alloc>
+  T norm1(const Matrix<T,Alloc>& a);
+
+  /// Frobenius norm: square root of the sum of squared components
+  template<typename T,class Alloc>
+  T norm2(const Matrix<T,Alloc>& a);
+
+  /// Largest absolute value of all components
+  template<typename T,class Alloc>
+  T normInf(const Matrix<T,Alloc>& a);
+  //@}
   
 } // namespace ANPI
 
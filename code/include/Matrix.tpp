@@ -9,6 +9,7 @@
  */
 
 #include "bits/MatrixArithmetic.hpp"
+#include "bits/MatrixReductions.hpp"
 
 namespace anpi
 {
@@ -19,18 +20,18 @@ namespace anpi
 
   template<typename T,class Alloc>
   Matrix<T,Alloc>::_Matrix_impl::_Matrix_impl()
-    : allocator_type(), _data(), _rows(), _cols(), _dcols() { }
+    : allocator_type(), _data(), _rows(), _cols(), _dcols(), _capacity() { }
 
   template<typename T,class Alloc>
   Matrix<T,Alloc>::_Matrix_impl::
   _Matrix_impl(allocator_type const& _a) noexcept
-    : allocator_type(_a), _data(), _rows(), _cols(), _dcols() { }
+    : allocator_type(_a), _data(), _rows(), _cols(), _dcols(), _capacity() { }
       
   template<typename T,class Alloc>
   Matrix<T,Alloc>::_Matrix_impl::
   _Matrix_impl(allocator_type&& _a) noexcept
     : allocator_type(std::move(_a)),
-      _data(), _rows(), _cols(), _dcols() { }
+      _data(), _rows(), _cols(), _dcols(), _capacity() { }
   
   template<typename T,class Alloc>
   void Matrix<T,Alloc>::_Matrix_impl::
@@ -39,6 +40,7 @@ namespace anpi
     std::swap(_rows,  _x._rows);
     std::swap(_cols,  _x._cols);
     std::swap(_dcols, _x._dcols);
+    std::swap(_capacity, _x._capacity);
   }
      
   // ------------------------
@@ -195,21 +197,8 @@ namespace anpi
     if ((other.rows() != this->rows()) ||
         (other.cols() != this->cols())) return false;
 
-    // check the content with pointers
-    if (this->_impl._dcols == this->_impl._cols)
-      return (memcmp(this->_impl._data,
-                     other._impl._data,
-                     this->_impl.tentries()*sizeof(T))==0);
-
-    // we have to compare row by row, becase the padding may differ
-    for (size_t i=0;i<this->_impl._rows;++i) {
-      if (memcmp(this->operator[](i),
-                 other[i],
-                 this->_impl._cols*sizeof(T))!=0) {
-        return false;
-      }
-    }
-    return true;
+    // compare the content, ignoring the padding
+    return ::anpi::aimpl::equal(*this,other);
   }
 
   template<typename T,class Alloc>
@@ -229,8 +218,39 @@ namespace anpi
                                  const size_t c) {
     // only reserve iff the desired size is different to the current one
     if ( (r!=rows()) || (c!=cols()) ) {
-      _deallocate();
-      _create_storage(r,c);
+      size_t dcols;
+      const size_t n = _storage_size(r,c,dcols);
+
+      if (n > this->_impl._capacity) {
+        _deallocate();
+        _create_storage(r,c);
+      } else {
+        // the new shape fits in the current buffer: just reinterpret it
+        this->_impl._rows  = r;
+        this->_impl._cols  = c;
+        this->_impl._dcols = dcols;
+      }
+    }
+  }
+
+  template<typename T,class Alloc>
+  void Matrix<T,Alloc>::reserve(const size_t r,
+                                const size_t c) {
+    size_t dcols;
+    const size_t n = _storage_size(r,c,dcols);
+
+    if (n > this->_impl._capacity) {
+      _reallocate(n);
+    }
+  }
+
+  template<typename T,class Alloc>
+  void Matrix<T,Alloc>::shrink_to_fit() {
+    size_t dcols;
+    const size_t n = _storage_size(this->_impl._rows,this->_impl._cols,dcols);
+
+    if (n < this->_impl._capacity) {
+      _reallocate(n);
     }
   }
 
@@ -253,28 +273,8 @@ namespace anpi
     // report an error if this has not previously been initialized
     assert(this->_impl._data == nullptr);
 
-    size_t n,dcols;
-
-    if (_Matrix_impl::rowAlign) {
-      // how many aligned "blocks" are required to hold __cols
-      const size_t blocks = (__cols*sizeof(T) + (_Matrix_impl::alignment-1) ) /
-                            _Matrix_impl::alignment;
-      // dominant columns are determined by the # blocks per row
-      dcols               = blocks*_Matrix_impl::alignment/sizeof(T);
-      // total number of entries already padded
-      n                   = __rows*dcols;
-      
-    } else { // do not align the rows, just the complete memory block
-
-      // total number of blocks
-      const size_t blocks
-        = (__cols*__rows*sizeof(T)+(_Matrix_impl::alignment-1) ) /
-          _Matrix_impl::alignment;
-      // dominant columns is the same as columns in this case
-      dcols = __cols;
-      // the total number of entries of type T to be allocated 
-      n     = blocks*_Matrix_impl::alignment/sizeof(T);
-    } 
+    size_t dcols;
+    const size_t n = _storage_size(__rows,__cols,dcols);
           
     // Call the allocator to reserve the required memory
     this->_impl._data
@@ -286,20 +286,85 @@ namespace anpi
     this->_impl._rows = __rows;
     this->_impl._cols = __cols;
     this->_impl._dcols = dcols;
+    this->_impl._capacity = n;
+
+    if (_Matrix_impl::firstTouch) {
+      // Touch the pages in parallel, with the same static row
+      // distribution used by fill(), so that each page is placed on
+      // the NUMA node of the thread that initializes it
+      const T zero = T();
+      const long r = static_cast<long>(__rows);
+#pragma omp parallel for schedule(static) if(n*sizeof(T) >= HugePageSize)
+      for (long i=0;i<r;++i) {
+        T* ptr = this->_impl._data + i*dcols;
+        T *const end = ptr + dcols;
+        for (;ptr!=end;++ptr) {
+          *ptr = zero;
+        }
+      }
+    }
+  }
+
+  template<typename T,class Alloc>
+  size_t Matrix<T,Alloc>::_storage_size(const size_t __rows,
+                                        const size_t __cols,
+                                        size_t& dcols) {
+    if (_Matrix_impl::rowAlign) {
+      // how many aligned "blocks" are required to hold __cols
+      const size_t blocks = (__cols*sizeof(T) + (_Matrix_impl::alignment-1) ) /
+                            _Matrix_impl::alignment;
+      // dominant columns are determined by the # blocks per row
+      dcols               = blocks*_Matrix_impl::alignment/sizeof(T);
+      // total number of entries already padded
+      return __rows*dcols;
+    }
+
+    // do not align the rows, just the complete memory block
+
+    // total number of blocks
+    const size_t blocks
+      = (__cols*__rows*sizeof(T)+(_Matrix_impl::alignment-1) ) /
+        _Matrix_impl::alignment;
+    // dominant columns is the same as columns in this case
+    dcols = __cols;
+    // the total number of entries of type T to be allocated 
+    return blocks*_Matrix_impl::alignment/sizeof(T);
+  }
+
+  template<typename T,class Alloc>
+  void Matrix<T,Alloc>::_reallocate(const size_t n) {
+    // the current content (with its padding) must fit in the new buffer
+    assert(n >= this->_impl.tentries());
+
+    pointer ptr = (n != 0)
+      ? std::allocator_traits<allocator_type>::allocate(_impl, n)
+      : pointer();
+
+    if (this->_impl._data) {
+      std::memcpy(ptr,this->_impl._data,sizeof(T)*this->_impl.tentries());
+      std::allocator_traits<allocator_type>::deallocate(this->_impl,
+                                                        this->_impl._data,
+                                                        this->_impl._capacity);
+    }
+
+    this->_impl._data     = ptr;
+    this->_impl._capacity = n;
   }
 
   template<typename T,class Alloc>
   void Matrix<T,Alloc>::_deallocate() {
     if (this->_impl._data) {
+      // give back exactly the number of entries reserved
       std::allocator_traits<allocator_type>::deallocate(this->_impl,
                                                         this->_impl._data,
-                                                        this->_impl.tentries());
+                                                        this->_impl._capacity);
     }
     
-    this->_impl._data  = 0;
-    this->_impl._rows  = 0;
-    this->_impl._cols  = 0;
-    this->_impl._dcols = 0;
+    this->_impl._data     = 0;
+    this->_impl._rows     = 0;
+    this->_impl._cols     = 0;
+    this->_impl._dcols    = 0;
+    this->_impl._capacity = 0;
   }
 
   template<typename T,class Alloc>
@@ -316,14 +381,28 @@ namespace anpi
   
   template<typename T,class Alloc>
   void Matrix<T,Alloc>::fill(const T val) {
-    T* end = this->_impl._data + ( this->_impl._rows * this->_impl._dcols );
-    for (T* ptr = this->_impl._data;ptr!=end;++ptr) {
-      *ptr = val;
+    if (_Matrix_impl::firstTouch) {
+      // keep the row distribution of the first touch in _create_storage
+      const long r = static_cast<long>(this->_impl._rows);
+      const size_t dcols = this->_impl._dcols;
+#pragma omp parallel for schedule(static) \
+  if(this->_impl.tentries()*sizeof(T) >= HugePageSize)
+      for (long i=0;i<r;++i) {
+        T* ptr = this->_impl._data + i*dcols;
+        T *const end = ptr + dcols;
+        for (;ptr!=end;++ptr) {
+          *ptr = val;
+        }
+      }
+      return;
     }
 
-    // ACCELERATE ME!
+    ::anpi::aimpl::fill(*this,val);
   }
 
+  // Copies have no SIMD kernel of their own, unlike fill(val): memcpy
+  // is already vectorized by the C library for the running machine, and
+  // uses non-temporal stores for large blocks.
   template<typename T,class Alloc>
   void Matrix<T,Alloc>::fill(const T* mem) {
     std::memcpy(this->_impl._data,mem,sizeof(T)*this->_impl.tentries());
@@ -419,5 +498,114 @@ namespace anpi
     ::anpi::aimpl::subtract(a,b,c);
     return c;
   }
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator+(Matrix<T,Alloc>&& a,
+                            const Matrix<T,Alloc>& b) {
+
+    assert( (a.rows()==b.rows()) && (a.cols()==b.cols()) );
+
+    ::anpi::aimpl::add(a,b);
+    return std::move(a);
+  }
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator+(const Matrix<T,Alloc>& a,
+                            Matrix<T,Alloc>&& b) {
+
+    assert( (a.rows()==b.rows()) && (a.cols()==b.cols()) );
+
+    ::anpi::aimpl::add(b,a);
+    return std::move(b);
+  }
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator+(Matrix<T,Alloc>&& a,
+                            Matrix<T,Alloc>&& b) {
+
+    assert( (a.rows()==b.rows()) && (a.cols()==b.cols()) );
+
+    ::anpi::aimpl::add(a,b);
+    return std::move(a);
+  }
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator-(Matrix<T,Alloc>&& a,
+                            const Matrix<T,Alloc>& b) {
+
+    assert( (a.rows()==b.rows()) && (a.cols()==b.cols()) );
+
+    ::anpi::aimpl::subtract(a,b);
+    return std::move(a);
+  }
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator-(const Matrix<T,Alloc>& a,
+                            Matrix<T,Alloc>&& b) {
+
+    assert( (a.rows()==b.rows()) && (a.cols()==b.cols()) );
+
+    // the on-copy version can write over its second operand
+    ::anpi::aimpl::subtract(a,b,b);
+    return std::move(b);
+  }
+
+  template<typename T,class Alloc>
+  Matrix<T,Alloc> operator-(Matrix<T,Alloc>&& a,
+                            Matrix<T,Alloc>&& b) {
+
+    assert( (a.rows()==b.rows()) && (a.cols()==b.cols()) );
+
+    ::anpi::aimpl::subtract(a,b);
+    return std::move(a);
+  }
+  
+  template<typename T,class Alloc,typename U>
+  bool approxEqual(const Matrix<T,Alloc>& a,
+                   const Matrix<T,Alloc>& b,
+                   const U tol) {
+    if ((a.rows() != b.rows()) ||
+        (a.cols() != b.cols())) return false;
+
+    return ::anpi::aimpl::approxEqual(a,b,tol);
+  }
+
+  template<typename T,class Alloc>
+  T sum(const Matrix<T,Alloc>& a) {
+    return ::anpi::aimpl::sum(a);
+  }
+
+  template<typename T,class Alloc>
+  T min(const Matrix<T,Alloc>& a) {
+    return ::anpi::aimpl::min(a);
+  }
+
+  template<typename T,class Alloc>
+  T max(const Matrix<T,Alloc>& a) {
+    return ::anpi::aimpl::max(a);
+  }
+
+  template<typename T,class Alloc>
+  T dot(const Matrix<T,Alloc>& a,
+        const Matrix<T,Alloc>& b) {
+    assert( (a.rows()==b.rows()) && (a.cols()==b.cols()) );
+
+    return ::anpi::aimpl::dot(a,b);
+  }
+
+  template<typename T,class Alloc>
+  T norm1(const Matrix<T,Alloc>& a) {
+    return ::anpi::aimpl::norm1(a);
+  }
+
+  template<typename T,class Alloc>
+  T norm2(const Matrix<T,Alloc>& a) {
+    return ::anpi::aimpl::norm2(a);
+  }
+
+  template<typename T,class Alloc>
+  T normInf(const Matrix<T,Alloc>& a) {
+    return ::anpi::aimpl::normInf(a);
+  }
   
 } // namespace ANPI
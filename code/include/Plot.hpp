@@ -0,0 +1,23 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ *
+ * Selects the plotting backend: Matplotlib through embedded Python if
+ * the project was configured with ANPI_ENABLE_PYTHON, or the native
+ * SVG backend otherwise.
+ */
+
+#ifndef ANPI_PLOT_HPP
+#define ANPI_PLOT_HPP
+
+#include "AnpiConfig.hpp"
+
+#ifdef ANPI_ENABLE_PYTHON
+#  include "PlotPy.hpp"
+#else
+#  include "PlotSvg.hpp"
+#endif
+
+#endif // ANPI_PLOT_HPP
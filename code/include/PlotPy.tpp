@@ -10,8 +10,27 @@
  * @date:   15.07.2017
  */
 
+#include <limits>
+#include <sstream>
+
 namespace anpi {
 
+  namespace plot {
+    /// Python list literal with the given values, at full precision
+    template <typename T>
+    std::string pyList(const std::vector<T>& data) {
+      std::ostringstream os;
+      os.precision(std::numeric_limits<T>::max_digits10);
+      os << '[';
+      for (size_t i = 0; i < data.size(); i++) {
+        if (i > 0) os << ',';
+        os << data[i];
+      }
+      os << ']';
+      return os.str();
+    }
+  } // namespace plot
+
   template <typename T>
   Plot2d<T>::Plot2d(){}
 
@@ -78,8 +97,8 @@ namespace anpi {
                        const std::vector<T>& datay,
                        const std::string& label,
                        const std::string& color) {
-    std::string xstr = "datax = [";
-    std::string ystr = "datay = [";
+    std::string xstr = "datax = " + plot::pyList(datax);
+    std::string ystr = "datay = " + plot::pyList(datay);
     std::string pltcmd = "plt.plot(datax,datay";
     if (!label.empty()) {
       pltcmd += ",label='" + label + "'";
@@ -88,16 +107,6 @@ namespace anpi {
       pltcmd += ",color='" + color + "'";
     }
     pltcmd += ")";
-    
-    for(size_t i = 0; i < datax.size(); i++) {
-      if (i == datax.size() - 1){
-        xstr.append(std::to_string(datax[i]) + "]");
-        ystr.append(std::to_string(datay[i]) + "]");
-      } else{
-        xstr.append(std::to_string(datax[i]) + ",");
-        ystr.append(std::to_string(datay[i]) + ",");
-      }
-    }
 
     PyRun_SimpleString(xstr.c_str());
     PyRun_SimpleString(ystr.c_str());
@@ -114,21 +123,10 @@ namespace anpi {
                         const std::string& color) {
 
     // Convert the vectors of data into Python strings
-    std::string xstr    = "datax = [";
-    std::string avgystr = "avgy = [";
-    std::string minystr = "miny = [";
-    std::string maxystr = "maxy = [";
-    
-    char c=',';
-    for(size_t i = 0; i < datax.size(); i++) {
-      if (i == datax.size()-1) {
-        c=']';
-      }
-      xstr.append(std::to_string(datax[i])   + c);
-      avgystr.append(std::to_string(averagey[i])    + c);
-      minystr.append(std::to_string(miny[i]) + c);
-      maxystr.append(std::to_string(maxy[i]) + c);
-    }
+    std::string xstr    = "datax = " + plot::pyList(datax);
+    std::string avgystr = "avgy = "  + plot::pyList(averagey);
+    std::string minystr = "miny = "  + plot::pyList(miny);
+    std::string maxystr = "maxy = "  + plot::pyList(maxy);
 
     std::string lstr = legend.empty()
       ? ""
@@ -0,0 +1,173 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ *
+ * Native plotting backend, writing SVG files and NumPy data files.
+ * It has the same interface as the Matplotlib wrapper in PlotPy.hpp,
+ * but needs neither Python nor a display.
+ */
+
+#ifndef ANPI_PLOTSVG_HPP
+#define ANPI_PLOTSVG_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace anpi {
+
+  namespace plot {
+
+    /// One curve, optionally with a range band around it
+    struct curve {
+      std::string legend;
+      std::string color;
+      std::vector<double> x;
+      std::vector<double> y;
+      /// Lower and upper limits of the band (empty for plain curves)
+      std::vector<double> ymin;
+      std::vector<double> ymax;
+    };
+
+    /// All the state of one plot window
+    struct figure {
+      figure();
+
+      std::string title;
+      std::string xlabel;
+      std::string ylabel;
+      double grid;
+
+      bool fixedX;
+      double xlo,xhi;
+      bool fixedY;
+      double ylo,yhi;
+
+      std::vector<curve> curves;
+    };
+
+    /**
+     * Figures are shared by all Plot2d objects, as Matplotlib does:
+     * initialize(id) selects (or creates) a figure and every other
+     * call acts on the currently selected one.
+     */
+    inline std::map<int,figure>& figures();
+    inline int& currentFigure();
+
+    /// Render a figure as a standalone SVG document
+    inline std::string renderSvg(const figure& fig,
+                                 const int width = 800,
+                                 const int height = 600);
+
+    /**
+     * Write a row-major matrix of doubles as a NumPy .npy file (format
+     * version 1.0).  Returns false if the file could not be written.
+     */
+    inline bool writeNpy(const std::string& filename,
+                         const std::vector<double>& data,
+                         const size_t rows,
+                         const size_t cols);
+  } // namespace plot
+
+  /**
+   * Two-dimensional plots
+   *
+   * Given a set of x coordinates and a corresponding set of y values,
+   * plot a line between each point (x,y).
+   *
+   * You give a pair of vectors with the x and y values with the
+   * plot() method to plot a curve.  You may overlay as many curves as
+   * you need simply by calling plot() as many times as you need to.
+   *
+   * Finally, you call show(), which writes each open figure into the
+   * file figure<id>.svg in the working directory (the prefix "figure"
+   * can be changed with the environment variable ANPI_PLOT_PREFIX).
+   * Figures shown again later are written to figure<id>-<n>.svg.
+   * If the environment variable ANPI_PLOT_EXPORT is set, the data of
+   * the curves is also exported with exportData().
+   */
+  template<typename T>
+  class Plot2d {
+  public:
+    /// Constructors
+    //@{
+    Plot2d();
+    ~Plot2d();
+    //@}
+
+    /**
+     * Initialize a plot window.
+     *
+     * Each id is associated with a different plot window.
+     */
+    void initialize(int id);
+
+    /// Set plot title
+    void setTitle(const std::string& title);
+
+    /// Set label for the X axis
+    void setXLabel(const std::string& label);
+    /// Set label for the Y axis
+    void setYLabel(const std::string& label);
+
+    /// Set the grid size (zero disables the grid)
+    void setGridSize(const T sizegrid);
+
+    /// Set initial and final limits of the X axis
+    void setXRange(const T xi,const T xs);
+
+    /// Set initial and final limits of the Y axis
+    void setYRange(const T yi,const T ys);
+
+    /**
+     * Plot a curve by drawing line segments from
+     * the sequence of points (datax[i],datay[i]).  The
+     * curve will have the given legend
+     */
+    void plot(const std::vector<T>& datax,
+              const std::vector<T>& datay,
+              const std::string& legend,
+              const std::string& color="");
+
+    /**
+     * Plot an area range between the min and max values
+     * and the average data inbetween.
+     * @param datax values of x
+     * @param averagey average values of y, corresponding to each x
+     * @param miny minimum values of y, corresponding to each x
+     * @param maxy maximum values of y, corresponding to each x
+     */
+    void plot(const std::vector<T>& datax,
+              const std::vector<T>& averagey,
+              const std::vector<T>& miny,
+              const std::vector<T>& maxy,
+              const std::string& legend,
+              const std::string& color="r");
+
+    /// Write the current figure as SVG into the given file
+    void save(const std::string& filename);
+
+    /**
+     * Export the data of each curve of the current figure into
+     * prefix_<n>_<legend>.npy, as an array with the columns x and y,
+     * or x, y, min and max for range plots.
+     */
+    void exportData(const std::string& prefix);
+
+    /**
+     * Write all figures plotted so far, and close them.
+     */
+    void show();
+
+  private:
+    /// Currently selected figure
+    plot::figure& current();
+  }; //class Plot2d
+
+} // namespace anpi
+
+#include "PlotSvg.tpp"
+
+#endif // ANPI_PLOTSVG_HPP
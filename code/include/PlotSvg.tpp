@@ -0,0 +1,493 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ *
+ * Native plotting backend, writing SVG files and NumPy data files.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace anpi {
+
+  namespace plot {
+
+    inline figure::figure()
+      : grid(0.),fixedX(false),xlo(0.),xhi(1.),
+        fixedY(false),ylo(0.),yhi(1.) {}
+
+    inline std::map<int,figure>& figures() {
+      static std::map<int,figure> figs;
+      return figs;
+    }
+
+    inline int& currentFigure() {
+      static int id = 1;
+      return id;
+    }
+
+    /// Number of times each figure id has been shown
+    inline int shown(const int id) {
+      static std::map<int,int> count;
+      return count[id]++;
+    }
+
+    /// Append a number with the given printf format
+    inline void append(std::string& s,const char* format,const double v) {
+      char buf[32];
+      std::snprintf(buf,sizeof(buf),format,v);
+      s += buf;
+    }
+
+    /// Append text escaping the XML special characters
+    inline void appendEscaped(std::string& s,const std::string& text) {
+      for (const char c : text) {
+        switch (c) {
+        case '&': s += "&amp;";  break;
+        case '<': s += "&lt;";   break;
+        case '>': s += "&gt;";   break;
+        case '"': s += "&quot;"; break;
+        default:  s += c;
+        }
+      }
+    }
+
+    /**
+     * SVG color of a Matplotlib color specification.  The one letter
+     * codes are translated, other names are valid SVG colors already.
+     * Without color, the Matplotlib default color cycle is used.
+     */
+    inline std::string svgColor(const std::string& color,const size_t index) {
+      static const char* cycle[10] = {
+        "#1f77b4","#ff7f0e","#2ca02c","#d62728","#9467bd",
+        "#8c564b","#e377c2","#7f7f7f","#bcbd22","#17becf"
+      };
+      if (color.empty()) {
+        return cycle[index % 10];
+      }
+      if (color.size() == 1) {
+        switch (color[0]) {
+        case 'b': return "#0000ff";
+        case 'g': return "#008000";
+        case 'r': return "#ff0000";
+        case 'c': return "#00bfbf";
+        case 'm': return "#bf00bf";
+        case 'y': return "#bfbf00";
+        case 'k': return "#000000";
+        case 'w': return "#ffffff";
+        default: break;
+        }
+      }
+      return color;
+    }
+
+    /// Step between ticks: 1, 2 or 5 times a power of ten
+    inline double tickStep(const double range,const int ticks) {
+      const double raw  = range/double(ticks);
+      const double base = std::pow(10.,std::floor(std::log10(raw)));
+      const double r    = raw/base;
+      return base*((r < 1.5) ? 1. : (r < 3.5) ? 2. : (r < 7.5) ? 5. : 10.);
+    }
+
+    /// Extend a degenerate range so that it can be drawn
+    inline void fixRange(double& lo,double& hi) {
+      if (!(lo <= hi)) { // empty, or NaN
+        lo = 0.;
+        hi = 1.;
+      } else if (lo == hi) {
+        const double d = (lo == 0.) ? 1. : 0.5*std::abs(lo);
+        lo -= d;
+        hi += d;
+      }
+    }
+
+    inline std::string renderSvg(const figure& fig,
+                                 const int width,
+                                 const int height) {
+      // data limits
+      const double inf = std::numeric_limits<double>::infinity();
+      double xlo = inf, xhi = -inf, ylo = inf, yhi = -inf;
+      for (const curve& c : fig.curves) {
+        for (size_t i=0;i<c.x.size();++i) {
+          if (!std::isfinite(c.x[i])) continue;
+          xlo = std::min(xlo,c.x[i]);
+          xhi = std::max(xhi,c.x[i]);
+          const double lo = c.ymin.empty() ? c.y[i] : c.ymin[i];
+          const double hi = c.ymax.empty() ? c.y[i] : c.ymax[i];
+          if (std::isfinite(lo)) ylo = std::min(ylo,std::min(lo,c.y[i]));
+          if (std::isfinite(hi)) yhi = std::max(yhi,std::max(hi,c.y[i]));
+        }
+      }
+      if (fig.fixedX) {
+        xlo = fig.xlo;
+        xhi = fig.xhi;
+      }
+      if (fig.fixedY) {
+        ylo = fig.ylo;
+        yhi = fig.yhi;
+      } else if (yhi > ylo) { // 5% margin, as Matplotlib
+        const double m = 0.05*(yhi-ylo);
+        ylo -= m;
+        yhi += m;
+      }
+      fixRange(xlo,xhi);
+      fixRange(ylo,yhi);
+
+      // plot area
+      const double left = 80., right = double(width) - 20.;
+      const double top  = 40., bottom = double(height) - 60.;
+      const double sx = (right-left)/(xhi-xlo);
+      const double sy = (bottom-top)/(yhi-ylo);
+
+      std::string s;
+      size_t points = 0u;
+      for (const curve& c : fig.curves) {
+        points += 3u*c.x.size();
+      }
+      s.reserve(4096u + 24u*points);
+
+      s += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"";
+      append(s,"%.0f",double(width));
+      s += "\" height=\"";
+      append(s,"%.0f",double(height));
+      s += "\" font-family=\"sans-serif\" font-size=\"12\">\n"
+           "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+           "<defs><clipPath id=\"area\"><rect x=\"";
+      append(s,"%.2f",left);
+      s += "\" y=\"";
+      append(s,"%.2f",top);
+      s += "\" width=\"";
+      append(s,"%.2f",right-left);
+      s += "\" height=\"";
+      append(s,"%.2f",bottom-top);
+      s += "\"/></clipPath></defs>\n";
+
+      // ticks, labels and grid
+      const double xstep = tickStep(xhi-xlo,8);
+      const double ystep = tickStep(yhi-ylo,8);
+      for (double t = std::ceil(xlo/xstep)*xstep; t <= xhi + 1e-9*xstep;
+           t += xstep) {
+        const double px = left + (t-xlo)*sx;
+        s += "<line x1=\"";
+        append(s,"%.2f",px);
+        s += "\" x2=\"";
+        append(s,"%.2f",px);
+        s += "\" y1=\"";
+        append(s,"%.2f",fig.grid > 0. ? top : bottom);
+        s += "\" y2=\"";
+        append(s,"%.2f",bottom + 5.);
+        s += "\" stroke=\"#b0b0b0\" stroke-width=\"0.8\"/>\n<text x=\"";
+        append(s,"%.2f",px);
+        s += "\" y=\"";
+        append(s,"%.2f",bottom + 20.);
+        s += "\" text-anchor=\"middle\">";
+        append(s,"%g",std::abs(t) < 1e-12*xstep ? 0. : t);
+        s += "</text>\n";
+      }
+      for (double t = std::ceil(ylo/ystep)*ystep; t <= yhi + 1e-9*ystep;
+           t += ystep) {
+        const double py = bottom - (t-ylo)*sy;
+        s += "<line x1=\"";
+        append(s,"%.2f",left - 5.);
+        s += "\" x2=\"";
+        append(s,"%.2f",fig.grid > 0. ? right : left);
+        s += "\" y1=\"";
+        append(s,"%.2f",py);
+        s += "\" y2=\"";
+        append(s,"%.2f",py);
+        s += "\" stroke=\"#b0b0b0\" stroke-width=\"0.8\"/>\n<text x=\"";
+        append(s,"%.2f",left - 8.);
+        s += "\" y=\"";
+        append(s,"%.2f",py + 4.);
+        s += "\" text-anchor=\"end\">";
+        append(s,"%g",std::abs(t) < 1e-12*ystep ? 0. : t);
+        s += "</text>\n";
+      }
+
+      // curves
+      for (size_t k=0;k<fig.curves.size();++k) {
+        const curve& c = fig.curves[k];
+        const std::string color = svgColor(c.color,k);
+
+        if (!c.ymin.empty()) {
+          s += "<polygon clip-path=\"url(#area)\" fill=\"" + color +
+               "\" fill-opacity=\"0.1\" stroke=\"none\" points=\"";
+          for (size_t i=0;i<c.x.size();++i) {
+            if (!std::isfinite(c.x[i]) || !std::isfinite(c.ymax[i])) continue;
+            append(s,"%.2f,",left + (c.x[i]-xlo)*sx);
+            append(s,"%.2f ",bottom - (c.ymax[i]-ylo)*sy);
+          }
+          for (size_t i=c.x.size();i-- > 0;) {
+            if (!std::isfinite(c.x[i]) || !std::isfinite(c.ymin[i])) continue;
+            append(s,"%.2f,",left + (c.x[i]-xlo)*sx);
+            append(s,"%.2f ",bottom - (c.ymin[i]-ylo)*sy);
+          }
+          s += "\"/>\n";
+        }
+
+        s += "<polyline clip-path=\"url(#area)\" fill=\"none\" stroke=\"" +
+             color + "\" stroke-width=\"";
+        s += c.ymin.empty() ? "1.5" : "2";
+        s += "\" points=\"";
+        for (size_t i=0;i<c.x.size();++i) {
+          if (!std::isfinite(c.x[i]) || !std::isfinite(c.y[i])) continue;
+          append(s,"%.2f,",left + (c.x[i]-xlo)*sx);
+          append(s,"%.2f ",bottom - (c.y[i]-ylo)*sy);
+        }
+        s += "\"/>\n";
+      }
+
+      // frame
+      s += "<rect x=\"";
+      append(s,"%.2f",left);
+      s += "\" y=\"";
+      append(s,"%.2f",top);
+      s += "\" width=\"";
+      append(s,"%.2f",right-left);
+      s += "\" height=\"";
+      append(s,"%.2f",bottom-top);
+      s += "\" fill=\"none\" stroke=\"black\"/>\n";
+
+      // title and labels
+      s += "<text x=\"";
+      append(s,"%.2f",0.5*(left+right));
+      s += "\" y=\"25\" text-anchor=\"middle\" font-size=\"14\">";
+      appendEscaped(s,fig.title);
+      s += "</text>\n<text x=\"";
+      append(s,"%.2f",0.5*(left+right));
+      s += "\" y=\"";
+      append(s,"%.2f",double(height) - 15.);
+      s += "\" text-anchor=\"middle\">";
+      appendEscaped(s,fig.xlabel);
+      s += "</text>\n<text transform=\"translate(20,";
+      append(s,"%.2f",0.5*(top+bottom));
+      s += ") rotate(-90)\" text-anchor=\"middle\">";
+      appendEscaped(s,fig.ylabel);
+      s += "</text>\n";
+
+      // legend, top right as Matplotlib does by default
+      double ly = top + 20.;
+      for (size_t k=0;k<fig.curves.size();++k) {
+        const curve& c = fig.curves[k];
+        if (c.legend.empty()) continue;
+        s += "<line x1=\"";
+        append(s,"%.2f",right - 170.);
+        s += "\" x2=\"";
+        append(s,"%.2f",right - 145.);
+        s += "\" y1=\"";
+        append(s,"%.2f",ly - 4.);
+        s += "\" y2=\"";
+        append(s,"%.2f",ly - 4.);
+        s += "\" stroke=\"" + svgColor(c.color,k) +
+             "\" stroke-width=\"2\"/>\n<text x=\"";
+        append(s,"%.2f",right - 140.);
+        s += "\" y=\"";
+        append(s,"%.2f",ly);
+        s += "\">";
+        appendEscaped(s,c.legend);
+        s += "</text>\n";
+        ly += 18.;
+      }
+
+      s += "</svg>\n";
+      return s;
+    }
+
+    inline bool writeNpy(const std::string& filename,
+                         const std::vector<double>& data,
+                         const size_t rows,
+                         const size_t cols) {
+      std::string header = "{'descr': '<f8', 'fortran_order': False, "
+                           "'shape': (" + std::to_string(rows) + ", " +
+                           std::to_string(cols) + "), }";
+      // magic (6), version (2) and header length (2), padded to 64 bytes
+      const size_t total = 10u + header.size() + 1u;
+      header.append((64u - total%64u)%64u,' ');
+      header += '\n';
+
+      std::ofstream os(filename.c_str(),std::ios::binary);
+      if (!os) {
+        return false;
+      }
+      const unsigned char preamble[10] = {
+        0x93,'N','U','M','P','Y',1,0,
+        (unsigned char)(header.size() & 0xff),
+        (unsigned char)(header.size() >> 8)
+      };
+      os.write(reinterpret_cast<const char*>(preamble),10);
+      os.write(header.data(),std::streamsize(header.size()));
+      // the hosts we support are little endian, as '<f8' requires
+      os.write(reinterpret_cast<const char*>(data.data()),
+               std::streamsize(data.size()*sizeof(double)));
+      return bool(os);
+    }
+  } // namespace plot
+
+  template <typename T>
+  Plot2d<T>::Plot2d(){}
+
+  template <typename T>
+  Plot2d<T>::~Plot2d(){}
+
+  template <typename T>
+  plot::figure& Plot2d<T>::current() {
+    return plot::figures()[plot::currentFigure()];
+  }
+
+  template <typename T>
+  void Plot2d<T>::initialize(int id){
+    plot::currentFigure() = id;
+    current();
+  }
+
+  template <typename T>
+  void Plot2d<T>::setTitle(const std::string& title){
+    current().title = title;
+  }
+
+  template <typename T>
+  void Plot2d<T>::setXLabel(const std::string& xlabel){
+    current().xlabel = xlabel;
+  }
+
+  template <typename T>
+  void Plot2d<T>::setYLabel(const std::string& ylabel){
+    current().ylabel = ylabel;
+  }
+
+  template <typename T>
+  void Plot2d<T>::setGridSize(const T sizegrid){
+    current().grid = double(sizegrid);
+  }
+
+  template <typename T>
+  void Plot2d<T>::setXRange(const T xi, const T xs){
+    plot::figure& fig = current();
+    fig.fixedX = true;
+    fig.xlo = double(xi);
+    fig.xhi = double(xs);
+  }
+
+  template <typename T>
+  void Plot2d<T>::setYRange(const T yi, const T ys){
+    plot::figure& fig = current();
+    fig.fixedY = true;
+    fig.ylo = double(yi);
+    fig.yhi = double(ys);
+  }
+
+  template <typename T>
+  void Plot2d<T>::plot(const std::vector<T>& datax,
+                       const std::vector<T>& datay,
+                       const std::string& label,
+                       const std::string& color) {
+    const size_t n = std::min(datax.size(),datay.size());
+    plot::curve c;
+    c.legend = label;
+    c.color  = color;
+    c.x.assign(datax.begin(),datax.begin()+n);
+    c.y.assign(datay.begin(),datay.begin()+n);
+    current().curves.push_back(c);
+  }
+
+  template <typename T>
+  void Plot2d<T>::plot(const std::vector<T>& datax,
+                       const std::vector<T>& averagey,
+                       const std::vector<T>& miny,
+                       const std::vector<T>& maxy,
+                       const std::string& legend,
+                       const std::string& color) {
+    const size_t n = std::min(std::min(datax.size(),averagey.size()),
+                              std::min(miny.size(),maxy.size()));
+    plot::curve c;
+    c.legend = legend;
+    c.color  = color;
+    c.x.assign(datax.begin(),datax.begin()+n);
+    c.y.assign(averagey.begin(),averagey.begin()+n);
+    c.ymin.assign(miny.begin(),miny.begin()+n);
+    c.ymax.assign(maxy.begin(),maxy.begin()+n);
+    current().curves.push_back(c);
+  }
+
+  template <typename T>
+  void Plot2d<T>::save(const std::string& filename) {
+    std::ofstream os(filename.c_str());
+    os << plot::renderSvg(current());
+    if (!os) {
+      std::cerr << "Could not write the plot " << filename << std::endl;
+    }
+  }
+
+  template <typename T>
+  void Plot2d<T>::exportData(const std::string& prefix) {
+    const plot::figure& fig = current();
+    for (size_t k=0;k<fig.curves.size();++k) {
+      const plot::curve& c = fig.curves[k];
+      const size_t cols = c.ymin.empty() ? 2u : 4u;
+      std::vector<double> data;
+      data.reserve(cols*c.x.size());
+      for (size_t i=0;i<c.x.size();++i) {
+        data.push_back(c.x[i]);
+        data.push_back(c.y[i]);
+        if (cols == 4u) {
+          data.push_back(c.ymin[i]);
+          data.push_back(c.ymax[i]);
+        }
+      }
+
+      // keep the legend in the name, only with safe characters
+      std::string name = prefix + "_" + std::to_string(k);
+      if (!c.legend.empty()) {
+        name += '_';
+        for (const char ch : c.legend) {
+          name += (std::isalnum(static_cast<unsigned char>(ch)) ||
+                   ch == '-' || ch == '.') ? ch : '_';
+        }
+      }
+      name += ".npy";
+
+      if (!plot::writeNpy(name,data,c.x.size(),cols)) {
+        std::cerr << "Could not write the data " << name << std::endl;
+      }
+    }
+  }
+
+  template <typename T>
+  void Plot2d<T>::show(){
+    const char* env = std::getenv("ANPI_PLOT_PREFIX");
+    const std::string prefix = (env != 0) ? env : "figure";
+    const bool data = std::getenv("ANPI_PLOT_EXPORT") != 0;
+
+    std::map<int,plot::figure>& figs = plot::figures();
+    const int selected = plot::currentFigure();
+    for (std::map<int,plot::figure>::const_iterator it = figs.begin();
+         it != figs.end(); ++it) {
+      if (it->second.curves.empty()) continue;
+
+      // later shows of the same figure do not overwrite the first one
+      plot::currentFigure() = it->first;
+      const int n = plot::shown(it->first);
+      const std::string name = prefix + std::to_string(it->first) +
+        ((n > 0) ? "-" + std::to_string(n) : std::string());
+      save(name + ".svg");
+      if (data) {
+        exportData(name);
+      }
+      std::cout << "Plot written to " << name << ".svg" << std::endl;
+    }
+
+    // shown figures are closed, as in Matplotlib
+    figs.clear();
+    plot::currentFigure() = selected;
+  }
+
+} // namespace anpi
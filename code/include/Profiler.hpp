@@ -0,0 +1,278 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_PROFILER_HPP
+#define ANPI_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <AnpiConfig.hpp>
+
+#include "bits/JsonEscape.hpp"
+
+/**
+ * Scoped trace macros.
+ *
+ * ANPI_PROFILE_SCOPE(category,name) records a begin event where it
+ * appears and the matching end event when the enclosing scope is left.
+ * Both arguments must be string literals, since only their addresses
+ * are stored.  ANPI_PROFILE_THREAD(name) names the calling thread in
+ * the trace.
+ *
+ * Unless the project is configured with ANPI_ENABLE_PROFILER, both
+ * expand to an empty statement and their arguments are not even
+ * evaluated, so the instrumented code compiles exactly as without them.
+ */
+#ifdef ANPI_ENABLE_PROFILER
+#  define ANPI_PROFILE_CONCAT_(a,b) a##b
+#  define ANPI_PROFILE_CONCAT(a,b) ANPI_PROFILE_CONCAT_(a,b)
+#  define ANPI_PROFILE_SCOPE(category,name)                              \
+  const ::anpi::profiler::scope                                         \
+    ANPI_PROFILE_CONCAT(anpiProfileScope,__LINE__)(category,name)
+#  define ANPI_PROFILE_THREAD(name) ::anpi::profiler::nameThread(name)
+#else
+#  define ANPI_PROFILE_SCOPE(category,name) do {} while (false)
+#  define ANPI_PROFILE_THREAD(name) do {} while (false)
+#endif
+
+namespace anpi {
+  namespace profiler {
+
+    /// One begin ('B') or end ('E') event, 32 bytes
+    struct event {
+      const char* category;
+      const char* name;
+      /// steady_clock time in nanoseconds
+      uint64_t ns;
+      char phase;
+    };
+
+    /// Current steady_clock time in nanoseconds
+    inline uint64_t now() {
+      return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * Events of one thread.
+     *
+     * Only the owning thread appends, into a linked list of fixed
+     * blocks: an event is written and then published by a release
+     * store of the block count, and a new block is linked in the same
+     * way, so that the list can be read at any time by another thread
+     * without locks.  Blocks are never freed.
+     */
+    class threadBuffer {
+    public:
+      /// Events per block
+      static const size_t BlockEvents = 4096u;
+
+      explicit threadBuffer(const uint32_t tid)
+        : _tid(tid),_head(new block),_tail(_head) {}
+
+      uint32_t tid() const { return _tid; }
+
+      /// Append an event; owner thread only
+      void record(const char* category,const char* name,const char phase) {
+        size_t n = _tail->count.load(std::memory_order_relaxed);
+        if (n == BlockEvents) {
+          block* b = new block;
+          _tail->next.store(b,std::memory_order_release);
+          _tail = b;
+          n = 0u;
+        }
+        event& e = _tail->events[n];
+        e.category = category;
+        e.name = name;
+        e.ns = now();
+        e.phase = phase;
+        _tail->count.store(n + 1u,std::memory_order_release);
+      }
+
+      /// Call f with each published event, in order
+      template<typename F>
+      void forEach(F f) const {
+        for (const block* b = _head;b != 0;
+             b = b->next.load(std::memory_order_acquire)) {
+          const size_t n = b->count.load(std::memory_order_acquire);
+          for (size_t i=0;i<n;++i) f(b->events[i]);
+        }
+      }
+
+    private:
+      threadBuffer(const threadBuffer&);
+      threadBuffer& operator=(const threadBuffer&);
+
+      struct block {
+        block() : count(0u),next(0) {}
+        event events[BlockEvents];
+        std::atomic<size_t> count;
+        std::atomic<block*> next;
+      };
+
+      const uint32_t _tid;
+      block* const _head;
+      block* _tail;
+    };
+
+    /**
+     * All thread buffers of the process.
+     *
+     * The registry is created on first use and never destroyed, so that
+     * threads still running during static destruction keep valid
+     * buffers.  In profiling builds, the events are written at exit as
+     * Chrome trace JSON (Trace Event Format, readable by Perfetto and
+     * chrome://tracing) to the file named by the environment variable
+     * ANPI_PROFILE, by default anpi-trace-<pid>.json.
+     */
+    class registry {
+    public:
+      static registry& instance() {
+        static registry* r = new registry();
+        return *r;
+      }
+
+      /// Buffer of the calling thread, registered on first use
+      threadBuffer& local() {
+        static thread_local threadBuffer* buffer = 0;
+        if (buffer == 0) {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _buffers.push_back(std::unique_ptr<threadBuffer>(
+            new threadBuffer(uint32_t(_buffers.size() + 1u))));
+          _names.push_back(std::string());
+          buffer = _buffers.back().get();
+        }
+        return *buffer;
+      }
+
+      /// Name the calling thread in the trace
+      void nameThread(const std::string& name) {
+        threadBuffer& b = local();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _names[b.tid() - 1u] = name;
+      }
+
+      /// Write all events recorded so far
+      void write(std::ostream& out) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const long pid = long(::getpid());
+        char buf[512];
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        std::snprintf(buf,sizeof(buf),
+                      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%ld,"
+                      "\"args\":{\"name\":\"anpi\"}}",pid);
+        out << buf;
+        for (size_t i=0;i<_buffers.size();++i) {
+          const threadBuffer& b = *_buffers[i];
+          const std::string name = _names[i].empty() ?
+            "thread " + std::to_string(b.tid()) : _names[i];
+          std::snprintf(buf,sizeof(buf),
+                        ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,"
+                        "\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                        pid,unsigned(b.tid()),escape(name).c_str());
+          out << buf;
+          b.forEach([&](const event& e) {
+              const uint64_t ns = (e.ns > _start) ? e.ns - _start : 0u;
+              std::snprintf(buf,sizeof(buf),
+                            ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+                            "\"ts\":%llu.%03u,\"pid\":%ld,\"tid\":%u}",
+                            escape(e.name).c_str(),escape(e.category).c_str(),
+                            e.phase,
+                            static_cast<unsigned long long>(ns/1000u),
+                            unsigned(ns%1000u),pid,unsigned(b.tid()));
+              out << buf;
+            });
+        }
+        out << "\n]}\n";
+      }
+
+      /// Write the trace to path
+      bool write(const std::string& path) const {
+        std::ofstream f(path.c_str());
+        write(f);
+        return bool(f);
+      }
+
+      /// File written at exit
+      std::string path() const {
+        const char* env = std::getenv("ANPI_PROFILE");
+        if (env && *env) return env;
+        return "anpi-trace-" + std::to_string(long(::getpid())) + ".json";
+      }
+
+    private:
+      registry() : _start(now()) {
+#ifdef ANPI_ENABLE_PROFILER
+        std::atexit(&registry::atExit);
+#endif
+      }
+
+      static void atExit() {
+        registry& r = instance();
+        const std::string p = r.path();
+        if (!r.write(p)) {
+          std::fprintf(stderr,"Cannot write trace %s\n",p.c_str());
+        }
+      }
+
+      /**
+       * Names are literals or thread names; keep the JSON valid anyway,
+       * and short enough that two of them fit in the line buffer
+       */
+      static std::string escape(const char* s) {
+        return jsonEscape(s,160u);
+      }
+      static std::string escape(const std::string& s) {
+        return jsonEscape(s,160u);
+      }
+
+      const uint64_t _start;
+      mutable std::mutex _mutex;
+      std::vector<std::unique_ptr<threadBuffer> > _buffers;
+      std::vector<std::string> _names;
+    };
+
+    /// Begin event on construction, end event on destruction
+    class scope {
+    public:
+      scope(const char* category,const char* name)
+        : _buffer(registry::instance().local()),_category(category),
+          _name(name) {
+        _buffer.record(_category,_name,'B');
+      }
+      ~scope() { _buffer.record(_category,_name,'E'); }
+
+    private:
+      scope(const scope&);
+      scope& operator=(const scope&);
+
+      threadBuffer& _buffer;
+      const char* const _category;
+      const char* const _name;
+    };
+
+    /// Name the calling thread in the trace
+    inline void nameThread(const std::string& name) {
+      registry::instance().nameThread(name);
+    }
+
+  } // namespace profiler
+} // namespace anpi
+
+#endif
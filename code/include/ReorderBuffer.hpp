@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_REORDER_BUFFER_HPP
+#define ANPI_REORDER_BUFFER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Profiler.hpp"
+
+namespace anpi {
+
+  /**
+   * Bounded buffer restoring the order of results produced out of order.
+   *
+   * A producer reserves a sequence number for each unit of work, and
+   * the workers put() the result under that number in any order.  The
+   * consumer take()s the results in sequence order.  At most window
+   * sequence numbers can be reserved and not yet taken: reserve()
+   * blocks until the consumer catches up, so the memory in flight stays
+   * bounded however long the stream is.
+   */
+  template<typename T>
+  class reorderBuffer {
+  public:
+    explicit reorderBuffer(const size_t window)
+      : _slots(window ? window : 1u),
+        _ready(window ? window : 1u,0),
+        _reserved(0u),_taken(0u),_closed(false) {}
+
+    /// Number of sequence numbers that can be in flight
+    size_t window() const { return _slots.size(); }
+
+    /// Next sequence number, blocking while the window is full
+    uint64_t reserve() {
+      std::unique_lock<std::mutex> lock(_mutex);
+      while (_reserved - _taken >= _slots.size()) {
+        ANPI_PROFILE_SCOPE("sync","reorder full");
+        _space.wait(lock);
+      }
+      return _reserved++;
+    }
+
+    /// Store the result of a reserved sequence number
+    void put(const uint64_t seq,T value) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const size_t s = size_t(seq % _slots.size());
+      _slots[s] = std::move(value);
+      _ready[s] = 1;
+      if (seq == _taken) {
+        _data.notify_one();
+      }
+    }
+
+    /**
+     * Move the next result in sequence order into value, blocking until
+     * it is available.
+     *
+     * @return false once the buffer is closed and every reserved result
+     *         was taken
+     */
+    bool take(T& value) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      const size_t s = size_t(_taken % _slots.size());
+      while (!_ready[s]) {
+        if (_closed && _taken == _reserved) {
+          return false;
+        }
+        ANPI_PROFILE_SCOPE("sync","reorder empty");
+        _data.wait(lock);
+      }
+      value = std::move(_slots[s]);
+      _slots[s] = T();
+      _ready[s] = 0;
+      ++_taken;
+      _space.notify_one();
+      return true;
+    }
+
+    /// No more sequence numbers will be reserved
+    void close() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _closed = true;
+      _data.notify_all();
+    }
+
+  private:
+    std::vector<T> _slots;
+    std::vector<char> _ready;
+    uint64_t _reserved;
+    uint64_t _taken;
+    bool _closed;
+
+    std::mutex _mutex;
+    std::condition_variable _space;
+    std::condition_variable _data;
+  };
+
+} // namespace anpi
+
+#endif
@@ -0,0 +1,480 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_ROOT_AUTO_HPP
+#define ANPI_ROOT_AUTO_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Exception.hpp"
+#include "Profiler.hpp"
+#include "bits/FileUtil.hpp"
+
+#include "RootBisection.hpp"
+#include "RootInterpolation.hpp"
+#include "RootSecant.hpp"
+#include "RootNewtonRaphson.hpp"
+#include "RootBrent.hpp"
+#include "RootRidder.hpp"
+
+namespace anpi {
+
+  /// Root finders the autotuner chooses from
+  enum rootMethod {
+    BisectionMethod = 0,
+    InterpolationMethod,
+    SecantMethod,
+    NewtonRaphsonMethod,
+    BrentMethod,
+    RidderMethod,
+    /// Number of methods
+    NumRootMethods
+  };
+
+  /// Name of a method, as in the profile files and the batch solver
+  inline const char* rootMethodName(const rootMethod m) {
+    static const char* const names[NumRootMethods] = {
+      "bisection","interpolation","secant","newton","brent","ridder"
+    };
+    return names[m];
+  }
+
+  /**
+   * Method with the given name.
+   *
+   * @return false if there is no such method
+   */
+  inline bool parseRootMethod(const std::string& name,rootMethod& m) {
+    for (int i=0;i<NumRootMethods;++i) {
+      if (name == rootMethodName(rootMethod(i))) {
+        m = rootMethod(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// One problem of a function family, with a sign change in [a,b]
+  template<typename T>
+  struct tuningSample {
+    std::function<T(T)> f;
+    T a;
+    T b;
+  };
+
+  /// How the autotuner compares the methods that solve the most samples
+  enum tuningCriterion {
+    /// Least wall time
+    TuneTime = 0,
+    /// Least function evaluations, independent of the machine load
+    TuneEvaluations
+  };
+
+  /// Settings of a calibration
+  struct tuningSettings {
+    tuningSettings() : budget(1000u),repeats(3u),criterion(TuneTime) {}
+
+    /// Maximum evaluations of one calibration solve
+    size_t budget;
+    /// Timed passes over the samples; the fastest one counts
+    unsigned int repeats;
+    tuningCriterion criterion;
+  };
+
+  /// Calibration result of one method
+  struct tuningScore {
+    rootMethod method;
+    /// Samples solved to a verified root
+    size_t solved;
+    /// Mean evaluations per sample
+    double evaluations;
+    /// Most evaluations of one verified solve
+    size_t maxEvaluations;
+    /// Wall time of the fastest pass, per sample
+    double nanoseconds;
+  };
+
+  /**
+   * Method chosen for a function family and tolerance, as stored in an
+   * autotuneProfile.
+   */
+  struct tuningDecision {
+    tuningDecision()
+      : eps(0.),method(BrentMethod),budget(1000u),solvedFraction(0.),
+        evaluations(0.),nanoseconds(0.) {}
+
+    /// Name of the function family, without white space
+    std::string family;
+    /// Tolerance the method was calibrated for
+    double eps;
+    rootMethod method;
+    /// Evaluations after which rootAuto() gives up
+    size_t budget;
+    /// Calibration measurements of the chosen method
+    double solvedFraction;
+    double evaluations;
+    double nanoseconds;
+  };
+
+  namespace detail {
+
+    /// Thrown by autoBudgeted when a solve runs out of evaluations
+    class autoBudgetExhausted : public anpi::Exception {
+    public:
+      autoBudgetExhausted()
+        : anpi::Exception("Evaluation budget exhausted") {}
+    };
+
+    /// Counts the evaluations of a function and enforces a budget
+    template<typename T>
+    class autoBudgeted {
+    public:
+      autoBudgeted(const std::function<T(T)>& f,size_t* counter,
+                   const size_t budget)
+        : _f(&f),_counter(counter),_budget(budget) {}
+
+      T operator()(const T x) const {
+        if (++(*_counter) > _budget) {
+          throw autoBudgetExhausted();
+        }
+        return (*_f)(x);
+      }
+    private:
+      const std::function<T(T)>* _f;
+      size_t* _counter;
+      size_t _budget;
+    };
+
+    /**
+     * Solve with one method: the bracketing methods search [xi,xii],
+     * the secant method starts at both ends and Newton-Raphson at the
+     * middle.
+     */
+    template<typename T>
+    T solveWith(const rootMethod m,const std::function<T(T)>& f,
+                const T xi,const T xii,const T eps) {
+      switch (m) {
+      case BisectionMethod:
+        return anpi::rootBisection<T>(f,xi,xii,eps);
+      case InterpolationMethod:
+        return anpi::rootInterpolation<T>(f,xi,xii,eps);
+      case SecantMethod:
+        return anpi::rootSecant<T>(f,xi,xii,eps);
+      case NewtonRaphsonMethod:
+        return anpi::rootNewtonRaphson<T>(f,T(0.5)*(xi + xii),eps);
+      case BrentMethod:
+        return anpi::rootBrent<T>(f,xi,xii,eps);
+      case RidderMethod:
+        return anpi::rootRidder<T>(f,xi,xii,eps);
+      default:
+        break;
+      }
+      throw anpi::Exception("Unknown root method");
+    }
+
+    /**
+     * Whether x is a root of f in [a,b]: f vanishes at x or changes
+     * sign between x and a point 100*eps*max(1,|x|) to either side.
+     * Families without known roots can be checked this way; jumps count
+     * as roots, as for the bracketing methods.
+     */
+    template<typename T>
+    bool verifiedRoot(const std::function<T(T)>& f,const T a,const T b,
+                      const T x,const T eps) {
+      if (!std::isfinite(x) || x < std::min(a,b) || x > std::max(a,b)) {
+        return false;
+      }
+      const T fx = f(x);
+      if (fx == T(0)) {
+        return true;
+      }
+      const T tol = T(100)*eps*std::max(T(1),std::abs(x));
+      const T fl = f(std::max(std::min(a,b),x - tol));
+      const T fu = f(std::min(std::max(a,b),x + tol));
+      return (fl < T(0)) != (fx < T(0)) || (fu < T(0)) != (fx < T(0)) ||
+        fl == T(0) || fu == T(0);
+    }
+
+  } // namespace detail
+
+  /**
+   * Calibrate the six root finders on samples of a function family.
+   *
+   * Every method solves every sample once with settings.budget
+   * evaluations, counting the evaluations and verifying the root (see
+   * detail::verifiedRoot()), and then settings.repeats more times to
+   * measure the wall time of the fastest pass.  Among the methods with
+   * the most verified roots, the one with the least time or
+   * evaluations (see tuningCriterion) is chosen.
+   *
+   * The budget of the decision is four times the most evaluations the
+   * chosen method needed, at least 64 and at most settings.budget, so
+   * that rootAuto() bounds open methods that diverge.
+   *
+   * @param scores if not null, receives the measurements of all methods
+   *
+   * @throws anpi::Exception if there are no samples
+   */
+  template<typename T>
+  tuningDecision autotune(const std::string& family,
+                          const std::vector<tuningSample<T> >& samples,
+                          const T eps,
+                          const tuningSettings& settings = tuningSettings(),
+                          std::vector<tuningScore>* scores = 0) {
+    ANPI_PROFILE_SCOPE("tuning","autotune");
+
+    if (samples.empty()) {
+      throw anpi::Exception("No samples to calibrate " + family);
+    }
+
+    typedef std::chrono::steady_clock clock;
+    std::vector<tuningScore> score(NumRootMethods);
+    for (int m=0;m<NumRootMethods;++m) {
+      tuningScore& s = score[size_t(m)];
+      s.method = rootMethod(m);
+      s.solved = 0u;
+      s.maxEvaluations = 0u;
+      s.nanoseconds = std::numeric_limits<double>::infinity();
+
+      size_t total = 0u;
+      for (size_t i=0;i<samples.size();++i) {
+        const tuningSample<T>& p = samples[i];
+        size_t counter = 0u;
+        const detail::autoBudgeted<T> counted(p.f,&counter,settings.budget);
+        const std::function<T(T)> g(std::cref(counted));
+        const T x = detail::solveOrNaN<T>([&]() {
+            return detail::solveWith<T>(s.method,g,p.a,p.b,eps);
+          });
+        total += std::min(counter,settings.budget);
+        if (detail::verifiedRoot<T>(p.f,p.a,p.b,x,eps)) {
+          ++s.solved;
+          s.maxEvaluations = std::max(s.maxEvaluations,counter);
+        }
+      }
+      s.evaluations = double(total)/double(samples.size());
+    }
+
+    // interleave the timed passes of the methods, so that a change of
+    // the machine load does not favour one of them
+    for (unsigned int r=0;r<std::max(settings.repeats,1u);++r) {
+      for (int m=0;m<NumRootMethods;++m) {
+        tuningScore& s = score[size_t(m)];
+        const clock::time_point start = clock::now();
+        for (size_t i=0;i<samples.size();++i) {
+          const tuningSample<T>& p = samples[i];
+          size_t counter = 0u;
+          const detail::autoBudgeted<T> counted(p.f,&counter,settings.budget);
+          const std::function<T(T)> g(std::cref(counted));
+          detail::solveOrNaN<T>([&]() {
+              return detail::solveWith<T>(s.method,g,p.a,p.b,eps);
+            });
+        }
+        const std::chrono::duration<double,std::nano> d = clock::now() - start;
+        s.nanoseconds = std::min(s.nanoseconds,
+                                 d.count()/double(samples.size()));
+      }
+    }
+
+    size_t mostSolved = 0u;
+    for (size_t m=0;m<score.size();++m) {
+      mostSolved = std::max(mostSolved,score[m].solved);
+    }
+    const tuningScore* best = 0;
+    for (size_t m=0;m<score.size();++m) {
+      const tuningScore& s = score[m];
+      if (s.solved != mostSolved) continue;
+      const double cost = (settings.criterion == TuneTime) ?
+        s.nanoseconds : s.evaluations;
+      const double bestCost = (best == 0) ? 0. :
+        ((settings.criterion == TuneTime) ? best->nanoseconds :
+                                            best->evaluations);
+      if (best == 0 || cost < bestCost) {
+        best = &s;
+      }
+    }
+
+    tuningDecision d;
+    d.family = family;
+    d.eps = double(eps);
+    d.method = best->method;
+    d.budget = std::min(settings.budget,
+                        std::max(size_t(64u),4u*best->maxEvaluations));
+    d.solvedFraction = double(best->solved)/double(samples.size());
+    d.evaluations = best->evaluations;
+    d.nanoseconds = best->nanoseconds;
+
+    if (scores) {
+      *scores = score;
+    }
+    return d;
+  }
+
+  /**
+   * Decisions of the autotuner, one per function family and tolerance,
+   * kept in a small text file so that later runs skip the calibration.
+   *
+   * Each line after the header "# anpi autotune profile 1" holds
+   *
+   *   <family> <eps> <method> <budget> <solved fraction>
+   *   <evaluations> <nanoseconds>
+   *
+   * The file is replaced atomically and synced, like the batch
+   * checkpoints (see anpi::replaceFile()).
+   */
+  class autotuneProfile {
+  public:
+    /// Empty profile that is not saved
+    autotuneProfile() {}
+
+    /**
+     * Profile stored at path, which is read if it exists.
+     *
+     * @throws anpi::Exception if the file is not a valid profile
+     */
+    explicit autotuneProfile(const std::string& path) : _path(path) {
+      std::ifstream in(path.c_str());
+      if (!in) {
+        return;
+      }
+      std::string line;
+      if (!std::getline(in,line) || line != header()) {
+        throw anpi::Exception("Invalid autotune profile " + path);
+      }
+      while (std::getline(in,line)) {
+        if (line.empty()) continue;
+        std::istringstream is(line);
+        tuningDecision d;
+        std::string method;
+        if (!(is >> d.family >> d.eps >> method >> d.budget
+                 >> d.solvedFraction >> d.evaluations >> d.nanoseconds) ||
+            !parseRootMethod(method,d.method)) {
+          throw anpi::Exception("Invalid autotune profile " + path);
+        }
+        store(d);
+      }
+    }
+
+    const std::string& path() const { return _path; }
+
+    /// All decisions
+    const std::vector<tuningDecision>& decisions() const { return _decisions; }
+
+    /// Decision for a family and tolerance, or null if not calibrated
+    const tuningDecision* find(const std::string& family,
+                               const double eps) const {
+      for (size_t i=0;i<_decisions.size();++i) {
+        if (_decisions[i].family == family && _decisions[i].eps == eps) {
+          return &_decisions[i];
+        }
+      }
+      return 0;
+    }
+
+    /**
+     * Add or replace the decision of its family and tolerance.
+     *
+     * @throws anpi::Exception if the family name is empty or contains
+     *         white space
+     */
+    void store(const tuningDecision& d) {
+      if (d.family.empty() ||
+          d.family.find_first_of(" \t\r\n") != std::string::npos) {
+        throw anpi::Exception("Invalid function family name '" +
+                              d.family + "'");
+      }
+      for (size_t i=0;i<_decisions.size();++i) {
+        if (_decisions[i].family == d.family && _decisions[i].eps == d.eps) {
+          _decisions[i] = d;
+          return;
+        }
+      }
+      _decisions.push_back(d);
+    }
+
+    /**
+     * Write the profile to its path, if it has one.
+     *
+     * @throws anpi::Exception if the file cannot be written
+     */
+    void save() const {
+      if (_path.empty()) {
+        return;
+      }
+      std::string text = header();
+      text += '\n';
+      char buf[256];
+      for (size_t i=0;i<_decisions.size();++i) {
+        const tuningDecision& d = _decisions[i];
+        std::snprintf(buf,sizeof(buf),"%.17g %s %lu %.6g %.6g %.6g",
+                      d.eps,rootMethodName(d.method),
+                      static_cast<unsigned long>(d.budget),
+                      d.solvedFraction,d.evaluations,d.nanoseconds);
+        text += d.family + ' ' + buf + '\n';
+      }
+      replaceFile(_path,text.data(),text.size(),"autotune profile");
+    }
+
+    /**
+     * Decision for a family and tolerance, calibrated on the samples
+     * with autotune() and saved only if the profile has none yet.
+     */
+    template<typename T>
+    const tuningDecision& decide(const std::string& family,
+                                 const std::vector<tuningSample<T> >& samples,
+                                 const T eps,
+                                 const tuningSettings& settings =
+                                   tuningSettings()) {
+      const tuningDecision* d = find(family,double(eps));
+      if (d == 0) {
+        store(autotune<T>(family,samples,eps,settings));
+        save();
+        d = find(family,double(eps));
+      }
+      return *d;
+    }
+
+  private:
+    static const char* header() { return "# anpi autotune profile 1"; }
+
+    std::string _path;
+    std::vector<tuningDecision> _decisions;
+  };
+
+  /**
+   * Find a root of funct in [xi,xii] with the method an autotuner chose
+   * for its function family (see autotune() and autotuneProfile).
+   *
+   * The bracketing methods search [xi,xii], the secant method starts
+   * at both ends and Newton-Raphson at the middle, as in calibration.
+   *
+   * @return root found, or NaN if the method failed or exceeded the
+   *         evaluation budget of the decision
+   */
+  template<typename T>
+  T rootAuto(const std::function<T(T)>& funct,T xi,T xii,const T eps,
+             const tuningDecision& decision) {
+    size_t counter = 0u;
+    const detail::autoBudgeted<T> counted(funct,&counter,decision.budget);
+    // wrapped by reference, which std::function stores without allocating
+    const std::function<T(T)> f(std::cref(counted));
+    return detail::solveOrNaN<T>([&]() {
+        return detail::solveWith<T>(decision.method,f,xi,xii,eps);
+      });
+  }
+
+} // namespace anpi
+
+#endif
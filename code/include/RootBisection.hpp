@@ -13,6 +13,8 @@
 #include <functional>
 
 #include "Exception.hpp"
+#include "Profiler.hpp"
+#include "TraceRecorder.hpp"
 
 #ifndef ANPI_ROOT_BISECTION_HPP
 #define ANPI_ROOT_BISECTION_HPP
@@ -21,21 +23,24 @@ namespace anpi
 {
 
 /**
-   * Find the roots of the function funct looking for it in the
-   * interval [xl,xu], using the bisection method.
+   * Bisection method recording its iterations in a trace policy, such
+   * as anpi::ringTrace (see TraceRecorder.hpp).
    *
    * @param funct a std::function of the form "T funct(T x)"
    * @param xl lower interval limit
    * @param xu upper interval limit
+   * @param trace receives the initial bracket and every iteration
    *
    * @return root found, or NaN if none could be found.
    *
    * @throws anpi::Exception if inteval is reversed or both extremes
    *         have same sign.
    */
-template <typename T>
-T rootBisection(const std::function<T(T)> &funct, T xl, T xu, const T eps)
+template <typename T, class Trace>
+T rootBisectionTraced(const std::function<T(T)> &funct, T xl, T xu,
+                      const T eps, Trace &trace)
 {
+    ANPI_PROFILE_SCOPE("solver","rootBisection");
 
     //in case the function does not diverge
     const int MAX_ITERATIONS = 40;
@@ -44,6 +49,7 @@ T rootBisection(const std::function<T(T)> &funct, T xl, T xu, const T eps)
     //evaluate lower boundary
     T f_min = funct(xl);
     int iterations = 0;
+    trace.record(0, xl, f_min, xu - xl, Start);
     //while the difference between the boundaries is more than the desired accuracy
     while (xl + eps < xu)
     {
@@ -64,15 +70,39 @@ T rootBisection(const std::function<T(T)> &funct, T xl, T xu, const T eps)
             xu = mid;
         }
         ++iterations;
+        trace.record(iterations, mid, f_mid, xu - xl, Bisection);
         
         if (iterations == MAX_ITERATIONS)
+        {
+            trace.record(iterations, xl, f_min, xu - xl, Failed);
             return std::numeric_limits<T>::quiet_NaN();
+        }
     }
 
     return xl;
     
 } //end if sign of boundaries is different
 
+/**
+   * Find the roots of the function funct looking for it in the
+   * interval [xl,xu], using the bisection method.
+   *
+   * @param funct a std::function of the form "T funct(T x)"
+   * @param xl lower interval limit
+   * @param xu upper interval limit
+   *
+   * @return root found, or NaN if none could be found.
+   *
+   * @throws anpi::Exception if inteval is reversed or both extremes
+   *         have same sign.
+   */
+template <typename T>
+T rootBisection(const std::function<T(T)> &funct, T xl, T xu, const T eps)
+{
+    noTrace trace;
+    return rootBisectionTraced<T>(funct, xl, xu, eps, trace);
+}
+
 } // namespace anpi
 
 #endif
@@ -13,6 +13,8 @@
 #include <functional>
 
 #include "Exception.hpp"
+#include "Profiler.hpp"
+#include "TraceRecorder.hpp"
 
 #ifndef ANPI_ROOT_BRENT_HPP
 #define ANPI_ROOT_BRENT_HPP
@@ -20,20 +22,23 @@
 namespace anpi {
   
   /**
-   * Find the roots of the function funct looking for it in the
-   * interval [xl,xu], using the Brent's method.
+   * Brent's method recording its iterations in a trace policy, such as
+   * anpi::ringTrace (see TraceRecorder.hpp).
    *
    * @param funct a std::function of the form "T funct(T x)"
    * @param xl lower interval limit
    * @param xu upper interval limit
+   * @param trace receives the initial bracket and every iteration
    *
    * @return root found, or NaN if none could be found.
    *
    * @throws anpi::Exception if inteval is reversed or both extremes
    *         have same sign.
    */
-  template<typename T>
-  T rootBrent(const std::function<T(T)>& funct,T xl,T xu,const T eps) {
+  template<typename T,class Trace>
+  T rootBrentTraced(const std::function<T(T)>& funct,T xl,T xu,
+                    const T eps,Trace& trace) {
+    ANPI_PROFILE_SCOPE("solver","rootBrent");
 
     // TODO: Put your code in here!
 
@@ -53,7 +58,7 @@ namespace anpi {
     T a=xl;
     T b = xu;
     T c = xu;
-    T d,e,min1,min2;
+    T d = T(0), e = T(0), min1, min2; // set in the first iteration
     T fa= funct(a), fb = funct(b), fc, p,q,r,s,tol1,xm;
     
     if((fb>T(0) && fa >T(0)) || (fa<T(0) && fb < T(0))){
@@ -62,6 +67,7 @@ namespace anpi {
     }
     
     fc = fb;
+    traceStep step = Start;
     for (int i = 1; i<= maxi;i++){
         if ((fb > T(0) && fc > T(0)) || (fb < T(0) && fc < T(0))) {
             c=a;
@@ -78,6 +84,7 @@ namespace anpi {
             fc=fa;
             
         }
+        trace.record(i-1,b,fb,std::fabs(c-b),step);
         tol1=T(2)*eps*std::fabs(b)*T(0.5);//R revisar el dato de tool
         xm =T(0.5)*(c-b);
         if(std::fabs(xm)<= tol1 || fb == T(0)){
@@ -105,16 +112,19 @@ namespace anpi {
             if(T(2)*p < (min1 < min2 ? min1 : min2)){
                 e=d;
                 d=p/q;
+                step = Interpolation;
                 
             }else{
                 d = xm;
                 e=d;
+                step = Bisection;
                 
             }
             
         }else{
             d = xm;
             e=d;
+            step = Bisection;
             
         }
         a = b;
@@ -131,8 +141,28 @@ namespace anpi {
     }
 
     // Return NaN if no root was found
+    trace.record(maxi,b,fb,std::fabs(c-b),Failed);
     return std::numeric_limits<T>::quiet_NaN();
   }
+
+  /**
+   * Find the roots of the function funct looking for it in the
+   * interval [xl,xu], using the Brent's method.
+   *
+   * @param funct a std::function of the form "T funct(T x)"
+   * @param xl lower interval limit
+   * @param xu upper interval limit
+   *
+   * @return root found, or NaN if none could be found.
+   *
+   * @throws anpi::Exception if inteval is reversed or both extremes
+   *         have same sign.
+   */
+  template<typename T>
+  T rootBrent(const std::function<T(T)>& funct,T xl,T xu,const T eps) {
+    noTrace trace;
+    return rootBrentTraced<T>(funct,xl,xu,eps,trace);
+  }
 }
   
 #endif
@@ -0,0 +1,251 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_ROOT_CONSTEXPR_HPP
+#define ANPI_ROOT_CONSTEXPR_HPP
+
+#include <limits>
+
+#include "Exception.hpp"
+
+namespace anpi {
+
+  /**
+   * Root finders usable in constant expressions.
+   *
+   * They take any literal callable, such as a lambda or a pointer to a
+   * constexpr function, instead of a std::function, and use neither
+   * <cmath> nor trace policies, so that roots of fixed equations can be
+   * computed by the compiler:
+   *
+   *   constexpr double r = anpi::rootBrentConstexpr(
+   *     [](double x) { return x*x*x - 2.; },0.,2.,1.e-15);
+   *
+   * The same functions can be called at run time.  Invalid brackets
+   * throw anpi::Exception there, and are compile errors in constant
+   * expressions.
+   */
+
+  namespace detail {
+
+    template<typename T>
+    constexpr T cabs(const T x) { return (x < T(0)) ? -x : x; }
+
+    template<typename T>
+    constexpr T cmax(const T a,const T b) { return (a < b) ? b : a; }
+
+    template<typename T>
+    constexpr bool cfinite(const T x) {
+      return x == x && cabs(x) <= std::numeric_limits<T>::max();
+    }
+
+    template<typename T>
+    constexpr bool sameSign(const T a,const T b) {
+      return (a > T(0) && b > T(0)) || (a < T(0) && b < T(0));
+    }
+
+    /// Cube root of the machine epsilon, the step of central differences
+    template<typename T>
+    constexpr T cbrtEpsilon() {
+      const T e = std::numeric_limits<T>::epsilon();
+      T y = T(1);
+      for (int i=0;i<100;++i) {
+        const T next = y - (y*y*y - e)/(T(3)*y*y);
+        if (next == y) break;
+        y = next;
+      }
+      return y;
+    }
+
+    template<typename T>
+    constexpr void checkBracket(const T xl,const T xu,const T fl,const T fu) {
+      if (!(xl < xu)) {
+        throw anpi::Exception("reversed interval");
+      }
+      if (sameSign(fl,fu)) {
+        throw anpi::Exception("both extremes have same sign");
+      }
+    }
+
+  } // namespace detail
+
+  /**
+   * Bisection in [xl,xu] until the bracket is not wider than eps, or
+   * cannot be split any further.
+   *
+   * @param funct a literal callable of the form "T funct(T x)"
+   *
+   * @return root found
+   *
+   * @throws anpi::Exception if the interval is reversed or both
+   *         extremes have the same sign.
+   */
+  template<typename T,class F>
+  constexpr T rootBisectionConstexpr(const F& funct,T xl,T xu,const T eps) {
+    T fl = funct(xl);
+    const T fu = funct(xu);
+    detail::checkBracket(xl,xu,fl,fu);
+    if (fl == T(0)) return xl;
+    if (fu == T(0)) return xu;
+
+    while (xu - xl > eps) {
+      const T mid = xl + T(0.5)*(xu - xl);
+      if (mid <= xl || mid >= xu) {
+        break;
+      }
+      const T fm = funct(mid);
+      if (fm == T(0)) {
+        return mid;
+      }
+      if (detail::sameSign(fm,fl)) {
+        xl = mid;
+        fl = fm;
+      } else {
+        xu = mid;
+      }
+    }
+    return xl + T(0.5)*(xu - xl);
+  }
+
+  /**
+   * Newton-Raphson from xi with the derivative dfunct, until a step is
+   * not larger than eps.
+   *
+   * @param funct a literal callable of the form "T funct(T x)"
+   * @param dfunct its derivative, of the same form
+   *
+   * @return root found, or NaN if the iteration diverges, hits a zero
+   *         derivative or does not converge in 100 steps
+   */
+  template<typename T,class F,class D>
+  constexpr T rootNewtonRaphsonConstexpr(const F& funct,const D& dfunct,
+                                         T xi,const T eps) {
+    for (int i=0;i<100;++i) {
+      const T fx = funct(xi);
+      if (fx == T(0)) {
+        return xi;
+      }
+      const T d = dfunct(xi);
+      if (d == T(0) || !detail::cfinite(d)) {
+        break;
+      }
+      const T dx = fx/d;
+      xi -= dx;
+      if (!detail::cfinite(xi)) {
+        break;
+      }
+      if (detail::cabs(dx) <= eps) {
+        return xi;
+      }
+    }
+    return std::numeric_limits<T>::quiet_NaN();
+  }
+
+  /**
+   * Newton-Raphson from xi with central difference derivatives.
+   *
+   * @param funct a literal callable of the form "T funct(T x)"
+   *
+   * @return root found, or NaN if none could be found
+   */
+  template<typename T,class F>
+  constexpr T rootNewtonRaphsonConstexpr(const F& funct,T xi,const T eps) {
+    const auto dfunct = [&funct](const T x) {
+      const T h = detail::cbrtEpsilon<T>()*detail::cmax(T(1),detail::cabs(x));
+      return (funct(x + h) - funct(x - h))/(T(2)*h);
+    };
+    return rootNewtonRaphsonConstexpr<T>(funct,dfunct,xi,eps);
+  }
+
+  /**
+   * Brent's method in [xl,xu], combining inverse quadratic
+   * interpolation, secant and bisection steps, until the bracket is not
+   * wider than eps (plus the rounding error at the root).
+   *
+   * @param funct a literal callable of the form "T funct(T x)"
+   *
+   * @return root found, or NaN if none could be found in as many
+   *         iterations as the mantissa has bits, times four
+   *
+   * @throws anpi::Exception if the interval is reversed or both
+   *         extremes have the same sign.
+   */
+  template<typename T,class F>
+  constexpr T rootBrentConstexpr(const F& funct,const T xl,const T xu,
+                                 const T eps) {
+    T a = xl;
+    T b = xu;
+    T fa = funct(a);
+    T fb = funct(b);
+    detail::checkBracket(xl,xu,fa,fb);
+
+    T c = b;
+    T fc = fb;
+    T d = b - a;
+    T e = d;
+    const T macheps = std::numeric_limits<T>::epsilon();
+    for (int i=0;i<4*std::numeric_limits<T>::digits;++i) {
+      if (detail::sameSign(fb,fc)) {
+        c = a;
+        fc = fa;
+        e = d = b - a;
+      }
+      if (detail::cabs(fc) < detail::cabs(fb)) {
+        a = b;
+        b = c;
+        c = a;
+        fa = fb;
+        fb = fc;
+        fc = fa;
+      }
+      const T tol = T(2)*macheps*detail::cabs(b) + T(0.5)*eps;
+      const T xm = T(0.5)*(c - b);
+      if (detail::cabs(xm) <= tol || fb == T(0)) {
+        return b;
+      }
+      if (detail::cabs(e) >= tol && detail::cabs(fa) > detail::cabs(fb)) {
+        // inverse quadratic interpolation, or secant if a == c
+        const T s = fb/fa;
+        T p = T(0);
+        T q = T(0);
+        if (a == c) {
+          p = T(2)*xm*s;
+          q = T(1) - s;
+        } else {
+          const T qa = fa/fc;
+          const T r = fb/fc;
+          p = s*(T(2)*xm*qa*(qa - r) - (b - a)*(r - T(1)));
+          q = (qa - T(1))*(r - T(1))*(s - T(1));
+        }
+        if (p > T(0)) {
+          q = -q;
+        }
+        p = detail::cabs(p);
+        const T min1 = T(3)*xm*q - detail::cabs(tol*q);
+        const T min2 = detail::cabs(e*q);
+        if (T(2)*p < ((min1 < min2) ? min1 : min2)) {
+          e = d;
+          d = p/q;
+        } else {
+          d = xm;
+          e = d;
+        }
+      } else {
+        d = xm;
+        e = d;
+      }
+      a = b;
+      fa = fb;
+      b += (detail::cabs(d) > tol) ? d : ((xm > T(0)) ? tol : -tol);
+      fb = funct(b);
+    }
+    return std::numeric_limits<T>::quiet_NaN();
+  }
+
+} // namespace anpi
+
+#endif
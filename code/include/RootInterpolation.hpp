@@ -13,6 +13,8 @@
 #include <functional>
 
 #include "Exception.hpp"
+#include "Profiler.hpp"
+#include "TraceRecorder.hpp"
 
 #ifndef ANPI_ROOT_INTERPOLATION_HPP
 #define ANPI_ROOT_INTERPOLATION_HPP
@@ -20,20 +22,23 @@
 namespace anpi {
   
   /**
-   * Find the roots of the function funct looking for it in the
-   * interval [xl,xu], by means of the interpolation method.
+   * Interpolation method recording its iterations in a trace policy,
+   * such as anpi::ringTrace (see TraceRecorder.hpp).
    *
    * @param funct a functor of the form "T funct(T x)"
    * @param xl lower interval limit
    * @param xu upper interval limit
+   * @param trace receives the initial bracket and every iteration
    *
    * @return root found, or NaN if none could be found.
    *
    * @throws anpi::Exception if inteval is reversed or both extremes
    *         have same sign.
    */
-  template<typename T>
-  T rootInterpolation(const std::function<T(T)>& funct,T xl,T xu,const T eps) {
+  template<typename T,class Trace>
+  T rootInterpolationTraced(const std::function<T(T)>& funct,T xl,T xu,
+                            const T eps,Trace& trace) {
+    ANPI_PROFILE_SCOPE("solver","rootInterpolation");
 
     // TODO: Put your code in here!
     // cant work with inverted interval
@@ -49,16 +54,18 @@ namespace anpi {
       T xr = xl;
       T fl = funct(xl);
       T fu = funct(xu);
+      trace.record(0,xl,fl,xu-xl,Start);
       T ea = T();
       int il = 0;
       int iu=0;
+      T fr = fl;
       const T es = std::sqrt(std::numeric_limits<T>::epsilon());
       const int maxi= std::numeric_limits<T>::digits;
       
       for(int i = maxi; i>0;--i){
           T xrold(xr); //Se utiliza para el calculo del error
           xr = xu - fu*(xl-xu)/(fl-fu);
-          T fr = funct(xr);
+          fr = funct(xr);
           //Evita una division por ceros.
           if (std::abs(xr)>std::numeric_limits<T>::epsilon()){
               ea = std::abs((xr-xrold)/xr)*T(100);
@@ -87,15 +94,36 @@ namespace anpi {
             xr = (fl == T(0)) ? xl : xu;
             
         }
+        trace.record(maxi-i+1,xr,fr,std::abs(xu-xl),FalsePosition);
         if (ea < es) return xr;
           
     }
 
 
     // Return NaN if no root was found
+    trace.record(maxi,xr,fr,std::abs(xu-xl),Failed);
     return std::numeric_limits<T>::quiet_NaN();
   }
 
+  /**
+   * Find the roots of the function funct looking for it in the
+   * interval [xl,xu], by means of the interpolation method.
+   *
+   * @param funct a functor of the form "T funct(T x)"
+   * @param xl lower interval limit
+   * @param xu upper interval limit
+   *
+   * @return root found, or NaN if none could be found.
+   *
+   * @throws anpi::Exception if inteval is reversed or both extremes
+   *         have same sign.
+   */
+  template<typename T>
+  T rootInterpolation(const std::function<T(T)>& funct,T xl,T xu,const T eps) {
+    noTrace trace;
+    return rootInterpolationTraced<T>(funct,xl,xu,eps,trace);
+  }
+
 }
   
 #endif
@@ -13,6 +13,8 @@
 #include <functional>
 
 #include "Exception.hpp"
+#include "Profiler.hpp"
+#include "TraceRecorder.hpp"
 
 #ifndef ANPI_NEWTON_RAPHSON_HPP
 #define ANPI_NEWTON_RAPHSON_HPP
@@ -41,16 +43,31 @@ namespace anpi {
   }
 
   
-  template<typename T>
-  T rootNewtonRaphson(const std::function<T(T)>& funct,T xi,const T eps) {
+  /**
+   * Newton-Raphson method recording its iterations in a trace policy,
+   * such as anpi::ringTrace (see TraceRecorder.hpp).
+   *
+   * @param funct a functor of the form "T funct(T x)"
+   * @param xi initial root guess
+   * @param trace receives every iterate and the step taken from it
+   *
+   * @return root found, or NaN if none could be found.
+   */
+  template<typename T,class Trace>
+  T rootNewtonRaphsonTraced(const std::function<T(T)>& funct,T xi,
+                            const T eps,Trace& trace) {
+    ANPI_PROFILE_SCOPE("solver","rootNewtonRaphson");
 
     // TODO: Put your code in here!
     T xii;
 	  T Dx;
+	  unsigned int iteration = 0;
 	
 	  do {
-		  xii = xi - funct(xi)/dfunct(funct,xi);
+		  const T fi = funct(xi);
+		  xii = xi - fi/dfunct(funct,xi);
 		  Dx = fabs(xii - xi);
+		  trace.record(iteration++,xi,fi,Dx,Newton);
 		  xi = xii;
 	  } while (Dx > eps);
 	  return xii;
@@ -59,6 +76,12 @@ namespace anpi {
      //return std::numeric_limits<T>::quiet_NaN();
   }
 
+  template<typename T>
+  T rootNewtonRaphson(const std::function<T(T)>& funct,T xi,const T eps) {
+    noTrace trace;
+    return rootNewtonRaphsonTraced<T>(funct,xi,eps,trace);
+  }
+
 }
   
 #endif
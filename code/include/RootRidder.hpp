@@ -13,6 +13,8 @@
 #include <functional>
 
 #include "Exception.hpp"
+#include "Profiler.hpp"
+#include "TraceRecorder.hpp"
 
 #ifndef ANPI_ROOT_RIDDER_HPP
 #define ANPI_ROOT_RIDDER_HPP
@@ -21,18 +23,25 @@ namespace anpi
 {
 
 /**
-   * Find a root of the function funct looking for it starting at xi
-   * by means of the secant method.
+   * Ridder's method recording its iterations in a trace policy, such as
+   * anpi::ringTrace (see TraceRecorder.hpp).  A Failed step is recorded
+   * before any of the exceptions is thrown.
    *
    * @param funct a functor of the form "T funct(T x)"
-   * @param xi initial position
-   * @param xii second initial position 
+   * @param xi lower interval limit
+   * @param xii upper interval limit
+   * @param trace receives the initial bracket and every iteration
    *
    * @return root found, or NaN if no root could be found
+   *
+   * @throws anpi::Exception if the root is not bracketed, or the method
+   *         does not converge
    */
-template <typename T>
-T rootRidder(const std::function<T(T)> &funct, T xi, T xii, const T eps)
+template <typename T, class Trace>
+T rootRidderTraced(const std::function<T(T)> &funct, T xi, T xii,
+                   const T eps, Trace &trace)
 {
+  ANPI_PROFILE_SCOPE("solver","rootRidder");
 
   // TODO: Put your code in here!
   //max amount of iterations before the function returns NaN
@@ -42,6 +51,7 @@ T rootRidder(const std::function<T(T)> &funct, T xi, T xii, const T eps)
   //boundaries
   T fl = funct(xi);
   T fh = funct(xii);
+  trace.record(0, xi, fl, xii - xi, Start);
 
   //the value has to be enclosed, therefore, the function evaluations must have diferent sign
   if ((fl > 0.0 && fh < 0.0) || (fl < 0.0 && fh > 0.0))
@@ -64,7 +74,7 @@ T rootRidder(const std::function<T(T)> &funct, T xi, T xii, const T eps)
       fm = funct(xm);
 
       //s is used to calculate new boundary xnew
-      s = sqrt(fm * fm - fl * fh);
+      s = std::sqrt(fm * fm - fl * fh);
 
       //this means fm==fl==fh, we have reached a solution
       if (s == 0.0)
@@ -75,7 +85,7 @@ T rootRidder(const std::function<T(T)> &funct, T xi, T xii, const T eps)
 
       //if the difference between our new point and our current answer is less than the desired
       //accuracy (eps) then we have reached a solution. ** This is why we need to initialize ans
-      if (abs(xnew - ans) <= eps)
+      if (std::abs(xnew - ans) <= eps)
         return ans;
 
       //set the answer to our estimation
@@ -114,15 +124,20 @@ T rootRidder(const std::function<T(T)> &funct, T xi, T xii, const T eps)
         fl = fnew;
       }
       else
-        throw("rootRidder should never get here.");
+      {
+        trace.record(j + 1, ans, fnew, xh - xl, Failed);
+        throw anpi::Exception("rootRidder should never get here.");
+      }
+      trace.record(j + 1, ans, fnew, xh - xl, Ridder);
 
       //if the difference between our boundaries is less than the desired accuracy we reached a solution
-      if (abs(xh - xl) <= eps)
+      if (std::abs(xh - xl) <= eps)
         return ans;
     } //end for
 
     //solution not found in MAX_ITERATION amout of tries
-    throw("rootRidder exceeded maximum iterations");
+    trace.record(MAX_ITERATION, ans, fnew, xh - xl, Failed);
+    throw anpi::Exception("rootRidder exceeded maximum iterations");
   }
   else
   {
@@ -133,13 +148,34 @@ T rootRidder(const std::function<T(T)> &funct, T xi, T xii, const T eps)
       return xii;
 
     //error reached
-    throw("root must be bracketed in rootRidder.");
+    trace.record(0, xi, fl, xii - xi, Failed);
+    throw anpi::Exception("root must be bracketed in rootRidder.");
   }
 
   // Return NaN if no root was found
   return std::numeric_limits<T>::quiet_NaN();
 }
 
+/**
+   * Find a root of the function funct looking for it starting at xi
+   * by means of the secant method.
+   *
+   * @param funct a functor of the form "T funct(T x)"
+   * @param xi initial position
+   * @param xii second initial position 
+   *
+   * @return root found, or NaN if no root could be found
+   *
+   * @throws anpi::Exception if the root is not bracketed, or the method
+   *         does not converge
+   */
+template <typename T>
+T rootRidder(const std::function<T(T)> &funct, T xi, T xii, const T eps)
+{
+  noTrace trace;
+  return rootRidderTraced<T>(funct, xi, xii, eps, trace);
+}
+
 } // namespace anpi
 
 #endif
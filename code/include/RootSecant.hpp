@@ -13,6 +13,8 @@
 #include <functional>
 
 #include "Exception.hpp"
+#include "Profiler.hpp"
+#include "TraceRecorder.hpp"
 
 #ifndef ANPI_ROOT_SECANT_HPP
 #define ANPI_ROOT_SECANT_HPP
@@ -20,26 +22,32 @@
 namespace anpi {
   
   /**
-   * Find a root of the function funct looking for it starting at xi
-   * by means of the secant method.
+   * Secant method recording its iterations in a trace policy, such as
+   * anpi::ringTrace (see TraceRecorder.hpp).
    *
    * @param funct a functor of the form "T funct(T x)"
    * @param xi initial position
-   * @param xii second initial position 
+   * @param xii second initial position
+   * @param trace receives every iterate and the step taken from it
    *
    * @return root found, or NaN if no root could be found
    */
-  template<typename T>
-  T rootSecant(const std::function<T(T)>& funct,T xi,T xii,const T eps) {
+  template<typename T,class Trace>
+  T rootSecantTraced(const std::function<T(T)>& funct,T xi,T xii,
+                     const T eps,Trace& trace) {
+    ANPI_PROFILE_SCOPE("solver","rootSecant");
 
     // TODO: Put your code in here!
     T Dx;
 	  T p,q,x2;
+	  unsigned int iteration = 0;
 	  do {
-        p = xi * funct(xii) - xii * funct(xi);
+        const T fii = funct(xii);
+        p = xi * fii - xii * funct(xi);
         q = funct(xii) - funct(xi);
         x2 = p / q;
         Dx = fabs(x2 - xii);
+        trace.record(iteration++,xii,fii,Dx,Secant);
         xi = xii;
         xii = x2;
 	  }while (Dx > eps);
@@ -51,6 +59,22 @@ namespace anpi {
     //return std::numeric_limits<T>::quiet_NaN();
   }
 
+  /**
+   * Find a root of the function funct looking for it starting at xi
+   * by means of the secant method.
+   *
+   * @param funct a functor of the form "T funct(T x)"
+   * @param xi initial position
+   * @param xii second initial position 
+   *
+   * @return root found, or NaN if no root could be found
+   */
+  template<typename T>
+  T rootSecant(const std::function<T(T)>& funct,T xi,T xii,const T eps) {
+    noTrace trace;
+    return rootSecantTraced<T>(funct,xi,xii,eps,trace);
+  }
+
 }
   
 #endif
@@ -0,0 +1,573 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_SHARDED_SOLVER_HPP
+#define ANPI_SHARDED_SOLVER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <csignal>
+#include <dirent.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "BatchSolver.hpp"
+#include "ThreadPool.hpp"
+
+namespace anpi {
+  namespace batch {
+
+    /// Settings of runSharded()
+    struct shardSettings {
+      shardSettings() : processes(0u),retries(8u) {}
+
+      /// Worker processes, 0 for one per NUMA node
+      unsigned int processes;
+      /**
+       * Workers of one shard that may die in a row without completing
+       * a chunk before the job is abandoned
+       */
+      unsigned int retries;
+      /**
+       * If set, called by the workers before solving each row.  Meant to
+       * inject faults in tests: a worker killed here is restarted.
+       */
+      std::function<void(uint64_t)> beforeRow;
+    };
+
+    /// Totals of a sharded run
+    struct shardSummary : public summary {
+      /// Worker processes started again after dying
+      uint64_t restarts;
+      /// Rows given status Error because solving them killed a worker
+      uint64_t poisoned;
+    };
+
+    /**
+     * CPUs of a list in the sysfs format, e.g. "0-3,8,10-11".
+     */
+    inline std::vector<int> parseCpuList(const std::string& list) {
+      std::vector<int> cpus;
+      std::istringstream in(list);
+      std::string item;
+      while (std::getline(in,item,',')) {
+        const size_t dash = item.find('-');
+        const int first = std::atoi(item.c_str());
+        const int last = (dash == std::string::npos) ? first :
+          std::atoi(item.c_str() + dash + 1u);
+        if (item.find_first_of("0123456789") == std::string::npos) continue;
+        for (int c=first;c<=last;++c) cpus.push_back(c);
+      }
+      return cpus;
+    }
+
+    /// A NUMA node and the CPUs of it the process may run on
+    struct numaNode {
+      /// Node number, -1 if the system reports no nodes
+      int id;
+      std::vector<int> cpus;
+    };
+
+    /**
+     * NUMA nodes with at least one CPU the process may run on, read from
+     * /sys/devices/system/node.  If there is no such information, one
+     * node with id -1 holds all allowed CPUs.
+     */
+    inline std::vector<numaNode> numaNodes() {
+      const std::vector<int> allowed = threadPool::allowedCpus();
+      const std::set<int> allowedSet(allowed.begin(),allowed.end());
+
+      std::vector<numaNode> nodes;
+      const char* const root = "/sys/devices/system/node";
+      if (DIR* dir = ::opendir(root)) {
+        while (const struct dirent* e = ::readdir(dir)) {
+          const std::string name(e->d_name);
+          if (name.compare(0u,4u,"node") != 0 || name.size() == 4u ||
+              name.find_first_not_of("0123456789",4u) != std::string::npos) {
+            continue;
+          }
+          std::ifstream f((std::string(root) + "/" + name + "/cpulist").c_str());
+          std::string list;
+          std::getline(f,list);
+          numaNode n;
+          n.id = std::atoi(name.c_str() + 4);
+          const std::vector<int> cpus = parseCpuList(list);
+          for (size_t i=0;i<cpus.size();++i) {
+            if (allowedSet.count(cpus[i])) n.cpus.push_back(cpus[i]);
+          }
+          if (!n.cpus.empty()) nodes.push_back(n);
+        }
+        ::closedir(dir);
+      }
+      if (nodes.empty()) {
+        numaNode n;
+        n.id = -1;
+        n.cpus = allowed;
+        nodes.push_back(n);
+      }
+      std::sort(nodes.begin(),nodes.end(),
+                [](const numaNode& x,const numaNode& y) { return x.id < y.id; });
+      return nodes;
+    }
+
+    namespace detail {
+
+      static_assert(ATOMIC_CHAR_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+                    "shared memory flags need lock-free atomics");
+
+      /// States of a chunk in the shared region
+      enum chunkState {
+        /// Not started
+        ChunkPending = 0,
+        /// Being solved by a worker thread
+        ChunkRunning,
+        /// Rows written
+        ChunkDone,
+        /// Was running when its worker died
+        ChunkSuspect,
+        /// Being solved again, alone and row by row
+        ChunkRetrying
+      };
+
+      /// Per shard counters in the shared region, one cache line each
+      struct shardSlot {
+        /// Rows solved by the workers of the shard
+        std::atomic<uint64_t> processed;
+        /// Row being solved in a retried chunk
+        std::atomic<uint64_t> row;
+        char padding[64 - 2*sizeof(std::atomic<uint64_t>)];
+      };
+
+      /**
+       * Anonymous shared mapping holding one state per chunk and one
+       * slot per shard.  Created before forking, so that the supervisor
+       * and all workers see the same memory; lock-free atomics are
+       * address free and so work across the processes.
+       */
+      class sharedRegion {
+      public:
+        sharedRegion(const uint64_t chunks,const size_t shards)
+          : _size(shards*sizeof(shardSlot) + size_t(chunks)) {
+          _base = ::mmap(0,_size,PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS,-1,0);
+          if (_base == MAP_FAILED) {
+            throw anpi::Exception(std::string("Cannot map shared memory: ") +
+                                  std::strerror(errno));
+          }
+          _slots = static_cast<shardSlot*>(_base);
+          for (size_t i=0;i<shards;++i) {
+            new (&_slots[i].processed) std::atomic<uint64_t>(0u);
+            new (&_slots[i].row) std::atomic<uint64_t>(0u);
+          }
+          _states = reinterpret_cast<std::atomic<uint8_t>*>(
+            static_cast<char*>(_base) + shards*sizeof(shardSlot));
+          for (uint64_t k=0;k<chunks;++k) {
+            new (&_states[k]) std::atomic<uint8_t>(uint8_t(ChunkPending));
+          }
+        }
+
+        ~sharedRegion() { ::munmap(_base,_size); }
+
+        sharedRegion(const sharedRegion&) = delete;
+        sharedRegion& operator=(const sharedRegion&) = delete;
+
+        std::atomic<uint8_t>& state(const uint64_t k) { return _states[k]; }
+        shardSlot& slot(const size_t i) { return _slots[i]; }
+
+      private:
+        void* _base;
+        size_t _size;
+        shardSlot* _slots;
+        std::atomic<uint8_t>* _states;
+      };
+
+      /// A contiguous range of chunks and the worker process solving it
+      struct shard {
+        uint64_t first;
+        uint64_t last;
+        const numaNode* node;
+        unsigned int threads;
+        pid_t pid;
+        /// Chunks of the shard done when its worker was started
+        uint64_t doneAtSpawn;
+        /// Workers died in a row without completing a chunk
+        unsigned int failures;
+      };
+
+      /// Exit status of a worker that caught an exception
+      const int WorkerError = 3;
+
+      /**
+       * Body of a worker process: bind to the node of the shard, solve
+       * the chunks suspected of killing a previous worker one row at a
+       * time, then the pending chunks on a threadPool.
+       */
+      inline void shardWorker(const shard& s,const size_t index,
+                              sharedRegion& region,
+                              const columnProblems& problems,
+                              columnResults& out,
+                              const uint64_t rows,const uint64_t chunk,
+                              const std::set<uint64_t>& poisoned,
+                              const options& opts,
+                              const shardSettings& settings) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (size_t i=0;i<s.node->cpus.size();++i) {
+          CPU_SET(s.node->cpus[i],&set);
+        }
+        sched_setaffinity(0,sizeof(set),&set);
+#if defined(SYS_set_mempolicy)
+        // prefer, not bind: a full node spills over instead of failing
+        if (s.node->id >= 0 && s.node->id < 64) {
+          const unsigned long mask = 1ul << s.node->id;
+          const int MpolPreferred = 1;
+          ::syscall(SYS_set_mempolicy,MpolPreferred,&mask,
+                    8u*sizeof(mask) + 1u);
+        }
+#endif
+
+        const solverType solver = findSolver(opts.method);
+        shardSlot& slot = region.slot(index);
+        const auto solveRow = [&](const uint64_t i) {
+          if (settings.beforeRow) settings.beforeRow(i);
+          out.store(i,problems.solve(i,solver,opts));
+        };
+
+        for (uint64_t k=s.first;k<s.last;++k) {
+          uint8_t expected = ChunkSuspect;
+          if (!region.state(k).compare_exchange_strong(expected,
+                                                       ChunkRetrying)) {
+            continue;
+          }
+          const uint64_t last = std::min(rows,(k+1u)*chunk);
+          for (uint64_t i=k*chunk;i<last;++i) {
+            if (poisoned.count(i)) continue;
+            slot.row.store(i,std::memory_order_relaxed);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            solveRow(i);
+          }
+          region.state(k).store(ChunkDone,std::memory_order_release);
+          slot.processed.fetch_add(last - k*chunk,std::memory_order_relaxed);
+        }
+
+        threadPool pool(s.threads,opts.pin);
+        pool.parallelFor(size_t(s.first),size_t(s.last),[&](const size_t k) {
+            uint8_t expected = ChunkPending;
+            if (!region.state(k).compare_exchange_strong(expected,
+                                                         ChunkRunning)) {
+              return;
+            }
+            const uint64_t last = std::min(rows,(k+1u)*chunk);
+            for (uint64_t i=k*chunk;i<last;++i) solveRow(i);
+            region.state(k).store(ChunkDone,std::memory_order_release);
+            slot.processed.fetch_add(last - k*chunk,
+                                     std::memory_order_relaxed);
+          },1u);
+      }
+
+      /// Kills and reaps the workers still running when it goes out of scope
+      struct workerReaper {
+        explicit workerReaper(std::vector<shard>& s) : shards(s) {}
+        ~workerReaper() {
+          for (size_t i=0;i<shards.size();++i) {
+            if (shards[i].pid > 0) ::kill(shards[i].pid,SIGKILL);
+          }
+          for (size_t i=0;i<shards.size();++i) {
+            if (shards[i].pid > 0) {
+              while (::waitpid(shards[i].pid,0,0) < 0 && errno == EINTR) {}
+            }
+          }
+        }
+        std::vector<shard>& shards;
+      };
+
+    } // namespace detail
+
+    /**
+     * Solve all rows of a column file like runColumns(), in several
+     * worker processes.
+     *
+     * The chunks of opts.chunk rows are split into one contiguous shard
+     * per process.  Each worker is forked with its CPUs and its memory
+     * preference restricted to one NUMA node (shards go round robin over
+     * the nodes), and solves its shard on a threadPool of opts.threads
+     * threads, by default the CPUs of the node divided among the
+     * workers sharing it.  The results are written straight into the
+     * shared mapping of the output file; the state of every chunk
+     * lives in an anonymous shared mapping, updated by the workers
+     * with lock-free atomics.
+     *
+     * The calling process supervises: it reports progress, writes the
+     * checkpoint of opts.checkpoint (in the format of runColumns(), so
+     * either function resumes the other's jobs) and restarts dead
+     * workers for the chunks of their shard not done yet.  Chunks that
+     * were running when a worker died are solved first and one row at
+     * a time by the next worker; a row during which that worker dies as
+     * well is given status Error and skipped from then on, so that a
+     * problem crashing the solver cannot stall the job.  The job is
+     * abandoned once settings.retries workers of a shard died in a row
+     * without completing a chunk.
+     *
+     * Must be called from a single-threaded process, since it forks.
+     *
+     * @throws anpi::Exception if a file cannot be mapped, output is the
+     *         input file, the input has no known problem columns, the
+     *         method is unknown, the checkpoint belongs to another job,
+     *         a worker reports an error, or the workers of a shard keep
+     *         dying
+     */
+    inline shardSummary runSharded(const std::string& input,
+                                   const std::string& output,
+                                   const options& opts,
+                                   const shardSettings& settings =
+                                     shardSettings(),
+                                   std::ostream* progress = 0) {
+      using namespace detail;
+      typedef std::chrono::steady_clock clock;
+      const clock::time_point start = clock::now();
+
+      findSolver(opts.method); // fail before forking
+      checkDistinctFiles(input,output);
+      const columnFile in(input);
+      const uint64_t rows = in.rows();
+      const columnProblems problems(in);
+
+      const uint64_t chunk = std::max(size_t(1u),opts.chunk);
+      const uint64_t chunks = (rows + chunk - 1u)/chunk;
+      const uint64_t job = jobFingerprint("columns",opts,rows);
+
+      const std::vector<numaNode> nodes = numaNodes();
+      const size_t processes = std::max<size_t>(
+        1u,std::min<uint64_t>(chunks,settings.processes ?
+                              settings.processes : nodes.size()));
+
+      std::vector<shard> shards(processes);
+      for (size_t i=0;i<processes;++i) {
+        shard& s = shards[i];
+        s.first = chunks*i/processes;
+        s.last = chunks*(i+1u)/processes;
+        s.node = &nodes[i % nodes.size()];
+        const size_t sharing = processes/nodes.size() +
+          (i % nodes.size() < processes % nodes.size() ? 1u : 0u);
+        s.threads = opts.threads ? opts.threads :
+          unsigned(std::max<size_t>(1u,s.node->cpus.size()/sharing));
+        s.pid = 0;
+        s.doneAtSpawn = 0u;
+        s.failures = 0u;
+      }
+
+      sharedRegion region(chunks,processes);
+
+      checkpointState resume;
+      const bool resuming = !opts.checkpoint.empty() &&
+        readCheckpoint(opts.checkpoint,resume);
+      uint64_t skipped = 0u;
+      if (resuming) {
+        if (resume.fingerprint != job) {
+          throw anpi::Exception("Checkpoint " + opts.checkpoint +
+                                " belongs to another job");
+        }
+        skipped = completedChunks(resume,rows,chunk,[&](const uint64_t k) {
+            region.state(k).store(ChunkDone,std::memory_order_relaxed);
+          });
+        if (progress) {
+          *progress << "Resuming with " << skipped << " rows done"
+                    << std::endl;
+        }
+      }
+      columnResults out(output,rows,resuming);
+
+      std::set<uint64_t> poisoned; // copied into each worker by fork
+      shardSummary sum;
+      sum.restarts = 0u;
+
+      workerReaper reaper(shards);
+      const auto completed = [&](const shard& s) {
+        uint64_t n = 0u;
+        for (uint64_t k=s.first;k<s.last;++k) {
+          n += region.state(k).load(std::memory_order_acquire) == ChunkDone;
+        }
+        return n;
+      };
+      const pid_t supervisor = ::getpid();
+      const auto spawn = [&](const size_t i) {
+        if (progress) progress->flush();
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+          throw anpi::Exception(std::string("Cannot fork: ") +
+                                std::strerror(errno));
+        }
+        if (pid == 0) {
+          // a worker outliving its supervisor would race a restarted job
+          ::prctl(PR_SET_PDEATHSIG,SIGKILL);
+          if (::getppid() != supervisor) ::_exit(WorkerError);
+          int code = 0;
+          try {
+            shardWorker(shards[i],i,region,problems,out,rows,chunk,poisoned,
+                        opts,settings);
+          } catch (std::exception& e) {
+            const std::string msg = std::string(e.what()) + "\n";
+            if (::write(2,msg.data(),msg.size()) < 0) {}
+            code = WorkerError;
+          } catch (...) {
+            code = WorkerError;
+          }
+          ::_exit(code); // no destructors or atexit handlers of the parent
+        }
+        shards[i].pid = pid;
+        shards[i].doneAtSpawn = completed(shards[i]);
+      };
+
+      size_t running = 0u;
+      for (size_t i=0;i<processes;++i) {
+        if (completed(shards[i]) < shards[i].last - shards[i].first) {
+          spawn(i);
+          ++running;
+        }
+      }
+
+      clock::time_point lastReport = start;
+      clock::time_point lastCheckpoint = start;
+      const std::chrono::duration<double> interval(opts.interval > 0. ?
+                                                   opts.interval : 1.);
+      const auto saveCheckpoint = [&]() {
+        checkpointState s;
+        s.fingerprint = job;
+        for (uint64_t k=0;k<chunks;++k) {
+          if (region.state(k).load(std::memory_order_acquire) == ChunkDone) {
+            appendChunk(s,k,rows,chunk);
+          }
+        }
+        out.file->sync(); // the rows of the states seen above are durable
+        writeCheckpoint(opts.checkpoint,s);
+      };
+      const auto processed = [&]() {
+        uint64_t n = 0u;
+        for (size_t i=0;i<processes;++i) {
+          n += region.slot(i).processed.load(std::memory_order_relaxed);
+        }
+        return n;
+      };
+
+      while (running > 0u) {
+        int status = 0;
+        const pid_t pid = ::waitpid(-1,&status,WNOHANG);
+        if (pid < 0 && errno != EINTR) {
+          throw anpi::Exception(std::string("Cannot wait for workers: ") +
+                                std::strerror(errno));
+        }
+        if (pid <= 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+          const clock::time_point now = clock::now();
+          if (!opts.checkpoint.empty() && now - lastCheckpoint >= interval) {
+            saveCheckpoint();
+            lastCheckpoint = now;
+          }
+          if (progress && now - lastReport >= std::chrono::seconds(1)) {
+            const std::chrono::duration<double> d = now - start;
+            *progress << "\r" << skipped + processed() << " rows, "
+                      << uint64_t(double(processed())/d.count())
+                      << " roots/s, " << running << " workers"
+                      << std::flush;
+            lastReport = now;
+          }
+          continue;
+        }
+
+        size_t i = 0u;
+        while (i < processes && shards[i].pid != pid) ++i;
+        if (i == processes) continue; // not one of ours
+        shard& s = shards[i];
+        s.pid = 0;
+        --running;
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == WorkerError) {
+          throw anpi::Exception("Worker of shard " + std::to_string(i) +
+                                " failed");
+        }
+        const bool clean = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        if (!clean) {
+          // blame the chunks the worker was in
+          for (uint64_t k=s.first;k<s.last;++k) {
+            const uint8_t st = region.state(k).load(std::memory_order_acquire);
+            if (st == ChunkRetrying) {
+              const uint64_t row =
+                region.slot(i).row.load(std::memory_order_relaxed);
+              outcome o;
+              o.root = std::numeric_limits<double>::quiet_NaN();
+              o.evaluations = 0u;
+              o.status = Error;
+              out.store(row,o);
+              poisoned.insert(row);
+            }
+            if (st == ChunkRetrying || st == ChunkRunning) {
+              region.state(k).store(ChunkSuspect,std::memory_order_relaxed);
+            }
+          }
+          s.failures = (completed(s) > s.doneAtSpawn) ? 0u : s.failures + 1u;
+          if (s.failures >= settings.retries) {
+            throw anpi::Exception("Workers of shard " + std::to_string(i) +
+                                  " keep dying");
+          }
+          if (progress) {
+            *progress << "\nWorker " << pid << " of shard " << i << " died";
+            if (WIFSIGNALED(status)) {
+              *progress << " by signal " << WTERMSIG(status);
+            }
+            *progress << std::endl;
+          }
+        }
+        if (completed(s) < s.last - s.first) {
+          ++sum.restarts;
+          spawn(i);
+          ++running;
+        }
+      }
+
+      if (!opts.checkpoint.empty()) {
+        out.file->sync();
+        ::unlink(opts.checkpoint.c_str());
+      }
+
+      sum.lines = rows;
+      sum.solved = uint64_t(std::count(out.status,out.status + rows,
+                                       uint8_t(Solved)));
+      sum.failed = rows - sum.solved;
+      sum.poisoned = poisoned.size();
+      const std::chrono::duration<double> d = clock::now() - start;
+      sum.seconds = d.count();
+      if (progress) {
+        *progress << "\r" << sum.lines << " rows in " << sum.seconds
+                  << " s, " << uint64_t(double(processed())/sum.seconds)
+                  << " roots/s, " << sum.failed << " failed, "
+                  << sum.restarts << " restarts" << std::endl;
+      }
+      return sum;
+    }
+
+  } // namespace batch
+} // namespace anpi
+
+#endif
@@ -0,0 +1,663 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_SOLVE_SERVICE_HPP
+#define ANPI_SOLVE_SERVICE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "BatchSolver.hpp"
+#include "Exception.hpp"
+#include "Profiler.hpp"
+
+namespace anpi {
+  namespace service {
+
+    /**
+     * Root solving service on a Unix domain socket.
+     *
+     * Each message is a frame: a uint32_t with the number of bytes that
+     * follow, and the payload.  All integers are in host byte order,
+     * since both ends run on the same machine.
+     *
+     * A request payload is a uint64_t id chosen by the client followed
+     * by one problem line in the format of the batch solver (see
+     * BatchSolver.hpp), for instance "corpus 1 42" or
+     * "expr 0 2 abs(x)-exp(-x)".
+     *
+     * A response payload is a response struct.  Responses to the
+     * requests of one connection may come back in any order; the id
+     * pairs them.
+     *
+     * The server collects the requests of all connections arriving
+     * within a short window into one batch, which its worker threads
+     * solve in slices.  Each response carries how long its request
+     * waited, how long the solve took and the size of its batch.
+     */
+
+    /// Largest request payload accepted
+    const uint32_t MaxRequest = 65536u;
+
+    /// Payload of a response
+    struct response {
+      /// Id of the request
+      uint64_t id;
+      /// Root found, or NaN
+      double root;
+      /// Time from the arrival of the request to the start of its solve
+      uint64_t queueNanos;
+      /// Time spent solving
+      uint64_t solveNanos;
+      /// Function evaluations
+      uint32_t evaluations;
+      /// Requests in the same batch
+      uint32_t batch;
+      /// A batch::solveStatus
+      uint8_t status;
+      uint8_t reserved[7];
+    };
+
+    static_assert(sizeof(response) == 48u,"response must have no padding");
+
+    /// Write all n bytes, retrying on short writes
+    inline bool writeAll(const int fd,const void* data,size_t n) {
+      const char* p = static_cast<const char*>(data);
+      while (n > 0u) {
+        const ssize_t w = ::send(fd,p,n,MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= size_t(w);
+      }
+      return true;
+    }
+
+    /// Read exactly n bytes; false on end of stream or error
+    inline bool readAll(const int fd,void* data,size_t n) {
+      char* p = static_cast<char*>(data);
+      while (n > 0u) {
+        const ssize_t r = ::recv(fd,p,n,0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= size_t(r);
+      }
+      return true;
+    }
+
+    /// Address of a socket path
+    inline sockaddr_un socketAddress(const std::string& path) {
+      sockaddr_un addr;
+      std::memset(&addr,0,sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      if (path.size() >= sizeof(addr.sun_path)) {
+        throw anpi::Exception("Socket path too long: " + path);
+      }
+      std::memcpy(addr.sun_path,path.c_str(),path.size());
+      return addr;
+    }
+
+    /// Settings of the server
+    struct settings {
+      settings() : delay(100u),maxBatch(4096u) {}
+
+      /// Solver, tolerance, budget and worker threads
+      batch::options solve;
+      /// Microseconds to wait for more requests after the first one
+      unsigned int delay;
+      /// Requests in a batch at most
+      size_t maxBatch;
+    };
+
+    /**
+     * Remove the socket left at path by a server that is gone.
+     *
+     * A regular file is never removed, and neither is the socket of a
+     * server that still accepts connections.
+     *
+     * @throws anpi::Exception if path is not a socket, or is in use
+     */
+    inline void removeStaleSocket(const std::string& path,
+                                  const sockaddr_un& addr) {
+      struct stat st;
+      if (::lstat(path.c_str(),&st) != 0) {
+        return;
+      }
+      if (!S_ISSOCK(st.st_mode)) {
+        throw anpi::Exception("Cannot listen on " + path + ": not a socket");
+      }
+      const int probe = ::socket(AF_UNIX,SOCK_STREAM,0);
+      if (probe < 0) {
+        throw anpi::Exception("Cannot create socket: " +
+                              std::string(std::strerror(errno)));
+      }
+      const bool answered =
+        ::connect(probe,reinterpret_cast<const sockaddr*>(&addr),
+                  sizeof(addr)) == 0;
+      const int err = errno;
+      ::close(probe);
+      if (answered) {
+        throw anpi::Exception("Cannot listen on " + path + ": already in use");
+      }
+      if (err != ECONNREFUSED) {
+        throw anpi::Exception("Cannot listen on " + path + ": " +
+                              std::string(std::strerror(err)));
+      }
+      ::unlink(path.c_str());
+    }
+
+    /**
+     * Server listening on a Unix domain socket.
+     *
+     * The constructor binds the socket and starts the threads: one
+     * acceptor, one reader per connection, the batcher and the workers.
+     * stop() or the destructor shut everything down.
+     */
+    class server {
+    public:
+      /**
+       * Listen on the given path, replacing any stale socket there.
+       *
+       * @throws anpi::Exception if the socket cannot be created, the path
+       *         holds something else than a socket, another server
+       *         listens there, or the method is unknown
+       */
+      server(const std::string& path,const settings& s)
+        : _path(path),_settings(s),_solver(batch::findSolver(s.solve.method)),
+          _listen(-1),_running(true),_requests(0u),_batches(0u) {
+
+        const sockaddr_un addr = socketAddress(path);
+        removeStaleSocket(path,addr);
+        _listen = ::socket(AF_UNIX,SOCK_STREAM,0);
+        if (_listen < 0) {
+          throw anpi::Exception("Cannot create socket: " +
+                                std::string(std::strerror(errno)));
+        }
+        if (::bind(_listen,reinterpret_cast<const sockaddr*>(&addr),
+                   sizeof(addr)) < 0 ||
+            ::listen(_listen,SOMAXCONN) < 0) {
+          const std::string err(std::strerror(errno));
+          ::close(_listen);
+          throw anpi::Exception("Cannot listen on " + path + ": " + err);
+        }
+
+        unsigned int threads = s.solve.threads;
+        if (threads == 0u) {
+          threads = std::max(1u,std::thread::hardware_concurrency());
+        }
+        for (unsigned int t=0;t<threads;++t) {
+          _workers.push_back(std::thread(&server::work,this));
+        }
+        _batcher = std::thread(&server::collect,this);
+        _acceptor = std::thread(&server::accept,this);
+      }
+
+      ~server() { stop(); }
+
+      /// Close the socket, drop all connections and join the threads
+      void stop() {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (!_running) return;
+          _running = false;
+        }
+        ::shutdown(_listen,SHUT_RDWR);
+        _acceptor.join();
+        ::close(_listen);
+        ::unlink(_path.c_str());
+
+        // wake the readers, and the workers blocked on slow clients
+        {
+          std::lock_guard<std::mutex> lock(_connectionsMutex);
+          for (size_t i=0;i<_connections.size();++i) {
+            const std::shared_ptr<connection> c = _connections[i].lock();
+            if (c) ::shutdown(c->fd,SHUT_RDWR);
+          }
+        }
+        for (size_t i=0;i<_readers.size();++i) {
+          _readers[i]->thread.join();
+        }
+
+        _arrived.notify_all();
+        _batcher.join();
+        _work.notify_all();
+        for (size_t t=0;t<_workers.size();++t) {
+          _workers[t].join();
+        }
+        _readers.clear();
+        _connections.clear();
+      }
+
+      /// Requests answered so far
+      uint64_t requests() const { return _requests.load(); }
+
+      /// Batches dispatched so far
+      uint64_t batches() const { return _batches.load(); }
+
+    private:
+      typedef std::chrono::steady_clock clock;
+
+      /// Accepted client; the socket closes with the last reference
+      struct connection {
+        explicit connection(const int f) : fd(f) {}
+        ~connection() { ::close(fd); }
+        int fd;
+        /// Serializes the responses of different workers
+        std::mutex write;
+      };
+
+      /// Thread reading the requests of one connection
+      struct reader {
+        reader() : done(false) {}
+        std::thread thread;
+        std::atomic<bool> done;
+      };
+
+      struct request {
+        std::shared_ptr<connection> from;
+        uint64_t id;
+        std::string line;
+        clock::time_point arrival;
+      };
+
+      /// Part of a batch solved by one worker
+      struct slice {
+        std::vector<request> requests;
+        uint32_t batch;
+      };
+
+      void accept() {
+        for (;;) {
+          const int fd = ::accept(_listen,0,0);
+          if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return; // shut down
+          }
+          const std::shared_ptr<connection> c =
+            std::make_shared<connection>(fd);
+          std::lock_guard<std::mutex> lock(_connectionsMutex);
+
+          // forget the clients that left
+          for (size_t i=_readers.size();i>0u;--i) {
+            if (_readers[i-1u]->done) {
+              _readers[i-1u]->thread.join();
+              _readers.erase(_readers.begin() + (i-1u));
+            }
+          }
+          for (size_t i=_connections.size();i>0u;--i) {
+            if (_connections[i-1u].expired()) {
+              _connections.erase(_connections.begin() + (i-1u));
+            }
+          }
+
+          _connections.push_back(c);
+          _readers.push_back(std::unique_ptr<reader>(new reader));
+          _readers.back()->thread = std::thread(&server::read,this,c,
+                                                _readers.back().get());
+        }
+      }
+
+      void read(std::shared_ptr<connection> c,reader* self) {
+        std::string payload;
+        for (;;) {
+          uint32_t size;
+          if (!readAll(c->fd,&size,sizeof(size)) ||
+              size < sizeof(uint64_t) || size > MaxRequest) {
+            break;
+          }
+          payload.resize(size);
+          if (!readAll(c->fd,&payload[0],size)) break;
+
+          request r;
+          r.from = c;
+          std::memcpy(&r.id,payload.data(),sizeof(r.id));
+          r.line.assign(payload,sizeof(uint64_t),std::string::npos);
+          r.arrival = clock::now();
+          {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_running) break;
+            _pending.push_back(std::move(r));
+          }
+          _arrived.notify_one();
+        }
+
+        // the last pending response closes the socket
+        ::shutdown(c->fd,SHUT_RD);
+        c.reset();
+        self->done = true;
+      }
+
+      /// Group the pending requests into batches for the workers
+      void collect() {
+        ANPI_PROFILE_THREAD("service batcher");
+        const size_t workers = _workers.size();
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+          while (_pending.empty() && _running) {
+            ANPI_PROFILE_SCOPE("sync","batcher idle");
+            _arrived.wait(lock);
+          }
+          if (!_running) return;
+
+          // let more requests join the batch of the first one
+          const clock::time_point deadline = _pending.front().arrival +
+            std::chrono::microseconds(_settings.delay);
+          while (_running && _pending.size() < _settings.maxBatch &&
+                 _arrived.wait_until(lock,deadline) !=
+                 std::cv_status::timeout) {}
+          if (!_running) return;
+
+          const size_t n = std::min(_pending.size(),
+                                    std::max(size_t(1u),_settings.maxBatch));
+          const size_t per = (n + workers - 1u)/workers;
+          for (size_t i=0;i<n;i+=per) {
+            slice s;
+            s.batch = uint32_t(n);
+            const size_t end = std::min(n,i + per);
+            s.requests.reserve(end - i);
+            for (size_t j=i;j<end;++j) {
+              s.requests.push_back(std::move(_pending[j]));
+            }
+            _slices.push_back(std::move(s));
+          }
+          _pending.erase(_pending.begin(),_pending.begin() + n);
+          ++_batches;
+          _work.notify_all();
+        }
+      }
+
+      void work() {
+        ANPI_PROFILE_THREAD("service worker");
+        std::vector<response> out;
+        for (;;) {
+          slice s;
+          {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (_slices.empty() && _running) {
+              ANPI_PROFILE_SCOPE("sync","worker idle");
+              _work.wait(lock);
+            }
+            if (!_running) return;
+            s = std::move(_slices.front());
+            _slices.pop_front();
+          }
+
+          // solve all, then answer each connection with one write
+          ANPI_PROFILE_SCOPE("service","slice");
+          out.resize(s.requests.size());
+          for (size_t i=0;i<s.requests.size();++i) {
+            const request& r = s.requests[i];
+            const clock::time_point t0 = clock::now();
+            const batch::outcome o =
+              batch::solveProblem(r.line,_solver,_settings.solve);
+            const clock::time_point t1 = clock::now();
+
+            response& a = out[i];
+            std::memset(&a,0,sizeof(a));
+            a.id = r.id;
+            a.root = o.root;
+            a.queueNanos = uint64_t(std::chrono::duration_cast<
+              std::chrono::nanoseconds>(t0 - r.arrival).count());
+            a.solveNanos = uint64_t(std::chrono::duration_cast<
+              std::chrono::nanoseconds>(t1 - t0).count());
+            a.evaluations = uint32_t(o.evaluations);
+            a.batch = s.batch;
+            a.status = uint8_t(o.status);
+          }
+
+          std::string frames;
+          std::vector<bool> sent(s.requests.size(),false);
+          for (size_t i=0;i<s.requests.size();++i) {
+            if (sent[i]) continue;
+            connection* c = s.requests[i].from.get();
+            frames.clear();
+            for (size_t j=i;j<s.requests.size();++j) {
+              if (s.requests[j].from.get() != c) continue;
+              const uint32_t size = uint32_t(sizeof(response));
+              frames.append(reinterpret_cast<const char*>(&size),
+                            sizeof(size));
+              frames.append(reinterpret_cast<const char*>(&out[j]),
+                            sizeof(response));
+              sent[j] = true;
+            }
+            std::lock_guard<std::mutex> lock(c->write);
+            writeAll(c->fd,frames.data(),frames.size()); // gone if false
+          }
+          _requests += s.requests.size();
+        }
+      }
+
+      std::string _path;
+      settings _settings;
+      batch::solverType _solver;
+      int _listen;
+
+      /// Guards _running, _pending and _slices
+      std::mutex _mutex;
+      std::condition_variable _arrived;
+      std::condition_variable _work;
+      bool _running;
+      std::deque<request> _pending;
+      std::deque<slice> _slices;
+
+      std::mutex _connectionsMutex;
+      std::vector<std::weak_ptr<connection> > _connections;
+      std::vector<std::unique_ptr<reader> > _readers;
+
+      std::thread _acceptor;
+      std::thread _batcher;
+      std::vector<std::thread> _workers;
+
+      std::atomic<uint64_t> _requests;
+      std::atomic<uint64_t> _batches;
+    };
+
+    /// Connection to a server
+    class client {
+    public:
+      /**
+       * Connect to the server at path.
+       *
+       * @throws anpi::Exception if there is no server
+       */
+      explicit client(const std::string& path) : _fd(-1) {
+        const sockaddr_un addr = socketAddress(path);
+        _fd = ::socket(AF_UNIX,SOCK_STREAM,0);
+        if (_fd < 0 ||
+            ::connect(_fd,reinterpret_cast<const sockaddr*>(&addr),
+                      sizeof(addr)) < 0) {
+          const std::string err(std::strerror(errno));
+          if (_fd >= 0) ::close(_fd);
+          throw anpi::Exception("Cannot connect to " + path + ": " + err);
+        }
+      }
+
+      ~client() { ::close(_fd); }
+
+      client(const client&) = delete;
+      client& operator=(const client&) = delete;
+
+      /**
+       * Send one request.
+       *
+       * @throws anpi::Exception if the line is too long or the server
+       *         is gone
+       */
+      void send(const uint64_t id,const std::string& line) {
+        if (line.size() + sizeof(id) > MaxRequest) {
+          throw anpi::Exception("Request too long");
+        }
+        const uint32_t size = uint32_t(sizeof(id) + line.size());
+        _frame.clear();
+        _frame.append(reinterpret_cast<const char*>(&size),sizeof(size));
+        _frame.append(reinterpret_cast<const char*>(&id),sizeof(id));
+        _frame.append(line);
+        if (!writeAll(_fd,_frame.data(),_frame.size())) {
+          throw anpi::Exception("Server closed the connection");
+        }
+      }
+
+      /**
+       * Wait for the next response.
+       *
+       * @return false if the server closed the connection
+       */
+      bool receive(response& r) {
+        uint32_t size;
+        if (!readAll(_fd,&size,sizeof(size))) return false;
+        if (size != sizeof(response)) {
+          throw anpi::Exception("Malformed response");
+        }
+        return readAll(_fd,&r,sizeof(r));
+      }
+
+    private:
+      int _fd;
+      std::string _frame;
+    };
+
+    /// Measurements of a load run
+    struct loadReport {
+      uint64_t requests;
+      double seconds;
+      /// Client side round trip percentiles, in microseconds
+      double p50;
+      double p99;
+      double p999;
+      double max;
+      /// Server side means, in microseconds and requests
+      double queue;
+      double solve;
+      double batch;
+    };
+
+    /**
+     * Send n requests, cycling through lines, over the given number of
+     * connections with up to depth requests in flight on each, and
+     * measure the latencies.
+     *
+     * @throws anpi::Exception if the server cannot be reached
+     */
+    inline loadReport load(const std::string& path,
+                           const std::vector<std::string>& lines,
+                           const uint64_t n,
+                           const unsigned int connections,
+                           const unsigned int depth) {
+      typedef std::chrono::steady_clock clock;
+      if (lines.empty()) {
+        throw anpi::Exception("No requests to send");
+      }
+      const unsigned int k = std::max(1u,connections);
+      const unsigned int d = std::max(1u,depth);
+
+      std::vector<std::unique_ptr<client> > clients;
+      for (unsigned int c=0;c<k;++c) {
+        clients.push_back(std::unique_ptr<client>(new client(path)));
+      }
+
+      std::vector<std::vector<double> > latencies(k);
+      std::vector<double> queue(k,0.),solve(k,0.),batch(k,0.);
+      std::vector<std::string> errors(k);
+
+      const clock::time_point start = clock::now();
+      std::vector<std::thread> threads;
+      for (unsigned int c=0;c<k;++c) {
+        threads.push_back(std::thread([&,c]() {
+          try {
+            client& cl = *clients[c];
+            const uint64_t mine = n/k + (c < n % k ? 1u : 0u);
+            std::map<uint64_t,clock::time_point> sent;
+            latencies[c].reserve(size_t(mine));
+            uint64_t next = 0u;
+            while (latencies[c].size() < mine) {
+              while (next < mine && sent.size() < d) {
+                const uint64_t id = next*k + c;
+                sent[id] = clock::now();
+                cl.send(id,lines[size_t(id % lines.size())]);
+                ++next;
+              }
+              response r;
+              if (!cl.receive(r)) {
+                throw anpi::Exception("Server closed the connection");
+              }
+              const std::map<uint64_t,clock::time_point>::iterator it =
+                sent.find(r.id);
+              if (it == sent.end()) {
+                throw anpi::Exception("Unexpected response");
+              }
+              const std::chrono::duration<double,std::micro> l =
+                clock::now() - it->second;
+              sent.erase(it);
+              latencies[c].push_back(l.count());
+              queue[c] += 1.e-3*double(r.queueNanos);
+              solve[c] += 1.e-3*double(r.solveNanos);
+              batch[c] += double(r.batch);
+            }
+          } catch (std::exception& e) {
+            errors[c] = e.what();
+          }
+        }));
+      }
+      for (size_t c=0;c<threads.size();++c) {
+        threads[c].join();
+      }
+      const std::chrono::duration<double> wall = clock::now() - start;
+      for (size_t c=0;c<errors.size();++c) {
+        if (!errors[c].empty()) throw anpi::Exception(errors[c]);
+      }
+
+      std::vector<double> all;
+      all.reserve(size_t(n));
+      loadReport rep;
+      rep.queue = rep.solve = rep.batch = 0.;
+      for (unsigned int c=0;c<k;++c) {
+        all.insert(all.end(),latencies[c].begin(),latencies[c].end());
+        rep.queue += queue[c];
+        rep.solve += solve[c];
+        rep.batch += batch[c];
+      }
+      std::sort(all.begin(),all.end());
+      rep.requests = all.size();
+      rep.seconds = wall.count();
+      const double m = double(std::max(size_t(1u),all.size()));
+      rep.queue /= m;
+      rep.solve /= m;
+      rep.batch /= m;
+      if (all.empty()) {
+        rep.p50 = rep.p99 = rep.p999 = rep.max = 0.;
+      } else {
+        const size_t last = all.size() - 1u;
+        rep.p50  = all[size_t(0.5*double(last))];
+        rep.p99  = all[size_t(0.99*double(last))];
+        rep.p999 = all[size_t(0.999*double(last))];
+        rep.max  = all[last];
+      }
+      return rep;
+    }
+
+  } // namespace service
+} // namespace anpi
+
+#endif
@@ -0,0 +1,547 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_THREAD_POOL_HPP
+#define ANPI_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+#include "Profiler.hpp"
+
+namespace anpi {
+
+  /**
+   * Chase-Lev work-stealing deque of pointers.
+   *
+   * The owner thread push()es and take()s at the bottom, like a stack,
+   * without locks; any other thread steal()s the oldest element at the
+   * top with one compare-and-swap.  The ring grows when full; the old
+   * rings are kept until the deque is destroyed, since a thief may
+   * still be reading them.
+   *
+   * Memory orders after Lê, Pop, Cohen and Zappa Nardelli, "Correct and
+   * efficient work-stealing for weak memory models" (PPoPP 2013).
+   */
+  template<typename T>
+  class workStealingDeque {
+    static_assert(std::is_pointer<T>::value,"elements must be pointers");
+  public:
+    explicit workStealingDeque(const size_t capacity = 256u)
+      : _top(0),_bottom(0) {
+      size_t c = 2u;
+      while (c < capacity) c <<= 1;
+      _rings.push_back(std::unique_ptr<ring>(new ring(c)));
+      _ring.store(_rings.back().get(),std::memory_order_relaxed);
+    }
+
+    workStealingDeque(const workStealingDeque&) = delete;
+    workStealingDeque& operator=(const workStealingDeque&) = delete;
+
+    /// Add x at the bottom; owner only
+    void push(const T x) {
+      const int64_t b = _bottom.load(std::memory_order_relaxed);
+      const int64_t t = _top.load(std::memory_order_acquire);
+      ring* a = _ring.load(std::memory_order_relaxed);
+      if (b - t > a->mask) {
+        a = grow(a,t,b);
+      }
+      a->put(b,x);
+      std::atomic_thread_fence(std::memory_order_release);
+      _bottom.store(b + 1,std::memory_order_relaxed);
+    }
+
+    /// Remove the newest element, or null if empty; owner only
+    T take() {
+      const int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+      ring* a = _ring.load(std::memory_order_relaxed);
+      _bottom.store(b,std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      int64_t t = _top.load(std::memory_order_relaxed);
+      if (t > b) { // empty
+        _bottom.store(b + 1,std::memory_order_relaxed);
+        return T();
+      }
+      T x = a->get(b);
+      if (t == b) { // last one: race against the thieves
+        if (!_top.compare_exchange_strong(t,t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+          x = T();
+        }
+        _bottom.store(b + 1,std::memory_order_relaxed);
+      }
+      return x;
+    }
+
+    /// Remove the oldest element, or null if empty or lost a race
+    T steal() {
+      int64_t t = _top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const int64_t b = _bottom.load(std::memory_order_acquire);
+      if (t >= b) return T();
+      ring* a = _ring.load(std::memory_order_acquire);
+      const T x = a->get(t);
+      if (!_top.compare_exchange_strong(t,t + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        return T();
+      }
+      return x;
+    }
+
+    /// Whether the deque looked empty
+    bool empty() const {
+      return _bottom.load(std::memory_order_relaxed) <=
+        _top.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct ring {
+      explicit ring(const size_t n)
+        : mask(int64_t(n) - 1),items(new std::atomic<T>[n]) {}
+      T get(const int64_t i) const {
+        return items[size_t(i & mask)].load(std::memory_order_relaxed);
+      }
+      void put(const int64_t i,const T x) {
+        items[size_t(i & mask)].store(x,std::memory_order_relaxed);
+      }
+      int64_t mask;
+      std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    ring* grow(ring* a,const int64_t t,const int64_t b) {
+      ring* n = new ring(size_t(2*(a->mask + 1)));
+      for (int64_t i=t;i<b;++i) {
+        n->put(i,a->get(i));
+      }
+      _rings.push_back(std::unique_ptr<ring>(n));
+      _ring.store(n,std::memory_order_release);
+      return n;
+    }
+
+    /// Thieves write _top, the owner _bottom: keep them a cache line
+    /// apart (padding instead of alignas, which C++11 new ignores)
+    std::atomic<int64_t> _top;
+    char _padding[64u - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> _bottom;
+    std::atomic<ring*> _ring;
+    /// All rings ever used, owned here
+    std::vector<std::unique_ptr<ring> > _rings;
+  };
+
+  class taskGroup;
+
+  /**
+   * Work-stealing thread pool.
+   *
+   * Each worker owns a workStealingDeque.  Tasks spawned by a worker go
+   * to its own deque, where it takes the newest first (cache-warm, and
+   * depth-first for recursive splits); idle workers steal the oldest,
+   * which in a recursive split are the largest pieces of work.  Tasks
+   * from other threads enter through a shared queue.
+   *
+   * parallelFor() splits its range lazily in halves down to a grain of
+   * iterations run as one task, so that uneven iterations (a solve of 5
+   * evaluations next to one of 1000) balance by stealing, while the
+   * queue operations are amortized over whole grains.
+   *
+   * Idle workers spin briefly and then sleep until new work arrives.
+   * With pinned workers, worker i runs only on the i-th CPU, modulo
+   * their number, of those the process may run on (Linux only), so that
+   * pinning stays inside a set given by taskset or sched_setaffinity.
+   */
+  class threadPool {
+  public:
+    /**
+     * Start the workers.
+     *
+     * @param threads number of workers, 0 for one per CPU the process
+     *                may run on
+     * @param pinned  bind each worker to one CPU
+     */
+    explicit threadPool(const unsigned int threads = 0u,
+                        const bool pinned = false)
+      : _stop(false),_sleeping(0u) {
+      const std::vector<int> cpus = allowedCpus();
+      const unsigned int n = threads ? threads : unsigned(cpus.size());
+      for (unsigned int i=0;i<n;++i) {
+        _workers.push_back(std::unique_ptr<worker>(new worker));
+      }
+      for (unsigned int i=0;i<n;++i) {
+        _workers[i]->thread = std::thread(&threadPool::loop,this,i);
+#if defined(__linux__)
+        if (pinned) {
+          cpu_set_t set;
+          CPU_ZERO(&set);
+          CPU_SET(cpus[i % cpus.size()],&set);
+          pthread_setaffinity_np(_workers[i]->thread.native_handle(),
+                                 sizeof(set),&set);
+        }
+#else
+        (void)pinned;
+#endif
+      }
+    }
+
+    /// CPUs the calling thread may run on, never empty
+    static std::vector<int> allowedCpus() {
+      std::vector<int> cpus;
+#if defined(__linux__)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if (sched_getaffinity(0,sizeof(set),&set) == 0) {
+        for (int c=0;c<CPU_SETSIZE;++c) {
+          if (CPU_ISSET(c,&set)) cpus.push_back(c);
+        }
+      }
+#endif
+      if (cpus.empty()) {
+        const unsigned int hw =
+          std::max(1u,std::thread::hardware_concurrency());
+        for (unsigned int c=0;c<hw;++c) cpus.push_back(int(c));
+      }
+      return cpus;
+    }
+
+    threadPool(const threadPool&) = delete;
+    threadPool& operator=(const threadPool&) = delete;
+
+    /// Finish the queued tasks and join the workers
+    ~threadPool() {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _wake.notify_all();
+      for (size_t i=0;i<_workers.size();++i) {
+        _workers[i]->thread.join();
+      }
+    }
+
+    /// Pool with one worker per hardware thread, started on first use
+    static threadPool& instance() {
+      static threadPool pool;
+      return pool;
+    }
+
+    /// Number of workers
+    unsigned int size() const { return unsigned(_workers.size()); }
+
+    /**
+     * Run f() on a worker.
+     *
+     * Waiting for the future from inside a task of the same pool can
+     * deadlock if all workers wait; use a taskGroup there instead.
+     */
+    template<class F>
+    std::future<typename std::result_of<F()>::type> submit(F f) {
+      typedef typename std::result_of<F()>::type R;
+      const std::shared_ptr<std::packaged_task<R()> > p =
+        std::make_shared<std::packaged_task<R()> >(std::move(f));
+      std::future<R> r = p->get_future();
+      spawn(makeTask([p]() { (*p)(); }));
+      return r;
+    }
+
+    /**
+     * Call body(first,last) on disjoint subranges covering [begin,end),
+     * each at most grain long, and wait for all of them.  The calling
+     * thread takes part.  A grain of 0 aims at eight pieces per worker.
+     *
+     * @throws the first exception thrown by body
+     */
+    template<class F>
+    void parallelForRange(const size_t begin,const size_t end,const F& body,
+                          size_t grain = 0u);
+
+    /// Call body(i) for all i in [begin,end), see parallelForRange()
+    template<class F>
+    void parallelFor(const size_t begin,const size_t end,const F& body,
+                     const size_t grain = 0u) {
+      parallelForRange(begin,end,[&body](const size_t b,const size_t e) {
+          for (size_t i=b;i<e;++i) body(i);
+        },grain);
+    }
+
+  private:
+    friend class taskGroup;
+
+    struct task {
+      virtual ~task() {}
+      virtual void run() = 0;
+    };
+
+    template<class F>
+    struct functionTask : task {
+      explicit functionTask(F&& fn) : f(std::move(fn)) {}
+      void run() { f(); }
+      F f;
+    };
+
+    template<class F>
+    static task* makeTask(F&& f) {
+      return new functionTask<typename std::decay<F>::type>(std::move(f));
+    }
+
+    struct worker {
+      workStealingDeque<task*> deque;
+      std::thread thread;
+    };
+
+    /// Pool and index of the calling worker thread, if it is one
+    static threadPool*& currentPool() {
+      static thread_local threadPool* pool = 0;
+      return pool;
+    }
+    static unsigned int& currentIndex() {
+      static thread_local unsigned int index = 0u;
+      return index;
+    }
+
+    /// Index of the calling thread among the workers, or -1
+    int self() const {
+      return currentPool() == this ? int(currentIndex()) : -1;
+    }
+
+    void spawn(task* t) {
+      const int me = self();
+      if (me >= 0) {
+        _workers[size_t(me)]->deque.push(t);
+      } else {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _injected.push_back(t);
+      }
+      // pairs with the fence in sleep(): either the sleeper sees the
+      // task or we see the sleeper
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_sleeping.load(std::memory_order_relaxed) > 0u) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wake.notify_one();
+      }
+    }
+
+    /// Find one task and run it; false if there was none
+    bool runOne(const int me) {
+      task* t = 0;
+      if (me >= 0) {
+        t = _workers[size_t(me)]->deque.take();
+      }
+      if (!t) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_injected.empty()) {
+          t = _injected.front();
+          _injected.pop_front();
+        }
+      }
+      if (!t) {
+        // steal, starting at a random victim
+        static thread_local uint32_t seed = 2463534242u;
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        const size_t n = _workers.size();
+        const size_t start = size_t(seed % n);
+        for (size_t k=0;k<n && !t;++k) {
+          const size_t v = (start + k) % n;
+          if (int(v) != me) t = _workers[v]->deque.steal();
+        }
+      }
+      if (!t) return false;
+      t->run();
+      delete t;
+      return true;
+    }
+
+    /// Whether any task seems to be waiting
+    bool pending() {
+      for (size_t i=0;i<_workers.size();++i) {
+        if (!_workers[i]->deque.empty()) return true;
+      }
+      return !_injected.empty(); // called with _mutex held
+    }
+
+    void loop(const unsigned int index) {
+      currentPool() = this;
+      currentIndex() = index;
+      ANPI_PROFILE_THREAD("pool worker " + std::to_string(index));
+      unsigned int idle = 0u;
+      for (;;) {
+        if (runOne(int(index))) {
+          idle = 0u;
+          continue;
+        }
+        if (++idle < 64u) {
+          std::this_thread::yield();
+          continue;
+        }
+        idle = 0u;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _sleeping.fetch_add(1u,std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!pending()) {
+          if (_stop) {
+            _sleeping.fetch_sub(1u,std::memory_order_relaxed);
+            return;
+          }
+          ANPI_PROFILE_SCOPE("sync","pool sleep");
+          _wake.wait_for(lock,std::chrono::milliseconds(10));
+        }
+        _sleeping.fetch_sub(1u,std::memory_order_relaxed);
+      }
+    }
+
+    std::vector<std::unique_ptr<worker> > _workers;
+
+    /// Guards _injected and _stop, and the sleeping workers
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<task*> _injected;
+    bool _stop;
+    std::atomic<unsigned int> _sleeping;
+  };
+
+  /**
+   * Set of tasks to wait for together.
+   *
+   * run() spawns a task on the pool; wait() returns once all tasks
+   * finished, running pending tasks of the pool itself meanwhile, so
+   * that it can also be used from inside a task.
+   */
+  class taskGroup {
+  public:
+    explicit taskGroup(threadPool& pool = threadPool::instance())
+      : _pool(pool),_pending(0u) {}
+
+    taskGroup(const taskGroup&) = delete;
+    taskGroup& operator=(const taskGroup&) = delete;
+
+    ~taskGroup() {
+      try {
+        wait();
+      } catch (...) {
+      }
+    }
+
+    /// Spawn f() as a task of the group
+    template<class F>
+    void run(F f) {
+      _pending.fetch_add(1u,std::memory_order_relaxed);
+      _pool.spawn(threadPool::makeTask([this,f]() {
+            try {
+              f();
+            } catch (...) {
+              fail(std::current_exception());
+            }
+            done();
+          }));
+    }
+
+    /**
+     * Wait for all tasks spawned so far.
+     *
+     * @throws the first exception thrown by a task
+     */
+    void wait() {
+      const int me = _pool.self();
+      unsigned int idle = 0u;
+      while (_pending.load(std::memory_order_acquire) > 0u) {
+        if (_pool.runOne(me)) {
+          idle = 0u;
+        } else if (++idle < 64u) {
+          std::this_thread::yield();
+        } else {
+          std::unique_lock<std::mutex> lock(_mutex);
+          if (_pending.load(std::memory_order_acquire) > 0u) {
+            ANPI_PROFILE_SCOPE("sync","taskGroup wait");
+            _finished.wait_for(lock,std::chrono::milliseconds(1));
+          }
+        }
+      }
+      // done() may still hold the lock after the last decrement
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_error) {
+        std::exception_ptr e = _error;
+        _error = std::exception_ptr();
+        std::rethrow_exception(e);
+      }
+    }
+
+  private:
+    void fail(const std::exception_ptr& e) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_error) _error = e;
+    }
+
+    void done() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_pending.fetch_sub(1u,std::memory_order_acq_rel) == 1u) {
+        _finished.notify_all();
+      }
+    }
+
+    threadPool& _pool;
+    std::atomic<size_t> _pending;
+    std::mutex _mutex;
+    std::condition_variable _finished;
+    std::exception_ptr _error;
+  };
+
+  namespace detail {
+    /// Run body on [b,e), spawning the right halves while longer than grain
+    template<class F>
+    void splitRange(taskGroup& g,size_t b,size_t e,const size_t grain,
+                    const F& body) {
+      while (e - b > grain) {
+        const size_t m = b + (e - b)/2u;
+        g.run([&g,&body,m,e,grain]() { splitRange(g,m,e,grain,body); });
+        e = m;
+      }
+      body(b,e);
+    }
+  } // namespace detail
+
+  template<class F>
+  void threadPool::parallelForRange(const size_t begin,const size_t end,
+                                    const F& body,size_t grain) {
+    if (begin >= end) return;
+    if (grain == 0u) {
+      grain = std::max(size_t(1u),(end - begin)/(8u*_workers.size()));
+    }
+    taskGroup g(*this);
+    try {
+      detail::splitRange(g,begin,end,grain,body);
+    } catch (...) {
+      try {
+        g.wait(); // the spawned pieces still use body
+      } catch (...) {
+      }
+      throw;
+    }
+    g.wait();
+  }
+
+} // namespace anpi
+
+#endif
@@ -0,0 +1,289 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_TRACE_RECORDER_HPP
+#define ANPI_TRACE_RECORDER_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Exception.hpp"
+#include "bits/JsonEscape.hpp"
+
+namespace anpi {
+
+  /// Kind of step taken by a root finder in one iteration
+  enum traceStep {
+    /// Evaluation of the initial bracket or guess
+    Start = 0,
+    /// Halving of the bracket
+    Bisection,
+    /// Regula falsi, possibly with a halved end value (Illinois)
+    FalsePosition,
+    /// Secant step through the last two iterates
+    Secant,
+    /// Newton step with the numerical derivative
+    Newton,
+    /// Inverse interpolation step of Brent's method
+    Interpolation,
+    /// Exponential interpolation of Ridder's method
+    Ridder,
+    /// The solver gave up; x is its last iterate
+    Failed,
+    NumTraceSteps
+  };
+
+  /// Printable name of a step type
+  inline const char* traceStepName(const int step) {
+    static const char* names[NumTraceSteps] = {
+      "start","bisection","false_position","secant","newton",
+      "interpolation","ridder","failed"
+    };
+    return (step >= 0 && step < NumTraceSteps) ? names[step] : "unknown";
+  }
+
+  /**
+   * One recorded iteration, 32 bytes.
+   *
+   * For bracketing methods width is the length of the current bracket,
+   * for the open methods (secant, Newton) the length of the step taken
+   * from x.
+   */
+  struct traceEvent {
+    double x;
+    double fx;
+    double width;
+    uint32_t iteration;
+    uint16_t step;
+    uint16_t reserved;
+  };
+
+  /**
+   * Trace policy that records nothing.
+   *
+   * This is the default policy of the traced solvers: the calls to
+   * record() are inlined away, so the solvers compile to the same code
+   * as without tracing.
+   */
+  struct noTrace {
+    static constexpr bool enabled() { return false; }
+
+    inline void record(const unsigned int /*iteration*/,
+                       const double /*x*/,
+                       const double /*fx*/,
+                       const double /*width*/,
+                       const traceStep /*step*/) {}
+  };
+
+  /**
+   * Trace policy that keeps the last events in a ring buffer.
+   *
+   * The buffer is allocated once at construction, with the capacity
+   * rounded up to a power of two.  Recording only stores the event, and
+   * once the buffer is full it overwrites the oldest one.  A ring is not
+   * thread-safe: use one per thread.
+   */
+  class ringTrace {
+  public:
+    static constexpr bool enabled() { return true; }
+
+    explicit ringTrace(const size_t capacity = 4096u) : _next(0u) {
+      size_t c = 1u;
+      while (c < capacity) c <<= 1;
+      _events.resize(c);
+      _mask = c - 1u;
+    }
+
+    /// Store one event, overwriting the oldest one if full
+    inline void record(const unsigned int iteration,
+                       const double x,
+                       const double fx,
+                       const double width,
+                       const traceStep step) {
+      traceEvent& e = _events[size_t(_next) & _mask];
+      e.x = x;
+      e.fx = fx;
+      e.width = width;
+      e.iteration = uint32_t(iteration);
+      e.step = uint16_t(step);
+      e.reserved = 0u;
+      ++_next;
+    }
+
+    /// Number of events the buffer can hold
+    size_t capacity() const { return _events.size(); }
+
+    /// Number of events held
+    size_t size() const {
+      return _next < _events.size() ? size_t(_next) : _events.size();
+    }
+
+    /// Number of events overwritten since the last clear()
+    uint64_t dropped() const { return _next - size(); }
+
+    /// Event i of the held ones, 0 being the oldest
+    const traceEvent& operator[](const size_t i) const {
+      return _events[size_t(_next - size() + i) & _mask];
+    }
+
+    /// Copy of the held events, oldest first
+    std::vector<traceEvent> events() const {
+      std::vector<traceEvent> out;
+      out.reserve(size());
+      for (size_t i=0;i<size();++i) {
+        out.push_back((*this)[i]);
+      }
+      return out;
+    }
+
+    /// Forget all events
+    void clear() { _next = 0u; }
+
+    /// Write the held events in the binary format, see writeTrace()
+    void write(std::ostream& os) const;
+
+  private:
+    std::vector<traceEvent> _events;
+    size_t _mask;
+    uint64_t _next;
+  };
+
+  /**
+   * Binary trace format, in the byte order of the host:
+   *
+   *   8 bytes   magic "ANPITRC1"
+   *   8 bytes   number of events n
+   *   8 bytes   number of events dropped before the first one
+   *   n*32      events as in traceEvent
+   */
+  inline void writeTrace(std::ostream& os,
+                         const std::vector<traceEvent>& events,
+                         const uint64_t dropped = 0u) {
+    static_assert(sizeof(traceEvent) == 32u,"Unexpected trace event size");
+    const uint64_t n = events.size();
+    os.write("ANPITRC1",8);
+    os.write(reinterpret_cast<const char*>(&n),sizeof(n));
+    os.write(reinterpret_cast<const char*>(&dropped),sizeof(dropped));
+    if (n > 0u) {
+      os.write(reinterpret_cast<const char*>(&events.front()),
+               std::streamsize(n*sizeof(traceEvent)));
+    }
+  }
+
+  inline void ringTrace::write(std::ostream& os) const {
+    writeTrace(os,events(),dropped());
+  }
+
+  /**
+   * Read a binary trace written by writeTrace().
+   *
+   * @return the events, oldest first
+   * @throws anpi::Exception if the stream is not a complete trace
+   */
+  inline std::vector<traceEvent> readTrace(std::istream& is,
+                                           uint64_t* dropped = 0) {
+    char magic[8];
+    uint64_t n = 0u, d = 0u;
+    is.read(magic,8);
+    if (!is || std::memcmp(magic,"ANPITRC1",8) != 0) {
+      throw anpi::Exception("Not an anpi trace");
+    }
+    is.read(reinterpret_cast<char*>(&n),sizeof(n));
+    is.read(reinterpret_cast<char*>(&d),sizeof(d));
+    if (!is || n > uint64_t(std::numeric_limits<uint32_t>::max())) {
+      throw anpi::Exception("Corrupt anpi trace header");
+    }
+    std::vector<traceEvent> events(static_cast<size_t>(n));
+    if (n > 0u) {
+      is.read(reinterpret_cast<char*>(&events.front()),
+              std::streamsize(n*sizeof(traceEvent)));
+      if (!is) {
+        throw anpi::Exception("Truncated anpi trace");
+      }
+    }
+    if (dropped != 0) *dropped = d;
+    return events;
+  }
+
+  /// Write the events as CSV with a header line
+  inline void writeTraceCsv(std::ostream& os,
+                            const std::vector<traceEvent>& events) {
+    const std::streamsize prec = os.precision(17);
+    os << "iteration,step,x,fx,width\n";
+    for (size_t i=0;i<events.size();++i) {
+      const traceEvent& e = events[i];
+      os << e.iteration << ',' << traceStepName(e.step) << ','
+         << e.x << ',' << e.fx << ',' << e.width << '\n';
+    }
+    os.precision(prec);
+  }
+
+  /**
+   * Write the events in the Chrome trace event format (JSON), to be
+   * opened in chrome://tracing or Perfetto.
+   *
+   * There are no timestamps in a trace, so each event takes one
+   * microsecond of the timeline.  A new solve starts wherever the
+   * iteration number does not grow, except on a Failed step.  Each solve
+   * becomes a slice holding one slice per iteration, and x, |f(x)| and
+   * the width are also written as counters.  Iterations with a value
+   * that is not finite carry no values, as JSON cannot represent them.
+   */
+  inline void writeTraceChrome(std::ostream& os,
+                               const std::vector<traceEvent>& events,
+                               const std::string& name = "solve") {
+    const std::streamsize prec = os.precision(17);
+    const std::string jsonName = jsonEscape(name);
+    os << "{\"traceEvents\":[";
+    const char* sep = "\n";
+    size_t begin = 0u;
+    while (begin < events.size()) {
+      size_t end = begin + 1u;
+      while (end < events.size() &&
+             (events[end].iteration > events[end-1u].iteration ||
+              events[end].step == Failed)) {
+        ++end;
+      }
+
+      os << sep << "{\"name\":\"" << jsonName << "\",\"ph\":\"X\",\"pid\":1,"
+         << "\"tid\":1,\"ts\":" << begin << ",\"dur\":" << (end - begin)
+         << "}";
+      sep = ",\n";
+      for (size_t i=begin;i<end;++i) {
+        const traceEvent& e = events[i];
+        const double afx = std::abs(e.fx);
+        const bool finite = std::isfinite(e.x) && std::isfinite(e.fx) &&
+                            std::isfinite(e.width);
+        os << sep << "{\"name\":\"" << traceStepName(e.step)
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << i
+           << ",\"dur\":1,\"args\":{\"iteration\":" << e.iteration;
+        if (finite) {
+          os << ",\"x\":" << e.x << ",\"fx\":" << e.fx
+             << ",\"width\":" << e.width << "}}";
+          os << sep << "{\"name\":\"" << jsonName
+             << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << i
+             << ",\"args\":{\"x\":" << e.x << ",\"abs_fx\":" << afx
+             << ",\"width\":" << e.width << "}}";
+        } else {
+          os << "}}";
+        }
+      }
+      begin = end;
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    os.precision(prec);
+  }
+
+} // namespace anpi
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_FILE_UTIL_HPP
+#define ANPI_FILE_UTIL_HPP
+
+#include <cstring>
+#include <string>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Exception.hpp"
+
+namespace anpi {
+
+  /**
+   * Replace the file at path with n bytes of data atomically: a
+   * temporary file, named after path and the process id so that
+   * concurrent writers do not share it, is written and synced, then
+   * renamed over path, so that a crash leaves either the old or the
+   * new contents.
+   *
+   * @param what kind of file, for the error messages
+   *
+   * @throws anpi::Exception if the file cannot be written
+   */
+  inline void replaceFile(const std::string& path,const void* data,
+                          size_t n,const std::string& what) {
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    const int fd = ::open(tmp.c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+    if (fd < 0) {
+      throw anpi::Exception("Cannot write " + what + " " + tmp + ": " +
+                            std::strerror(errno));
+    }
+    const char* p = static_cast<const char*>(data);
+    while (n > 0u) {
+      const ssize_t w = ::write(fd,p,n);
+      if (w < 0 && errno == EINTR) continue;
+      if (w <= 0) break;
+      p += w;
+      n -= size_t(w);
+    }
+    const bool ok = (n == 0u) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(),path.c_str()) != 0) {
+      const int err = errno;
+      ::unlink(tmp.c_str());
+      throw anpi::Exception("Cannot write " + what + " " + path + ": " +
+                            std::strerror(err));
+    }
+
+    // make the rename itself durable
+    const size_t slash = path.rfind('/');
+    const std::string dir = (slash == std::string::npos) ? "." :
+      (slash == 0u ? "/" : path.substr(0u,slash));
+    const int dfd = ::open(dir.c_str(),O_RDONLY);
+    if (dfd >= 0) {
+      ::fsync(dfd);
+      ::close(dfd);
+    }
+  }
+
+} // namespace anpi
+
+#endif
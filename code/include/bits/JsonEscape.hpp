@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ */
+
+#ifndef ANPI_JSON_ESCAPE_HPP
+#define ANPI_JSON_ESCAPE_HPP
+
+#include <cstdio>
+#include <string>
+
+namespace anpi {
+
+  /**
+   * Contents of a JSON string literal holding s, without the quotes.
+   *
+   * Quotes and backslashes are escaped, and control characters written
+   * as \uXXXX.  If maxLength is given, the result is cut before the
+   * first escape sequence that does not fit, so that it never ends in
+   * half of one.
+   */
+  inline std::string jsonEscape(const std::string& s,
+                                const size_t maxLength = std::string::npos) {
+    std::string r;
+    for (const char ch : s) {
+      char buf[8] = { ch, 0 };
+      if (ch == '"' || ch == '\\') {
+        buf[0] = '\\';
+        buf[1] = ch;
+        buf[2] = 0;
+      } else if (static_cast<unsigned char>(ch) < 0x20u) {
+        std::snprintf(buf,sizeof(buf),"\\u%04x",unsigned(ch));
+      }
+      const std::string seq(buf);
+      if (r.size() + seq.size() > maxLength) {
+        // nor in part of a UTF-8 character
+        while (!r.empty() &&
+               (static_cast<unsigned char>(r.back()) & 0xC0u) == 0x80u) {
+          r.pop_back();
+        }
+        if (!r.empty() && static_cast<unsigned char>(r.back()) >= 0xC0u) {
+          r.pop_back();
+        }
+        break;
+      }
+      r += seq;
+    }
+    return r;
+  }
+
+} // namespace anpi
+
+#endif
@@ -12,6 +12,9 @@
 #define ANPI_MATRIX_ARITHMETIC_HPP
 
 #include "Intrinsics.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cstring>
 #include <type_traits>
 
 namespace anpi
@@ -28,6 +31,7 @@ namespace anpi
     inline void add(const Matrix<T,Alloc>& a,
                     const Matrix<T,Alloc>& b,
                     Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","fallback add");
 
       assert( (a.rows() == b.rows()) &&
               (a.cols() == b.cols()) );
@@ -49,6 +53,7 @@ namespace anpi
     template<typename T,class Alloc>
     inline void add(Matrix<T,Alloc>& a,
                     const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","fallback add");
 
       assert( (a.rows() == b.rows()) &&
               (a.cols() == b.cols()) );
@@ -77,6 +82,7 @@ namespace anpi
     inline void subtract(const Matrix<T,Alloc>& a,
                          const Matrix<T,Alloc>& b,
                          Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","fallback subtract");
 
       assert( (a.rows() == b.rows()) &&
               (a.cols() == b.cols()) );
@@ -98,6 +104,7 @@ namespace anpi
     template<typename T,class Alloc>
     inline void subtract(Matrix<T,Alloc>& a,
                          const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","fallback subtract");
 
       assert( (a.rows() == b.rows()) &&
               (a.cols() == b.cols()) );
@@ -114,6 +121,181 @@ namespace anpi
       }
     }
 
+
+    /*
+     * Fused element-wise kernels
+     */
+
+    // On-copy implementation z = alpha*x + y
+    template<typename T,class Alloc>
+    inline void axpy(const T alpha,
+                     const Matrix<T,Alloc>& x,
+                     const Matrix<T,Alloc>& y,
+                     Matrix<T,Alloc>& z) {
+      ANPI_PROFILE_SCOPE("matrix","fallback axpy");
+
+      assert( (x.rows() == y.rows()) &&
+              (x.cols() == y.cols()) );
+
+      const size_t tentries = x.rows()*x.dcols();
+      z.allocate(x.rows(),x.cols());
+
+      T* here        = z.data();
+      T *const end   = here + tentries;
+      const T* xptr = x.data();
+      const T* yptr = y.data();
+
+      for (;here!=end;) {
+        *here++ = alpha * *xptr++ + *yptr++;
+      }
+    }
+
+    // In-place implementation y = alpha*x + y
+    template<typename T,class Alloc>
+    inline void axpy(const T alpha,
+                     const Matrix<T,Alloc>& x,
+                     Matrix<T,Alloc>& y) {
+      ANPI_PROFILE_SCOPE("matrix","fallback axpy");
+
+      assert( (x.rows() == y.rows()) &&
+              (x.cols() == y.cols()) );
+
+      const size_t tentries = y.rows()*y.dcols();
+
+      T* here        = y.data();
+      T *const end   = here + tentries;
+      const T* xptr = x.data();
+
+      for (;here!=end;) {
+        *here++ += alpha * *xptr++;
+      }
+    }
+
+    // On-copy implementation c = alpha*a
+    template<typename T,class Alloc>
+    inline void scale(const T alpha,
+                      const Matrix<T,Alloc>& a,
+                      Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","fallback scale");
+
+      const size_t tentries = a.rows()*a.dcols();
+      c.allocate(a.rows(),a.cols());
+
+      T* here        = c.data();
+      T *const end   = here + tentries;
+      const T* aptr = a.data();
+
+      for (;here!=end;) {
+        *here++ = alpha * *aptr++;
+      }
+    }
+
+    // In-place implementation a = alpha*a
+    template<typename T,class Alloc>
+    inline void scale(const T alpha,
+                      Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","fallback scale");
+
+      const size_t tentries = a.rows()*a.dcols();
+
+      T* here        = a.data();
+      T *const end   = here + tentries;
+
+      for (;here!=end;) {
+        *here++ *= alpha;
+      }
+    }
+
+    // On-copy implementation c = a .* b (element-wise product)
+    template<typename T,class Alloc>
+    inline void hadamard(const Matrix<T,Alloc>& a,
+                         const Matrix<T,Alloc>& b,
+                         Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","fallback hadamard");
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      const size_t tentries = a.rows()*a.dcols();
+      c.allocate(a.rows(),a.cols());
+
+      T* here        = c.data();
+      T *const end   = here + tentries;
+      const T* aptr = a.data();
+      const T* bptr = b.data();
+
+      for (;here!=end;) {
+        *here++ = *aptr++ * *bptr++;
+      }
+    }
+
+    // In-place implementation a = a .* b
+    template<typename T,class Alloc>
+    inline void hadamard(Matrix<T,Alloc>& a,
+                         const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","fallback hadamard");
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      const size_t tentries = a.rows()*a.dcols();
+
+      T* here        = a.data();
+      T *const end   = here + tentries;
+      const T* bptr = b.data();
+
+      for (;here!=end;) {
+        *here++ *= *bptr++;
+      }
+    }
+
+    // On-copy implementation c = alpha*a + beta*b
+    template<typename T,class Alloc>
+    inline void lincomb(const T alpha,
+                        const Matrix<T,Alloc>& a,
+                        const T beta,
+                        const Matrix<T,Alloc>& b,
+                        Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","fallback lincomb");
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      const size_t tentries = a.rows()*a.dcols();
+      c.allocate(a.rows(),a.cols());
+
+      T* here        = c.data();
+      T *const end   = here + tentries;
+      const T* aptr = a.data();
+      const T* bptr = b.data();
+
+      for (;here!=end;) {
+        *here++ = alpha * *aptr++ + beta * *bptr++;
+      }
+    }
+
+    // In-place implementation a = alpha*a + beta*b
+    template<typename T,class Alloc>
+    inline void lincomb(const T alpha,
+                        Matrix<T,Alloc>& a,
+                        const T beta,
+                        const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","fallback lincomb");
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      const size_t tentries = a.rows()*a.dcols();
+
+      T* here        = a.data();
+      T *const end   = here + tentries;
+      const T* bptr = b.data();
+
+      for (;here!=end;++here) {
+        *here = alpha * *here + beta * *bptr++;
+      }
+    }
+
   } // namespace fallback
 
 
@@ -276,7 +458,7 @@ namespace anpi
     template<>
     inline __m128i __attribute__((__always_inline__))
     mm_add<std::int32_t>(__m128i a,__m128i b) {
-      return _mm_add_epi16(a,b);
+      return _mm_add_epi32(a,b);
     }
     template<>
     inline __m128i __attribute__((__always_inline__))
@@ -286,108 +468,730 @@ namespace anpi
     template<>
     inline __m128i __attribute__((__always_inline__))
     mm_add<std::int16_t>(__m128i a,__m128i b) {
-      return _mm_add_epi32(a,b);
+      return _mm_add_epi16(a,b);
     }
     template<>
     inline __m128i __attribute__((__always_inline__))
     mm_add<std::uint8_t>(__m128i a,__m128i b) {
-      return _mm_add_epi16(a,b);
+      return _mm_add_epi8(a,b);
     }
     template<>
     inline __m128i __attribute__((__always_inline__))
     mm_add<std::int8_t>(__m128i a,__m128i b) {
-      return _mm_add_epi32(a,b);
+      return _mm_add_epi8(a,b);
     }
 #endif
-    
-    // On-copy implementation c=a+b
-    template<typename T,class Alloc,typename regType>
-    inline void addSIMD(const Matrix<T,Alloc>& a, 
-                        const Matrix<T,Alloc>& b,
-                        Matrix<T,Alloc>& c) {
 
-      // This method is instantiated with unaligned allocators.  We
-      // allow the instantiation although externally this is never
-      // called unaligned
-      static_assert(!extract_alignment<Alloc>::aligned ||
-		    (extract_alignment<Alloc>::value >= sizeof(regType)),
-		    "Insufficient alignment for the registers used");
-      
-      const size_t tentries = a.rows()*a.dcols();
-      c.allocate(a.rows(),a.cols());
+    /*
+     * Further register wrappers, used by the fill, comparison and
+     * reduction kernels in bits/MatrixReductions.hpp
+     */
 
-      regType* here        = reinterpret_cast<regType*>(c.data());
-      const size_t  blocks = ( tentries*sizeof(T) + (sizeof(regType)-1) )/
-        sizeof(regType);
-      regType *const end   = here + blocks;
-      const regType* aptr  = reinterpret_cast<const regType*>(a.data());
-      const regType* bptr  = reinterpret_cast<const regType*>(b.data());
-      
-      for (;here!=end;) {
-        *here++ = mm_add<T>(*aptr++,*bptr++);
-      }
-      
-    }
-       
-    // On-copy implementation c=a+b for SIMD-capable types
-    template<typename T,
-	     class Alloc,
-	     typename std::enable_if<is_simd_type<T>::value,int>::type=0>
-    inline void add(const Matrix<T,Alloc>& a,
-                    const Matrix<T,Alloc>& b,
-                    Matrix<T,Alloc>& c) {
+    /// Broadcast a value to all elements of a register
+    template<typename T,class regType>
+    regType mm_set1(T); // Not implemented: the specializations are used
 
-      assert( (a.rows() == b.rows()) &&
-              (a.cols() == b.cols()) );
+    /// Element-wise difference
+    template<typename T,class regType>
+    regType mm_sub(regType,regType);
 
+    /// Element-wise product
+    template<typename T,class regType>
+    regType mm_mul(regType,regType);
 
-      if (is_aligned_alloc<Alloc>::value) {        
-#ifdef __AVX512F__
-        addSIMD<T,Alloc,typename avx512_traits<T>::reg_type>(a,b,c);
-#elif  __AVX__
-        addSIMD<T,Alloc,typename avx_traits<T>::reg_type>(a,b,c);
-#elif  __SSE2__
-        addSIMD<T,Alloc,typename sse2_traits<T>::reg_type>(a,b,c);
-#else
-        ::anpi::fallback::add(a,b,c);
-#endif
-      } else { // allocator seems to be unaligned
-        ::anpi::fallback::add(a,b,c);
-      }
-    }
+    /// Element-wise minimum
+    template<typename T,class regType>
+    regType mm_min(regType,regType);
 
-    // Non-SIMD types such as complex
-    template<typename T,
-             class Alloc,
-             typename std::enable_if<!is_simd_type<T>::value,int>::type = 0>
-    inline void add(const Matrix<T,Alloc>& a,
-                    const Matrix<T,Alloc>& b,
-                    Matrix<T,Alloc>& c) {
-      
-      ::anpi::fallback::add(a,b,c);
-    }
+    /// Element-wise maximum
+    template<typename T,class regType>
+    regType mm_max(regType,regType);
 
-    // In-place implementation a = a+b
-    template<typename T,class Alloc>
-    inline void add(Matrix<T,Alloc>& a,
-                    const Matrix<T,Alloc>& b) {
+    /// Element-wise absolute value
+    template<typename T,class regType>
+    regType mm_abs(regType);
 
-      add(a,b,a);
+    /// True if all elements of the first register are <= than the second
+    template<typename T,class regType>
+    bool mm_all_le(regType,regType);
+    
+#ifdef __AVX512F__
+    template<>
+    inline __m512d __attribute__((__always_inline__))
+    mm_set1<double>(double a) {
+      return _mm512_set1_pd(a);
+    }
+    template<>
+    inline __m512 __attribute__((__always_inline__))
+    mm_set1<float>(float a) {
+      return _mm512_set1_ps(a);
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<uint64_t>(uint64_t a) {
+      return _mm512_set1_epi64(static_cast<long long>(a));
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<int64_t>(int64_t a) {
+      return _mm512_set1_epi64(a);
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<uint32_t>(uint32_t a) {
+      return _mm512_set1_epi32(static_cast<int>(a));
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<int32_t>(int32_t a) {
+      return _mm512_set1_epi32(a);
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<uint16_t>(uint16_t a) {
+      return _mm512_set1_epi16(static_cast<short>(a));
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<int16_t>(int16_t a) {
+      return _mm512_set1_epi16(a);
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<uint8_t>(uint8_t a) {
+      return _mm512_set1_epi8(static_cast<char>(a));
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_set1<int8_t>(int8_t a) {
+      return _mm512_set1_epi8(a);
     }
 
+    template<>
+    inline __m512d __attribute__((__always_inline__))
+    mm_sub<double>(__m512d a,__m512d b) {
+      return _mm512_sub_pd(a,b);
+    }
+    template<>
+    inline __m512 __attribute__((__always_inline__))
+    mm_sub<float>(__m512 a,__m512 b) {
+      return _mm512_sub_ps(a,b);
+    }
 
-    /*
-     * Subtraction
-     */
-
-    // Fall back implementations
+    template<>
+    inline __m512d __attribute__((__always_inline__))
+    mm_mul<double>(__m512d a,__m512d b) {
+      return _mm512_mul_pd(a,b);
+    }
+    template<>
+    inline __m512 __attribute__((__always_inline__))
+    mm_mul<float>(__m512 a,__m512 b) {
+      return _mm512_mul_ps(a,b);
+    }
 
-    // In-copy implementation c=a-b
-    template<typename T,class Alloc>
-    inline void subtract(const Matrix<T,Alloc>& a,
-                         const Matrix<T,Alloc>& b,
-                         Matrix<T,Alloc>& c) {
-      ::anpi::fallback::subtract(a,b,c);
+    // min and max merge into a instead of an undefined register, which
+    // GCC would otherwise report as maybe uninitialized when inlined
+    template<>
+    inline __m512d __attribute__((__always_inline__))
+    mm_min<double>(__m512d a,__m512d b) {
+      return _mm512_mask_min_pd(a,__mmask8(0xFF),a,b);
+    }
+    template<>
+    inline __m512 __attribute__((__always_inline__))
+    mm_min<float>(__m512 a,__m512 b) {
+      return _mm512_mask_min_ps(a,__mmask16(0xFFFF),a,b);
+    }
+
+    template<>
+    inline __m512d __attribute__((__always_inline__))
+    mm_max<double>(__m512d a,__m512d b) {
+      return _mm512_mask_max_pd(a,__mmask8(0xFF),a,b);
+    }
+    template<>
+    inline __m512 __attribute__((__always_inline__))
+    mm_max<float>(__m512 a,__m512 b) {
+      return _mm512_mask_max_ps(a,__mmask16(0xFFFF),a,b);
+    }
+
+    template<>
+    inline __m512d __attribute__((__always_inline__))
+    mm_abs<double>(__m512d a) {
+      return _mm512_abs_pd(a);
+    }
+    template<>
+    inline __m512 __attribute__((__always_inline__))
+    mm_abs<float>(__m512 a) {
+      return _mm512_abs_ps(a);
+    }
+
+    template<>
+    inline bool __attribute__((__always_inline__))
+    mm_all_le<double>(__m512d a,__m512d b) {
+      return _mm512_cmp_pd_mask(a,b,_CMP_LE_OQ) == 0xFF;
+    }
+    template<>
+    inline bool __attribute__((__always_inline__))
+    mm_all_le<float>(__m512 a,__m512 b) {
+      return _mm512_cmp_ps_mask(a,b,_CMP_LE_OQ) == 0xFFFF;
+    }
+#elif defined __AVX__
+    template<>
+    inline __m256d __attribute__((__always_inline__))
+    mm_set1<double>(double a) {
+      return _mm256_set1_pd(a);
+    }
+    template<>
+    inline __m256 __attribute__((__always_inline__))
+    mm_set1<float>(float a) {
+      return _mm256_set1_ps(a);
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<uint64_t>(uint64_t a) {
+      return _mm256_set1_epi64x(static_cast<long long>(a));
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<int64_t>(int64_t a) {
+      return _mm256_set1_epi64x(a);
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<uint32_t>(uint32_t a) {
+      return _mm256_set1_epi32(static_cast<int>(a));
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<int32_t>(int32_t a) {
+      return _mm256_set1_epi32(a);
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<uint16_t>(uint16_t a) {
+      return _mm256_set1_epi16(static_cast<short>(a));
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<int16_t>(int16_t a) {
+      return _mm256_set1_epi16(a);
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<uint8_t>(uint8_t a) {
+      return _mm256_set1_epi8(static_cast<char>(a));
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_set1<int8_t>(int8_t a) {
+      return _mm256_set1_epi8(a);
+    }
+
+    template<>
+    inline __m256d __attribute__((__always_inline__))
+    mm_sub<double>(__m256d a,__m256d b) {
+      return _mm256_sub_pd(a,b);
+    }
+    template<>
+    inline __m256 __attribute__((__always_inline__))
+    mm_sub<float>(__m256 a,__m256 b) {
+      return _mm256_sub_ps(a,b);
+    }
+
+    template<>
+    inline __m256d __attribute__((__always_inline__))
+    mm_mul<double>(__m256d a,__m256d b) {
+      return _mm256_mul_pd(a,b);
+    }
+    template<>
+    inline __m256 __attribute__((__always_inline__))
+    mm_mul<float>(__m256 a,__m256 b) {
+      return _mm256_mul_ps(a,b);
+    }
+
+    template<>
+    inline __m256d __attribute__((__always_inline__))
+    mm_min<double>(__m256d a,__m256d b) {
+      return _mm256_min_pd(a,b);
+    }
+    template<>
+    inline __m256 __attribute__((__always_inline__))
+    mm_min<float>(__m256 a,__m256 b) {
+      return _mm256_min_ps(a,b);
+    }
+
+    template<>
+    inline __m256d __attribute__((__always_inline__))
+    mm_max<double>(__m256d a,__m256d b) {
+      return _mm256_max_pd(a,b);
+    }
+    template<>
+    inline __m256 __attribute__((__always_inline__))
+    mm_max<float>(__m256 a,__m256 b) {
+      return _mm256_max_ps(a,b);
+    }
+
+    template<>
+    inline __m256d __attribute__((__always_inline__))
+    mm_abs<double>(__m256d a) {
+      return _mm256_andnot_pd(_mm256_set1_pd(-0.0),a);
+    }
+    template<>
+    inline __m256 __attribute__((__always_inline__))
+    mm_abs<float>(__m256 a) {
+      return _mm256_andnot_ps(_mm256_set1_ps(-0.0f),a);
+    }
+
+    template<>
+    inline bool __attribute__((__always_inline__))
+    mm_all_le<double>(__m256d a,__m256d b) {
+      return _mm256_movemask_pd(_mm256_cmp_pd(a,b,_CMP_LE_OQ)) == 0xF;
+    }
+    template<>
+    inline bool __attribute__((__always_inline__))
+    mm_all_le<float>(__m256 a,__m256 b) {
+      return _mm256_movemask_ps(_mm256_cmp_ps(a,b,_CMP_LE_OQ)) == 0xFF;
+    }
+#elif  defined __SSE2__
+    template<>
+    inline __m128d __attribute__((__always_inline__))
+    mm_set1<double>(double a) {
+      return _mm_set1_pd(a);
+    }
+    template<>
+    inline __m128 __attribute__((__always_inline__))
+    mm_set1<float>(float a) {
+      return _mm_set1_ps(a);
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::uint64_t>(std::uint64_t a) {
+      return _mm_set1_epi64x(static_cast<long long>(a));
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::int64_t>(std::int64_t a) {
+      return _mm_set1_epi64x(a);
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::uint32_t>(std::uint32_t a) {
+      return _mm_set1_epi32(static_cast<int>(a));
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::int32_t>(std::int32_t a) {
+      return _mm_set1_epi32(a);
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::uint16_t>(std::uint16_t a) {
+      return _mm_set1_epi16(static_cast<short>(a));
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::int16_t>(std::int16_t a) {
+      return _mm_set1_epi16(a);
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::uint8_t>(std::uint8_t a) {
+      return _mm_set1_epi8(static_cast<char>(a));
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_set1<std::int8_t>(std::int8_t a) {
+      return _mm_set1_epi8(a);
+    }
+
+    template<>
+    inline __m128d __attribute__((__always_inline__))
+    mm_sub<double>(__m128d a,__m128d b) {
+      return _mm_sub_pd(a,b);
+    }
+    template<>
+    inline __m128 __attribute__((__always_inline__))
+    mm_sub<float>(__m128 a,__m128 b) {
+      return _mm_sub_ps(a,b);
+    }
+
+    template<>
+    inline __m128d __attribute__((__always_inline__))
+    mm_mul<double>(__m128d a,__m128d b) {
+      return _mm_mul_pd(a,b);
+    }
+    template<>
+    inline __m128 __attribute__((__always_inline__))
+    mm_mul<float>(__m128 a,__m128 b) {
+      return _mm_mul_ps(a,b);
+    }
+
+    template<>
+    inline __m128d __attribute__((__always_inline__))
+    mm_min<double>(__m128d a,__m128d b) {
+      return _mm_min_pd(a,b);
+    }
+    template<>
+    inline __m128 __attribute__((__always_inline__))
+    mm_min<float>(__m128 a,__m128 b) {
+      return _mm_min_ps(a,b);
+    }
+
+    template<>
+    inline __m128d __attribute__((__always_inline__))
+    mm_max<double>(__m128d a,__m128d b) {
+      return _mm_max_pd(a,b);
+    }
+    template<>
+    inline __m128 __attribute__((__always_inline__))
+    mm_max<float>(__m128 a,__m128 b) {
+      return _mm_max_ps(a,b);
+    }
+
+    template<>
+    inline __m128d __attribute__((__always_inline__))
+    mm_abs<double>(__m128d a) {
+      return _mm_andnot_pd(_mm_set1_pd(-0.0),a);
+    }
+    template<>
+    inline __m128 __attribute__((__always_inline__))
+    mm_abs<float>(__m128 a) {
+      return _mm_andnot_ps(_mm_set1_ps(-0.0f),a);
+    }
+
+    template<>
+    inline bool __attribute__((__always_inline__))
+    mm_all_le<double>(__m128d a,__m128d b) {
+      return _mm_movemask_pd(_mm_cmple_pd(a,b)) == 0x3;
+    }
+    template<>
+    inline bool __attribute__((__always_inline__))
+    mm_all_le<float>(__m128 a,__m128 b) {
+      return _mm_movemask_ps(_mm_cmple_ps(a,b)) == 0xF;
+    }
+#endif
+
+    /*
+     * Integer products.  Only the lane widths with a native low-half
+     * multiplication on the current ISA are specialized; has_mm_mul
+     * tells the kernels which types can use them.
+     */
+
+    /// True if mm_mul is available for the type T on the current ISA
+    template<typename T>
+    struct has_mm_mul {
+      static constexpr bool value =
+        std::is_floating_point<T>::value
+#if defined __AVX512F__
+        || std::is_same<T,std::int32_t>::value
+        || std::is_same<T,std::uint32_t>::value
+#  ifdef __AVX512BW__
+        || std::is_same<T,std::int16_t>::value
+        || std::is_same<T,std::uint16_t>::value
+#  endif
+#  ifdef __AVX512DQ__
+        || std::is_same<T,std::int64_t>::value
+        || std::is_same<T,std::uint64_t>::value
+#  endif
+#elif defined __AVX2__
+        || std::is_same<T,std::int32_t>::value
+        || std::is_same<T,std::uint32_t>::value
+        || std::is_same<T,std::int16_t>::value
+        || std::is_same<T,std::uint16_t>::value
+#elif defined __AVX__
+        // integer lanes on 256 bits require AVX2
+#elif defined __SSE2__
+        || std::is_same<T,std::int16_t>::value
+        || std::is_same<T,std::uint16_t>::value
+#  ifdef __SSE4_1__
+        || std::is_same<T,std::int32_t>::value
+        || std::is_same<T,std::uint32_t>::value
+#  endif
+#endif
+        ;
+    };
+
+#ifdef __AVX512F__
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_mul<uint32_t>(__m512i a,__m512i b) {
+      return _mm512_mullo_epi32(a,b);
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_mul<int32_t>(__m512i a,__m512i b) {
+      return _mm512_mullo_epi32(a,b);
+    }
+#  ifdef __AVX512BW__
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_mul<uint16_t>(__m512i a,__m512i b) {
+      return _mm512_mullo_epi16(a,b);
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_mul<int16_t>(__m512i a,__m512i b) {
+      return _mm512_mullo_epi16(a,b);
+    }
+#  endif
+#  ifdef __AVX512DQ__
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_mul<uint64_t>(__m512i a,__m512i b) {
+      return _mm512_mullo_epi64(a,b);
+    }
+    template<>
+    inline __m512i __attribute__((__always_inline__))
+    mm_mul<int64_t>(__m512i a,__m512i b) {
+      return _mm512_mullo_epi64(a,b);
+    }
+#  endif
+#elif defined __AVX2__
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_mul<uint32_t>(__m256i a,__m256i b) {
+      return _mm256_mullo_epi32(a,b);
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_mul<int32_t>(__m256i a,__m256i b) {
+      return _mm256_mullo_epi32(a,b);
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_mul<uint16_t>(__m256i a,__m256i b) {
+      return _mm256_mullo_epi16(a,b);
+    }
+    template<>
+    inline __m256i __attribute__((__always_inline__))
+    mm_mul<int16_t>(__m256i a,__m256i b) {
+      return _mm256_mullo_epi16(a,b);
+    }
+#elif defined __SSE2__ && !defined __AVX__
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_mul<std::uint16_t>(__m128i a,__m128i b) {
+      return _mm_mullo_epi16(a,b);
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_mul<std::int16_t>(__m128i a,__m128i b) {
+      return _mm_mullo_epi16(a,b);
+    }
+#  ifdef __SSE4_1__
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_mul<std::uint32_t>(__m128i a,__m128i b) {
+      return _mm_mullo_epi32(a,b);
+    }
+    template<>
+    inline __m128i __attribute__((__always_inline__))
+    mm_mul<std::int32_t>(__m128i a,__m128i b) {
+      return _mm_mullo_epi32(a,b);
+    }
+#  endif
+#endif
+
+    /**
+     * Fused multiply-add a*b+c.
+     *
+     * The generic version composes mm_mul and mm_add, and is used for
+     * integers and for floating point types when the CPU lacks FMA.
+     * Note that the fused versions round only once, so that results
+     * may differ in the last bit from the fallback implementations.
+     */
+    template<typename T,class regType>
+    inline regType __attribute__((__always_inline__))
+    mm_fmadd(regType a,regType b,regType c) {
+      return mm_add<T>(mm_mul<T>(a,b),c);
+    }
+
+#ifdef __AVX512F__
+    template<>
+    inline __m512d __attribute__((__always_inline__))
+    mm_fmadd<double>(__m512d a,__m512d b,__m512d c) {
+      return _mm512_fmadd_pd(a,b,c);
+    }
+    template<>
+    inline __m512 __attribute__((__always_inline__))
+    mm_fmadd<float>(__m512 a,__m512 b,__m512 c) {
+      return _mm512_fmadd_ps(a,b,c);
+    }
+#elif defined __AVX__ && defined __FMA__
+    template<>
+    inline __m256d __attribute__((__always_inline__))
+    mm_fmadd<double>(__m256d a,__m256d b,__m256d c) {
+      return _mm256_fmadd_pd(a,b,c);
+    }
+    template<>
+    inline __m256 __attribute__((__always_inline__))
+    mm_fmadd<float>(__m256 a,__m256 b,__m256 c) {
+      return _mm256_fmadd_ps(a,b,c);
+    }
+#elif defined __SSE2__ && defined __FMA__
+    template<>
+    inline __m128d __attribute__((__always_inline__))
+    mm_fmadd<double>(__m128d a,__m128d b,__m128d c) {
+      return _mm_fmadd_pd(a,b,c);
+    }
+    template<>
+    inline __m128 __attribute__((__always_inline__))
+    mm_fmadd<float>(__m128 a,__m128 b,__m128 c) {
+      return _mm_fmadd_ps(a,b,c);
+    }
+#endif
+
+    /*
+     * Bitwise comparison of registers.  Integer compares on 256 bits
+     * require AVX2, so that plain AVX uses the SSE2 version.
+     */
+#ifdef __AVX512F__
+    typedef __m512i bits_reg_type;
+
+    inline bool __attribute__((__always_inline__))
+    mm_equal_bits(bits_reg_type a,bits_reg_type b) {
+      return _mm512_cmpeq_epi32_mask(a,b) == 0xFFFF;
+    }
+#elif defined __AVX2__
+    typedef __m256i bits_reg_type;
+
+    inline bool __attribute__((__always_inline__))
+    mm_equal_bits(bits_reg_type a,bits_reg_type b) {
+      return _mm256_movemask_epi8(_mm256_cmpeq_epi8(a,b)) == -1;
+    }
+#elif defined __SSE2__
+    typedef __m128i bits_reg_type;
+
+    inline bool __attribute__((__always_inline__))
+    mm_equal_bits(bits_reg_type a,bits_reg_type b) {
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(a,b)) == 0xFFFF;
+    }
+#endif
+
+    /// Sum all elements of a register
+    template<typename T,class regType>
+    inline T mm_reduce_add(regType a) {
+      T lanes[sizeof(regType)/sizeof(T)];
+      std::memcpy(lanes,&a,sizeof(regType));
+      T acc = lanes[0];
+      for (size_t i=1;i<sizeof(regType)/sizeof(T);++i) {
+        acc += lanes[i];
+      }
+      return acc;
+    }
+
+    /// Minimum of all elements of a register
+    template<typename T,class regType>
+    inline T mm_reduce_min(regType a) {
+      T lanes[sizeof(regType)/sizeof(T)];
+      std::memcpy(lanes,&a,sizeof(regType));
+      T acc = lanes[0];
+      for (size_t i=1;i<sizeof(regType)/sizeof(T);++i) {
+        acc = std::min(acc,lanes[i]);
+      }
+      return acc;
+    }
+
+    /// Maximum of all elements of a register
+    template<typename T,class regType>
+    inline T mm_reduce_max(regType a) {
+      T lanes[sizeof(regType)/sizeof(T)];
+      std::memcpy(lanes,&a,sizeof(regType));
+      T acc = lanes[0];
+      for (size_t i=1;i<sizeof(regType)/sizeof(T);++i) {
+        acc = std::max(acc,lanes[i]);
+      }
+      return acc;
+    }
+    
+    // On-copy implementation c=a+b
+    template<typename T,class Alloc,typename regType>
+    inline void addSIMD(const Matrix<T,Alloc>& a, 
+                        const Matrix<T,Alloc>& b,
+                        Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","simd add");
+
+      // This method is instantiated with unaligned allocators.  We
+      // allow the instantiation although externally this is never
+      // called unaligned
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+      
+      const size_t tentries = a.rows()*a.dcols();
+      c.allocate(a.rows(),a.cols());
+
+      regType* here        = reinterpret_cast<regType*>(c.data());
+      const size_t  blocks = ( tentries*sizeof(T) + (sizeof(regType)-1) )/
+        sizeof(regType);
+      regType *const end   = here + blocks;
+      const regType* aptr  = reinterpret_cast<const regType*>(a.data());
+      const regType* bptr  = reinterpret_cast<const regType*>(b.data());
+      
+      for (;here!=end;) {
+        *here++ = mm_add<T>(*aptr++,*bptr++);
+      }
+      
+    }
+       
+    // On-copy implementation c=a+b for SIMD-capable types
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<is_simd_type<T>::value,int>::type=0>
+    inline void add(const Matrix<T,Alloc>& a,
+                    const Matrix<T,Alloc>& b,
+                    Matrix<T,Alloc>& c) {
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+
+      if (is_aligned_alloc<Alloc>::value) {        
+#ifdef __AVX512F__
+        addSIMD<T,Alloc,typename avx512_traits<T>::reg_type>(a,b,c);
+#elif  __AVX__
+        addSIMD<T,Alloc,typename avx_traits<T>::reg_type>(a,b,c);
+#elif  __SSE2__
+        addSIMD<T,Alloc,typename sse2_traits<T>::reg_type>(a,b,c);
+#else
+        ::anpi::fallback::add(a,b,c);
+#endif
+      } else { // allocator seems to be unaligned
+        ::anpi::fallback::add(a,b,c);
+      }
+    }
+
+    // Non-SIMD types such as complex
+    template<typename T,
+             class Alloc,
+             typename std::enable_if<!is_simd_type<T>::value,int>::type = 0>
+    inline void add(const Matrix<T,Alloc>& a,
+                    const Matrix<T,Alloc>& b,
+                    Matrix<T,Alloc>& c) {
+      
+      ::anpi::fallback::add(a,b,c);
+    }
+
+    // In-place implementation a = a+b
+    template<typename T,class Alloc>
+    inline void add(Matrix<T,Alloc>& a,
+                    const Matrix<T,Alloc>& b) {
+
+      add(a,b,a);
+    }
+
+
+    /*
+     * Subtraction
+     */
+
+    // Fall back implementations
+
+    // In-copy implementation c=a-b
+    template<typename T,class Alloc>
+    inline void subtract(const Matrix<T,Alloc>& a,
+                         const Matrix<T,Alloc>& b,
+                         Matrix<T,Alloc>& c) {
+      ::anpi::fallback::subtract(a,b,c);
     }
 
     // In-place implementation a = a-b
@@ -397,6 +1201,292 @@ namespace anpi
 
       ::anpi::fallback::subtract(a,b);
     }
+
+    /*
+     * Fused element-wise kernels
+     *
+     * Only the on-copy versions are implemented with SIMD; the in-place
+     * versions alias the output with one of the inputs, which is safe
+     * since every register is read before it is written.
+     */
+
+    // On-copy implementation z = alpha*x + y
+    template<typename T,class Alloc,typename regType>
+    inline void axpySIMD(const T alpha,
+                         const Matrix<T,Alloc>& x,
+                         const Matrix<T,Alloc>& y,
+                         Matrix<T,Alloc>& z) {
+      ANPI_PROFILE_SCOPE("matrix","simd axpy");
+
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+
+      const size_t tentries = x.rows()*x.dcols();
+      z.allocate(x.rows(),x.cols());
+
+      regType* here        = reinterpret_cast<regType*>(z.data());
+      const size_t  blocks = ( tentries*sizeof(T) + (sizeof(regType)-1) )/
+        sizeof(regType);
+      regType *const end   = here + blocks;
+      const regType* xptr  = reinterpret_cast<const regType*>(x.data());
+      const regType* yptr  = reinterpret_cast<const regType*>(y.data());
+      const regType ralpha = mm_set1<T,regType>(alpha);
+
+      for (;here!=end;) {
+        *here++ = mm_fmadd<T>(ralpha,*xptr++,*yptr++);
+      }
+    }
+
+    // On-copy implementation c = alpha*a
+    template<typename T,class Alloc,typename regType>
+    inline void scaleSIMD(const T alpha,
+                          const Matrix<T,Alloc>& a,
+                          Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","simd scale");
+
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+
+      const size_t tentries = a.rows()*a.dcols();
+      c.allocate(a.rows(),a.cols());
+
+      regType* here        = reinterpret_cast<regType*>(c.data());
+      const size_t  blocks = ( tentries*sizeof(T) + (sizeof(regType)-1) )/
+        sizeof(regType);
+      regType *const end   = here + blocks;
+      const regType* aptr  = reinterpret_cast<const regType*>(a.data());
+      const regType ralpha = mm_set1<T,regType>(alpha);
+
+      for (;here!=end;) {
+        *here++ = mm_mul<T>(ralpha,*aptr++);
+      }
+    }
+
+    // On-copy implementation c = a .* b
+    template<typename T,class Alloc,typename regType>
+    inline void hadamardSIMD(const Matrix<T,Alloc>& a,
+                             const Matrix<T,Alloc>& b,
+                             Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","simd hadamard");
+
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+
+      const size_t tentries = a.rows()*a.dcols();
+      c.allocate(a.rows(),a.cols());
+
+      regType* here        = reinterpret_cast<regType*>(c.data());
+      const size_t  blocks = ( tentries*sizeof(T) + (sizeof(regType)-1) )/
+        sizeof(regType);
+      regType *const end   = here + blocks;
+      const regType* aptr  = reinterpret_cast<const regType*>(a.data());
+      const regType* bptr  = reinterpret_cast<const regType*>(b.data());
+
+      for (;here!=end;) {
+        *here++ = mm_mul<T>(*aptr++,*bptr++);
+      }
+    }
+
+    // On-copy implementation c = alpha*a + beta*b
+    template<typename T,class Alloc,typename regType>
+    inline void lincombSIMD(const T alpha,
+                            const Matrix<T,Alloc>& a,
+                            const T beta,
+                            const Matrix<T,Alloc>& b,
+                            Matrix<T,Alloc>& c) {
+      ANPI_PROFILE_SCOPE("matrix","simd lincomb");
+
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+
+      const size_t tentries = a.rows()*a.dcols();
+      c.allocate(a.rows(),a.cols());
+
+      regType* here        = reinterpret_cast<regType*>(c.data());
+      const size_t  blocks = ( tentries*sizeof(T) + (sizeof(regType)-1) )/
+        sizeof(regType);
+      regType *const end   = here + blocks;
+      const regType* aptr  = reinterpret_cast<const regType*>(a.data());
+      const regType* bptr  = reinterpret_cast<const regType*>(b.data());
+      const regType ralpha = mm_set1<T,regType>(alpha);
+      const regType rbeta  = mm_set1<T,regType>(beta);
+
+      for (;here!=end;) {
+        *here++ = mm_fmadd<T>(ralpha,*aptr++,mm_mul<T>(rbeta,*bptr++));
+      }
+    }
+
+    /*
+     * The register type for the current ISA.  The dispatchers below
+     * only use it for types with has_mm_mul, so that the fallback is
+     * taken for integer widths without a native product.
+     */
+#ifdef __AVX512F__
+#  define ANPI_SIMD_REG(T) typename avx512_traits<T>::reg_type
+#elif  __AVX__
+#  define ANPI_SIMD_REG(T) typename avx_traits<T>::reg_type
+#elif  __SSE2__
+#  define ANPI_SIMD_REG(T) typename sse2_traits<T>::reg_type
+#endif
+
+    // On-copy implementation z = alpha*x + y for SIMD-capable types
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<has_mm_mul<T>::value,int>::type=0>
+    inline void axpy(const T alpha,
+                     const Matrix<T,Alloc>& x,
+                     const Matrix<T,Alloc>& y,
+                     Matrix<T,Alloc>& z) {
+
+      assert( (x.rows() == y.rows()) &&
+              (x.cols() == y.cols()) );
+
+#ifdef ANPI_SIMD_REG
+      if (is_aligned_alloc<Alloc>::value) {
+        axpySIMD<T,Alloc,ANPI_SIMD_REG(T)>(alpha,x,y,z);
+        return;
+      }
+#endif
+      ::anpi::fallback::axpy(alpha,x,y,z);
+    }
+
+    // Types without SIMD products, such as complex or 8-bit integers
+    template<typename T,
+             class Alloc,
+             typename std::enable_if<!has_mm_mul<T>::value,int>::type = 0>
+    inline void axpy(const T alpha,
+                     const Matrix<T,Alloc>& x,
+                     const Matrix<T,Alloc>& y,
+                     Matrix<T,Alloc>& z) {
+      ::anpi::fallback::axpy(alpha,x,y,z);
+    }
+
+    // In-place implementation y = alpha*x + y
+    template<typename T,class Alloc>
+    inline void axpy(const T alpha,
+                     const Matrix<T,Alloc>& x,
+                     Matrix<T,Alloc>& y) {
+      axpy(alpha,x,y,y);
+    }
+
+    // On-copy implementation c = alpha*a for SIMD-capable types
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<has_mm_mul<T>::value,int>::type=0>
+    inline void scale(const T alpha,
+                      const Matrix<T,Alloc>& a,
+                      Matrix<T,Alloc>& c) {
+#ifdef ANPI_SIMD_REG
+      if (is_aligned_alloc<Alloc>::value) {
+        scaleSIMD<T,Alloc,ANPI_SIMD_REG(T)>(alpha,a,c);
+        return;
+      }
+#endif
+      ::anpi::fallback::scale(alpha,a,c);
+    }
+
+    // Types without SIMD products
+    template<typename T,
+             class Alloc,
+             typename std::enable_if<!has_mm_mul<T>::value,int>::type = 0>
+    inline void scale(const T alpha,
+                      const Matrix<T,Alloc>& a,
+                      Matrix<T,Alloc>& c) {
+      ::anpi::fallback::scale(alpha,a,c);
+    }
+
+    // In-place implementation a = alpha*a
+    template<typename T,class Alloc>
+    inline void scale(const T alpha,
+                      Matrix<T,Alloc>& a) {
+      scale(alpha,a,a);
+    }
+
+    // On-copy implementation c = a .* b for SIMD-capable types
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<has_mm_mul<T>::value,int>::type=0>
+    inline void hadamard(const Matrix<T,Alloc>& a,
+                         const Matrix<T,Alloc>& b,
+                         Matrix<T,Alloc>& c) {
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+#ifdef ANPI_SIMD_REG
+      if (is_aligned_alloc<Alloc>::value) {
+        hadamardSIMD<T,Alloc,ANPI_SIMD_REG(T)>(a,b,c);
+        return;
+      }
+#endif
+      ::anpi::fallback::hadamard(a,b,c);
+    }
+
+    // Types without SIMD products
+    template<typename T,
+             class Alloc,
+             typename std::enable_if<!has_mm_mul<T>::value,int>::type = 0>
+    inline void hadamard(const Matrix<T,Alloc>& a,
+                         const Matrix<T,Alloc>& b,
+                         Matrix<T,Alloc>& c) {
+      ::anpi::fallback::hadamard(a,b,c);
+    }
+
+    // In-place implementation a = a .* b
+    template<typename T,class Alloc>
+    inline void hadamard(Matrix<T,Alloc>& a,
+                         const Matrix<T,Alloc>& b) {
+      hadamard(a,b,a);
+    }
+
+    // On-copy implementation c = alpha*a + beta*b for SIMD-capable types
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<has_mm_mul<T>::value,int>::type=0>
+    inline void lincomb(const T alpha,
+                        const Matrix<T,Alloc>& a,
+                        const T beta,
+                        const Matrix<T,Alloc>& b,
+                        Matrix<T,Alloc>& c) {
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+#ifdef ANPI_SIMD_REG
+      if (is_aligned_alloc<Alloc>::value) {
+        lincombSIMD<T,Alloc,ANPI_SIMD_REG(T)>(alpha,a,beta,b,c);
+        return;
+      }
+#endif
+      ::anpi::fallback::lincomb(alpha,a,beta,b,c);
+    }
+
+    // Types without SIMD products
+    template<typename T,
+             class Alloc,
+             typename std::enable_if<!has_mm_mul<T>::value,int>::type = 0>
+    inline void lincomb(const T alpha,
+                        const Matrix<T,Alloc>& a,
+                        const T beta,
+                        const Matrix<T,Alloc>& b,
+                        Matrix<T,Alloc>& c) {
+      ::anpi::fallback::lincomb(alpha,a,beta,b,c);
+    }
+
+    // In-place implementation a = alpha*a + beta*b
+    template<typename T,class Alloc>
+    inline void lincomb(const T alpha,
+                        Matrix<T,Alloc>& a,
+                        const T beta,
+                        const Matrix<T,Alloc>& b) {
+      lincomb(alpha,a,beta,b,a);
+    }
+
+#undef ANPI_SIMD_REG
   } // namespace simd
 
 
@@ -0,0 +1,729 @@
+/*
+ * Copyright (C) 2017-2018
+ * Área Académica de Ingeniería en Computadoras, ITCR, Costa Rica
+ *
+ * This file is part of the numerical analysis lecture CE3102 at TEC
+ *
+ * @Author: Pablo Alvarado
+ * @Date:   28.12.2017
+ */
+
+#ifndef ANPI_MATRIX_REDUCTIONS_HPP
+#define ANPI_MATRIX_REDUCTIONS_HPP
+
+#include "bits/MatrixArithmetic.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace anpi
+{
+  /**
+   * The element-wise arithmetic can process the padding of the rows
+   * as well, but the comparisons and reductions must ignore it.
+   *
+   * The entries of a matrix are visited as "runs" of contiguous
+   * elements.  If the rows are not padded the whole matrix is a single
+   * run, otherwise each row is a run.  The start of each run keeps the
+   * alignment of the allocator.
+   */
+  template<typename T,class Alloc>
+  inline void matrixRuns(const Matrix<T,Alloc>& a,
+                         size_t& runs,
+                         size_t& length) {
+    if (a.dcols() == a.cols()) {
+      runs   = a.empty() ? 0u : 1u;
+      length = a.rows()*a.cols();
+    } else {
+      runs   = a.rows();
+      length = a.cols();
+    }
+  }
+
+  namespace fallback {
+
+    /*
+     * Fill
+     */
+
+    // Fill all entries (including padding) with the given value
+    template<typename T,class Alloc>
+    inline void fill(Matrix<T,Alloc>& a,const T val) {
+      ANPI_PROFILE_SCOPE("matrix","fallback fill");
+      std::fill_n(a.data(),a.rows()*a.dcols(),val);
+    }
+
+    /*
+     * Comparison
+     */
+
+    // Bitwise equality of all entries, ignoring the padding
+    template<typename T,class Alloc>
+    inline bool equal(const Matrix<T,Alloc>& a,
+                      const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","fallback equal");
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+
+      for (size_t r=0;r<runs;++r) {
+        if (std::memcmp(a[r],b[r],length*sizeof(T))!=0) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // All entries differ at most by tol
+    template<typename T,class Alloc,typename U>
+    inline bool approxEqual(const Matrix<T,Alloc>& a,
+                            const Matrix<T,Alloc>& b,
+                            const U tol) {
+      ANPI_PROFILE_SCOPE("matrix","fallback approxEqual");
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      for (size_t r=0;r<a.rows();++r) {
+        const T* aptr = a[r];
+        const T* bptr = b[r];
+        const T *const end = aptr + a.cols();
+        for (;aptr!=end;++aptr,++bptr) {
+          using std::abs;
+          if (!(abs(*aptr - *bptr) <= tol)) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    /*
+     * Reductions
+     */
+
+    // Sum of all entries
+    template<typename T,class Alloc>
+    inline T sum(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","fallback sum");
+      T acc = T(0);
+      for (size_t r=0;r<a.rows();++r) {
+        const T* ptr = a[r];
+        const T *const end = ptr + a.cols();
+        for (;ptr!=end;) {
+          acc += *ptr++;
+        }
+      }
+      return acc;
+    }
+
+    // Smallest entry
+    template<typename T,class Alloc>
+    inline T min(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","fallback min");
+      assert(!a.empty());
+
+      T acc = a(0,0);
+      for (size_t r=0;r<a.rows();++r) {
+        const T* ptr = a[r];
+        const T *const end = ptr + a.cols();
+        for (;ptr!=end;++ptr) {
+          acc = std::min(acc,*ptr);
+        }
+      }
+      return acc;
+    }
+
+    // Largest entry
+    template<typename T,class Alloc>
+    inline T max(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","fallback max");
+      assert(!a.empty());
+
+      T acc = a(0,0);
+      for (size_t r=0;r<a.rows();++r) {
+        const T* ptr = a[r];
+        const T *const end = ptr + a.cols();
+        for (;ptr!=end;++ptr) {
+          acc = std::max(acc,*ptr);
+        }
+      }
+      return acc;
+    }
+
+    // Sum of the element-wise products
+    template<typename T,class Alloc>
+    inline T dot(const Matrix<T,Alloc>& a,
+                 const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","fallback dot");
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      T acc = T(0);
+      for (size_t r=0;r<a.rows();++r) {
+        const T* aptr = a[r];
+        const T* bptr = b[r];
+        const T *const end = aptr + a.cols();
+        for (;aptr!=end;) {
+          acc += *aptr++ * *bptr++;
+        }
+      }
+      return acc;
+    }
+
+    // Sum of the absolute values of all entries
+    template<typename T,class Alloc>
+    inline T norm1(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","fallback norm1");
+      T acc = T(0);
+      for (size_t r=0;r<a.rows();++r) {
+        const T* ptr = a[r];
+        const T *const end = ptr + a.cols();
+        for (;ptr!=end;) {
+          using std::abs;
+          acc += abs(*ptr++);
+        }
+      }
+      return acc;
+    }
+
+    // Frobenius norm
+    template<typename T,class Alloc>
+    inline T norm2(const Matrix<T,Alloc>& a) {
+      using std::sqrt;
+      return sqrt(::anpi::fallback::dot(a,a));
+    }
+
+    // Largest absolute value of all entries
+    template<typename T,class Alloc>
+    inline T normInf(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","fallback normInf");
+      T acc = T(0);
+      for (size_t r=0;r<a.rows();++r) {
+        const T* ptr = a[r];
+        const T *const end = ptr + a.cols();
+        for (;ptr!=end;++ptr) {
+          using std::abs;
+          acc = std::max(acc,T(abs(*ptr)));
+        }
+      }
+      return acc;
+    }
+
+  } // namespace fallback
+
+
+  namespace simd
+  {
+    /*
+     * Fill
+     */
+
+    // Fill all entries (including padding) with the given value
+    template<typename T,class Alloc,typename regType>
+    inline void fillSIMD(Matrix<T,Alloc>& a,const T val) {
+      ANPI_PROFILE_SCOPE("matrix","simd fill");
+
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+
+      const size_t tentries = a.rows()*a.dcols();
+      const size_t  blocks  = ( tentries*sizeof(T) + (sizeof(regType)-1) )/
+        sizeof(regType);
+
+      const regType rval   = mm_set1<T,regType>(val);
+      regType* here        = reinterpret_cast<regType*>(a.data());
+      regType *const end   = here + blocks;
+
+      for (;here!=end;) {
+        *here++ = rval;
+      }
+    }
+
+    // Fill for SIMD-capable types
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<is_simd_type<T>::value,int>::type=0>
+    inline void fill(Matrix<T,Alloc>& a,const T val) {
+      if (is_aligned_alloc<Alloc>::value) {
+#ifdef __AVX512F__
+        fillSIMD<T,Alloc,typename avx512_traits<T>::reg_type>(a,val);
+#elif  __AVX__
+        fillSIMD<T,Alloc,typename avx_traits<T>::reg_type>(a,val);
+#elif  __SSE2__
+        fillSIMD<T,Alloc,typename sse2_traits<T>::reg_type>(a,val);
+#else
+        ::anpi::fallback::fill(a,val);
+#endif
+      } else { // allocator seems to be unaligned
+        ::anpi::fallback::fill(a,val);
+      }
+    }
+
+    // Non-SIMD types such as complex
+    template<typename T,
+             class Alloc,
+             typename std::enable_if<!is_simd_type<T>::value,int>::type = 0>
+    inline void fill(Matrix<T,Alloc>& a,const T val) {
+      ::anpi::fallback::fill(a,val);
+    }
+
+    /*
+     * Comparison
+     */
+
+    // Bitwise equality, leaving as soon as one block differs
+    template<typename T,class Alloc,typename regType>
+    inline bool equalSIMD(const Matrix<T,Alloc>& a,
+                          const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","simd equal");
+
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+
+      // full registers per run, and remaining bytes
+      const size_t bytes  = length*sizeof(T);
+      const size_t blocks = bytes/sizeof(regType);
+      const size_t rest   = bytes - blocks*sizeof(regType);
+
+      for (size_t r=0;r<runs;++r) {
+        const regType* aptr = reinterpret_cast<const regType*>(a[r]);
+        const regType* bptr = reinterpret_cast<const regType*>(b[r]);
+        const regType *const end = aptr + blocks;
+        for (;aptr!=end;) {
+          if (!mm_equal_bits(*aptr++,*bptr++)) {
+            return false;
+          }
+        }
+        if ((rest != 0) && (std::memcmp(aptr,bptr,rest) != 0)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Bitwise equality of all entries, ignoring the padding
+    template<typename T,class Alloc>
+    inline bool equal(const Matrix<T,Alloc>& a,
+                      const Matrix<T,Alloc>& b) {
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+#if defined(__SSE2__)
+      if (is_aligned_alloc<Alloc>::value) {
+        return equalSIMD<T,Alloc,bits_reg_type>(a,b);
+      }
+#endif
+      return ::anpi::fallback::equal(a,b);
+    }
+
+    // Approximate equality, leaving as soon as one block differs
+    template<typename T,class Alloc,typename regType>
+    inline bool approxEqualSIMD(const Matrix<T,Alloc>& a,
+                                const Matrix<T,Alloc>& b,
+                                const T tol) {
+      ANPI_PROFILE_SCOPE("matrix","simd approxEqual");
+
+      static_assert(!extract_alignment<Alloc>::aligned ||
+		    (extract_alignment<Alloc>::value >= sizeof(regType)),
+		    "Insufficient alignment for the registers used");
+
+      const size_t lanes = sizeof(regType)/sizeof(T);
+      const regType rtol = mm_set1<T,regType>(tol);
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+      const size_t blocks = length/lanes;
+
+      for (size_t r=0;r<runs;++r) {
+        const regType* aptr = reinterpret_cast<const regType*>(a[r]);
+        const regType* bptr = reinterpret_cast<const regType*>(b[r]);
+        const regType *const end = aptr + blocks;
+        for (;aptr!=end;) {
+          if (!mm_all_le<T>(mm_abs<T>(mm_sub<T>(*aptr++,*bptr++)),rtol)) {
+            return false;
+          }
+        }
+        const T* atail = a[r];
+        const T* btail = b[r];
+        for (size_t i=blocks*lanes;i<length;++i) {
+          if (!(std::abs(atail[i]-btail[i]) <= tol)) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    // All entries differ at most by tol, for float and double
+    template<typename T,
+	     class Alloc,
+             typename U,
+	     typename std::enable_if<std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline bool approxEqual(const Matrix<T,Alloc>& a,
+                            const Matrix<T,Alloc>& b,
+                            const U tol) {
+
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+
+      if (is_aligned_alloc<Alloc>::value) {
+#ifdef __AVX512F__
+        return approxEqualSIMD<T,Alloc,
+                               typename avx512_traits<T>::reg_type>(a,b,T(tol));
+#elif  __AVX__
+        return approxEqualSIMD<T,Alloc,
+                               typename avx_traits<T>::reg_type>(a,b,T(tol));
+#elif  __SSE2__
+        return approxEqualSIMD<T,Alloc,
+                               typename sse2_traits<T>::reg_type>(a,b,T(tol));
+#endif
+      }
+      return ::anpi::fallback::approxEqual(a,b,tol);
+    }
+
+    // Other types, like integers or complex
+    template<typename T,
+	     class Alloc,
+             typename U,
+	     typename std::enable_if<!std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline bool approxEqual(const Matrix<T,Alloc>& a,
+                            const Matrix<T,Alloc>& b,
+                            const U tol) {
+      return ::anpi::fallback::approxEqual(a,b,tol);
+    }
+
+    /*
+     * Reductions
+     *
+     * Each accumulates element-wise into one register, which is
+     * reduced at the end.  Hence, the order of the floating point
+     * operations differs from the fallback versions.
+     */
+
+    // Sum of all entries
+    template<typename T,class Alloc,typename regType>
+    inline T sumSIMD(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","simd sum");
+
+      const size_t lanes = sizeof(regType)/sizeof(T);
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+      const size_t blocks = length/lanes;
+
+      regType acc = mm_set1<T,regType>(T(0));
+      T tail = T(0);
+      for (size_t r=0;r<runs;++r) {
+        const regType* ptr = reinterpret_cast<const regType*>(a[r]);
+        const regType *const end = ptr + blocks;
+        for (;ptr!=end;) {
+          acc = mm_add<T>(acc,*ptr++);
+        }
+        const T* row = a[r];
+        for (size_t i=blocks*lanes;i<length;++i) {
+          tail += row[i];
+        }
+      }
+      return mm_reduce_add<T>(acc) + tail;
+    }
+
+    // Smallest entry
+    template<typename T,class Alloc,typename regType>
+    inline T minSIMD(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","simd min");
+
+      const size_t lanes = sizeof(regType)/sizeof(T);
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+      const size_t blocks = length/lanes;
+
+      regType acc = mm_set1<T,regType>(a(0,0));
+      T tail = a(0,0);
+      for (size_t r=0;r<runs;++r) {
+        const regType* ptr = reinterpret_cast<const regType*>(a[r]);
+        const regType *const end = ptr + blocks;
+        for (;ptr!=end;) {
+          acc = mm_min<T>(acc,*ptr++);
+        }
+        const T* row = a[r];
+        for (size_t i=blocks*lanes;i<length;++i) {
+          tail = std::min(tail,row[i]);
+        }
+      }
+      return std::min(mm_reduce_min<T>(acc),tail);
+    }
+
+    // Largest entry
+    template<typename T,class Alloc,typename regType>
+    inline T maxSIMD(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","simd max");
+
+      const size_t lanes = sizeof(regType)/sizeof(T);
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+      const size_t blocks = length/lanes;
+
+      regType acc = mm_set1<T,regType>(a(0,0));
+      T tail = a(0,0);
+      for (size_t r=0;r<runs;++r) {
+        const regType* ptr = reinterpret_cast<const regType*>(a[r]);
+        const regType *const end = ptr + blocks;
+        for (;ptr!=end;) {
+          acc = mm_max<T>(acc,*ptr++);
+        }
+        const T* row = a[r];
+        for (size_t i=blocks*lanes;i<length;++i) {
+          tail = std::max(tail,row[i]);
+        }
+      }
+      return std::max(mm_reduce_max<T>(acc),tail);
+    }
+
+    // Sum of the element-wise products
+    template<typename T,class Alloc,typename regType>
+    inline T dotSIMD(const Matrix<T,Alloc>& a,
+                     const Matrix<T,Alloc>& b) {
+      ANPI_PROFILE_SCOPE("matrix","simd dot");
+
+      const size_t lanes = sizeof(regType)/sizeof(T);
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+      const size_t blocks = length/lanes;
+
+      regType acc = mm_set1<T,regType>(T(0));
+      T tail = T(0);
+      for (size_t r=0;r<runs;++r) {
+        const regType* aptr = reinterpret_cast<const regType*>(a[r]);
+        const regType* bptr = reinterpret_cast<const regType*>(b[r]);
+        const regType *const end = aptr + blocks;
+        for (;aptr!=end;) {
+          acc = mm_fmadd<T>(*aptr++,*bptr++,acc);
+        }
+        const T* arow = a[r];
+        const T* brow = b[r];
+        for (size_t i=blocks*lanes;i<length;++i) {
+          tail += arow[i]*brow[i];
+        }
+      }
+      return mm_reduce_add<T>(acc) + tail;
+    }
+
+    // Sum of the absolute values of all entries
+    template<typename T,class Alloc,typename regType>
+    inline T norm1SIMD(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","simd norm1");
+
+      const size_t lanes = sizeof(regType)/sizeof(T);
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+      const size_t blocks = length/lanes;
+
+      regType acc = mm_set1<T,regType>(T(0));
+      T tail = T(0);
+      for (size_t r=0;r<runs;++r) {
+        const regType* ptr = reinterpret_cast<const regType*>(a[r]);
+        const regType *const end = ptr + blocks;
+        for (;ptr!=end;) {
+          acc = mm_add<T>(acc,mm_abs<T>(*ptr++));
+        }
+        const T* row = a[r];
+        for (size_t i=blocks*lanes;i<length;++i) {
+          tail += std::abs(row[i]);
+        }
+      }
+      return mm_reduce_add<T>(acc) + tail;
+    }
+
+    // Largest absolute value of all entries
+    template<typename T,class Alloc,typename regType>
+    inline T normInfSIMD(const Matrix<T,Alloc>& a) {
+      ANPI_PROFILE_SCOPE("matrix","simd normInf");
+
+      const size_t lanes = sizeof(regType)/sizeof(T);
+
+      size_t runs,length;
+      matrixRuns(a,runs,length);
+      const size_t blocks = length/lanes;
+
+      regType acc = mm_set1<T,regType>(T(0));
+      T tail = T(0);
+      for (size_t r=0;r<runs;++r) {
+        const regType* ptr = reinterpret_cast<const regType*>(a[r]);
+        const regType *const end = ptr + blocks;
+        for (;ptr!=end;) {
+          acc = mm_max<T>(acc,mm_abs<T>(*ptr++));
+        }
+        const T* row = a[r];
+        for (size_t i=blocks*lanes;i<length;++i) {
+          tail = std::max(tail,std::abs(row[i]));
+        }
+      }
+      return std::max(mm_reduce_max<T>(acc),tail);
+    }
+
+/*
+ * Dispatch a reduction to the SIMD implementation for the available
+ * ISA, if the type and allocator permit it, or to the fallback version
+ */
+#ifdef __AVX512F__
+# define ANPI_SIMD_REDUCTION(name,...)                                 \
+    if (std::is_floating_point<T>::value &&                            \
+        is_aligned_alloc<Alloc>::value) {                              \
+      return name##SIMD<T,Alloc,                                       \
+                        typename avx512_traits<T>::reg_type>(__VA_ARGS__); \
+    }                                                                  \
+    return ::anpi::fallback::name(__VA_ARGS__)
+#elif  __AVX__
+# define ANPI_SIMD_REDUCTION(name,...)                                 \
+    if (std::is_floating_point<T>::value &&                            \
+        is_aligned_alloc<Alloc>::value) {                              \
+      return name##SIMD<T,Alloc,                                       \
+                        typename avx_traits<T>::reg_type>(__VA_ARGS__);  \
+    }                                                                  \
+    return ::anpi::fallback::name(__VA_ARGS__)
+#elif  __SSE2__
+# define ANPI_SIMD_REDUCTION(name,...)                                 \
+    if (std::is_floating_point<T>::value &&                            \
+        is_aligned_alloc<Alloc>::value) {                              \
+      return name##SIMD<T,Alloc,                                       \
+                        typename sse2_traits<T>::reg_type>(__VA_ARGS__); \
+    }                                                                  \
+    return ::anpi::fallback::name(__VA_ARGS__)
+#else
+# define ANPI_SIMD_REDUCTION(name,...)                                 \
+    return ::anpi::fallback::name(__VA_ARGS__)
+#endif
+
+    // Reductions for float and double
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T sum(const Matrix<T,Alloc>& a) {
+      ANPI_SIMD_REDUCTION(sum,a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T min(const Matrix<T,Alloc>& a) {
+      assert(!a.empty());
+      ANPI_SIMD_REDUCTION(min,a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T max(const Matrix<T,Alloc>& a) {
+      assert(!a.empty());
+      ANPI_SIMD_REDUCTION(max,a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T dot(const Matrix<T,Alloc>& a,
+                 const Matrix<T,Alloc>& b) {
+      assert( (a.rows() == b.rows()) &&
+              (a.cols() == b.cols()) );
+      ANPI_SIMD_REDUCTION(dot,a,b);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T norm1(const Matrix<T,Alloc>& a) {
+      ANPI_SIMD_REDUCTION(norm1,a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T normInf(const Matrix<T,Alloc>& a) {
+      ANPI_SIMD_REDUCTION(normInf,a);
+    }
+
+#undef ANPI_SIMD_REDUCTION
+
+    // Other types, like integers or complex
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<!std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T sum(const Matrix<T,Alloc>& a) {
+      return ::anpi::fallback::sum(a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<!std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T min(const Matrix<T,Alloc>& a) {
+      return ::anpi::fallback::min(a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<!std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T max(const Matrix<T,Alloc>& a) {
+      return ::anpi::fallback::max(a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<!std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T dot(const Matrix<T,Alloc>& a,
+                 const Matrix<T,Alloc>& b) {
+      return ::anpi::fallback::dot(a,b);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<!std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T norm1(const Matrix<T,Alloc>& a) {
+      return ::anpi::fallback::norm1(a);
+    }
+
+    template<typename T,
+	     class Alloc,
+	     typename std::enable_if<!std::is_floating_point<T>::value,
+                                     int>::type=0>
+    inline T normInf(const Matrix<T,Alloc>& a) {
+      return ::anpi::fallback::normInf(a);
+    }
+
+    // Frobenius norm
+    template<typename T,class Alloc>
+    inline T norm2(const Matrix<T,Alloc>& a) {
+      using std::sqrt;
+      return sqrt(::anpi::simd::dot(a,a));
+    }
+
+  } // namespace simd
+
+} // namespace anpi
+
+#endif
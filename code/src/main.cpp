@@ -4,19 +4,283 @@
  *
  * This file is part of the CE3102 Numerical Analysis lecture at TEC
  *
- * @Author: 
+ * @Author:
  * @Date  : 24.02.2018
  */
 
+#include <csignal>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
-int main() {
+#include <pthread.h>
 
-  // Put your main code in here
+#include "BatchSolver.hpp"
+#include "Profiler.hpp"
+#include "ShardedSolver.hpp"
+#include "SolveService.hpp"
 
-  std::cout << "Nothing done yet!" << std::endl; // REMOVE-ME!
-  
-  return EXIT_FAILURE;
+namespace {
+
+  void usage(const char* prog) {
+    std::cerr
+      << "Usage: " << prog << " [options] [input [output]]\n"
+      << "       " << prog << " [options] -s <socket>\n"
+      << "       " << prog << " [options] -l <socket> [input]\n"
+      << "\n"
+      << "Solves one problem per input line and writes the roots in the\n"
+      << "same order.  Input and output default to stdin and stdout.\n"
+      << "If input is a column file (see ColumnFile.hpp), the rows are\n"
+      << "solved in place and output is written as a column file too.\n"
+      << "With -s, serves solve requests on a Unix domain socket until\n"
+      << "interrupted (see SolveService.hpp).  With -l, sends the lines of\n"
+      << "input (default: corpus equations) to such a server and reports\n"
+      << "the latency percentiles and the throughput.\n"
+      << "\n"
+      << "Input lines:\n"
+      << "  poly <a> <b> <c0> [<c1> ...]  c0 + c1 x + ... in [a,b]\n"
+      << "  corpus <seed> <index>         equation of the seeded corpus\n"
+      << "  expr <a> <b> <expression>     e.g. expr 0 2 abs(x)-exp(-x)\n"
+      << "Output lines:\n"
+      << "  <root> <evaluations> ok|failed|budget|error|invalid\n"
+      << "\n"
+      << "Options:\n"
+      << "  -m <method>  bisection, interpolation, secant, newton, brent\n"
+      << "               or ridder (default brent)\n"
+      << "  -e <eps>     tolerance (default 1e-10)\n"
+      << "  -b <n>       evaluation budget per problem (default 1000)\n"
+      << "  -t <n>       worker threads (default: hardware threads)\n"
+      << "  -c <n>       lines per chunk of work (default 1024)\n"
+      << "  -w <n>       chunks in flight (default: 4 per thread)\n"
+      << "  -r <file>    checkpoint file: resume from it if it exists, and\n"
+      << "               update it while solving (needs input and output\n"
+      << "               files)\n"
+      << "  -i <s>       seconds between checkpoints (default 10)\n"
+      << "  -a           bind each worker thread to one CPU\n"
+      << "  -f <n>       column input: solve in n worker processes, each\n"
+      << "               bound to a NUMA node, restarting dead ones\n"
+      << "               (0 for one per node)\n"
+      << "  -q           no progress report on stderr\n"
+      << "  -u <us>      server: wait for a batch to fill (default 100)\n"
+      << "  -n <n>       load: requests to send (default 100000)\n"
+      << "  -k <n>       load: connections (default 4)\n"
+      << "  -p <n>       load: requests in flight per connection\n"
+      << "               (default 16)\n"
+      << "  -h           this help\n";
+  }
+
+  /// Serve on path until SIGINT or SIGTERM
+  int serve(const std::string& path,const anpi::service::settings& s,
+            const bool quiet) {
+    // the threads of the server inherit the blocked signals, so that
+    // only sigwait below sees them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals,SIGINT);
+    sigaddset(&signals,SIGTERM);
+    pthread_sigmask(SIG_BLOCK,&signals,0);
+
+    anpi::service::server srv(path,s);
+    if (!quiet) {
+      std::cerr << "Serving " << s.solve.method << " on " << path
+                << std::endl;
+    }
+    int sig = 0;
+    sigwait(&signals,&sig);
+    srv.stop();
+    if (!quiet) {
+      std::cerr << srv.requests() << " requests in " << srv.batches()
+                << " batches" << std::endl;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  /// Run the load generator against the server on path
+  int load(const std::string& path,std::istream* in,const uint64_t n,
+           const unsigned int connections,const unsigned int depth) {
+    std::vector<std::string> lines;
+    if (in) {
+      std::string line;
+      while (std::getline(*in,line)) {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first != std::string::npos && line[first] != '#') {
+          lines.push_back(line);
+        }
+      }
+    } else {
+      for (int i=0;i<4096;++i) {
+        lines.push_back("corpus 1 " + std::to_string(i));
+      }
+    }
+
+    const anpi::service::loadReport r =
+      anpi::service::load(path,lines,n,connections,depth);
+    std::cout << r.requests << " requests in " << r.seconds << " s, "
+              << uint64_t(double(r.requests)/r.seconds) << " requests/s\n"
+              << "latency us: p50 " << r.p50 << ", p99 " << r.p99
+              << ", p99.9 " << r.p999 << ", max " << r.max << "\n"
+              << "server us: queue " << r.queue << ", solve " << r.solve
+              << ", mean batch " << r.batch << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+} // namespace
+
+int main(int argc,char* argv[]) {
+  std::ios::sync_with_stdio(false);
+  ANPI_PROFILE_THREAD("main");
+
+  anpi::batch::options opts;
+  bool quiet = false;
+  std::string serveOn,loadOn;
+  unsigned int delay = 100u;
+  uint64_t requests = 100000u;
+  unsigned int connections = 4u,depth = 16u;
+  bool sharded = false;
+  anpi::batch::shardSettings shards;
+  std::string files[2] = { "-", "-" };
+  int nfiles = 0;
+
+  for (int i=1;i<argc;++i) {
+    const std::string arg(argv[i]);
+    if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (arg == "-q") {
+      quiet = true;
+    } else if (arg == "-a") {
+      opts.pin = true;
+    } else if (arg.size() == 2u && arg[0] == '-' &&
+               std::string("mebtcwslunkprif").find(arg[1]) != std::string::npos) {
+      if (i+1 >= argc) {
+        std::cerr << "Missing value of " << arg << std::endl;
+        return EXIT_FAILURE;
+      }
+      const char* v = argv[++i];
+      switch (arg[1]) {
+      case 'm': opts.method  = v; break;
+      case 'e': opts.eps     = std::atof(v); break;
+      case 'b': opts.budget  = size_t(std::strtoul(v,0,10)); break;
+      case 't': opts.threads = unsigned(std::strtoul(v,0,10)); break;
+      case 'c': opts.chunk   = size_t(std::strtoul(v,0,10)); break;
+      case 'w': opts.window  = size_t(std::strtoul(v,0,10)); break;
+      case 's': serveOn = v; break;
+      case 'l': loadOn  = v; break;
+      case 'u': delay   = unsigned(std::strtoul(v,0,10)); break;
+      case 'n': requests = std::strtoull(v,0,10); break;
+      case 'k': connections = unsigned(std::strtoul(v,0,10)); break;
+      case 'p': depth   = unsigned(std::strtoul(v,0,10)); break;
+      case 'r': opts.checkpoint = v; break;
+      case 'i': opts.interval = std::atof(v); break;
+      case 'f':
+        sharded = true;
+        shards.processes = unsigned(std::strtoul(v,0,10));
+        break;
+      }
+    } else if (arg.size() > 1u && arg[0] == '-') {
+      std::cerr << "Unknown option " << arg << std::endl;
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    } else if (nfiles < 2) {
+      files[nfiles++] = arg;
+    } else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!serveOn.empty()) {
+    anpi::service::settings s;
+    s.solve = opts;
+    s.delay = delay;
+    try {
+      return serve(serveOn,s,quiet);
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (files[0] != "-" && files[1] != "-" &&
+      anpi::batch::sameFile(files[0],files[1])) {
+    std::cerr << "Output " << files[1] << " is the input file" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (loadOn.empty() && files[0] != "-" &&
+      anpi::columnFile::isColumnFile(files[0])) {
+    if (files[1] == "-") {
+      std::cerr << "Column input needs an output file" << std::endl;
+      return EXIT_FAILURE;
+    }
+    try {
+      if (sharded) {
+        anpi::batch::runSharded(files[0],files[1],opts,shards,
+                                quiet ? 0 : &std::cerr);
+      } else {
+        anpi::batch::runColumns(files[0],files[1],opts,
+                                quiet ? 0 : &std::cerr);
+      }
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (sharded && serveOn.empty() && loadOn.empty()) {
+    std::cerr << "Worker processes need a column file input" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!opts.checkpoint.empty() && loadOn.empty()) {
+    if (files[0] == "-" || files[1] == "-") {
+      std::cerr << "Checkpoints need input and output files" << std::endl;
+      return EXIT_FAILURE;
+    }
+    try {
+      anpi::batch::runText(files[0],files[1],opts,quiet ? 0 : &std::cerr);
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  std::ifstream fin;
+  if (files[0] != "-") {
+    fin.open(files[0].c_str());
+    if (!fin) {
+      std::cerr << "Cannot read " << files[0] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::ofstream fout;
+  if (files[1] != "-") {
+    fout.open(files[1].c_str());
+    if (!fout) {
+      std::cerr << "Cannot write " << files[1] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  try {
+    if (!loadOn.empty()) {
+      return load(loadOn,fin.is_open() ? &fin : 0,requests,connections,
+                  depth);
+    }
+    anpi::batch::run(fin.is_open() ? static_cast<std::istream&>(fin)
+                                   : std::cin,
+                     fout.is_open() ? static_cast<std::ostream&>(fout)
+                                    : std::cout,
+                     opts,
+                     quiet ? 0 : &std::cerr);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
 }
-  
@@ -41,6 +41,35 @@ BOOST_AUTO_TEST_CASE( Allocation ) {
   
 }
 
+BOOST_AUTO_TEST_CASE( HugePages ) {
+
+  typedef anpi::huge_page_row_allocator<float,32> alloc_type;
+  alloc_type alloc;
+
+  { // small blocks use the aligned allocator
+    alloc_type::pointer ptr = alloc.allocate(1024);
+    size_t ptrcst = reinterpret_cast<size_t>(ptr);
+
+    BOOST_CHECK( ptrcst % 32 == 0);
+    ptr[1023] = 1.f;
+
+    alloc.deallocate(ptr,1024);
+  }
+
+  { // large blocks are mapped directly
+    const size_t n = 3*anpi::HugePageSize/sizeof(float) + 5;
+    alloc_type::pointer ptr = alloc.allocate(n);
+    size_t ptrcst = reinterpret_cast<size_t>(ptr);
+
+    BOOST_CHECK( ptrcst % 32 == 0);
+    ptr[0]   = 1.f;
+    ptr[n-1] = 2.f;
+    BOOST_CHECK( ptr[n-1] == 2.f );
+
+    alloc.deallocate(ptr,n);
+  }
+}
+
 BOOST_AUTO_TEST_CASE( Checks ) {
   BOOST_CHECK(!anpi::is_aligned_alloc<std::allocator<float> >::value );
   bool val = anpi::is_aligned_alloc<anpi::aligned_allocator<float,16> >::value;
@@ -67,9 +96,68 @@ BOOST_AUTO_TEST_CASE( Checks ) {
     BOOST_CHECK(ext::value==32);
     BOOST_CHECK(ext::aligned == true );
     BOOST_CHECK(ext::row_aligned == true );
+    BOOST_CHECK(ext::first_touch == false );
   }
 
-  
+  {
+    typedef anpi::extract_alignment<anpi::huge_page_allocator<float,64> > ext;
+    BOOST_CHECK(ext::value==64);
+    BOOST_CHECK(ext::aligned == true );
+    BOOST_CHECK(ext::row_aligned == false );
+    BOOST_CHECK(ext::first_touch == false );
+  }
+
+  {
+    typedef anpi::extract_alignment<anpi::huge_page_row_allocator<int,32> > ext;
+    BOOST_CHECK(ext::value==32);
+    BOOST_CHECK(ext::aligned == true );
+    BOOST_CHECK(ext::row_aligned == true );
+    BOOST_CHECK(ext::first_touch == true );
+  }
+
+  val = anpi::is_aligned_alloc<anpi::huge_page_row_allocator<float,16> >::value;
+  BOOST_CHECK(val);
+}
+
+BOOST_AUTO_TEST_CASE( Statistics ) {
+  typedef anpi::allocationStats as;
+  as& stats = as::instance();
+
+  // counters are process-wide: check differences only
+  const as::snapshot before = stats.read();
+  stats.resetPeak();
+  stats.allocated(as::Heap,100u);
+  stats.allocated(as::Anpi,300u);
+  stats.freed(as::Heap,100u);
+  stats.allocated(as::Heap,50u);
+  stats.freed(as::Heap,50u);
+  stats.freed(as::Anpi,300u);
+  const as::snapshot after = stats.read();
+
+  BOOST_CHECK_EQUAL(after.allocations[as::Heap] - before.allocations[as::Heap],
+                    2u);
+  BOOST_CHECK_EQUAL(after.bytes[as::Heap] - before.bytes[as::Heap],150u);
+  BOOST_CHECK_EQUAL(after.allocations[as::Anpi] - before.allocations[as::Anpi],
+                    1u);
+  BOOST_CHECK_EQUAL(after.deallocations[as::Anpi] -
+                    before.deallocations[as::Anpi],1u);
+  BOOST_CHECK_EQUAL(after.current,before.current);
+  BOOST_CHECK(after.peak >= before.current + 400u);
+
+  if (as::enabled()) {
+    // the anpi allocators report their blocks
+    const as::snapshot b = stats.read();
+    anpi::aligned_allocator<double> alloc;
+    double* ptr = alloc.allocate(1000);
+    const as::snapshot m = stats.read();
+    alloc.deallocate(ptr,1000);
+    const as::snapshot a = stats.read();
+    BOOST_CHECK_EQUAL(m.allocations[as::Anpi] - b.allocations[as::Anpi],1u);
+    BOOST_CHECK_EQUAL(m.bytes[as::Anpi] - b.bytes[as::Anpi],
+                      1000u*sizeof(double));
+    BOOST_CHECK_EQUAL(a.deallocations[as::Anpi] - b.deallocations[as::Anpi],
+                      1u);
+  }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
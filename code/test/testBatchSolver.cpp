@@ -0,0 +1,245 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "BatchSolver.hpp"
+#include "ReorderBuffer.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+BOOST_AUTO_TEST_SUITE( BatchSolver )
+
+BOOST_AUTO_TEST_CASE(Parse)
+{
+  anpi::batch::problem p;
+
+  BOOST_REQUIRE(anpi::batch::parseProblem("poly 0 2 -2 0 1",p));
+  BOOST_CHECK_EQUAL(p.a,0.);
+  BOOST_CHECK_EQUAL(p.b,2.);
+  BOOST_CHECK_EQUAL(p.x0,1.);
+  BOOST_CHECK_EQUAL(p.f(3.),7.);
+
+  BOOST_REQUIRE(anpi::batch::parseProblem("  corpus 5 17\r",p));
+  const anpi::equation<double> e = anpi::equationCorpus<double>(5u)[17u];
+  BOOST_CHECK_EQUAL(p.a,e.a);
+  BOOST_CHECK_EQUAL(p.f(0.25),e(0.25));
+
+  BOOST_REQUIRE(anpi::batch::parseProblem("expr 0 2 abs(x)-exp(-x)",p));
+  BOOST_CHECK_EQUAL(p.b,2.);
+  BOOST_CHECK_EQUAL(p.f(1.5),1.5-std::exp(-1.5));
+  BOOST_REQUIRE(anpi::batch::parseProblem("expr -1 1 x^3 - x/2",p));
+  BOOST_CHECK_EQUAL(p.f(1.),0.5);
+
+  BOOST_CHECK(!anpi::batch::parseProblem("expr 0 1 sin(",p));
+  BOOST_CHECK(!anpi::batch::parseProblem("expr 0 1",p));
+  BOOST_CHECK(!anpi::batch::parseProblem("poly 2 0 1",p));    // reversed
+  BOOST_CHECK(!anpi::batch::parseProblem("poly 0 1",p));      // no terms
+  BOOST_CHECK(!anpi::batch::parseProblem("poly 0 1 x",p));
+  BOOST_CHECK(!anpi::batch::parseProblem("corpus 1",p));
+  BOOST_CHECK(!anpi::batch::parseProblem("sin(x)",p));
+
+  BOOST_CHECK_THROW(anpi::batch::findSolver("regula"),anpi::Exception);
+}
+
+BOOST_AUTO_TEST_CASE(Reorder)
+{
+  const uint64_t n = 5000u;
+  anpi::reorderBuffer<uint64_t> buffer(8u);
+
+  // the producers finish in any order, the consumer sees them in order
+  std::vector<std::thread> producers;
+  for (int t=0;t<4;++t) {
+    producers.push_back(std::thread([&buffer,t]() {
+      std::srand(unsigned(t));
+      for (uint64_t i=0;i<n/4u;++i) {
+        const uint64_t seq = buffer.reserve();
+        if (std::rand() % 4 == 0) std::this_thread::yield();
+        buffer.put(seq,seq*seq);
+      }
+    }));
+  }
+
+  uint64_t expected = 0u;
+  std::thread consumer([&]() {
+    uint64_t v;
+    while (buffer.take(v)) {
+      BOOST_CHECK_EQUAL(v,expected*expected);
+      ++expected;
+    }
+  });
+
+  for (size_t t=0;t<producers.size();++t) producers[t].join();
+  buffer.close();
+  consumer.join();
+  BOOST_CHECK_EQUAL(expected,n);
+}
+
+BOOST_AUTO_TEST_CASE(Run)
+{
+  std::ostringstream input;
+  input << "# roots of x^2 - k\n";
+  for (int k=1;k<=500;++k) {
+    input << "poly 0 " << k+1 << " " << -k << " 0 1\n";
+    if (k % 100 == 0) {
+      input << "\n" << "poly 1 0 1\n" << "corpus 3 " << k << "\n";
+    }
+  }
+
+  anpi::batch::options serial;
+  serial.threads = 1u;
+  std::istringstream in1(input.str());
+  std::ostringstream out1;
+  const anpi::batch::summary s1 = anpi::batch::run(in1,out1,serial);
+
+  // tiny chunks and window on many threads give the same output
+  anpi::batch::options parallel;
+  parallel.threads = 4u;
+  parallel.chunk = 3u;
+  parallel.window = 2u;
+  std::istringstream in2(input.str());
+  std::ostringstream out2;
+  const anpi::batch::summary s2 = anpi::batch::run(in2,out2,parallel);
+
+  BOOST_CHECK(out1.str() == out2.str());
+  BOOST_CHECK_EQUAL(s1.lines,s2.lines);
+  BOOST_CHECK_EQUAL(s1.lines,1u + 500u + 15u);
+  BOOST_CHECK_EQUAL(s2.solved + s2.failed,500u + 10u);
+  BOOST_CHECK_EQUAL(s1.solved,s2.solved);
+  BOOST_CHECK(s2.solved >= 500u);
+  BOOST_CHECK(s2.failed >= 5u);   // the invalid lines
+
+  // every output line answers the input line in the same position
+  std::istringstream res(out2.str());
+  std::istringstream src(input.str());
+  std::string line,answer;
+  int k = 0;
+  while (std::getline(src,line) && std::getline(res,answer)) {
+    if (line.compare(0u,7u,"poly 0 ") == 0) {
+      ++k;
+      const double x = std::strtod(answer.c_str(),0);
+      BOOST_CHECK_CLOSE(x,std::sqrt(double(k)),1.e-6);
+      BOOST_CHECK(answer.find(" ok") != std::string::npos);
+    } else if (line == "poly 1 0 1") {
+      BOOST_CHECK_EQUAL(answer,"nan 0 invalid");
+    } else if (line.empty() || line[0] == '#') {
+      BOOST_CHECK_EQUAL(answer,line);
+    }
+  }
+  BOOST_CHECK_EQUAL(k,500);
+}
+
+BOOST_AUTO_TEST_CASE(Columns)
+{
+  const std::string base = "/tmp/anpi-batch-" + std::to_string(::getpid());
+  const uint64_t rows = 3000u;
+  const anpi::batch::solverType brent = anpi::batch::findSolver("brent");
+  anpi::batch::options opts;
+  opts.threads = 3u;
+  opts.chunk = 7u;
+
+  // polynomials x^2 - k in [0,k+1], and one reversed bracket
+  typedef anpi::columnFile::columnSpec spec;
+  {
+    std::vector<spec> s;
+    s.push_back(spec("a",anpi::Float64));
+    s.push_back(spec("b",anpi::Float64));
+    s.push_back(spec("c0",anpi::Float64));
+    s.push_back(spec("c1",anpi::Float64));
+    s.push_back(spec("c2",anpi::Float64));
+    anpi::columnFile f(base + ".poly",rows,s);
+    double* a = f.writableColumn<double>("a");
+    double* b = f.writableColumn<double>("b");
+    double* c0 = f.writableColumn<double>("c0");
+    double* c1 = f.writableColumn<double>("c1");
+    double* c2 = f.writableColumn<double>("c2");
+    for (uint64_t i=0;i<rows;++i) {
+      a[i] = 0.;
+      b[i] = double(i + 2u);
+      c0[i] = -double(i + 1u);
+      c1[i] = 0.;
+      c2[i] = 1.;
+    }
+    a[5] = 10.;
+  }
+  const anpi::batch::summary s1 =
+    anpi::batch::runColumns(base + ".poly",base + ".roots",opts);
+  BOOST_CHECK_EQUAL(s1.lines,rows);
+  BOOST_CHECK_EQUAL(s1.solved,rows - 1u);
+  {
+    const anpi::columnFile r(base + ".roots");
+    BOOST_REQUIRE_EQUAL(r.rows(),rows);
+    const double* root = r.column<double>("root");
+    const uint8_t* status = r.column<uint8_t>("status");
+    const uint32_t* evaluations = r.column<uint32_t>("evaluations");
+    for (uint64_t i=0;i<rows;++i) {
+      if (i == 5u) {
+        BOOST_CHECK_EQUAL(int(status[i]),int(anpi::batch::Invalid));
+        continue;
+      }
+      BOOST_CHECK_EQUAL(int(status[i]),int(anpi::batch::Solved));
+      BOOST_CHECK_CLOSE(root[i],std::sqrt(double(i + 1u)),1.e-6);
+      BOOST_CHECK(evaluations[i] > 0u);
+    }
+  }
+
+  // corpus equations give the same results as the text lines
+  {
+    std::vector<spec> s;
+    s.push_back(spec("seed",anpi::UInt64));
+    s.push_back(spec("index",anpi::UInt64));
+    anpi::columnFile f(base + ".corpus",rows,s);
+    uint64_t* seed = f.writableColumn<uint64_t>("seed");
+    uint64_t* index = f.writableColumn<uint64_t>("index");
+    for (uint64_t i=0;i<rows;++i) {
+      seed[i] = 3u;
+      index[i] = i;
+    }
+  }
+  anpi::batch::runColumns(base + ".corpus",base + ".roots",opts);
+  {
+    const anpi::columnFile r(base + ".roots");
+    const double* root = r.column<double>("root");
+    const uint8_t* status = r.column<uint8_t>("status");
+    const uint32_t* evaluations = r.column<uint32_t>("evaluations");
+    for (uint64_t i=0;i<rows;i+=13u) {
+      const anpi::batch::outcome o =
+        anpi::batch::solveProblem("corpus 3 " + std::to_string(i),
+                                  brent,opts);
+      BOOST_CHECK_EQUAL(int(status[i]),int(o.status));
+      BOOST_CHECK_EQUAL(evaluations[i],o.evaluations);
+      if (o.status == anpi::batch::Solved) {
+        BOOST_CHECK_EQUAL(root[i],o.root);
+      }
+    }
+  }
+
+  // no such input
+  BOOST_CHECK_THROW(anpi::batch::runColumns(base + ".missing",
+                                            base + ".roots",opts),
+                    anpi::Exception);
+
+  // writing the output over the input is refused, leaving it intact
+  BOOST_CHECK_THROW(anpi::batch::runColumns(base + ".corpus",
+                                            base + ".corpus",opts),
+                    anpi::Exception);
+  BOOST_CHECK(anpi::columnFile::isColumnFile(base + ".corpus"));
+
+  std::remove((base + ".poly").c_str());
+  std::remove((base + ".corpus").c_str());
+  std::remove((base + ".roots").c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
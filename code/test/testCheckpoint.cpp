@@ -0,0 +1,249 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "BatchSolver.hpp"
+#include "Checkpoint.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace anpi {
+  namespace test {
+
+    inline std::string tempPath(const std::string& name) {
+      return "/tmp/anpi-" + name + "-" + std::to_string(::getpid());
+    }
+
+    inline std::string readFile(const std::string& path) {
+      std::ifstream f(path.c_str(),std::ios::binary);
+      std::ostringstream s;
+      s << f.rdbuf();
+      return s.str();
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( Checkpoint )
+
+BOOST_AUTO_TEST_CASE(Format)
+{
+  const std::string path = anpi::test::tempPath("ckp");
+  anpi::batch::checkpointState s;
+  s.fingerprint = anpi::batch::fingerprint("job");
+  s.lines = 12u;
+  s.inputOffset = 345u;
+  s.outputOffset = 678u;
+  s.solved = 10u;
+  s.failed = 2u;
+  s.ranges.push_back(std::make_pair(uint64_t(0u),uint64_t(64u)));
+  s.ranges.push_back(std::make_pair(uint64_t(128u),uint64_t(130u)));
+  anpi::batch::writeCheckpoint(path,s);
+  BOOST_CHECK_EQUAL(::access((path + ".tmp." + std::to_string(::getpid())).c_str(),
+                             F_OK),-1);
+
+  anpi::batch::checkpointState r;
+  BOOST_REQUIRE(anpi::batch::readCheckpoint(path,r));
+  BOOST_CHECK_EQUAL(r.fingerprint,s.fingerprint);
+  BOOST_CHECK_EQUAL(r.lines,12u);
+  BOOST_CHECK_EQUAL(r.inputOffset,345u);
+  BOOST_CHECK_EQUAL(r.outputOffset,678u);
+  BOOST_CHECK_EQUAL(r.solved,10u);
+  BOOST_CHECK_EQUAL(r.failed,2u);
+  BOOST_CHECK(r.ranges == s.ranges);
+
+  // a flipped byte is detected
+  {
+    std::string bytes = anpi::test::readFile(path);
+    bytes[20] ^= 1;
+    std::ofstream f(path.c_str(),std::ios::binary);
+    f << bytes;
+  }
+  BOOST_CHECK_THROW(anpi::batch::readCheckpoint(path,r),anpi::Exception);
+  std::remove(path.c_str());
+  BOOST_CHECK(!anpi::batch::readCheckpoint(path,r));
+}
+
+BOOST_AUTO_TEST_CASE(Checkpointer)
+{
+  const std::string path = anpi::test::tempPath("saver");
+  std::atomic<int> snapshots(0);
+  {
+    anpi::batch::checkpointer saver(path,0.01,
+                                    [&](anpi::batch::checkpointState& s) {
+                                      s.lines = uint64_t(++snapshots);
+                                    });
+    while (saver.written() < 3u) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    BOOST_CHECK(saver.error().empty());
+  }
+  BOOST_CHECK_THROW(anpi::batch::checkpointer("/nonexistent-anpi-dir/ckp",0.01,
+                      [](anpi::batch::checkpointState&) {}),
+                    anpi::Exception);
+  anpi::batch::checkpointState r;
+  BOOST_REQUIRE(anpi::batch::readCheckpoint(path,r));
+  BOOST_CHECK(r.lines >= 3u);
+  BOOST_CHECK(r.lines <= uint64_t(snapshots.load()));
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(ResumeText)
+{
+  const std::string input = anpi::test::tempPath("text.in");
+  const std::string output = anpi::test::tempPath("text.out");
+  const std::string full = anpi::test::tempPath("text.full");
+  const std::string ckp = anpi::test::tempPath("text.ckp");
+
+  std::vector<std::string> lines;
+  for (int k=1;k<=300;++k) {
+    lines.push_back("poly 0 " + std::to_string(k+1) + " " +
+                    std::to_string(-k) + " 0 1");
+    if (k % 50 == 0) lines.push_back("# comment");
+  }
+  {
+    std::ofstream f(input.c_str());
+    for (size_t i=0;i<lines.size();++i) f << lines[i] << '\n';
+  }
+
+  anpi::batch::options opts;
+  opts.threads = 2u;
+  opts.chunk = 16u;
+  anpi::batch::runText(input,full,opts);
+  const std::string expected = anpi::test::readFile(full);
+
+  // state after the first 100 lines, with half written output after it,
+  // as left by a crash
+  const size_t n = 100u;
+  anpi::batch::checkpointState s;
+  {
+    struct stat st;
+    BOOST_REQUIRE_EQUAL(::stat(input.c_str(),&st),0);
+    s.fingerprint = anpi::batch::jobFingerprint("text",opts,
+                                                uint64_t(st.st_size));
+  }
+  s.lines = n;
+  size_t pos = 0u;
+  for (size_t i=0;i<n;++i) {
+    s.inputOffset += lines[i].size() + 1u;
+    pos = expected.find('\n',pos) + 1u;
+    if (lines[i][0] != '#') ++s.solved;
+  }
+  s.outputOffset = pos;
+  anpi::batch::writeCheckpoint(ckp,s);
+  {
+    std::ofstream f(output.c_str(),std::ios::binary);
+    f << expected.substr(0u,pos) << "0.5 3 o";
+  }
+
+  opts.checkpoint = ckp;
+  const anpi::batch::summary sum = anpi::batch::runText(input,output,opts);
+  BOOST_CHECK(anpi::test::readFile(output) == expected);
+  BOOST_CHECK_EQUAL(sum.lines,lines.size());
+  BOOST_CHECK_EQUAL(sum.solved,300u);
+  BOOST_CHECK_EQUAL(::access(ckp.c_str(),F_OK),-1); // done
+
+  // a checkpoint of another job is refused
+  opts.eps = 1.e-6;
+  anpi::batch::writeCheckpoint(ckp,s);
+  BOOST_CHECK_THROW(anpi::batch::runText(input,output,opts),anpi::Exception);
+
+  // a checkpoint that cannot be written stops the job before it starts
+  opts.checkpoint = "/nonexistent-anpi-dir/ckp";
+  std::remove(output.c_str());
+  BOOST_CHECK_THROW(anpi::batch::runText(input,output,opts),anpi::Exception);
+  BOOST_CHECK_EQUAL(anpi::test::readFile(output),"");
+
+  std::remove(input.c_str());
+  std::remove(output.c_str());
+  std::remove(full.c_str());
+  std::remove(ckp.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(ResumeColumns)
+{
+  const std::string input = anpi::test::tempPath("cols.in");
+  const std::string output = anpi::test::tempPath("cols.out");
+  const std::string full = anpi::test::tempPath("cols.full");
+  const std::string ckp = anpi::test::tempPath("cols.ckp");
+  const uint64_t rows = 1000u;
+
+  {
+    std::vector<anpi::columnFile::columnSpec> spec;
+    spec.push_back(anpi::columnFile::columnSpec("seed",anpi::UInt64));
+    spec.push_back(anpi::columnFile::columnSpec("index",anpi::UInt64));
+    anpi::columnFile f(input,rows,spec);
+    uint64_t* seed = f.writableColumn<uint64_t>("seed");
+    uint64_t* index = f.writableColumn<uint64_t>("index");
+    for (uint64_t i=0;i<rows;++i) {
+      seed[i] = 9u;
+      index[i] = i;
+    }
+  }
+
+  anpi::batch::options opts;
+  opts.threads = 3u;
+  opts.chunk = 32u;
+  opts.checkpoint = ckp;
+  opts.interval = 0.001;
+  anpi::batch::runColumns(input,full,opts);
+  BOOST_CHECK_EQUAL(::access(ckp.c_str(),F_OK),-1);
+
+  // chunks 0-1 and 5 are done, marked with a root no solver gives
+  {
+    std::vector<anpi::columnFile::columnSpec> spec;
+    spec.push_back(anpi::columnFile::columnSpec("root",anpi::Float64));
+    spec.push_back(anpi::columnFile::columnSpec("evaluations",anpi::UInt32));
+    spec.push_back(anpi::columnFile::columnSpec("status",anpi::UInt8));
+    anpi::columnFile f(output,rows,spec);
+    double* root = f.writableColumn<double>("root");
+    for (uint64_t i=0;i<rows;++i) root[i] = -1.e300;
+  }
+  anpi::batch::checkpointState s;
+  s.fingerprint = anpi::batch::jobFingerprint("columns",opts,rows);
+  s.ranges.push_back(std::make_pair(uint64_t(0u),uint64_t(64u)));
+  s.ranges.push_back(std::make_pair(uint64_t(160u),uint64_t(192u)));
+  anpi::batch::writeCheckpoint(ckp,s);
+
+  anpi::batch::runColumns(input,output,opts);
+  BOOST_CHECK_EQUAL(::access(ckp.c_str(),F_OK),-1);
+
+  const anpi::columnFile a(output);
+  const anpi::columnFile b(full);
+  const double* ra = a.column<double>("root");
+  const double* rb = b.column<double>("root");
+  const uint32_t* ea = a.column<uint32_t>("evaluations");
+  const uint32_t* eb = b.column<uint32_t>("evaluations");
+  for (uint64_t i=0;i<rows;++i) {
+    const bool skipped = i < 64u || (i >= 160u && i < 192u);
+    if (skipped) {
+      BOOST_CHECK_EQUAL(ra[i],-1.e300);
+    } else {
+      BOOST_CHECK_EQUAL(ea[i],eb[i]);
+      BOOST_CHECK(ra[i] == rb[i] || (std::isnan(ra[i]) && std::isnan(rb[i])));
+    }
+  }
+
+  opts.checkpoint = "/nonexistent-anpi-dir/ckp";
+  BOOST_CHECK_THROW(anpi::batch::runColumns(input,output,opts),
+                    anpi::Exception);
+
+  std::remove(input.c_str());
+  std::remove(output.c_str());
+  std::remove(full.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
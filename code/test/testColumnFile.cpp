@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "ColumnFile.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+BOOST_AUTO_TEST_SUITE( ColumnFile )
+
+BOOST_AUTO_TEST_CASE(Layout)
+{
+  const std::string path = "/tmp/anpi-columns-" +
+    std::to_string(::getpid()) + ".bin";
+  const uint64_t rows = 1001u;
+
+  std::vector<anpi::columnFile::columnSpec> spec;
+  spec.push_back(anpi::columnFile::columnSpec("x",anpi::Float64));
+  spec.push_back(anpi::columnFile::columnSpec("flag",anpi::UInt8));
+  spec.push_back(anpi::columnFile::columnSpec("n",anpi::UInt32));
+  spec.push_back(anpi::columnFile::columnSpec("id",anpi::UInt64));
+  {
+    anpi::columnFile out(path,rows,spec);
+    double* x = out.writableColumn<double>("x");
+    uint8_t* flag = out.writableColumn<uint8_t>("flag");
+    uint32_t* n = out.writableColumn<uint32_t>("n");
+    uint64_t* id = out.writableColumn<uint64_t>("id");
+    for (uint64_t i=0;i<rows;++i) {
+      x[i] = 0.5*double(i);
+      flag[i] = uint8_t(i & 1u);
+      n[i] = uint32_t(3u*i);
+      id[i] = i << 40;
+    }
+    out.sync();
+  }
+
+  BOOST_CHECK(anpi::columnFile::isColumnFile(path));
+  const anpi::columnFile in(path);
+  BOOST_CHECK_EQUAL(in.rows(),rows);
+  BOOST_REQUIRE_EQUAL(in.columns(),4u);
+  BOOST_CHECK_EQUAL(in.name(1),"flag");
+  BOOST_CHECK_EQUAL(in.type(2),anpi::UInt32);
+  BOOST_CHECK(!in.has("y"));
+
+  const double* x = in.column<double>("x");
+  const uint8_t* flag = in.column<uint8_t>("flag");
+  const uint32_t* n = in.column<uint32_t>("n");
+  const uint64_t* id = in.column<uint64_t>("id");
+  BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(flag) %
+                    anpi::columnFile::Alignment,0u);
+  BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(id) %
+                    anpi::columnFile::Alignment,0u);
+  for (uint64_t i=0;i<rows;++i) {
+    BOOST_CHECK_EQUAL(x[i],0.5*double(i));
+    BOOST_CHECK_EQUAL(flag[i],uint8_t(i & 1u));
+    BOOST_CHECK_EQUAL(n[i],uint32_t(3u*i));
+    BOOST_CHECK_EQUAL(id[i],i << 40);
+  }
+
+  // wrong type or name
+  BOOST_CHECK_THROW(in.column<double>("n"),anpi::Exception);
+  BOOST_CHECK_THROW(in.column<double>("y"),anpi::Exception);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(Invalid)
+{
+  const std::string path = "/tmp/anpi-invalid-" +
+    std::to_string(::getpid()) + ".bin";
+
+  {
+    std::ofstream f(path.c_str());
+    f << "poly 0 1 2 3\n";
+  }
+  BOOST_CHECK(!anpi::columnFile::isColumnFile(path));
+  BOOST_CHECK_THROW(anpi::columnFile f(path),anpi::Exception);
+
+  // a header promising more rows than the file holds
+  std::vector<anpi::columnFile::columnSpec> spec;
+  spec.push_back(anpi::columnFile::columnSpec("x",anpi::Float64));
+  {
+    anpi::columnFile out(path,100u,spec);
+  }
+  BOOST_REQUIRE_EQUAL(::truncate(path.c_str(),512),0);
+  BOOST_CHECK(anpi::columnFile::isColumnFile(path));
+  BOOST_CHECK_THROW(anpi::columnFile f(path),anpi::Exception);
+
+  BOOST_CHECK_THROW(anpi::columnFile f("/nonexistent/anpi.bin"),
+                    anpi::Exception);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "EquationCorpus.hpp"
+#include "RootBisection.hpp"
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace anpi {
+  namespace test {
+
+    /// Check the brackets and known roots of the first n equations
+    template<typename T>
+    void corpusTest(const size_t n) {
+      anpi::equationCorpus<T> corpus(42u);
+
+      size_t perFamily[anpi::NumEquationFamilies] = {0,0,0,0,0,0};
+
+      for (size_t i=0;i<n;++i) {
+        const anpi::equation<T> e = corpus[i];
+        ++perFamily[e.family];
+
+        // the bracket encloses the roots and the start point
+        BOOST_CHECK(e.a < e.b);
+        BOOST_CHECK(e.a <= e.x0 && e.x0 <= e.b);
+        BOOST_CHECK(e.nroots >= 1 && e.nroots <= anpi::equation<T>::MaxRoots);
+        for (int r=0;r<e.nroots;++r) {
+          BOOST_CHECK(e.a < e.roots[r] && e.roots[r] < e.b);
+        }
+
+        // with a sign change at its ends
+        BOOST_CHECK(e(e.a)*e(e.b) < T(0));
+
+        // and bisection lands on one of the known roots, or on the jump
+        const T eps = std::sqrt(std::numeric_limits<T>::epsilon());
+        const T x = anpi::rootBisection<T>(e,e.a,e.b,eps);
+        BOOST_CHECK(e.distance(x) <= T(8)*eps*std::max(T(1),std::abs(x)));
+      }
+
+      // families cycle with the index
+      for (int f=0;f<anpi::NumEquationFamilies;++f) {
+        BOOST_CHECK(perFamily[f] >= n/anpi::NumEquationFamilies);
+      }
+    }
+
+    /// The corpus depends only on the seed and the index
+    template<typename T>
+    void corpusDeterminism() {
+      anpi::equationCorpus<T> c1(7u), c2(7u), c3(8u);
+
+      // generate in different orders
+      std::vector< anpi::equation<T> > reversed(64);
+      for (size_t i=64;i-- > 0;) {
+        reversed[i] = c2[i];
+      }
+      for (size_t i=0;i<64;++i) {
+        const anpi::equation<T> e = c1[i];
+        BOOST_CHECK(e.family == reversed[i].family);
+        BOOST_CHECK(e.a == reversed[i].a && e.b == reversed[i].b);
+        BOOST_CHECK(e.x0 == reversed[i].x0);
+        BOOST_CHECK(e.roots[0] == reversed[i].roots[0]);
+      }
+
+      // other seeds give other equations
+      size_t same=0;
+      for (size_t i=0;i<64;++i) {
+        if (c1[i].roots[0] == c3[i].roots[0]) ++same;
+      }
+      BOOST_CHECK(same == 0u);
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( EquationCorpus )
+
+BOOST_AUTO_TEST_CASE(Brackets)
+{
+  anpi::test::corpusTest<float>(600);
+  anpi::test::corpusTest<double>(600);
+}
+
+BOOST_AUTO_TEST_CASE(Determinism)
+{
+  anpi::test::corpusDeterminism<float>();
+  anpi::test::corpusDeterminism<double>();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
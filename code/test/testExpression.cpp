@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Expression.hpp"
+#include "RootBrent.hpp"
+#include "RootNewtonRaphson.hpp"
+
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace anpi {
+  namespace test {
+
+    /**
+     * Compare an expression with the native function at a few points.
+     *
+     * The tolerance is relative to the size of the terms, given by
+     * magnitude, or to the result if there is none: the bytecode and the
+     * native function may round differently (e.g. with FMA), and
+     * cancellation turns that into a large relative error of the result.
+     */
+    template<typename T>
+    void checkExpression(const std::string& text,
+                         const std::function<T(T)>& native,
+                         const std::function<T(T)>& magnitude =
+                           std::function<T(T)>()) {
+      const anpi::expression<T> f(text);
+      for (int i=-20;i<=20;++i) {
+        const T x = T(0.173)*T(i) + T(0.05);
+        const T e = native(x);
+        if (std::isnan(e)) {
+          BOOST_CHECK(std::isnan(f(x)));
+        } else {
+          const T m = magnitude ? magnitude(x) : std::abs(e);
+          BOOST_CHECK_MESSAGE(std::abs(f(x) - e) <=
+                              T(4)*std::numeric_limits<T>::epsilon()*
+                              std::max(T(1),m),
+                              text << " at " << x << ": " << f(x)
+                              << " != " << e);
+        }
+      }
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( Expression )
+
+BOOST_AUTO_TEST_CASE(Syntax)
+{
+  using anpi::test::checkExpression;
+  typedef std::function<double(double)> f_type;
+
+  checkExpression<double>("abs(x)-exp(-x)",
+                          f_type([](double x) {
+                              return std::abs(x)-std::exp(-x); }));
+  checkExpression<double>("-x^2 + 2*x - 3/4",
+                          f_type([](double x) {
+                              return -(x*x) + 2*x - 0.75; }));
+  checkExpression<double>("2^x^2",
+                          f_type([](double x) {
+                              return std::pow(2.,x*x); }));
+  checkExpression<double>("atan2(sin(x), cos(x)) + max(x, 0.5)*min(1, x)",
+                          f_type([](double x) {
+                              return std::atan2(std::sin(x),std::cos(x)) +
+                                std::max(x,0.5)*std::min(1.,x); }));
+  checkExpression<double>("log(x)+sqrt(x)*cbrt(x)-log10(x)",
+                          f_type([](double x) {
+                              return std::log(x)+std::sqrt(x)*std::cbrt(x)
+                                - std::log10(x); }));
+  checkExpression<double>("tanh(x)*cosh(x)/sinh(x) + floor(x) - ceil(pi*x)",
+                          f_type([](double x) {
+                              return std::tanh(x)*std::cosh(x)/std::sinh(x)
+                                + std::floor(x) - std::ceil(M_PI*x); }));
+  checkExpression<float>("e^x - 1e1*x",
+                         std::function<float(float)>([](float x) {
+                             return std::pow(2.7182817f,x) - 10.f*x; }),
+                         std::function<float(float)>([](float x) {
+                             return std::pow(2.7182817f,x) +
+                               std::abs(10.f*x); }));
+
+  const char* bad[] = { "", "x+", "sin x", "foo(x)", "y", "(x", "pow(x)",
+                        "x)", "1..2" };
+  for (size_t i=0;i<sizeof(bad)/sizeof(bad[0]);++i) {
+    BOOST_CHECK_THROW(anpi::expression<double> e(bad[i]),anpi::Exception);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Optimizations)
+{
+  typedef anpi::expression<double> expr;
+
+  // constants are folded
+  BOOST_CHECK_EQUAL(expr("2*3+4^0.5").instructions().size(),0u);
+  BOOST_CHECK_EQUAL(expr("2*3+4^0.5")(7.),8.);
+  BOOST_CHECK_EQUAL(expr("x*(1+1)").instructions().size(),1u);
+
+  // common subexpressions are shared, also for swapped operands
+  BOOST_CHECK_EQUAL(expr("sin(x)*sin(x)").instructions().size(),2u);
+  BOOST_CHECK_EQUAL(expr("(x+1)*(1+x)").instructions().size(),2u);
+  BOOST_CHECK_EQUAL(expr("exp(-x)+exp(-x)/exp(-x)").instructions().size(),
+                    4u);
+
+  // identities
+  BOOST_CHECK_EQUAL(expr("-(-x)*1+0").instructions().size(),0u);
+  BOOST_CHECK_EQUAL(expr("x^2").instructions()[0].op,expr::Mul);
+
+  // registers are reused: a long sum needs few of them
+  std::string sum = "x";
+  for (int i=1;i<100;++i) sum += "+sin(" + std::to_string(i) + "*x)";
+  const expr s(sum);
+  BOOST_CHECK(s.registers() < 110u);
+  BOOST_CHECK_CLOSE(s(0.3),
+                    [](double x) {
+                      double r = x;
+                      for (int i=1;i<100;++i) r += std::sin(i*x);
+                      return r;
+                    }(0.3),1.e-10);
+}
+
+BOOST_AUTO_TEST_CASE(Batch)
+{
+  const anpi::expression<double> f("abs(x)-exp(-x)+x^2*sin(3*x)");
+  const anpi::expression<float>  g("abs(x)-exp(-x)+x^2*sin(3*x)");
+
+  // sizes around the number of lanes, including the tails
+  const size_t sizes[] = { 1u, 7u, anpi::expression<double>::Lanes,
+                           anpi::expression<double>::Lanes + 1u, 1001u };
+  for (size_t s=0;s<sizeof(sizes)/sizeof(sizes[0]);++s) {
+    std::vector<double> x(sizes[s]),y;
+    std::vector<float> xf(sizes[s]),yf;
+    for (size_t i=0;i<x.size();++i) {
+      x[i] = -3. + 0.01*double(i);
+      xf[i] = float(x[i]);
+    }
+    f.evaluate(x,y);
+    g.evaluate(xf,yf);
+    BOOST_REQUIRE_EQUAL(y.size(),x.size());
+    for (size_t i=0;i<x.size();++i) {
+      BOOST_CHECK_EQUAL(y[i],f(x[i]));
+      BOOST_CHECK_EQUAL(yf[i],g(xf[i]));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Solvers)
+{
+  // plugs into the solvers through std::function
+  const std::function<double(double)> f(anpi::expression<double>
+                                        ("abs(x)-exp(-x)"));
+  const double r = 0.56714329040978387; // omega constant
+  BOOST_CHECK_CLOSE(anpi::rootBrent<double>(f,0.,2.,1.e-12),r,1.e-8);
+  BOOST_CHECK_CLOSE(anpi::rootNewtonRaphson<double>(f,1.,1.e-12),r,1.e-6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Instrumentation.hpp"
+#include "RootBisection.hpp"
+
+#include <cmath>
+#include <functional>
+
+namespace anpi {
+  namespace test {
+
+    /// Function with a root at x=1
+    template<typename T>
+    T shifted(const T x) { return x - T(1); }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( Instrumentation )
+
+BOOST_AUTO_TEST_CASE(Buckets)
+{
+  typedef anpi::logHistogram h;
+
+  // every value lies in the bounds of its bucket, with relative
+  // width below 1/16
+  for (uint64_t v = 0u; v < 100000u; v = v + 1u + v/7u) {
+    const size_t b = h::index(v);
+    BOOST_CHECK(h::lowerBound(b) <= v);
+    BOOST_CHECK(v <= h::upperBound(b));
+    BOOST_CHECK(double(h::upperBound(b) - h::lowerBound(b)) <=
+                double(h::lowerBound(b))/16.);
+  }
+  BOOST_CHECK_EQUAL(h::index(15u),15u);
+  BOOST_CHECK_EQUAL(h::index(16u),16u);
+  BOOST_CHECK(h::index(~uint64_t(0u)) == h::NumBuckets-1u);
+  BOOST_CHECK(h::upperBound(h::NumBuckets-1u) == ~uint64_t(0u));
+
+  // buckets are contiguous
+  for (size_t b=1;b<h::NumBuckets;++b) {
+    BOOST_CHECK(h::lowerBound(b) == h::upperBound(b-1) + 1u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Percentiles)
+{
+  anpi::logHistogram hist;
+  for (uint64_t v=1u;v<=1000u;++v) {
+    hist.record(v);
+  }
+  BOOST_CHECK_EQUAL(hist.total(),1000u);
+  BOOST_CHECK_CLOSE(hist.mean(),500.5,1.e-9);
+  BOOST_CHECK_EQUAL(hist.min(),1u);
+  BOOST_CHECK(hist.max() >= 1000u && hist.max() < 1064u);
+
+  const uint64_t p50 = hist.percentile(0.5);
+  const uint64_t p99 = hist.percentile(0.99);
+  BOOST_CHECK(p50 >= 500u && p50 < 532u);
+  BOOST_CHECK(p99 >= 990u && p99 < 1054u);
+
+  anpi::logHistogram other;
+  other.record(7u,10u);
+  hist.merge(other);
+  BOOST_CHECK_EQUAL(hist.total(),1010u);
+
+  uint64_t count = 0u;
+  for (const auto& bk : hist.buckets()) {
+    BOOST_CHECK(bk.count > 0u);
+    count += bk.count;
+  }
+  BOOST_CHECK_EQUAL(count,1010u);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelCounts)
+{
+  typedef anpi::instrumentationState is;
+  anpi::instrumented<double> f(anpi::test::shifted<double>,
+                               is::Latency | is::Iterations);
+
+  const long n = 2000;
+  double sum = 0.;
+#pragma omp parallel for reduction(+:sum) schedule(dynamic,16)
+  for (long i=0;i<n;++i) {
+    // each copy shares the counters, as inside std::function
+    std::function<double(double)> g(f);
+    f.beginSolve();
+    sum += anpi::rootBisection<double>(g,0.,3.,1.e-6);
+    f.endSolve();
+  }
+  BOOST_CHECK_CLOSE(sum/double(n),1.,1.e-3);
+
+  const anpi::instrumentationSnapshot snap = f.snapshot();
+  BOOST_CHECK_EQUAL(snap.solves,uint64_t(n));
+  BOOST_CHECK_EQUAL(snap.latency.total(),snap.evaluations);
+  BOOST_CHECK_EQUAL(snap.iterations.total(),uint64_t(n));
+
+  // all solves are identical
+  const uint64_t perSolve = snap.evaluations/uint64_t(n);
+  BOOST_CHECK_EQUAL(snap.evaluations,perSolve*uint64_t(n));
+  BOOST_CHECK_CLOSE(snap.iterations.mean(),double(perSolve),1.e-9);
+
+  f.reset();
+  BOOST_CHECK_EQUAL(f.evaluations(),0u);
+}
+
+BOOST_AUTO_TEST_CASE(Independent)
+{
+  anpi::instrumented<float> f(anpi::test::shifted<float>);
+  anpi::instrumented<float> g(anpi::test::shifted<float>);
+
+  for (int i=0;i<10;++i) {
+    f(float(i));
+    if (i%2) g(float(i));
+  }
+  BOOST_CHECK_EQUAL(f.evaluations(),10u);
+  BOOST_CHECK_EQUAL(g.evaluations(),5u);
+
+  // without the option no histograms are collected
+  f.beginSolve();
+  f(0.f);
+  f.endSolve();
+  BOOST_CHECK_EQUAL(f.snapshot().solves,1u);
+  BOOST_CHECK_EQUAL(f.snapshot().iterations.total(),0u);
+  BOOST_CHECK_EQUAL(f.snapshot().latency.total(),0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
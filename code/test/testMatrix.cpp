@@ -66,6 +66,19 @@ typedef anpi::Matrix<double  ,aralloc> ardmatrix;
 typedef anpi::Matrix<float   ,aralloc> arfmatrix;
 typedef anpi::Matrix<int     ,aralloc> arimatrix;
 
+// huge page row aligned allocator
+typedef anpi::huge_page_row_allocator<float> hpalloc;
+
+template class anpi::Matrix<dcomplex,hpalloc>;
+template class anpi::Matrix<double  ,hpalloc>;
+template class anpi::Matrix<float   ,hpalloc>;
+template class anpi::Matrix<int     ,hpalloc>;
+
+typedef anpi::Matrix<dcomplex,hpalloc> hpcmatrix;
+typedef anpi::Matrix<double  ,hpalloc> hpdmatrix;
+typedef anpi::Matrix<float   ,hpalloc> hpfmatrix;
+typedef anpi::Matrix<int     ,hpalloc> hpimatrix;
+
 #if 1
 # define dispatchTest(func) \
   func<cmatrix>();          \
@@ -81,7 +94,12 @@ typedef anpi::Matrix<int     ,aralloc> arimatrix;
   func<arcmatrix>();        \
   func<ardmatrix>();        \
   func<arfmatrix>();        \
-  func<arimatrix>();
+  func<arimatrix>();        \
+                            \
+  func<hpcmatrix>();        \
+  func<hpdmatrix>();        \
+  func<hpfmatrix>();        \
+  func<hpimatrix>();
 
 #else
 # define dispatchTest(func) func<arfmatrix>(); 
@@ -230,6 +248,81 @@ BOOST_AUTO_TEST_CASE(Assignment)
   dispatchTest(testAssignment);
 }
 
+template<class M>
+void testCapacity() {
+  typedef typename M::value_type T;
+
+  { // shrinking and regrowing within the capacity does not allocate
+    M a(4,9,T(1));
+    const size_t cap = a.capacity();
+    const T* ptr = a.data();
+    BOOST_CHECK( cap >= a.rows()*a.dcols() );
+
+    a.allocate(3,5);
+    BOOST_CHECK( a.rows() == 3 );
+    BOOST_CHECK( a.cols() == 5 );
+    BOOST_CHECK( a.dcols() >= 5 );
+    BOOST_CHECK( a.data() == ptr );
+    BOOST_CHECK( a.capacity() == cap );
+
+    a.allocate(4,9);
+    BOOST_CHECK( a.data() == ptr );
+    BOOST_CHECK( a.dcols() >= 9 );
+
+    a.allocate(2,18);
+    BOOST_CHECK( a.rows() == 2 );
+    BOOST_CHECK( a.cols() == 18 );
+    BOOST_CHECK( a.rows()*a.dcols() <= a.capacity() );
+  }
+  { // reserve keeps shape and content
+    M a = { {1,2,3},{4,5,6} };
+    M b(a);
+    a.reserve(10,10);
+    BOOST_CHECK( a.capacity() >= 100 );
+    BOOST_CHECK( a == b );
+
+    const T* ptr = a.data();
+    a.allocate(10,10);
+    BOOST_CHECK( a.data() == ptr );
+
+    a.allocate(2,3);
+    a.fill(b);
+    a.shrink_to_fit();
+    BOOST_CHECK( a.capacity() < 100 );
+    BOOST_CHECK( a == b );
+  }
+  { // on-copy arithmetic reuses the result buffer
+    M a = { {1,2,3},{4,5,6} };
+    M b = { {7,8,9},{10,11,12} };
+    M r = { {8,10,12},{14,16,18} };
+    M c(5,5);
+    const T* ptr = c.data();
+
+    c = a + b;
+    BOOST_CHECK( c == r );
+
+    c.reserve(5,5);
+    ptr = c.data();
+    anpi::simd::add(a,b,c);
+    BOOST_CHECK( c == r );
+    BOOST_CHECK( c.data() == ptr );
+  }
+  { // swap exchanges the capacities
+    M a(8,8);
+    M b(1,1);
+    const size_t cap = a.capacity();
+    a.swap(b);
+    BOOST_CHECK( b.capacity() == cap );
+    a.clear();
+    BOOST_CHECK( a.capacity() == 0 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Capacity)
+{
+  dispatchTest(testCapacity);
+}
+
 template<class M>
 void testArithmetic() {
   
@@ -269,11 +362,249 @@ void testArithmetic() {
 
     c=a-M{ {7,8,9},{10,11,12} };
     BOOST_CHECK( c==r );
+
+    c=M{ {1,2,3},{ 4, 5, 6} } - M{ {7,8,9},{10,11,12} };
+    BOOST_CHECK( c==r );
   } 
+
+  { // temporaries lend their buffers to the result
+    M a = { {1,2,3},{ 4, 5, 6} };
+    M b = { {7,8,9},{10,11,12} };
+    M r = { {15,18,21},{24,27,30} };
+
+    M t(a);
+    const typename M::value_type* ptr = t.data();
+    M c = (std::move(t) + b) + b;
+    BOOST_CHECK( c==r );
+    BOOST_CHECK( c.data()==ptr );
+
+    t = b;
+    ptr = t.data();
+    c = a + (b + std::move(t));
+    BOOST_CHECK( c==r );
+    BOOST_CHECK( c.data()==ptr );
+
+    M s = { {-13,-14,-15},{-16,-17,-18} };
+    t = b;
+    ptr = t.data();
+    c = a - (b + std::move(t));
+    BOOST_CHECK( c==s );
+    BOOST_CHECK( c.data()==ptr );
+  }
 }
 
 BOOST_AUTO_TEST_CASE(Arithmetic) {
   dispatchTest(testArithmetic);  
 }
+
+template<class M>
+void testFillAndCompare() {
+  typedef typename M::value_type T;
+
+  // odd sizes to exercise the padding and the scalar tails
+  const size_t sizes[][2] = { {1,1}, {3,7}, {7,13}, {5,33}, {17,64} };
+
+  for (const auto& sz : sizes) {
+    M a(sz[0],sz[1],anpi::DoNotInitialize);
+    a.fill(T(3));
+    M b(sz[0],sz[1],anpi::DoNotInitialize);
+    b.fill(T(3));
+
+    bool ok=true;
+    for (size_t r=0;r<a.rows();++r) {
+      for (size_t c=0;c<a.cols();++c) {
+        ok = ok && (a(r,c) == T(3));
+      }
+    }
+    BOOST_CHECK( ok );
+    BOOST_CHECK( a==b );
+    BOOST_CHECK( anpi::approxEqual(a,b,0) );
+
+    // differences in the last entry must be detected
+    b(sz[0]-1,sz[1]-1) = T(4);
+    BOOST_CHECK( a!=b );
+    BOOST_CHECK( !anpi::approxEqual(a,b,0) );
+    BOOST_CHECK( anpi::approxEqual(a,b,2) );
+
+    // and in the first one
+    b(sz[0]-1,sz[1]-1) = T(3);
+    b(0,0) = T(2);
+    BOOST_CHECK( a!=b );
+    BOOST_CHECK( !anpi::approxEqual(a,b,0) );
+  }
+
+  { // shapes must agree
+    M a(2,3,T(1));
+    M b(3,2,T(1));
+    BOOST_CHECK( a!=b );
+    BOOST_CHECK( !anpi::approxEqual(a,b,1) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FillAndCompare)
+{
+  dispatchTest(testFillAndCompare);
+}
+
+template<class M>
+void testReductions() {
+  typedef typename M::value_type T;
+
+  const size_t sizes[][2] = { {1,1}, {3,7}, {7,13}, {5,33}, {17,64} };
+
+  for (const auto& sz : sizes) {
+    M a(sz[0],sz[1],anpi::DoNotInitialize);
+    M b(sz[0],sz[1],anpi::DoNotInitialize);
+
+    // small integers, so that all sums are exact
+    for (size_t r=0;r<a.rows();++r) {
+      for (size_t c=0;c<a.cols();++c) {
+        a(r,c) = T(int((r*7+c*3)%11) - 5);
+        b(r,c) = T(int((r+c)%3) - 1);
+      }
+    }
+
+    T rsum(0), rmin(a(0,0)), rmax(a(0,0)), rdot(0), rn1(0), rninf(0);
+    for (size_t r=0;r<a.rows();++r) {
+      for (size_t c=0;c<a.cols();++c) {
+        const T v = a(r,c);
+        rsum += v;
+        rmin = std::min(rmin,v);
+        rmax = std::max(rmax,v);
+        rdot += v*b(r,c);
+        rn1  += std::abs(v);
+        rninf = std::max(rninf,T(std::abs(v)));
+      }
+    }
+
+    BOOST_CHECK( anpi::sum(a) == rsum );
+    BOOST_CHECK( anpi::min(a) == rmin );
+    BOOST_CHECK( anpi::max(a) == rmax );
+    BOOST_CHECK( anpi::dot(a,b) == rdot );
+    BOOST_CHECK( anpi::norm1(a) == rn1 );
+    BOOST_CHECK( anpi::normInf(a) == rninf );
+
+    BOOST_CHECK( anpi::fallback::sum(a) == rsum );
+    BOOST_CHECK( anpi::fallback::dot(a,b) == rdot );
+  }
+
+  {
+    M a = { {3,0},{0,4} };
+    BOOST_CHECK( std::abs(double(anpi::norm2(a)) - 5.0) < 1.e-3 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Reductions)
+{
+  testReductions<dmatrix>();
+  testReductions<fmatrix>();
+  testReductions<admatrix>();
+  testReductions<afmatrix>();
+  testReductions<aimatrix>();
+  testReductions<ardmatrix>();
+  testReductions<arfmatrix>();
+  testReductions<arimatrix>();
+  testReductions<hpdmatrix>();
+  testReductions<hpfmatrix>();
+}
+
+template<class M>
+void testFusedKernels() {
+  typedef typename M::value_type T;
+
+  const size_t sizes[][2] = { {1,1}, {3,7}, {7,13}, {5,33}, {17,64} };
+  const T alpha(3), beta(-2);
+
+  for (const auto& sz : sizes) {
+    M x(sz[0],sz[1],anpi::DoNotInitialize);
+    M y(sz[0],sz[1],anpi::DoNotInitialize);
+
+    // small integers, so that fused and unfused results are exact
+    for (size_t r=0;r<x.rows();++r) {
+      for (size_t c=0;c<x.cols();++c) {
+        x(r,c) = T(int((r*7+c*3)%11) - 5);
+        y(r,c) = T(int((r+c)%3) - 1);
+      }
+    }
+
+    M rax(sz[0],sz[1]),rsc(sz[0],sz[1]),rha(sz[0],sz[1]),rlc(sz[0],sz[1]);
+    for (size_t r=0;r<x.rows();++r) {
+      for (size_t c=0;c<x.cols();++c) {
+        rax(r,c) = alpha*x(r,c) + y(r,c);
+        rsc(r,c) = alpha*x(r,c);
+        rha(r,c) = x(r,c)*y(r,c);
+        rlc(r,c) = alpha*x(r,c) + beta*y(r,c);
+      }
+    }
+
+    // on-copy
+    M z;
+    anpi::aimpl::axpy(alpha,x,y,z);
+    BOOST_CHECK( z == rax );
+    anpi::aimpl::scale(alpha,x,z);
+    BOOST_CHECK( z == rsc );
+    anpi::aimpl::hadamard(x,y,z);
+    BOOST_CHECK( z == rha );
+    anpi::aimpl::lincomb(alpha,x,beta,y,z);
+    BOOST_CHECK( z == rlc );
+
+    anpi::fallback::axpy(alpha,x,y,z);
+    BOOST_CHECK( z == rax );
+    anpi::fallback::lincomb(alpha,x,beta,y,z);
+    BOOST_CHECK( z == rlc );
+
+    // in-place
+    z = y;
+    anpi::aimpl::axpy(alpha,x,z);
+    BOOST_CHECK( z == rax );
+    z = x;
+    anpi::aimpl::scale(alpha,z);
+    BOOST_CHECK( z == rsc );
+    z = x;
+    anpi::aimpl::hadamard(z,y);
+    BOOST_CHECK( z == rha );
+    z = x;
+    anpi::aimpl::lincomb(alpha,z,beta,y);
+    BOOST_CHECK( z == rlc );
+
+    z = x;
+    anpi::fallback::hadamard(z,y);
+    BOOST_CHECK( z == rha );
+    z = x;
+    anpi::fallback::lincomb(alpha,z,beta,y);
+    BOOST_CHECK( z == rlc );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FusedKernels)
+{
+  testFusedKernels<dmatrix>();
+  testFusedKernels<fmatrix>();
+  testFusedKernels<admatrix>();
+  testFusedKernels<afmatrix>();
+  testFusedKernels<aimatrix>();
+  testFusedKernels<ardmatrix>();
+  testFusedKernels<arfmatrix>();
+  testFusedKernels<arimatrix>();
+  testFusedKernels<hpdmatrix>();
+  testFusedKernels<hpfmatrix>();
+}
+
+BOOST_AUTO_TEST_CASE(HugePages) {
+  // large enough to be mapped with huge pages and touched in parallel
+  const size_t n=1100;
+  hpfmatrix a(n,n,1.f);
+  hpfmatrix b(n,n,2.f);
+  hpfmatrix r(n,n,3.f);
+
+  BOOST_CHECK( a.dcols()*sizeof(float) % anpi::DefaultAlignment == 0 );
+  BOOST_CHECK( a(n-1,n-1) == 1.f );
+
+  a+=b;
+  BOOST_CHECK( a==r );
+
+  hpfmatrix c(n,n,anpi::DoNotInitialize);
+  BOOST_CHECK( c(n/2,n/2) == 0.f );
+}
   
 BOOST_AUTO_TEST_SUITE_END()
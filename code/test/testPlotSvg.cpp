@@ -0,0 +1,99 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "PlotSvg.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace anpi {
+  namespace test {
+
+    /// Whole content of a file
+    inline std::string readFile(const std::string& filename) {
+      std::ifstream is(filename.c_str(),std::ios::binary);
+      std::ostringstream os;
+      os << is.rdbuf();
+      return os.str();
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( PlotSvg )
+
+BOOST_AUTO_TEST_CASE(Render)
+{
+  std::vector<double> x = {0.,1.,2.,3.};
+  std::vector<double> y = {1.,3.,2.,4.};
+  std::vector<double> lo = {0.5,2.5,1.5,3.5};
+  std::vector<double> hi = {1.5,3.5,2.5,4.5};
+
+  anpi::Plot2d<double> plotter;
+  plotter.initialize(99);
+  plotter.setTitle("a < b & c");
+  plotter.setGridSize(1.);
+  plotter.plot(x,y,"line","b");
+  plotter.plot(x,y,lo,hi,"range");
+
+  const std::string svg = anpi::plot::renderSvg(anpi::plot::figures()[99]);
+  BOOST_CHECK(svg.find("<svg") != std::string::npos);
+  BOOST_CHECK(svg.find("</svg>") != std::string::npos);
+  BOOST_CHECK(svg.find("a &lt; b &amp; c") != std::string::npos);
+
+  // two curves and one band
+  size_t lines = 0, pos = 0;
+  while ((pos = svg.find("<polyline",pos)) != std::string::npos) {
+    ++lines;
+    ++pos;
+  }
+  BOOST_CHECK_EQUAL(lines,2u);
+  BOOST_CHECK(svg.find("<polygon") != std::string::npos);
+  BOOST_CHECK(svg.find("#0000ff") != std::string::npos);
+  BOOST_CHECK(svg.find("nan") == std::string::npos);
+
+  // a second plotter acts on the same figure
+  anpi::Plot2d<float> other;
+  other.initialize(99);
+  other.plot(std::vector<float>(1,1.f),std::vector<float>(1,1.f),"","");
+  BOOST_CHECK_EQUAL(anpi::plot::figures()[99].curves.size(),3u);
+
+  anpi::plot::figures().erase(99);
+}
+
+BOOST_AUTO_TEST_CASE(Npy)
+{
+  std::vector<double> data = {1.,2.,3.,4.,5.,6.};
+  const std::string name = "anpi_test_plot.npy";
+  BOOST_REQUIRE(anpi::plot::writeNpy(name,data,3,2));
+
+  const std::string npy = anpi::test::readFile(name);
+  std::remove(name.c_str());
+
+  BOOST_REQUIRE(npy.size() > 10u);
+  BOOST_CHECK(npy.compare(0,6,"\x93NUMPY") == 0);
+  const size_t hlen = size_t((unsigned char)npy[8]) +
+                      256u*size_t((unsigned char)npy[9]);
+  BOOST_CHECK_EQUAL((10u + hlen) % 64u,0u);
+
+  const std::string header = npy.substr(10,hlen);
+  BOOST_CHECK(header.find("'<f8'") != std::string::npos);
+  BOOST_CHECK(header.find("(3, 2)") != std::string::npos);
+
+  BOOST_REQUIRE_EQUAL(npy.size(),10u + hlen + data.size()*sizeof(double));
+  std::vector<double> back(data.size());
+  std::memcpy(back.data(),npy.data() + 10 + hlen,data.size()*sizeof(double));
+  BOOST_CHECK(back == data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
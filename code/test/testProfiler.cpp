@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Profiler.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace anpi {
+  namespace test {
+
+    /// Number of non overlapping occurrences of what in s
+    inline size_t occurrences(const std::string& s,const std::string& what) {
+      size_t n = 0u;
+      for (size_t p = s.find(what);p != std::string::npos;
+           p = s.find(what,p + what.size())) ++n;
+      return n;
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( Profiler )
+
+BOOST_AUTO_TEST_CASE(Buffer)
+{
+  // grows past one block, keeping the order
+  anpi::profiler::threadBuffer b(7u);
+  const size_t n = 3u*anpi::profiler::threadBuffer::BlockEvents + 5u;
+  for (size_t i=0;i<n;++i) b.record("test",(i % 2u) ? "odd" : "even",'B');
+  size_t count = 0u;
+  bool ordered = true;
+  uint64_t last = 0u;
+  b.forEach([&](const anpi::profiler::event& e) {
+      ordered = ordered && e.ns >= last &&
+        std::string(e.name) == ((count % 2u) ? "odd" : "even");
+      last = e.ns;
+      ++count;
+    });
+  BOOST_CHECK_EQUAL(count,n);
+  BOOST_CHECK(ordered);
+  BOOST_CHECK_EQUAL(b.tid(),7u);
+}
+
+BOOST_AUTO_TEST_CASE(Escape)
+{
+  BOOST_CHECK_EQUAL(anpi::jsonEscape("a\"b\\c\n"),"a\\\"b\\\\c\\u000a");
+
+  // cut before an escape sequence or a UTF-8 character that does not fit
+  BOOST_CHECK_EQUAL(anpi::jsonEscape(std::string(100u,'"'),7u),
+                    "\\\"\\\"\\\"");
+  BOOST_CHECK_EQUAL(anpi::jsonEscape("ab\xc3\xa9",3u),"ab");
+  BOOST_CHECK_EQUAL(anpi::jsonEscape("ab\xc3\xa9",4u),"ab\xc3\xa9");
+}
+
+BOOST_AUTO_TEST_CASE(Trace)
+{
+  anpi::profiler::registry& r = anpi::profiler::registry::instance();
+  std::vector<std::thread> threads;
+  for (int t=0;t<3;++t) {
+    threads.push_back(std::thread([t]() {
+      anpi::profiler::nameThread("profiled \"" + std::to_string(t) + "\"");
+      for (int i=0;i<100;++i) {
+        const anpi::profiler::scope outer("test","outer scope");
+        const anpi::profiler::scope inner("test","inner scope");
+      }
+    }));
+  }
+  for (size_t t=0;t<threads.size();++t) threads[t].join();
+
+  std::ostringstream os;
+  r.write(os);
+  const std::string s = os.str();
+  BOOST_CHECK_EQUAL(s.find("{\"displayTimeUnit\""),0u);
+  BOOST_CHECK_EQUAL(s.substr(s.size() - 4u),"\n]}\n");
+  BOOST_CHECK(s.find("\"name\":\"profiled \\\"1\\\"\"") != std::string::npos);
+  BOOST_CHECK_EQUAL(anpi::test::occurrences(s,"\"name\":\"outer scope\",\"cat\":\"test\",\"ph\":\"B\""),300u);
+  BOOST_CHECK_EQUAL(anpi::test::occurrences(s,"\"name\":\"inner scope\",\"cat\":\"test\",\"ph\":\"E\""),300u);
+  BOOST_CHECK_EQUAL(anpi::test::occurrences(s,"{"),
+                    anpi::test::occurrences(s,"}"));
+}
+
+BOOST_AUTO_TEST_CASE(Macros)
+{
+  // compiled out builds must not even evaluate the arguments
+  int evaluated = 0;
+  {
+    ANPI_PROFILE_SCOPE("test",(++evaluated,"macro"));
+    ANPI_PROFILE_THREAD((++evaluated,"macro thread"));
+  }
+#ifdef ANPI_ENABLE_PROFILER
+  BOOST_CHECK_EQUAL(evaluated,2);
+#else
+  BOOST_CHECK_EQUAL(evaluated,0);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,157 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "RootAuto.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace anpi {
+  namespace test {
+
+    /// Roots of x^3 = c for c in [1,8), bracketed in [0,3]
+    inline std::vector<anpi::tuningSample<double> > cubeSamples(const int n) {
+      std::vector<anpi::tuningSample<double> > s;
+      for (int i=0;i<n;++i) {
+        const double c = 1. + 7.*double(i)/double(n);
+        anpi::tuningSample<double> p;
+        p.f = [c](const double x) { return x*x*x - c; };
+        p.a = 0.;
+        p.b = 3.;
+        s.push_back(p);
+      }
+      return s;
+    }
+
+    /// Steep steps tanh(1000 (x-r)), where Newton-Raphson overshoots
+    inline std::vector<anpi::tuningSample<double> > stepSamples(const int n) {
+      std::vector<anpi::tuningSample<double> > s;
+      for (int i=0;i<n;++i) {
+        const double r = 0.1 + 0.8*double(i)/double(n);
+        anpi::tuningSample<double> p;
+        p.f = [r](const double x) { return std::tanh(1000.*(x - r)); };
+        p.a = -1.;
+        p.b = 2.;
+        s.push_back(p);
+      }
+      return s;
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( RootAuto )
+
+BOOST_AUTO_TEST_CASE(Calibration)
+{
+  anpi::tuningSettings settings;
+  settings.criterion = anpi::TuneEvaluations;
+  settings.repeats = 1u;
+
+  std::vector<anpi::tuningScore> scores;
+  const anpi::tuningDecision d =
+    anpi::autotune<double>("cubes",anpi::test::cubeSamples(20),1.e-10,
+                           settings,&scores);
+  BOOST_REQUIRE_EQUAL(scores.size(),size_t(anpi::NumRootMethods));
+  BOOST_CHECK_EQUAL(d.family,"cubes");
+  BOOST_CHECK_EQUAL(d.eps,1.e-10);
+  BOOST_CHECK_EQUAL(d.solvedFraction,1.);
+
+  // the chosen method needs the least evaluations of those solving all
+  for (size_t m=0;m<scores.size();++m) {
+    BOOST_CHECK(scores[m].nanoseconds > 0.);
+    if (scores[m].solved == 20u) {
+      BOOST_CHECK(scores[m].evaluations >= d.evaluations);
+    }
+  }
+  BOOST_CHECK_EQUAL(scores[size_t(d.method)].evaluations,d.evaluations);
+  BOOST_CHECK(d.budget >= 64u && d.budget <= settings.budget);
+
+  // open methods that miss the steps lose against bracketing ones
+  const anpi::tuningDecision s =
+    anpi::autotune<double>("steps",anpi::test::stepSamples(20),1.e-10,
+                           settings,&scores);
+  BOOST_CHECK(scores[anpi::NewtonRaphsonMethod].solved < 20u);
+  BOOST_CHECK(s.method != anpi::NewtonRaphsonMethod);
+  BOOST_CHECK_EQUAL(s.solvedFraction,1.);
+
+  BOOST_CHECK_THROW(anpi::autotune<double>("none",
+                      std::vector<anpi::tuningSample<double> >(),1.e-10),
+                    anpi::Exception);
+}
+
+BOOST_AUTO_TEST_CASE(Profile)
+{
+  const std::string path =
+    "/tmp/anpi-autotune-" + std::to_string(::getpid()) + ".txt";
+  std::remove(path.c_str());
+
+  anpi::tuningDecision chosen;
+  {
+    anpi::autotuneProfile p(path);
+    BOOST_CHECK(p.decisions().empty());
+    chosen = p.decide<double>("cubes",anpi::test::cubeSamples(10),1.e-8);
+    BOOST_CHECK(p.find("cubes",1.e-8) != 0);
+    BOOST_CHECK(p.find("cubes",1.e-9) == 0);
+  }
+
+  // later runs find the decision without samples to calibrate
+  anpi::autotuneProfile p(path);
+  BOOST_REQUIRE_EQUAL(p.decisions().size(),1u);
+  const anpi::tuningDecision& d =
+    p.decide<double>("cubes",std::vector<anpi::tuningSample<double> >(),1.e-8);
+  BOOST_CHECK_EQUAL(d.method,chosen.method);
+  BOOST_CHECK_EQUAL(d.eps,1.e-8);
+  BOOST_CHECK_EQUAL(d.budget,chosen.budget);
+
+  anpi::tuningDecision other = d;
+  other.family = "other";
+  other.method = anpi::RidderMethod;
+  p.store(other);
+  other.family = "two words";
+  BOOST_CHECK_THROW(p.store(other),anpi::Exception);
+  p.save();
+  BOOST_CHECK_EQUAL(anpi::autotuneProfile(path).decisions().size(),2u);
+  BOOST_CHECK_EQUAL(anpi::autotuneProfile(path).find("other",1.e-8)->method,
+                    anpi::RidderMethod);
+
+  {
+    std::ofstream f(path.c_str(),std::ios::app);
+    f << "cubes 1e-8 fastest 10 1 1 1\n";
+  }
+  BOOST_CHECK_THROW(anpi::autotuneProfile(static_cast<const std::string&>(path)),
+                    anpi::Exception);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(Solve)
+{
+  anpi::tuningDecision d;
+  d.family = "cubes";
+  d.eps = 1.e-10;
+  const std::function<double(double)> f = [](const double x) {
+    return x*x*x - 2.;
+  };
+  for (int m=0;m<anpi::NumRootMethods;++m) {
+    d.method = anpi::rootMethod(m);
+    d.budget = 1000u;
+    BOOST_CHECK_CLOSE(anpi::rootAuto<double>(f,0.,3.,1.e-10,d),
+                      std::cbrt(2.),1.e-4);
+    // running out of the budget gives NaN instead of throwing
+    d.budget = 1u;
+    BOOST_CHECK(std::isnan(anpi::rootAuto<double>(f,0.,3.,1.e-10,d)));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
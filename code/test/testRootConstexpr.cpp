@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "RootConstexpr.hpp"
+
+#include <array>
+#include <cmath>
+
+namespace anpi {
+  namespace test {
+
+    constexpr double cubic(const double x) { return x*x*x - 2.; }
+
+    constexpr double dcubic(const double x) { return 3.*x*x; }
+
+    /// Inverse of y = x + x^3/3 at y = 0, 1/8, ..., 15/8
+    constexpr std::array<double,16> inverseTable() {
+      std::array<double,16> t{};
+      for (size_t k=0;k<t.size();++k) {
+        const double y = double(k)/8.;
+        t[k] = anpi::rootBrentConstexpr(
+          [y](const double x) { return x + x*x*x/3. - y; },0.,2.,1.e-14);
+      }
+      return t;
+    }
+
+    constexpr bool near(const double a,const double b,const double tol) {
+      return (a < b) ? b - a <= tol : a - b <= tol;
+    }
+
+  } // test
+} // anpi
+
+// computed by the compiler
+static_assert(anpi::test::near(anpi::rootBisectionConstexpr(
+                &anpi::test::cubic,0.,2.,1.e-12),1.2599210498948732,1.e-11),
+              "bisection");
+static_assert(anpi::test::near(anpi::rootBrentConstexpr(
+                &anpi::test::cubic,0.,2.,1.e-14),1.2599210498948732,1.e-13),
+              "brent");
+static_assert(anpi::test::near(anpi::rootNewtonRaphsonConstexpr(
+                &anpi::test::cubic,&anpi::test::dcubic,1.,1.e-14),
+                1.2599210498948732,1.e-13),"newton");
+static_assert(anpi::test::near(anpi::rootNewtonRaphsonConstexpr(
+                [](const float x) { return x*x - 2.f; },1.f,1.e-6f),
+                1.41421356f,1.e-6f),"newton with differences");
+
+BOOST_AUTO_TEST_SUITE( RootConstexpr )
+
+BOOST_AUTO_TEST_CASE(Constants)
+{
+  constexpr std::array<double,16> table = anpi::test::inverseTable();
+  for (size_t k=0;k<table.size();++k) {
+    const double x = table[k];
+    BOOST_CHECK_SMALL(x + x*x*x/3. - double(k)/8.,1.e-13);
+  }
+
+  constexpr float rf = anpi::rootBrentConstexpr(
+    [](const float x) { return x*x - 2.f; },0.f,2.f,1.e-6f);
+  BOOST_CHECK_CLOSE(rf,std::sqrt(2.f),1.e-4f);
+}
+
+BOOST_AUTO_TEST_CASE(Runtime)
+{
+  // the same functions run at run time, with any callable
+  const double c = 3.;
+  const auto f = [c](const double x) { return std::exp(x) - c; };
+  BOOST_CHECK_CLOSE(anpi::rootBisectionConstexpr(f,0.,2.,1.e-12),
+                    std::log(3.),1.e-9);
+  BOOST_CHECK_CLOSE(anpi::rootBrentConstexpr(f,0.,2.,1.e-12),
+                    std::log(3.),1.e-9);
+  BOOST_CHECK_CLOSE(anpi::rootNewtonRaphsonConstexpr(f,1.,1.e-12),
+                    std::log(3.),1.e-9);
+
+  // a root at an extreme
+  BOOST_CHECK_EQUAL(anpi::rootBisectionConstexpr(
+                      [](const double x) { return x - 1.; },1.,2.,1.e-12),1.);
+
+  // invalid brackets throw
+  BOOST_CHECK_THROW(anpi::rootBrentConstexpr(f,2.,0.,1.e-12),anpi::Exception);
+  BOOST_CHECK_THROW(anpi::rootBisectionConstexpr(f,2.,3.,1.e-12),
+                    anpi::Exception);
+
+  // zero derivative
+  BOOST_CHECK(std::isnan(anpi::rootNewtonRaphsonConstexpr(
+    [](const double x) { return x*x + 1.; },0.,1.e-12)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
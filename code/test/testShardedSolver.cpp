@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "ShardedSolver.hpp"
+
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace anpi {
+  namespace test {
+
+    /// Column file of rows corpus equations
+    inline void writeCorpusColumns(const std::string& path,
+                                   const uint64_t rows) {
+      std::vector<anpi::columnFile::columnSpec> spec;
+      spec.push_back(anpi::columnFile::columnSpec("seed",anpi::UInt64));
+      spec.push_back(anpi::columnFile::columnSpec("index",anpi::UInt64));
+      anpi::columnFile f(path,rows,spec);
+      uint64_t* seed = f.writableColumn<uint64_t>("seed");
+      uint64_t* index = f.writableColumn<uint64_t>("index");
+      for (uint64_t i=0;i<rows;++i) {
+        seed[i] = 5u;
+        index[i] = i;
+      }
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( ShardedSolver )
+
+BOOST_AUTO_TEST_CASE(CpuList)
+{
+  const std::vector<int> cpus = anpi::batch::parseCpuList("0-3,8,10-11");
+  const int expected[] = { 0, 1, 2, 3, 8, 10, 11 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(cpus.begin(),cpus.end(),
+                                expected,expected + 7);
+  BOOST_CHECK(anpi::batch::parseCpuList("").empty());
+
+  const std::vector<anpi::batch::numaNode> nodes = anpi::batch::numaNodes();
+  BOOST_REQUIRE(!nodes.empty());
+  for (size_t i=0;i<nodes.size();++i) BOOST_CHECK(!nodes[i].cpus.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Shards)
+{
+  const std::string pid = std::to_string(::getpid());
+  const std::string input = "/tmp/anpi-shards-" + pid + ".in";
+  const std::string full = "/tmp/anpi-shards-" + pid + ".full";
+  const std::string output = "/tmp/anpi-shards-" + pid + ".out";
+  const std::string marker = "/tmp/anpi-shards-" + pid + ".marker";
+  const uint64_t rows = 2000u;
+  anpi::test::writeCorpusColumns(input,rows);
+
+  anpi::batch::options opts;
+  opts.threads = 2u;
+  opts.chunk = 64u;
+  anpi::batch::runColumns(input,full,opts);
+
+  anpi::batch::shardSettings settings;
+  settings.processes = 3u;
+  anpi::batch::shardSummary sum =
+    anpi::batch::runSharded(input,output,opts,settings);
+  BOOST_CHECK_EQUAL(sum.lines,rows);
+  BOOST_CHECK_EQUAL(sum.restarts,0u);
+  {
+    const anpi::columnFile a(output);
+    const anpi::columnFile b(full);
+    const double* ra = a.column<double>("root");
+    const double* rb = b.column<double>("root");
+    const uint8_t* sa = a.column<uint8_t>("status");
+    const uint8_t* sb = b.column<uint8_t>("status");
+    int wrong = 0;
+    for (uint64_t i=0;i<rows;++i) {
+      wrong += !(sa[i] == sb[i] &&
+                 (ra[i] == rb[i] || (std::isnan(ra[i]) && std::isnan(rb[i]))));
+    }
+    BOOST_CHECK_EQUAL(wrong,0);
+  }
+
+  // row 700 kills its worker every time, row 1500 only the first time
+  settings.beforeRow = [&marker](const uint64_t row) {
+    if (row == 700u) ::raise(SIGKILL);
+    if (row == 1500u) {
+      const int fd = ::open(marker.c_str(),O_CREAT | O_EXCL | O_WRONLY,0644);
+      if (fd >= 0) ::raise(SIGKILL);
+    }
+  };
+  sum = anpi::batch::runSharded(input,output,opts,settings);
+  BOOST_CHECK_EQUAL(sum.poisoned,1u);
+  BOOST_CHECK(sum.restarts >= 2u);
+  {
+    const anpi::columnFile a(output);
+    const anpi::columnFile b(full);
+    const double* ra = a.column<double>("root");
+    const double* rb = b.column<double>("root");
+    const uint8_t* sa = a.column<uint8_t>("status");
+    const uint8_t* sb = b.column<uint8_t>("status");
+    BOOST_CHECK_EQUAL(int(sa[700]),int(anpi::batch::Error));
+    int wrong = 0;
+    for (uint64_t i=0;i<rows;++i) {
+      if (i == 700u) continue;
+      wrong += !(sa[i] == sb[i] &&
+                 (ra[i] == rb[i] || (std::isnan(ra[i]) && std::isnan(rb[i]))));
+    }
+    BOOST_CHECK_EQUAL(wrong,0);
+  }
+
+  // the output must not be the input
+  BOOST_CHECK_THROW(anpi::batch::runSharded(input,input,opts,settings),
+                    anpi::Exception);
+  BOOST_CHECK(anpi::columnFile::isColumnFile(input));
+
+  // workers that never complete a chunk are given up on
+  settings.beforeRow = [](const uint64_t) { ::raise(SIGKILL); };
+  BOOST_CHECK_THROW(anpi::batch::runSharded(input,output,opts,settings),
+                    anpi::Exception);
+
+  std::remove(input.c_str());
+  std::remove(full.c_str());
+  std::remove(output.c_str());
+  std::remove(marker.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
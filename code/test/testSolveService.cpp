@@ -0,0 +1,159 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "SolveService.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace anpi {
+  namespace test {
+
+    /// Socket path unique to this process
+    inline std::string socketPath(const char* name) {
+      return "/tmp/anpi-" + std::string(name) + "-" +
+        std::to_string(::getpid()) + ".sock";
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( SolveService )
+
+BOOST_AUTO_TEST_CASE(Requests)
+{
+  const std::string path = anpi::test::socketPath("requests");
+  anpi::service::settings s;
+  s.solve.threads = 3u;
+  s.delay = 20000u; // long enough to batch all pipelined requests
+  anpi::service::server srv(path,s);
+
+  std::vector<std::string> lines;
+  for (int i=0;i<200;++i) {
+    lines.push_back("corpus 7 " + std::to_string(i));
+  }
+  lines.push_back("expr 0 2 abs(x)-exp(-x)");
+  lines.push_back("poly 1 0 1");
+  lines.push_back("expr 0 1 sin(");
+
+  anpi::service::client c(path);
+  for (size_t i=0;i<lines.size();++i) {
+    c.send(1000u + i,lines[i]);
+  }
+
+  const anpi::batch::solverType solver = anpi::batch::findSolver("brent");
+  std::map<uint64_t,anpi::service::response> got;
+  uint32_t largest = 0u;
+  for (size_t i=0;i<lines.size();++i) {
+    anpi::service::response r;
+    BOOST_REQUIRE(c.receive(r));
+    got[r.id] = r;
+    largest = std::max(largest,r.batch);
+  }
+  BOOST_REQUIRE_EQUAL(got.size(),lines.size());
+
+  // the same answers as the batch solver
+  for (size_t i=0;i<lines.size();++i) {
+    const anpi::service::response& r = got[1000u + i];
+    const anpi::batch::outcome o =
+      anpi::batch::solveProblem(lines[i],solver,s.solve);
+    BOOST_CHECK_EQUAL(int(r.status),int(o.status));
+    BOOST_CHECK_EQUAL(r.evaluations,o.evaluations);
+    if (o.status == anpi::batch::Solved) {
+      BOOST_CHECK_EQUAL(r.root,o.root);
+    }
+  }
+  BOOST_CHECK_EQUAL(int(got[1000u + 200u].status),int(anpi::batch::Solved));
+  BOOST_CHECK_CLOSE(got[1000u + 200u].root,0.56714329040978387,1.e-6);
+  BOOST_CHECK_EQUAL(int(got[1000u + 201u].status),int(anpi::batch::Invalid));
+  BOOST_CHECK_EQUAL(int(got[1000u + 202u].status),int(anpi::batch::Invalid));
+
+  // concurrent requests were grouped
+  BOOST_CHECK(largest > 1u);
+  BOOST_CHECK(srv.batches() < lines.size());
+
+  srv.stop();
+  BOOST_CHECK_EQUAL(srv.requests(),lines.size());
+  BOOST_CHECK_EQUAL(::access(path.c_str(),F_OK),-1);
+}
+
+BOOST_AUTO_TEST_CASE(Load)
+{
+  const std::string path = anpi::test::socketPath("load");
+  anpi::service::settings s;
+  s.solve.threads = 2u;
+  s.delay = 50u;
+  anpi::service::server srv(path,s);
+
+  std::vector<std::string> lines;
+  for (int i=0;i<64;++i) {
+    lines.push_back("corpus 3 " + std::to_string(i));
+  }
+  const anpi::service::loadReport r =
+    anpi::service::load(path,lines,2000u,3u,8u);
+  BOOST_CHECK_EQUAL(r.requests,2000u);
+  BOOST_CHECK(r.p50 > 0.);
+  BOOST_CHECK(r.p50 <= r.p99);
+  BOOST_CHECK(r.p99 <= r.p999);
+  BOOST_CHECK(r.p999 <= r.max);
+  BOOST_CHECK(r.batch >= 1.);
+
+  // clients come and go while the server runs
+  for (int i=0;i<5;++i) {
+    anpi::service::client c(path);
+    c.send(7u,"poly 0 2 -2 0 1");
+    anpi::service::response a;
+    BOOST_REQUIRE(c.receive(a));
+    BOOST_CHECK_EQUAL(a.id,7u);
+    BOOST_CHECK_CLOSE(a.root,std::sqrt(2.),1.e-6);
+  }
+  srv.stop();
+  BOOST_CHECK_THROW(anpi::service::client c(path),anpi::Exception);
+
+  // nor is the socket of a running server
+  {
+    anpi::service::server first(path,s);
+    BOOST_CHECK_THROW(anpi::service::server(path,s),anpi::Exception);
+    anpi::service::client c(path);
+    c.send(8u,"poly 0 2 -2 0 1");
+    anpi::service::response a;
+    BOOST_REQUIRE(c.receive(a));
+    BOOST_CHECK_EQUAL(a.id,8u);
+  }
+
+  // the socket left by a crashed server is replaced
+  {
+    const sockaddr_un addr = anpi::service::socketAddress(path);
+    const int fd = ::socket(AF_UNIX,SOCK_STREAM,0);
+    BOOST_REQUIRE(::bind(fd,reinterpret_cast<const sockaddr*>(&addr),
+                         sizeof(addr)) == 0);
+    ::close(fd);
+    anpi::service::server again(path,s);
+    anpi::service::client c(path);
+  }
+
+  // a regular file at the socket path is never removed
+  {
+    std::ofstream f(path.c_str());
+    f << "keep\n";
+  }
+  BOOST_CHECK_THROW(anpi::service::server(path,s),anpi::Exception);
+  std::ifstream kept(path.c_str());
+  std::string line;
+  BOOST_CHECK(std::getline(kept,line) && line == "keep");
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( ThreadPool )
+
+BOOST_AUTO_TEST_CASE(Deque)
+{
+  // the owner sees a stack, thieves the other end
+  anpi::workStealingDeque<int*> d(2u);
+  std::vector<int> v(10);
+  BOOST_CHECK(d.empty());
+  BOOST_CHECK(d.take() == 0);
+  BOOST_CHECK(d.steal() == 0);
+  for (size_t i=0;i<v.size();++i) d.push(&v[i]); // grows
+  BOOST_CHECK(d.take() == &v[9]);
+  BOOST_CHECK(d.steal() == &v[0]);
+  BOOST_CHECK(d.steal() == &v[1]);
+  BOOST_CHECK(d.take() == &v[8]);
+  for (int i=7;i>=2;--i) BOOST_CHECK(d.take() == &v[size_t(i)]);
+  BOOST_CHECK(d.take() == 0);
+  BOOST_CHECK(d.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Steal)
+{
+  // every element is taken exactly once, while the owner keeps pushing
+  const int n = 200000;
+  std::vector<int> v(size_t(n),0);
+  std::vector<std::atomic<int> > seen(static_cast<size_t>(n));
+  for (int i=0;i<n;++i) seen[size_t(i)] = 0;
+
+  anpi::workStealingDeque<int*> d(16u);
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> thieves;
+  for (int t=0;t<3;++t) {
+    thieves.push_back(std::thread([&]() {
+      while (!stop) {
+        int* p = d.steal();
+        if (p) ++seen[size_t(p - v.data())];
+      }
+    }));
+  }
+  for (int i=0;i<n;++i) {
+    d.push(&v[size_t(i)]);
+    if (i % 3 == 0) {
+      int* p = d.take();
+      if (p) ++seen[size_t(p - v.data())];
+    }
+  }
+  while (int* p = d.take()) ++seen[size_t(p - v.data())];
+  stop = true;
+  for (size_t t=0;t<thieves.size();++t) thieves[t].join();
+
+  int wrong = 0;
+  for (int i=0;i<n;++i) wrong += (seen[size_t(i)] != 1);
+  BOOST_CHECK_EQUAL(wrong,0);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelFor)
+{
+  anpi::threadPool pool(4u);
+  BOOST_CHECK_EQUAL(pool.size(),4u);
+
+  // uneven iterations, every index exactly once
+  const size_t n = 100000u;
+  std::vector<int> hits(n,0);
+  std::atomic<uint64_t> work(0u);
+  pool.parallelFor(0u,n,[&](const size_t i) {
+      ++hits[i];
+      uint64_t x = i;
+      for (size_t k=0;k<(i % 97u == 0u ? 2000u : 1u);++k) {
+        x = x*6364136223846793005ull + 1u;
+      }
+      work += x & 1u;
+    });
+  BOOST_CHECK_EQUAL(std::accumulate(hits.begin(),hits.end(),size_t(0u)),n);
+  BOOST_CHECK(*std::max_element(hits.begin(),hits.end()) == 1);
+
+  // ranges respect the grain and cover [begin,end)
+  std::atomic<size_t> covered(0u);
+  std::atomic<size_t> largest(0u);
+  pool.parallelForRange(10u,10010u,[&](const size_t b,const size_t e) {
+      covered += e - b;
+      size_t l = largest.load();
+      while (e - b > l && !largest.compare_exchange_weak(l,e - b)) {}
+    },64u);
+  BOOST_CHECK_EQUAL(covered.load(),10000u);
+  BOOST_CHECK(largest.load() <= 64u);
+
+  // nested loops run inside the tasks of the outer one
+  std::atomic<size_t> inner(0u);
+  pool.parallelFor(0u,50u,[&](const size_t) {
+      pool.parallelFor(0u,100u,[&](const size_t) { ++inner; });
+    },1u);
+  BOOST_CHECK_EQUAL(inner.load(),5000u);
+
+  // empty range
+  pool.parallelFor(5u,5u,[](const size_t) { BOOST_ERROR("called"); });
+}
+
+BOOST_AUTO_TEST_CASE(Submit)
+{
+  anpi::threadPool pool(3u,true);
+  std::vector<std::future<int> > f;
+  for (int i=0;i<100;++i) {
+    f.push_back(pool.submit([i]() { return i*i; }));
+  }
+  int sum = 0;
+  for (size_t i=0;i<f.size();++i) sum += f[i].get();
+  BOOST_CHECK_EQUAL(sum,328350);
+
+  std::future<void> bad = pool.submit([]() {
+      throw std::runtime_error("bad");
+    });
+  BOOST_CHECK_THROW(bad.get(),std::runtime_error);
+
+  // exceptions of parallelFor bodies reach the caller
+  BOOST_CHECK_THROW(pool.parallelFor(0u,1000u,[](const size_t i) {
+        if (i == 777u) throw std::runtime_error("777");
+      }),std::runtime_error);
+
+  // task groups
+  anpi::taskGroup g(pool);
+  std::atomic<int> count(0);
+  for (int i=0;i<1000;++i) {
+    g.run([&count]() { ++count; });
+  }
+  g.wait();
+  BOOST_CHECK_EQUAL(count.load(),1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
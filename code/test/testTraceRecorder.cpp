@@ -0,0 +1,190 @@
+/**
+ * Copyright (C) 2018
+ * Área Académica de Ingeniería en Computadoras, TEC, Costa Rica
+ *
+ * This file is part of the CE3102 Numerical Analysis lecture at TEC
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "TraceRecorder.hpp"
+#include "RootBisection.hpp"
+#include "RootInterpolation.hpp"
+#include "RootSecant.hpp"
+#include "RootNewtonRaphson.hpp"
+#include "RootBrent.hpp"
+#include "RootRidder.hpp"
+
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <string>
+
+namespace anpi {
+  namespace test {
+
+    /// Function with a root at x=0.5
+    template<typename T>
+    T cubic(const T x) { return x*x*x - T(0.125); }
+
+    /// Check that trace holds one solve of a bracketing method ending
+    /// near the root 0.5
+    void checkBracketing(const ringTrace& trace,const traceStep step) {
+      BOOST_REQUIRE(trace.size() > 1u);
+      BOOST_CHECK_EQUAL(trace[0].iteration,0u);
+      BOOST_CHECK_EQUAL(trace[0].step,uint16_t(Start));
+      for (size_t i=1;i<trace.size();++i) {
+        BOOST_CHECK_EQUAL(trace[i].iteration,uint32_t(i));
+        BOOST_CHECK(trace[i].step == step || trace[i].step == Bisection);
+        BOOST_CHECK(trace[i].width >= 0.);
+      }
+      BOOST_CHECK(std::abs(trace[trace.size()-1u].x - 0.5) < 1.e-2);
+    }
+
+  } // test
+} // anpi
+
+BOOST_AUTO_TEST_SUITE( TraceRecorder )
+
+BOOST_AUTO_TEST_CASE(Ring)
+{
+  anpi::ringTrace trace(5u);
+  BOOST_CHECK_EQUAL(trace.capacity(),8u);
+  BOOST_CHECK_EQUAL(trace.size(),0u);
+
+  for (unsigned int i=0;i<11u;++i) {
+    trace.record(i,double(i),-double(i),1./double(i+1),anpi::Secant);
+  }
+  BOOST_CHECK_EQUAL(trace.size(),8u);
+  BOOST_CHECK_EQUAL(trace.dropped(),3u);
+
+  // the oldest events were overwritten
+  for (size_t i=0;i<trace.size();++i) {
+    BOOST_CHECK_EQUAL(trace[i].iteration,uint32_t(i+3u));
+    BOOST_CHECK_EQUAL(trace[i].x,double(i+3u));
+  }
+  BOOST_CHECK_EQUAL(trace.events().size(),8u);
+
+  trace.clear();
+  BOOST_CHECK_EQUAL(trace.size(),0u);
+  BOOST_CHECK_EQUAL(trace.dropped(),0u);
+}
+
+BOOST_AUTO_TEST_CASE(Solvers)
+{
+  const std::function<double(double)> f(anpi::test::cubic<double>);
+  anpi::ringTrace trace(256u);
+
+  // the traced solvers find the same roots as the plain ones
+  double x = anpi::rootBisectionTraced<double>(f,0.,2.,1.e-6,trace);
+  BOOST_CHECK_EQUAL(x,anpi::rootBisection<double>(f,0.,2.,1.e-6));
+  anpi::test::checkBracketing(trace,anpi::Bisection);
+
+  trace.clear();
+  x = anpi::rootInterpolationTraced<double>(f,0.,2.,1.e-6,trace);
+  BOOST_CHECK_EQUAL(x,anpi::rootInterpolation<double>(f,0.,2.,1.e-6));
+  anpi::test::checkBracketing(trace,anpi::FalsePosition);
+
+  trace.clear();
+  x = anpi::rootBrentTraced<double>(f,0.,2.,1.e-6,trace);
+  BOOST_CHECK_EQUAL(x,anpi::rootBrent<double>(f,0.,2.,1.e-6));
+  anpi::test::checkBracketing(trace,anpi::Interpolation);
+
+  trace.clear();
+  x = anpi::rootRidderTraced<double>(f,0.,2.,1.e-6,trace);
+  BOOST_CHECK_EQUAL(x,anpi::rootRidder<double>(f,0.,2.,1.e-6));
+  BOOST_REQUIRE(trace.size() > 0u);
+  BOOST_CHECK_EQUAL(trace[0].step,uint16_t(anpi::Start));
+  BOOST_CHECK_EQUAL(trace[0].width,2.);
+  for (size_t i=1;i<trace.size();++i) {
+    BOOST_CHECK_EQUAL(trace[i].step,uint16_t(anpi::Ridder));
+  }
+
+  // open methods record each iterate with the length of its step
+  trace.clear();
+  x = anpi::rootSecantTraced<double>(f,0.4,0.7,1.e-9,trace);
+  BOOST_CHECK_EQUAL(x,anpi::rootSecant<double>(f,0.4,0.7,1.e-9));
+  BOOST_REQUIRE(trace.size() > 1u);
+  BOOST_CHECK_EQUAL(trace[0].x,0.7);
+  BOOST_CHECK_EQUAL(trace[0].fx,f(0.7));
+  BOOST_CHECK(trace[trace.size()-1u].width <= 1.e-9);
+
+  trace.clear();
+  x = anpi::rootNewtonRaphsonTraced<double>(f,1.,1.e-9,trace);
+  BOOST_CHECK_EQUAL(x,anpi::rootNewtonRaphson<double>(f,1.,1.e-9));
+  BOOST_REQUIRE(trace.size() > 1u);
+  BOOST_CHECK_EQUAL(trace[0].step,uint16_t(anpi::Newton));
+  BOOST_CHECK_EQUAL(trace[1].x,trace[0].x - trace[0].width);
+}
+
+BOOST_AUTO_TEST_CASE(Failure)
+{
+  const std::function<double(double)> f(anpi::test::cubic<double>);
+  anpi::ringTrace trace(64u);
+
+  // no sign change: Ridder throws, leaving a failed step behind
+  BOOST_CHECK_THROW(anpi::rootRidderTraced<double>(f,1.,2.,1.e-6,trace),
+                    anpi::Exception);
+  BOOST_REQUIRE_EQUAL(trace.size(),2u);
+  BOOST_CHECK_EQUAL(trace[1].step,uint16_t(anpi::Failed));
+}
+
+BOOST_AUTO_TEST_CASE(Formats)
+{
+  const std::function<float(float)> f(anpi::test::cubic<float>);
+  anpi::ringTrace trace(16u);
+  anpi::rootBisectionTraced<float>(f,0.f,2.f,1.e-6f,trace);
+  anpi::rootBrentTraced<float>(f,0.f,2.f,1.e-6f,trace);
+  BOOST_REQUIRE(trace.dropped() > 0u);
+
+  // binary round trip
+  std::stringstream bin;
+  trace.write(bin);
+  BOOST_CHECK_EQUAL(bin.str().size(),24u + 32u*trace.size());
+  uint64_t dropped = 0u;
+  const std::vector<anpi::traceEvent> events = anpi::readTrace(bin,&dropped);
+  BOOST_CHECK_EQUAL(dropped,trace.dropped());
+  BOOST_REQUIRE_EQUAL(events.size(),trace.size());
+  for (size_t i=0;i<events.size();++i) {
+    BOOST_CHECK_EQUAL(events[i].x,trace[i].x);
+    BOOST_CHECK_EQUAL(events[i].fx,trace[i].fx);
+    BOOST_CHECK_EQUAL(events[i].iteration,trace[i].iteration);
+    BOOST_CHECK_EQUAL(events[i].step,trace[i].step);
+  }
+
+  std::stringstream truncated(bin.str().substr(0u,40u));
+  BOOST_CHECK_THROW(anpi::readTrace(truncated),anpi::Exception);
+  std::stringstream garbage("not a trace at all, just text");
+  BOOST_CHECK_THROW(anpi::readTrace(garbage),anpi::Exception);
+
+  // CSV: a header and one line per event
+  std::ostringstream csv;
+  anpi::writeTraceCsv(csv,events);
+  const std::string text = csv.str();
+  BOOST_CHECK_EQUAL(text.compare(0u,26u,"iteration,step,x,fx,width\n"),0);
+  size_t lines = 0u;
+  for (size_t i=0;i<text.size();++i) lines += (text[i] == '\n');
+  BOOST_CHECK_EQUAL(lines,events.size() + 1u);
+
+  // Chrome: the tail of the bisection and the whole Brent solve
+  std::ostringstream json;
+  anpi::writeTraceChrome(json,events,"cubic");
+  const std::string js = json.str();
+  BOOST_CHECK(js.find("{\"traceEvents\":[") == 0u);
+  BOOST_CHECK(js.find("\"name\":\"interpolation\"") != std::string::npos);
+  size_t solves = 0u;
+  for (size_t p = js.find("\"name\":\"cubic\",\"ph\":\"X\"");
+       p != std::string::npos;
+       p = js.find("\"name\":\"cubic\",\"ph\":\"X\"",p+1u)) {
+    ++solves;
+  }
+  BOOST_CHECK_EQUAL(solves,2u);
+
+  // names are escaped
+  std::ostringstream quoted;
+  anpi::writeTraceChrome(quoted,events,"a \"cubic\"");
+  BOOST_CHECK(quoted.str().find("\"name\":\"a \\\"cubic\\\"\"") !=
+              std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()